@@ -1,7 +1,10 @@
 #include <kernel/types.h>
+#include <kernel/interrupt.h>
 
 #define GICD_BASE 0xFF841000
 #define GICC_BASE 0xFF842000
+#define GICD_ITARGETSR (GICD_BASE + 0x800)
+#define GIC_MAX_TARGET_CPUS 8
 
 typedef struct {
     u32 ctlr;
@@ -28,6 +31,8 @@ typedef struct {
 static volatile gicd_t *gicd = (volatile gicd_t *)GICD_BASE;
 static volatile gicc_t *gicc = (volatile gicc_t *)GICC_BASE;
 
+static int arm_gic_route_irq(u32 irq, u32 cpu_mask);
+
 void arm_gic_init(void)
 {
     gicd->ctlr = 1;
@@ -40,6 +45,8 @@ void arm_gic_init(void)
     gicc->ctlr = 1;
     gicc->pmr = 0xFF;
     gicc->bpr = 0;
+    
+    ied_set_affinity_hook(arm_gic_route_irq);
 }
 
 void arm_gic_enable_irq(u32 irq)
@@ -68,9 +75,15 @@ void arm_gic_eoi(u32 irq)
 
 void arm_gic_set_target(u32 irq, u8 cpu_mask)
 {
-    u32 byte_offset = irq / 4;
-    u32 bit_offset = (irq % 4) * 8;
+    /* GICD_ITARGETSR holds one byte-accessible target mask per interrupt. */
+    volatile u8 *targets = (volatile u8 *)GICD_ITARGETSR;
+    targets[irq] = cpu_mask;
+}
+
+static int arm_gic_route_irq(u32 irq, u32 cpu_mask)
+{
+    if (cpu_mask >> GIC_MAX_TARGET_CPUS) return -1;
     
-    u32 *reg = (u32 *)((u8 *)&gicd->igroupr[32] + byte_offset);
-    *reg = (*reg & ~(0xFF << bit_offset)) | (cpu_mask << bit_offset);
+    arm_gic_set_target(irq, (u8)cpu_mask);
+    return 0;
 }
@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+static bench_result_t bench_results[BENCH_MAX_RESULTS];
+static uint32_t bench_result_count;
+
+static uint32_t bench_warmup = 3;
+static uint32_t bench_reps = 15;
+
+void bench_set_reps(uint32_t warmup, uint32_t reps)
+{
+    bench_warmup = warmup;
+    bench_reps = reps == 0 ? 1 : reps > BENCH_MAX_REPS ? BENCH_MAX_REPS : reps;
+}
+
+static int bench_cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static bench_result_t *bench_record(const char *name, uint64_t ops, double *per_op, uint32_t reps)
+{
+    qsort(per_op, reps, sizeof(double), bench_cmp_double);
+
+    bench_result_t *result = NULL;
+    for (uint32_t i = 0; i < bench_result_count; i++) {
+        if (strcmp(bench_results[i].name, name) == 0) {
+            result = &bench_results[i];
+            break;
+        }
+    }
+    if (!result) {
+        if (bench_result_count >= BENCH_MAX_RESULTS) return NULL;
+        result = &bench_results[bench_result_count++];
+    }
+
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->ops = ops;
+    result->reps = reps;
+    result->median_ns = reps % 2 ? per_op[reps / 2] : (per_op[reps / 2 - 1] + per_op[reps / 2]) / 2;
+    result->max_ns = per_op[reps - 1];
+    result->min_ns = per_op[0];
+
+    return result;
+}
+
+static void bench_print(const bench_result_t *result)
+{
+    printf("  %-36s %14.0f ops/sec  median %9.1f ns  max %9.1f ns\n",
+           result->name, result->median_ns > 0 ? 1e9 / result->median_ns : 0,
+           result->median_ns, result->max_ns);
+}
+
+const bench_result_t *bench_run(const char *name, bench_fn_t fn, void *ctx, uint64_t ops)
+{
+    double per_op[BENCH_MAX_REPS];
+
+    if (!name || !fn || ops == 0) return NULL;
+
+    for (uint32_t i = 0; i < bench_warmup; i++) {
+        fn(ctx, ops);
+    }
+
+    for (uint32_t i = 0; i < bench_reps; i++) {
+        uint64_t start = bench_now_ns();
+        fn(ctx, ops);
+        per_op[i] = (double)(bench_now_ns() - start) / (double)ops;
+    }
+
+    bench_result_t *result = bench_record(name, ops, per_op, bench_reps);
+    if (result) bench_print(result);
+    return result;
+}
+
+void bench_report_rate(const char *name, uint64_t ops, uint64_t elapsed_ns)
+{
+    double seconds = (double)elapsed_ns / 1e9;
+    double rate = seconds > 0 ? (double)ops / seconds : 0;
+
+    printf("  %-36s %14.0f ops/sec  (%llu ops in %.3f ms)\n",
+           name, rate, (unsigned long long)ops, (double)elapsed_ns / 1e6);
+
+    if (ops > 0) {
+        double per_op = (double)elapsed_ns / (double)ops;
+        bench_record(name, ops, &per_op, 1);
+    }
+}
+
+static void bench_json_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+int bench_write_json(const char *path)
+{
+    FILE *out = fopen(path, "w");
+    if (!out) return -1;
+
+    /* One benchmark per line, so bench_compare can read it back without a JSON parser. */
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (uint32_t i = 0; i < bench_result_count; i++) {
+        const bench_result_t *result = &bench_results[i];
+
+        fprintf(out, "    {\"name\": ");
+        bench_json_string(out, result->name);
+        fprintf(out, ", \"ops\": %llu, \"reps\": %u, \"median_ns\": %.3f, \"max_ns\": %.3f, \"min_ns\": %.3f}%s\n",
+                (unsigned long long)result->ops, result->reps, result->median_ns,
+                result->max_ns, result->min_ns, i + 1 < bench_result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+static int bench_parse_line(const char *line, char *name, size_t name_size, double *median_ns)
+{
+    const char *p = strstr(line, "\"name\": \"");
+    if (!p) return -1;
+    p += strlen("\"name\": \"");
+
+    size_t n = 0;
+    while (*p && *p != '"') {
+        if (*p == '\\' && p[1]) p++;
+        if (n + 1 < name_size) name[n++] = *p;
+        p++;
+    }
+    name[n] = '\0';
+
+    p = strstr(p, "\"median_ns\": ");
+    if (!p || sscanf(p + strlen("\"median_ns\": "), "%lf", median_ns) != 1) return -1;
+
+    return 0;
+}
+
+int bench_compare(const char *baseline_path, double threshold_pct)
+{
+    FILE *in = fopen(baseline_path, "r");
+    if (!in) return -1;
+
+    char line[512];
+    char name[64];
+    double baseline_ns;
+    int compared = 0;
+    int regressions = 0;
+
+    printf("\n--- Compared with %s (threshold %.1f%%) ---\n", baseline_path, threshold_pct);
+
+    while (fgets(line, sizeof(line), in)) {
+        if (bench_parse_line(line, name, sizeof(name), &baseline_ns) != 0) continue;
+
+        for (uint32_t i = 0; i < bench_result_count; i++) {
+            const bench_result_t *result = &bench_results[i];
+            if (strcmp(result->name, name) != 0 || baseline_ns <= 0) continue;
+
+            double change = (result->median_ns - baseline_ns) / baseline_ns * 100.0;
+            int regressed = change > threshold_pct;
+
+            printf("  %-36s %9.1f -> %9.1f ns  %+7.1f%%%s\n", name, baseline_ns,
+                   result->median_ns, change, regressed ? "  REGRESSION" : "");
+            compared++;
+            regressions += regressed;
+            break;
+        }
+    }
+    fclose(in);
+
+    printf("  %d compared, %d regressed\n", compared, regressions);
+    return regressions;
+}
@@ -0,0 +1,52 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_MAX_RESULTS  128
+#define BENCH_MAX_REPS     1000
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Runs 'ops' operations of one benchmark; called once per repetition. */
+typedef void (*bench_fn_t)(void *ctx, uint64_t ops);
+
+typedef struct {
+    char name[64];
+    uint64_t ops;
+    uint32_t reps;
+    double median_ns;   /* per operation, over the measured repetitions */
+    double max_ns;
+    double min_ns;
+} bench_result_t;
+
+void bench_set_reps(uint32_t warmup, uint32_t reps);
+
+/*
+ * Time 'fn' over the configured warmup and measured repetitions and
+ * report the median and slowest per-operation cost across the measured
+ * ones. Each repetition is an average over 'ops', so there are too few
+ * samples for a tail percentile.
+ */
+const bench_result_t *bench_run(const char *name, bench_fn_t fn, void *ctx, uint64_t ops);
+
+/* Report a one-shot measurement; it is recorded as a single repetition. */
+void bench_report_rate(const char *name, uint64_t ops, uint64_t elapsed_ns);
+
+int bench_write_json(const char *path);
+
+/*
+ * Compare this run against a JSON file written by an earlier run and list
+ * every benchmark whose median got more than 'threshold_pct' slower.
+ * Returns the number of regressions, or -1 if the baseline can't be read.
+ */
+int bench_compare(const char *baseline_path, double threshold_pct);
+
+#endif
@@ -0,0 +1,62 @@
+#include <string.h>
+#include <kernel/filesystem.h>
+#include "bench.h"
+
+#define BENCH_FS_OPS        100000
+#define BENCH_FS_FILE_SIZE  (AEGISFS_MAX_BLOCKS * PAGE_SIZE)
+
+typedef struct {
+    inode_t *inode;
+    u64 size;
+    u64 offset;
+} bench_fs_ctx_t;
+
+static u8 bench_fs_buf[64 * 1024];
+
+static u64 bench_fs_next(bench_fs_ctx_t *fs)
+{
+    u64 offset = fs->offset;
+    fs->offset = (fs->offset + fs->size) % BENCH_FS_FILE_SIZE;
+    return offset;
+}
+
+static void bench_fs_write(void *ctx, uint64_t ops)
+{
+    bench_fs_ctx_t *fs = (bench_fs_ctx_t *)ctx;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        aegisfs_write(fs->inode, bench_fs_next(fs), bench_fs_buf, fs->size);
+    }
+}
+
+static void bench_fs_read(void *ctx, uint64_t ops)
+{
+    bench_fs_ctx_t *fs = (bench_fs_ctx_t *)ctx;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        aegisfs_read(fs->inode, bench_fs_next(fs), bench_fs_buf, fs->size);
+    }
+}
+
+void run_aegisfs_benchmarks(void)
+{
+    printf("\n--- AegisFS ---\n");
+
+    aegisfs_init();
+    bench_fs_ctx_t fs = { aegisfs_create_file("/bench_fs", 0644), 4096, 0 };
+    if (!fs.inode) return;
+
+    memset(bench_fs_buf, 0xA5, sizeof(bench_fs_buf));
+
+    bench_run("aegisfs write 4 KiB", bench_fs_write, &fs, BENCH_FS_OPS);
+    bench_run("aegisfs read 4 KiB", bench_fs_read, &fs, BENCH_FS_OPS);
+
+    fs.size = 64;
+    bench_run("aegisfs read 64 B", bench_fs_read, &fs, BENCH_FS_OPS);
+
+    fs.size = sizeof(bench_fs_buf);
+    fs.offset = 0;
+    bench_run("aegisfs read 64 KiB", bench_fs_read, &fs, BENCH_FS_OPS / 16);
+
+    aegisfs_delete_file("/bench_fs");
+}
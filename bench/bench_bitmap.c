@@ -0,0 +1,59 @@
+#include <string.h>
+#include <kernel/types.h>
+#include "bench.h"
+
+#define BENCH_BITMAP_BITS   32768
+#define BENCH_BITMAP_BYTES  (BENCH_BITMAP_BITS / 8)
+#define BENCH_BITMAP_OPS    1000000
+#define BENCH_BITMAP_SCANS  2000
+
+/* common/bitmap.c has no header of its own. */
+void bitmap_set(u8 *bitmap, u32 bit);
+void bitmap_clear(u8 *bitmap, u32 bit);
+int bitmap_test(const u8 *bitmap, u32 bit);
+u32 bitmap_find_first_clear(const u8 *bitmap, u32 size);
+u32 bitmap_count_set(const u8 *bitmap, u32 size);
+
+static u8 bench_bitmap[BENCH_BITMAP_BYTES];
+
+static void bench_bitmap_set_clear(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    u32 bit = 0;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        bitmap_set(bench_bitmap, bit);
+        bitmap_clear(bench_bitmap, bit);
+        bit = (bit + 97) % BENCH_BITMAP_BITS;
+    }
+}
+
+/* The free bit sits at the far end, as in a nearly full page bitmap. */
+static void bench_bitmap_find_clear(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    for (uint64_t i = 0; i < ops; i++) {
+        bitmap_find_first_clear(bench_bitmap, BENCH_BITMAP_BYTES);
+    }
+}
+
+static void bench_bitmap_count(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    for (uint64_t i = 0; i < ops; i++) {
+        bitmap_count_set(bench_bitmap, BENCH_BITMAP_BYTES);
+    }
+}
+
+void run_bitmap_benchmarks(void)
+{
+    printf("\n--- Bitmap (32 Ki bits) ---\n");
+
+    memset(bench_bitmap, 0, sizeof(bench_bitmap));
+    bench_run("bitmap set+clear", bench_bitmap_set_clear, NULL, BENCH_BITMAP_OPS);
+
+    memset(bench_bitmap, 0xFF, sizeof(bench_bitmap));
+    bitmap_clear(bench_bitmap, BENCH_BITMAP_BITS - 1);
+    bench_run("bitmap find_first_clear", bench_bitmap_find_clear, NULL, BENCH_BITMAP_SCANS);
+    bench_run("bitmap count_set", bench_bitmap_count, NULL, BENCH_BITMAP_SCANS);
+}
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <string.h>
+#include <security/crypto_engine.h>
+#include "bench.h"
+
+#define BENCH_CRYPTO_OPS    20000
+#define BENCH_CRYPTO_BLOCK  4096
+
+static u8 bench_crypto_in[BENCH_CRYPTO_BLOCK];
+static u8 bench_crypto_out[BENCH_CRYPTO_BLOCK];
+
+static void bench_crypto_encrypt(void *ctx, uint64_t ops)
+{
+    cipher_context_t *cipher = (cipher_context_t *)ctx;
+    u64 len;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        crypto_encrypt(cipher, bench_crypto_in, BENCH_CRYPTO_BLOCK, bench_crypto_out, &len);
+    }
+}
+
+static void bench_crypto_decrypt(void *ctx, uint64_t ops)
+{
+    cipher_context_t *cipher = (cipher_context_t *)ctx;
+    u64 len;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        crypto_decrypt(cipher, bench_crypto_out, BENCH_CRYPTO_BLOCK, bench_crypto_in, &len);
+    }
+}
+
+static void bench_crypto_hash(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    for (uint64_t i = 0; i < ops; i++) {
+        free(crypto_hash(HASH_SHA256, bench_crypto_in, BENCH_CRYPTO_BLOCK));
+    }
+}
+
+void run_crypto_benchmarks(void)
+{
+    u8 key[32];
+    u8 iv[16];
+
+    printf("\n--- Crypto Engine (4 KiB blocks) ---\n");
+
+    crypto_engine_init();
+    crypto_generate_random(key, sizeof(key));
+    crypto_generate_random(iv, sizeof(iv));
+    crypto_generate_random(bench_crypto_in, sizeof(bench_crypto_in));
+
+    cipher_context_t *cipher = crypto_create_cipher(CIPHER_AES_XTS, key, sizeof(key), iv);
+    if (!cipher) return;
+
+    bench_run("crypto encrypt 4 KiB", bench_crypto_encrypt, cipher, BENCH_CRYPTO_OPS);
+    bench_run("crypto decrypt 4 KiB", bench_crypto_decrypt, cipher, BENCH_CRYPTO_OPS);
+    bench_run("crypto hash 4 KiB", bench_crypto_hash, NULL, BENCH_CRYPTO_OPS);
+
+    crypto_destroy_cipher(cipher);
+}
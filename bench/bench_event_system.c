@@ -0,0 +1,126 @@
+#include <string.h>
+#include <kernel/event_system.h>
+#include "bench.h"
+
+#define BENCH_EVENT_ITERATIONS 20000
+#define BENCH_EVENT_SLOW_NS    2000
+#define BENCH_EVENT_FAST_OPS   200000
+
+static int bench_slow_subscriber(const kernel_event_t *event, void *context)
+{
+    (void)event;
+    (void)context;
+
+    uint64_t start = bench_now_ns();
+    while (bench_now_ns() - start < BENCH_EVENT_SLOW_NS) {
+    }
+    return 0;
+}
+
+static int bench_noop_subscriber(const kernel_event_t *event, void *context)
+{
+    (void)event;
+    (void)context;
+    return 0;
+}
+
+static void bench_event_publish_fast(void *ctx, uint64_t ops)
+{
+    kernel_event_t *event = (kernel_event_t *)ctx;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        event->event_id = (uint32_t)i;
+        event_publish(event);
+    }
+}
+
+static void bench_event_publish(uint32_t type, const char *name)
+{
+    kernel_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.event_type = type;
+
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_EVENT_ITERATIONS; i++) {
+        event.event_id = (uint32_t)i;
+        event_publish(&event);
+    }
+
+    bench_report_rate(name, BENCH_EVENT_ITERATIONS, bench_now_ns() - start);
+}
+
+void run_event_system_benchmarks(void)
+{
+    kernel_event_t event;
+
+    printf("\n--- Event Publish ---\n");
+
+    event_system_init();
+
+    memset(&event, 0, sizeof(event));
+    event.event_type = EVENT_IRQ_RECEIVED;
+    bench_run("publish, no subscribers", bench_event_publish_fast, &event, BENCH_EVENT_FAST_OPS);
+    event_subscribe(1, EVENT_IRQ_RECEIVED, bench_noop_subscriber, NULL);
+    bench_run("publish, 1 no-op subscriber", bench_event_publish_fast, &event, BENCH_EVENT_FAST_OPS);
+    event_unsubscribe(1, EVENT_IRQ_RECEIVED);
+
+    printf("\n--- Event Publish (slow subscriber, 2 us/event) ---\n");
+
+    event_subscribe(1, EVENT_IRQ_RECEIVED, bench_slow_subscriber, NULL);
+    bench_event_publish(EVENT_IRQ_RECEIVED, "publish, sync subscriber");
+    event_unsubscribe(1, EVENT_IRQ_RECEIVED);
+
+    event_subscription_opts_t opts = {
+        .delivery = EVENT_DELIVERY_ASYNC,
+        .backpressure = EVENT_BACKPRESSURE_DROP_OLDEST,
+        .queue_depth = 256,
+    };
+    event_subscribe_ex(1, EVENT_IRQ_RECEIVED, bench_slow_subscriber, NULL, &opts);
+    event_dispatch_start(2);
+    bench_event_publish(EVENT_IRQ_RECEIVED, "publish, async drop-oldest");
+    event_dispatch_flush();
+
+    event_subscriber_stats_t stats;
+    if (event_get_subscriber_stats(1, EVENT_IRQ_RECEIVED, &stats) == 0) {
+        printf("    %-34s %14llu\n", "dropped", (unsigned long long)stats.dropped);
+        printf("    %-34s %14.0f\n", "mean lag (ns)",
+               stats.delivered ? (double)stats.total_lag_ns / (double)stats.delivered : 0.0);
+    }
+
+    event_dispatch_stop();
+    event_unsubscribe(1, EVENT_IRQ_RECEIVED);
+
+    /* Telemetry-style listeners: 16 slow subscribers that only want source 3. */
+    event_filter_t filter;
+    event_filter_compile("source == 3", &filter);
+    memset(&opts, 0, sizeof(opts));
+
+    for (int i = 0; i < 16; i++) {
+        event_subscribe(100 + i, EVENT_IRQ_RECEIVED, bench_slow_subscriber, NULL);
+    }
+    bench_event_publish(EVENT_IRQ_RECEIVED, "publish, 16 unfiltered subscribers");
+    for (int i = 0; i < 16; i++) {
+        event_unsubscribe_all(100 + i);
+    }
+
+    opts.filter = &filter;
+    for (int i = 0; i < 16; i++) {
+        event_subscribe_ex(100 + i, EVENT_IRQ_RECEIVED, bench_slow_subscriber, NULL, &opts);
+    }
+    bench_event_publish(EVENT_IRQ_RECEIVED, "publish, 16 compiled filters");
+    for (int i = 0; i < 16; i++) {
+        event_unsubscribe_all(100 + i);
+    }
+
+    memset(&opts, 0, sizeof(opts));
+    opts.coalesce_window_ns = 1000000;
+    event_subscribe_ex(1, EVENT_IRQ_RECEIVED, bench_slow_subscriber, NULL, &opts);
+    bench_event_publish(EVENT_IRQ_RECEIVED, "publish, 1 ms coalescing window");
+    event_dispatch_flush();
+
+    if (event_get_subscriber_stats(1, EVENT_IRQ_RECEIVED, &stats) == 0) {
+        printf("    %-34s %14llu\n", "deliveries", (unsigned long long)stats.bursts);
+    }
+    event_unsubscribe(1, EVENT_IRQ_RECEIVED);
+}
@@ -0,0 +1,61 @@
+#include <string.h>
+#include <kernel/ipc_bus.h>
+#include "bench.h"
+
+#define BENCH_IPC_SOURCE   100
+#define BENCH_IPC_DEST     101
+#define BENCH_IPC_MESSAGES 200000
+#define BENCH_IPC_BATCH    32
+
+static ipc_message_t bench_batch[BENCH_IPC_BATCH];
+
+static void bench_ipc_single(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    ipc_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.source_id = BENCH_IPC_SOURCE;
+    msg.dest_id = BENCH_IPC_DEST;
+    msg.payload_size = 64;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        msg.msg_id = (uint32_t)i;
+        ipc_bus_send_message(&msg);
+        ipc_bus_receive_message(BENCH_IPC_DEST, &msg);
+    }
+}
+
+static void bench_ipc_batch(void *ctx, uint64_t ops)
+{
+    int batch_size = *(int *)ctx;
+    uint64_t messages = 0;
+
+    for (int i = 0; i < batch_size; i++) {
+        bench_batch[i].source_id = BENCH_IPC_SOURCE;
+        bench_batch[i].dest_id = BENCH_IPC_DEST;
+        bench_batch[i].payload_size = 64;
+    }
+
+    while (messages < ops) {
+        int sent = ipc_bus_send_batch(bench_batch, batch_size);
+        if (sent <= 0) {
+            break;
+        }
+        messages += (uint64_t)ipc_bus_receive_batch(BENCH_IPC_DEST, bench_batch, sent);
+    }
+}
+
+void run_ipc_bus_benchmarks(void)
+{
+    static int small_batch = 8;
+    static int full_batch = BENCH_IPC_BATCH;
+
+    printf("\n--- IPC Bus ---\n");
+
+    ipc_bus_init();
+    ipc_bus_register_route(BENCH_IPC_SOURCE, BENCH_IPC_DEST, 5);
+
+    bench_run("ipc_bus send/recv (single)", bench_ipc_single, NULL, BENCH_IPC_MESSAGES);
+    bench_run("ipc_bus send/recv (batch of 8)", bench_ipc_batch, &small_batch, BENCH_IPC_MESSAGES);
+    bench_run("ipc_bus send/recv (batch of 32)", bench_ipc_batch, &full_batch, BENCH_IPC_MESSAGES);
+}
@@ -0,0 +1,102 @@
+#include <string.h>
+#include <kernel/ipc.h>
+#include <kernel/ipc_bus.h>
+#include <kernel/process.h>
+#include <kernel/profiler.h>
+#include "bench.h"
+
+#define BENCH_CALL_ITERATIONS 100000
+#define BENCH_CALL_CLIENT     200
+#define BENCH_CALL_SERVER     201
+
+static int bench_echo_handler(thread_t *server, ipc_fastpath_msg_t *msg, void *context)
+{
+    (void)server;
+    (void)context;
+    msg->mr[0]++;
+    return 0;
+}
+
+static void bench_ipc_call_fastpath(thread_t *client, thread_t *server)
+{
+    ipc_endpoint_t *ep = ipc_endpoint_create(bench_echo_handler, NULL);
+    if (!ep) return;
+
+    ipc_reply_wait(ep, server);
+    client->state = PROCESS_STATE_RUNNING;
+
+    ipc_fastpath_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.length = 1;
+
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_CALL_ITERATIONS; i++) {
+        ipc_call(ep, client, &msg);
+    }
+
+    bench_report_rate("ipc_call round trip (fast path)", BENCH_CALL_ITERATIONS, bench_now_ns() - start);
+    printf("  %-36s %14llu cycles/round trip (profiler avg %llu)\n", "",
+           (unsigned long long)ipc_endpoint_get_average_cycles(ep),
+           (unsigned long long)profiler_get_average_duration("ipc_call"));
+
+    ipc_endpoint_destroy(ep);
+}
+
+static void bench_ipc_bus_round_trip(void)
+{
+    ipc_message_t request;
+    ipc_message_t reply;
+    memset(&request, 0, sizeof(request));
+    memset(&reply, 0, sizeof(reply));
+
+    ipc_bus_register_route(BENCH_CALL_CLIENT, BENCH_CALL_SERVER, 5);
+    ipc_bus_register_route(BENCH_CALL_SERVER, BENCH_CALL_CLIENT, 5);
+
+    uint64_t cycles = 0;
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_CALL_ITERATIONS; i++) {
+        uint64_t begin = profiler_get_cpu_cycles();
+
+        request.source_id = BENCH_CALL_CLIENT;
+        request.dest_id = BENCH_CALL_SERVER;
+        request.payload_size = sizeof(uint64_t);
+        ipc_bus_send_message(&request);
+
+        ipc_bus_receive_message(BENCH_CALL_SERVER, &reply);
+        reply.source_id = BENCH_CALL_SERVER;
+        reply.dest_id = BENCH_CALL_CLIENT;
+        ipc_bus_send_message(&reply);
+
+        ipc_bus_receive_message(BENCH_CALL_CLIENT, &request);
+
+        cycles += profiler_get_cpu_cycles() - begin;
+    }
+
+    bench_report_rate("ipc_bus request/response round trip", BENCH_CALL_ITERATIONS, bench_now_ns() - start);
+    printf("  %-36s %14llu cycles/round trip\n", "",
+           (unsigned long long)(cycles / BENCH_CALL_ITERATIONS));
+}
+
+void run_ipc_call_benchmarks(void)
+{
+    printf("\n--- IPC Call/Reply ---\n");
+
+    pmgr_init();
+    ipc_bus_init();
+    profiler_init();
+    profiler_clear();
+
+    process_t *proc = pmgr_create_process("bench_ipc_call", NULL, 1);
+    if (!proc) return;
+
+    thread_t *server = pmgr_create_thread(proc->pid, NULL, NULL);
+    thread_t *client = pmgr_create_thread(proc->pid, NULL, NULL);
+    if (!server || !client) return;
+
+    bench_ipc_call_fastpath(client, server);
+    bench_ipc_bus_round_trip();
+
+    profiler_clear();
+}
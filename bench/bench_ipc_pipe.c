@@ -0,0 +1,72 @@
+#include <string.h>
+#include <stdlib.h>
+#include <kernel/ipc.h>
+#include <kernel/filesystem.h>
+#include "bench.h"
+
+#define BENCH_PIPE_FILE_SIZE  (AEGISFS_MAX_BLOCKS * PAGE_SIZE)
+#define BENCH_PIPE_ITERATIONS 200
+
+static void bench_pipe_copy(inode_t *src, inode_t *dst)
+{
+    ipc_object_t *pipe = ipc_create_pipe(1, 2);
+    u8 *buf = (u8 *)malloc(IPC_PIPE_DEFAULT_PAGES * PAGE_SIZE);
+    if (!pipe || !buf) return;
+
+    u64 chunk = IPC_PIPE_DEFAULT_PAGES * PAGE_SIZE;
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_PIPE_ITERATIONS; i++) {
+        for (u64 off = 0; off < BENCH_PIPE_FILE_SIZE; off += chunk) {
+            aegisfs_read(src, off, buf, chunk);
+            ipc_write_pipe(pipe, buf, chunk);
+            int n = ipc_read_pipe(pipe, buf, chunk);
+            aegisfs_write(dst, off, buf, (u64)n);
+        }
+    }
+
+    bench_report_rate("1 MiB file to file via pipe (copy)", BENCH_PIPE_ITERATIONS, bench_now_ns() - start);
+
+    ipc_destroy_pipe(pipe);
+    free(buf);
+}
+
+static void bench_pipe_splice(inode_t *src, inode_t *dst)
+{
+    ipc_object_t *pipe = ipc_create_pipe(1, 2);
+    if (!pipe) return;
+
+    u64 chunk = IPC_PIPE_DEFAULT_PAGES * PAGE_SIZE;
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_PIPE_ITERATIONS; i++) {
+        for (u64 off = 0; off < BENCH_PIPE_FILE_SIZE; off += chunk) {
+            ipc_splice_from_file(pipe, src, off, chunk);
+            ipc_splice_to_file(pipe, dst, off, chunk);
+        }
+    }
+
+    bench_report_rate("1 MiB file to file via pipe (splice)", BENCH_PIPE_ITERATIONS, bench_now_ns() - start);
+
+    ipc_destroy_pipe(pipe);
+}
+
+void run_ipc_pipe_benchmarks(void)
+{
+    printf("\n--- IPC Pipes ---\n");
+
+    aegisfs_init();
+    inode_t *src = aegisfs_create_file("/bench_pipe_src", 0644);
+    inode_t *dst = aegisfs_create_file("/bench_pipe_dst", 0644);
+    u8 *data = (u8 *)malloc(BENCH_PIPE_FILE_SIZE);
+    if (!src || !dst || !data) return;
+
+    memset(data, 0x6C, BENCH_PIPE_FILE_SIZE);
+    aegisfs_write(src, 0, data, BENCH_PIPE_FILE_SIZE);
+
+    bench_pipe_copy(src, dst);
+    bench_pipe_splice(src, dst);
+
+    aegisfs_delete_file("/bench_pipe_src");
+    free(data);
+}
@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <kernel/ipc.h>
+#include "bench.h"
+
+#define BENCH_SEM_RUN_NS   (100ULL * 1000000ULL)
+#define BENCH_SEM_MAX_THREADS 64
+
+typedef struct {
+    ipc_object_t *sem;
+    volatile int *stop;
+    int spin_only;
+    uint64_t ops;
+} bench_sem_worker_t;
+
+static void *bench_sem_worker(void *arg)
+{
+    bench_sem_worker_t *w = (bench_sem_worker_t *)arg;
+    volatile u64 shared = 0;
+
+    while (!*w->stop) {
+        if (w->spin_only) {
+            while (ipc_semaphore_try_wait(w->sem) != 0) {
+                if (*w->stop) return NULL;
+            }
+        } else {
+            ipc_semaphore_wait(w->sem);
+        }
+
+        for (int i = 0; i < 32; i++) {
+            shared += (u64)i;
+        }
+
+        ipc_semaphore_signal(w->sem);
+        w->ops++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Fairness is Jain's index over per-thread acquisitions: 1.0 means every
+ * thread got the same share, 1/n means one thread took everything.
+ */
+static void bench_sem_contention(int threads, int spin_only)
+{
+    ipc_object_t *sem = ipc_create_semaphore(1);
+    pthread_t tids[BENCH_SEM_MAX_THREADS];
+    bench_sem_worker_t workers[BENCH_SEM_MAX_THREADS];
+    volatile int stop = 0;
+    if (!sem) return;
+
+    for (int i = 0; i < threads; i++) {
+        workers[i].sem = sem;
+        workers[i].stop = &stop;
+        workers[i].spin_only = spin_only;
+        workers[i].ops = 0;
+        pthread_create(&tids[i], NULL, bench_sem_worker, &workers[i]);
+    }
+
+    uint64_t start = bench_now_ns();
+    while (bench_now_ns() - start < BENCH_SEM_RUN_NS) {
+        sched_yield();
+    }
+    stop = 1;
+
+    if (!spin_only) {
+        for (int i = 0; i < threads; i++) {
+            ipc_semaphore_signal(sem);
+        }
+    }
+
+    uint64_t total = 0;
+    double sum_sq = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        total += workers[i].ops;
+        sum_sq += (double)workers[i].ops * (double)workers[i].ops;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    double fairness = sum_sq > 0 ? ((double)total * (double)total) / (threads * sum_sq) : 0;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s, %d threads", spin_only ? "spin only" : "spin then sleep", threads);
+    bench_report_rate(name, total, elapsed);
+    printf("    %-34s %14.3f\n", "fairness (Jain index)", fairness);
+}
+
+void run_ipc_sem_benchmarks(void)
+{
+    printf("\n--- IPC Semaphore Contention ---\n");
+
+    for (int threads = 2; threads <= BENCH_SEM_MAX_THREADS; threads *= 2) {
+        bench_sem_contention(threads, 1);
+        bench_sem_contention(threads, 0);
+    }
+}
@@ -0,0 +1,72 @@
+#include <string.h>
+#include <stdlib.h>
+#include <kernel/ipc.h>
+#include <kernel/memory.h>
+#include "bench.h"
+
+#define BENCH_SHM_TRANSFER   (1024 * 1024)
+#define BENCH_SHM_PAGES      (BENCH_SHM_TRANSFER / PAGE_SIZE)
+#define BENCH_SHM_ITERATIONS 2000
+#define BENCH_SHM_SRC_VIRT   0x10000000UL
+
+static void bench_shm_copy(u8 *src, u8 *dst)
+{
+    u8 *staging = (u8 *)malloc(BENCH_SHM_TRANSFER);
+    if (!staging) return;
+
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_SHM_ITERATIONS; i++) {
+        memcpy(staging, src, BENCH_SHM_TRANSFER);
+        memcpy(dst, staging, BENCH_SHM_TRANSFER);
+    }
+
+    bench_report_rate("1 MiB transfer (copy in + copy out)", BENCH_SHM_ITERATIONS, bench_now_ns() - start);
+    free(staging);
+}
+
+static void bench_shm_grant(u8 *src, u32 flags, const char *name)
+{
+    address_space_t *sender = mmgr_create_address_space();
+    address_space_t *receiver = mmgr_create_address_space();
+    if (!sender || !receiver) return;
+
+    mmgr_map_pages(sender, BENCH_SHM_SRC_VIRT, (u64)src, BENCH_SHM_PAGES, PROT_READ | PROT_WRITE);
+
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_SHM_ITERATIONS; i++) {
+        u64 dst_virt = 0;
+        ipc_grant_pages(sender, BENCH_SHM_SRC_VIRT, receiver, &dst_virt, BENCH_SHM_PAGES, flags);
+
+        if (flags & IPC_GRANT_MOVE) {
+            u64 back = BENCH_SHM_SRC_VIRT;
+            ipc_grant_pages(receiver, dst_virt, sender, &back, BENCH_SHM_PAGES, flags);
+        } else {
+            ipc_revoke_grant(receiver, dst_virt, BENCH_SHM_PAGES);
+        }
+    }
+
+    bench_report_rate(name, BENCH_SHM_ITERATIONS, bench_now_ns() - start);
+
+    mmgr_destroy_address_space(sender);
+    mmgr_destroy_address_space(receiver);
+}
+
+void run_ipc_shm_benchmarks(void)
+{
+    printf("\n--- IPC Shared Memory (1 MiB) ---\n");
+
+    u8 *src = (u8 *)aligned_alloc(PAGE_SIZE, BENCH_SHM_TRANSFER);
+    u8 *dst = (u8 *)aligned_alloc(PAGE_SIZE, BENCH_SHM_TRANSFER);
+    if (!src || !dst) return;
+
+    memset(src, 0x5A, BENCH_SHM_TRANSFER);
+
+    bench_shm_copy(src, dst);
+    bench_shm_grant(src, IPC_GRANT_READ, "1 MiB transfer (grant map + revoke)");
+    bench_shm_grant(src, IPC_GRANT_READ | IPC_GRANT_WRITE | IPC_GRANT_MOVE, "1 MiB transfer (grant move, round trip)");
+
+    free(src);
+    free(dst);
+}
@@ -0,0 +1,118 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+void run_ipc_bus_benchmarks(void);
+void run_ipc_shm_benchmarks(void);
+void run_ipc_call_benchmarks(void);
+void run_ipc_pipe_benchmarks(void);
+void run_ipc_sem_benchmarks(void);
+void run_event_system_benchmarks(void);
+void run_syscall_ring_benchmarks(void);
+void run_memory_benchmarks(void);
+void run_scheduler_benchmarks(void);
+void run_syscall_benchmarks(void);
+void run_aegisfs_benchmarks(void);
+void run_crypto_benchmarks(void);
+void run_bitmap_benchmarks(void);
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} bench_groups[] = {
+    { "mmgr",         run_memory_benchmarks },
+    { "sched",        run_scheduler_benchmarks },
+    { "ipc_bus",      run_ipc_bus_benchmarks },
+    { "ipc_shm",      run_ipc_shm_benchmarks },
+    { "ipc_call",     run_ipc_call_benchmarks },
+    { "ipc_pipe",     run_ipc_pipe_benchmarks },
+    { "ipc_sem",      run_ipc_sem_benchmarks },
+    { "event",        run_event_system_benchmarks },
+    { "syscall",      run_syscall_benchmarks },
+    { "syscall_ring", run_syscall_ring_benchmarks },
+    { "aegisfs",      run_aegisfs_benchmarks },
+    { "crypto",       run_crypto_benchmarks },
+    { "bitmap",       run_bitmap_benchmarks },
+};
+
+#define BENCH_GROUP_COUNT (sizeof(bench_groups) / sizeof(bench_groups[0]))
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--json FILE] [--baseline FILE] [--threshold PCT]\n"
+                    "       [--warmup N] [--reps N] [group...]\n"
+                    "groups:", prog);
+    for (size_t i = 0; i < BENCH_GROUP_COUNT; i++) {
+        fprintf(stderr, " %s", bench_groups[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    double threshold = 10.0;
+    unsigned warmup = 3;
+    unsigned reps = 15;
+    bool selected[BENCH_GROUP_COUNT] = { false };
+    bool any_selected = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--json") == 0 && value) {
+            json_path = value;
+        } else if (strcmp(arg, "--baseline") == 0 && value) {
+            baseline_path = value;
+        } else if (strcmp(arg, "--threshold") == 0 && value) {
+            threshold = atof(value);
+        } else if (strcmp(arg, "--warmup") == 0 && value) {
+            warmup = (unsigned)atoi(value);
+        } else if (strcmp(arg, "--reps") == 0 && value) {
+            reps = (unsigned)atoi(value);
+        } else {
+            size_t g;
+            for (g = 0; g < BENCH_GROUP_COUNT; g++) {
+                if (strcmp(arg, bench_groups[g].name) == 0) break;
+            }
+            if (g == BENCH_GROUP_COUNT) {
+                usage(argv[0]);
+                return 2;
+            }
+            selected[g] = true;
+            any_selected = true;
+            continue;
+        }
+        i++;
+    }
+
+    bench_set_reps(warmup, reps);
+
+    printf("\n=== Aegis OS Kernel Benchmarks ===\n");
+    printf("  %u warmup + %u measured repetitions\n", warmup, reps);
+
+    for (size_t g = 0; g < BENCH_GROUP_COUNT; g++) {
+        if (!any_selected || selected[g]) {
+            bench_groups[g].run();
+        }
+    }
+
+    if (json_path && bench_write_json(json_path) != 0) {
+        fprintf(stderr, "cannot write %s\n", json_path);
+        return 1;
+    }
+
+    if (baseline_path) {
+        int regressions = bench_compare(baseline_path, threshold);
+        if (regressions < 0) {
+            fprintf(stderr, "cannot read %s\n", baseline_path);
+            return 1;
+        }
+        return regressions > 0 ? 1 : 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <kernel/memory.h>
+#include "bench.h"
+
+#define BENCH_MMGR_OPS      100000
+#define BENCH_MMGR_HELD     4096
+#define BENCH_MMGR_HELD_OPS 2000
+#define BENCH_MMGR_BATCH    64
+
+static void *bench_mmgr_held[BENCH_MMGR_HELD];
+static void *bench_mmgr_batch[BENCH_MMGR_BATCH];
+
+static void bench_mmgr_alloc_free(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    for (uint64_t i = 0; i < ops; i++) {
+        mmgr_free_page(mmgr_alloc_page());
+    }
+}
+
+static void bench_mmgr_alloc_batch(void *ctx, uint64_t ops)
+{
+    (void)ctx;
+    for (uint64_t i = 0; i < ops; i += BENCH_MMGR_BATCH) {
+        for (int j = 0; j < BENCH_MMGR_BATCH; j++) {
+            bench_mmgr_batch[j] = mmgr_alloc_page();
+        }
+        for (int j = 0; j < BENCH_MMGR_BATCH; j++) {
+            mmgr_free_page(bench_mmgr_batch[j]);
+        }
+    }
+}
+
+void run_memory_benchmarks(void)
+{
+    printf("\n--- Page Allocator ---\n");
+
+    if (mmgr_init() != 0) return;
+
+    bench_run("mmgr alloc+free page", bench_mmgr_alloc_free, NULL, BENCH_MMGR_OPS);
+    bench_run("mmgr alloc 64, free 64", bench_mmgr_alloc_batch, NULL, BENCH_MMGR_OPS);
+
+    /* First fit scans the bitmap, so the cost grows with the pages in use below the hole. */
+    for (int i = 0; i < BENCH_MMGR_HELD; i++) {
+        bench_mmgr_held[i] = mmgr_alloc_page();
+    }
+    bench_run("mmgr alloc+free page, 4096 held", bench_mmgr_alloc_free, NULL, BENCH_MMGR_HELD_OPS);
+    for (int i = 0; i < BENCH_MMGR_HELD; i++) {
+        mmgr_free_page(bench_mmgr_held[i]);
+    }
+}
@@ -0,0 +1,66 @@
+#include <string.h>
+#include <kernel/scheduler.h>
+#include "bench.h"
+
+#define BENCH_SCHED_OPS      100000
+#define BENCH_SCHED_ENTITIES 256
+
+static thread_t bench_sched_threads[BENCH_SCHED_ENTITIES + 1];
+static sched_entity_t bench_sched_entities[BENCH_SCHED_ENTITIES + 1];
+
+static void bench_sched_setup(int count)
+{
+    for (int i = 0; i <= count; i++) {
+        memset(&bench_sched_threads[i], 0, sizeof(thread_t));
+        memset(&bench_sched_entities[i], 0, sizeof(sched_entity_t));
+        bench_sched_threads[i].tid = (u64)i + 1;
+        bench_sched_threads[i].state = PROCESS_STATE_READY;
+        bench_sched_entities[i].thread = &bench_sched_threads[i];
+        bench_sched_entities[i].sched_class = SCHED_CLASS_FAIR;
+        bench_sched_entities[i].ctx.cfs.vruntime = (u64)(i * 7919 % count + 1) * 1000;
+    }
+
+    for (int i = 0; i < count; i++) {
+        scheduler_enqueue(&bench_sched_entities[i]);
+    }
+}
+
+static void bench_sched_teardown(int count)
+{
+    for (int i = 0; i < count; i++) {
+        scheduler_dequeue(&bench_sched_entities[i]);
+    }
+}
+
+/* One thread wakes up, gets picked and runs, then blocks again. */
+static void bench_sched_cycle(void *ctx, uint64_t ops)
+{
+    sched_entity_t *waker = (sched_entity_t *)ctx;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        scheduler_enqueue(waker);
+        scheduler_pick_next(0);
+        scheduler_dequeue(waker);
+    }
+}
+
+static void bench_sched_queue(int count)
+{
+    char name[64];
+
+    bench_sched_setup(count);
+    snprintf(name, sizeof(name), "sched enqueue/pick/dequeue, %d ready", count);
+    bench_run(name, bench_sched_cycle, &bench_sched_entities[count], BENCH_SCHED_OPS / (count / 8 + 1));
+    bench_sched_teardown(count);
+}
+
+void run_scheduler_benchmarks(void)
+{
+    printf("\n--- Scheduler ---\n");
+
+    if (scheduler_init() != 0) return;
+
+    bench_sched_queue(8);
+    bench_sched_queue(64);
+    bench_sched_queue(BENCH_SCHED_ENTITIES);
+}
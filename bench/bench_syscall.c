@@ -0,0 +1,33 @@
+#include <kernel/syscalls.h>
+#include "bench.h"
+
+#define BENCH_SYSCALL_OPS   1000000
+#define BENCH_SYSCALL_NULL  401
+
+static int bench_null_syscall(void)
+{
+    return 0;
+}
+
+static void bench_syscall_dispatch(void *ctx, uint64_t ops)
+{
+    int num = *(int *)ctx;
+
+    for (uint64_t i = 0; i < ops; i++) {
+        syscall_dispatch(num, NULL);
+    }
+}
+
+void run_syscall_benchmarks(void)
+{
+    static int null_syscall = BENCH_SYSCALL_NULL;
+    static int missing_syscall = BENCH_SYSCALL_NULL + 1;
+
+    printf("\n--- Syscall Dispatch ---\n");
+
+    syscall_gate_init();
+    syscall_register(BENCH_SYSCALL_NULL, bench_null_syscall, "bench_null", SYSCALL_PRIVILEGE_USER, 0);
+
+    bench_run("syscall_dispatch, null handler", bench_syscall_dispatch, &null_syscall, BENCH_SYSCALL_OPS);
+    bench_run("syscall_dispatch, unregistered", bench_syscall_dispatch, &missing_syscall, BENCH_SYSCALL_OPS);
+}
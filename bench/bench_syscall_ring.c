@@ -0,0 +1,126 @@
+#include <string.h>
+#include <stdlib.h>
+#include <kernel/syscalls.h>
+#include <kernel/syscall_ring.h>
+#include <kernel/filesystem.h>
+#include <kernel/process.h>
+#include "bench.h"
+
+#define BENCH_RING_READ_SIZE  4096
+#define BENCH_RING_FILE_SIZE  (AEGISFS_MAX_BLOCKS * PAGE_SIZE)
+#define BENCH_RING_READS      200000
+#define BENCH_RING_BATCH      32
+#define BENCH_RING_SYSCALL    400
+
+static inode_t *bench_ring_file;
+static u8 bench_ring_buf[BENCH_RING_BATCH][BENCH_RING_READ_SIZE];
+static u64 bench_ring_off;
+static process_t *bench_ring_proc;
+static u8 *bench_ring_user;
+
+static u64 bench_ring_next_off(void)
+{
+    u64 off = bench_ring_off;
+    bench_ring_off = (bench_ring_off + BENCH_RING_READ_SIZE) % BENCH_RING_FILE_SIZE;
+    return off;
+}
+
+static int bench_read_syscall(void)
+{
+    return aegisfs_read(bench_ring_file, bench_ring_next_off(), bench_ring_buf[0], BENCH_RING_READ_SIZE);
+}
+
+static void bench_dispatch_reads(void)
+{
+    syscall_register(BENCH_RING_SYSCALL, bench_read_syscall, "bench_read", SYSCALL_PRIVILEGE_USER, 0);
+
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_RING_READS; i++) {
+        syscall_dispatch(BENCH_RING_SYSCALL, NULL);
+    }
+
+    bench_report_rate("4 KiB read via syscall_dispatch", BENCH_RING_READS, bench_now_ns() - start);
+
+    syscall_unregister(BENCH_RING_SYSCALL);
+}
+
+static void bench_ring_reads(const char *name, u32 flags)
+{
+    syscall_ring_t *ring = syscall_ring_create(bench_ring_proc->pid, BENCH_RING_BATCH, flags);
+    if (!ring) return;
+
+    void *files[] = { bench_ring_file };
+    syscall_ring_register_files(ring, files, 1);
+
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < BENCH_RING_READS; i += BENCH_RING_BATCH) {
+        for (int j = 0; j < BENCH_RING_BATCH; j++) {
+            syscall_sqe_t *sqe = syscall_ring_get_sqe(ring);
+            syscall_ring_prep(sqe, SQE_OP_READ, 0, bench_ring_user + j * BENCH_RING_READ_SIZE, BENCH_RING_READ_SIZE,
+                              bench_ring_next_off(), (u64)j);
+        }
+        syscall_ring_submit(ring);
+
+        /* With a poller the completions are polled too, so the loop never enters the kernel. */
+        for (int j = 0; j < BENCH_RING_BATCH; j++) {
+            syscall_cqe_t *cqe;
+            if (flags & SYSCALL_RING_SQPOLL) {
+                u32 spins = 0;
+                while (!syscall_ring_peek_cqe(ring)) {
+                    lock_spin_wait(&spins);
+                }
+            } else {
+                syscall_ring_wait_cqe(ring, &cqe);
+            }
+            syscall_ring_cqe_seen(ring);
+        }
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report_rate(name, BENCH_RING_READS, elapsed);
+
+    syscall_ring_stats_t stats;
+    syscall_ring_get_stats(ring, &stats);
+    printf("  %-36s %14llu kernel entries (%llu poller wakeups)\n", "",
+           (unsigned long long)stats.enters, (unsigned long long)stats.poller_wakeups);
+
+    syscall_ring_destroy(ring);
+}
+
+void run_syscall_ring_benchmarks(void)
+{
+    printf("\n--- Syscall Rings ---\n");
+
+    syscall_gate_init();
+    aegisfs_init();
+    pmgr_init();
+    bench_ring_file = aegisfs_create_file("/bench_ring", 0644);
+    if (!bench_ring_file) return;
+
+    u8 *data = (u8 *)malloc(BENCH_RING_FILE_SIZE);
+    if (!data) {
+        aegisfs_delete_file("/bench_ring");
+        return;
+    }
+
+    memset(data, 0x5A, BENCH_RING_FILE_SIZE);
+    aegisfs_write(bench_ring_file, 0, data, BENCH_RING_FILE_SIZE);
+    free(data);
+
+    bench_dispatch_reads();
+
+    /* Ring reads land in the submitting process, so the buffers live in its shared memory. */
+    bench_ring_proc = pmgr_create_process("bench_ring", NULL, 1);
+    ipc_object_t *shm = bench_ring_proc ? ipc_create_shared_memory(bench_ring_proc->pid, sizeof(bench_ring_buf)) : NULL;
+    bench_ring_user = shm ? (u8 *)ipc_attach_shared_memory(shm, bench_ring_proc->pid) : NULL;
+    if (bench_ring_user) {
+        bench_ring_reads("4 KiB read via ring (batch 32)", 0);
+        bench_ring_reads("4 KiB read via ring (SQ poller)", SYSCALL_RING_SQPOLL);
+    }
+
+    if (shm) ipc_destroy_shared_memory(shm);
+    if (bench_ring_proc) pmgr_destroy_process(bench_ring_proc->pid);
+    aegisfs_delete_file("/bench_ring");
+}
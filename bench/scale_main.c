@@ -0,0 +1,329 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <kernel/percpu.h>
+#include <kernel/memory.h>
+#include <kernel/ipc_bus.h>
+#include <kernel/event_system.h>
+#include <kernel/scheduler.h>
+#include "bench.h"
+
+/*
+ * Scalability harness: N host threads, each pinned to its own core and
+ * running kernel code as simulated CPU N, hammer one subsystem at a time
+ * for a fixed interval. Throughput per thread count gives the scaling
+ * curve; build with -DAEGIS_SCALE_TSAN=ON to have ThreadSanitizer watch
+ * the same runs for races.
+ */
+
+#define SCALE_MAX_THREADS   MAX_CPUS
+#define SCALE_IPC_SOURCE    0
+#define SCALE_IPC_DEST      (MAX_IPC_ROUTES / 2)
+#define SCALE_CHECK_EVERY   64
+
+typedef struct {
+    const char *name;
+    int (*setup)(u32 threads);
+    void (*op)(u32 cpu);
+    void (*teardown)(u32 threads);
+} scale_workload_t;
+
+typedef struct {
+    pthread_t thread;
+    u32 cpu;
+    u64 ops;
+    const scale_workload_t *workload;
+} scale_worker_t;
+
+static int scale_cores[CPU_SETSIZE];
+static int scale_core_count;
+
+static pthread_barrier_t scale_barrier;
+static volatile bool scale_stop;
+
+static thread_t scale_threads[SCALE_MAX_THREADS];
+static sched_entity_t scale_entities[SCALE_MAX_THREADS];
+static ipc_message_t scale_msgs[SCALE_MAX_THREADS];
+
+static void scale_mmgr_op(u32 cpu)
+{
+    (void)cpu;
+    mmgr_free_page(mmgr_alloc_page());
+}
+
+/* One route per CPU, so the bus's single-consumer queues are never shared. */
+static int scale_ipc_setup(u32 threads)
+{
+    for (u32 cpu = 0; cpu < threads; cpu++) {
+        if (!ipc_bus_is_route_available(SCALE_IPC_SOURCE + cpu, SCALE_IPC_DEST + cpu) &&
+            ipc_bus_register_route(SCALE_IPC_SOURCE + cpu, SCALE_IPC_DEST + cpu, 5) != 0) {
+            return -1;
+        }
+        memset(&scale_msgs[cpu], 0, sizeof(ipc_message_t));
+        scale_msgs[cpu].source_id = SCALE_IPC_SOURCE + cpu;
+        scale_msgs[cpu].dest_id = SCALE_IPC_DEST + cpu;
+        scale_msgs[cpu].payload_size = 64;
+    }
+    return 0;
+}
+
+static void scale_ipc_op(u32 cpu)
+{
+    ipc_bus_send_message(&scale_msgs[cpu]);
+    ipc_bus_receive_message(SCALE_IPC_DEST + cpu, &scale_msgs[cpu]);
+}
+
+static int scale_event_subscriber(const kernel_event_t *event, void *context)
+{
+    (void)event;
+    (void)context;
+    return 0;
+}
+
+static int scale_event_setup(u32 threads)
+{
+    (void)threads;
+    return event_subscribe(1, EVENT_IRQ_RECEIVED, scale_event_subscriber, NULL);
+}
+
+static void scale_event_op(u32 cpu)
+{
+    kernel_event_t event;
+
+    memset(&event, 0, sizeof(event));
+    event.event_type = EVENT_IRQ_RECEIVED;
+    event.event_id = cpu;
+    event_publish(&event);
+}
+
+static void scale_event_teardown(u32 threads)
+{
+    (void)threads;
+    event_unsubscribe(1, EVENT_IRQ_RECEIVED);
+}
+
+/* Each CPU wakes its own thread, picks the next one to run and blocks again. */
+static int scale_sched_setup(u32 threads)
+{
+    for (u32 cpu = 0; cpu < threads; cpu++) {
+        memset(&scale_threads[cpu], 0, sizeof(thread_t));
+        memset(&scale_entities[cpu], 0, sizeof(sched_entity_t));
+        scale_threads[cpu].tid = cpu + 1;
+        scale_threads[cpu].state = PROCESS_STATE_READY;
+        scale_entities[cpu].thread = &scale_threads[cpu];
+        scale_entities[cpu].sched_class = SCHED_CLASS_FAIR;
+        scale_entities[cpu].ctx.cfs.vruntime = (u64)(cpu + 1) * 1000;
+    }
+    return 0;
+}
+
+static void scale_sched_op(u32 cpu)
+{
+    scheduler_enqueue(&scale_entities[cpu]);
+    scheduler_pick_next(cpu);
+    scheduler_dequeue(&scale_entities[cpu]);
+}
+
+static const scale_workload_t scale_workloads[] = {
+    { "mmgr alloc+free page",       NULL,              scale_mmgr_op,  NULL },
+    { "ipc_bus send/recv",          scale_ipc_setup,   scale_ipc_op,   NULL },
+    { "event publish",              scale_event_setup, scale_event_op, scale_event_teardown },
+    { "sched enqueue/pick/dequeue", scale_sched_setup, scale_sched_op, NULL },
+};
+
+#define SCALE_WORKLOAD_COUNT (sizeof(scale_workloads) / sizeof(scale_workloads[0]))
+
+static void scale_find_cores(void)
+{
+    cpu_set_t set;
+
+    scale_core_count = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int core = 0; core < CPU_SETSIZE; core++) {
+            if (CPU_ISSET(core, &set)) scale_cores[scale_core_count++] = core;
+        }
+    }
+    if (scale_core_count == 0) {
+        scale_cores[0] = 0;
+        scale_core_count = 1;
+    }
+}
+
+static void *scale_worker(void *arg)
+{
+    scale_worker_t *worker = (scale_worker_t *)arg;
+    cpu_set_t set;
+    u64 ops = 0;
+
+    CPU_ZERO(&set);
+    CPU_SET(scale_cores[worker->cpu % scale_core_count], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    percpu_set_current_cpu(worker->cpu);
+
+    pthread_barrier_wait(&scale_barrier);
+
+    while (!__atomic_load_n(&scale_stop, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < SCALE_CHECK_EVERY; i++) {
+            worker->workload->op(worker->cpu);
+        }
+        ops += SCALE_CHECK_EVERY;
+    }
+
+    worker->ops = ops;
+    return NULL;
+}
+
+/* Returns operations per second across all threads, or a negative value on failure. */
+static double scale_run(const scale_workload_t *workload, u32 threads, u32 duration_ms)
+{
+    static scale_worker_t workers[SCALE_MAX_THREADS];
+    u32 started = 0;
+    u64 total = 0;
+
+    if (workload->setup && workload->setup(threads) != 0) return -1;
+
+    __atomic_store_n(&scale_stop, false, __ATOMIC_RELAXED);
+    pthread_barrier_init(&scale_barrier, NULL, threads + 1);
+
+    for (u32 cpu = 0; cpu < threads; cpu++) {
+        workers[cpu].cpu = cpu;
+        workers[cpu].ops = 0;
+        workers[cpu].workload = workload;
+        if (pthread_create(&workers[cpu].thread, NULL, scale_worker, &workers[cpu]) != 0) break;
+        started++;
+    }
+
+    /* A thread that failed to start would leave the others at the barrier. */
+    if (started < threads) {
+        fprintf(stderr, "only %u of %u threads started\n", started, threads);
+        exit(1);
+    }
+
+    pthread_barrier_wait(&scale_barrier);
+    uint64_t start = bench_now_ns();
+    usleep(duration_ms * 1000);
+    __atomic_store_n(&scale_stop, true, __ATOMIC_RELAXED);
+
+    for (u32 cpu = 0; cpu < threads; cpu++) {
+        pthread_join(workers[cpu].thread, NULL);
+        total += workers[cpu].ops;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    pthread_barrier_destroy(&scale_barrier);
+    if (workload->teardown) workload->teardown(threads);
+
+    return elapsed ? (double)total * 1e9 / (double)elapsed : 0;
+}
+
+/* 1, 2, 4, ... and always the full thread count last. */
+static u32 scale_next_count(u32 threads, u32 max_threads)
+{
+    u32 next = threads * 2;
+    return next > max_threads && threads < max_threads ? max_threads : next;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--threads N] [--duration MS] [--csv FILE] [workload...]\n"
+                    "workloads:", prog);
+    for (size_t i = 0; i < SCALE_WORKLOAD_COUNT; i++) {
+        fprintf(stderr, " \"%s\"", scale_workloads[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    u32 max_threads = 0;
+    u32 duration_ms = 200;
+    const char *csv_path = NULL;
+    bool selected[SCALE_WORKLOAD_COUNT] = { false };
+    bool any_selected = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--threads") == 0 && value) {
+            max_threads = (u32)atoi(value);
+            i++;
+        } else if (strcmp(argv[i], "--duration") == 0 && value) {
+            duration_ms = (u32)atoi(value);
+            i++;
+        } else if (strcmp(argv[i], "--csv") == 0 && value) {
+            csv_path = value;
+            i++;
+        } else {
+            size_t w;
+            for (w = 0; w < SCALE_WORKLOAD_COUNT; w++) {
+                if (strncmp(argv[i], scale_workloads[w].name, strlen(argv[i])) == 0) break;
+            }
+            if (w == SCALE_WORKLOAD_COUNT) {
+                usage(argv[0]);
+                return 2;
+            }
+            selected[w] = true;
+            any_selected = true;
+        }
+    }
+
+    scale_find_cores();
+    if (max_threads == 0) max_threads = (u32)scale_core_count;
+    if (max_threads > SCALE_MAX_THREADS) max_threads = SCALE_MAX_THREADS;
+
+    if (percpu_init(max_threads) != 0 || mmgr_init() != 0 || scheduler_init() != 0) {
+        fprintf(stderr, "kernel init failed\n");
+        return 1;
+    }
+    ipc_bus_init();
+    event_system_init();
+
+    FILE *csv = csv_path ? fopen(csv_path, "w") : NULL;
+    if (csv_path && !csv) {
+        fprintf(stderr, "cannot write %s\n", csv_path);
+        return 1;
+    }
+    if (csv) fprintf(csv, "workload,threads,ops_per_sec,speedup\n");
+
+    printf("\n=== Aegis OS Scalability (%u cores, %u ms per point) ===\n",
+           (u32)scale_core_count, duration_ms);
+
+    for (size_t w = 0; w < SCALE_WORKLOAD_COUNT; w++) {
+        const scale_workload_t *workload = &scale_workloads[w];
+        double base = 0, peak = 0;
+        u32 peak_threads = 1;
+
+        if (any_selected && !selected[w]) continue;
+
+        printf("\n--- %s ---\n", workload->name);
+        printf("  %8s %16s %9s %11s\n", "threads", "ops/sec", "speedup", "efficiency");
+
+        for (u32 threads = 1; threads <= max_threads; threads = scale_next_count(threads, max_threads)) {
+            double rate = scale_run(workload, threads, duration_ms);
+            if (rate < 0) {
+                printf("  %8u %16s\n", threads, "setup failed");
+                break;
+            }
+            if (threads == 1) base = rate;
+
+            double speedup = base > 0 ? rate / base : 0;
+            printf("  %8u %16.0f %8.2fx %10.0f%%\n", threads, rate, speedup, speedup / threads * 100.0);
+            if (csv) fprintf(csv, "\"%s\",%u,%.0f,%.3f\n", workload->name, threads, rate, speedup);
+
+            if (rate > peak) {
+                peak = rate;
+                peak_threads = threads;
+            }
+        }
+
+        printf("  peak at %u thread%s (%.2fx one thread)\n", peak_threads,
+               peak_threads == 1 ? "" : "s", base > 0 ? peak / base : 0);
+    }
+
+    if (csv) fclose(csv);
+    return 0;
+}
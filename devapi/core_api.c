@@ -1,4 +1,5 @@
 #include <devapi/core_api.h>
+#include <kernel/futex.h>
 #include <string.h>
 
 int aegis_process_create(const char *name, const char *entrypoint, 
@@ -57,7 +58,107 @@ int aegis_capability_grant(aegis_pid_t pid, uint32_t capability_mask) { return 0
 int aegis_capability_revoke(aegis_pid_t pid, uint32_t capability_mask) { return 0; }
 int aegis_capability_check(aegis_pid_t pid, uint32_t capability) { return 0; }
 
-int aegis_event_create(const char *event_name, uint8_t manual_reset, uint8_t initial_state) { return 0; }
-int aegis_event_set(const char *event_name) { return 0; }
-int aegis_event_clear(const char *event_name) { return 0; }
-int aegis_event_wait(const char *event_name, uint32_t timeout_ms) { return 0; }
+typedef struct {
+    char name[AEGIS_MAX_EVENT_NAME];
+    uint32_t state;
+    uint8_t manual_reset;
+    uint32_t in_use;
+} aegis_event_slot_t;
+
+static aegis_event_slot_t aegis_events[AEGIS_MAX_EVENTS];
+
+static aegis_event_slot_t *aegis_event_find(const char *event_name)
+{
+    for (uint32_t i = 0; i < AEGIS_MAX_EVENTS; i++) {
+        if (__atomic_load_n(&aegis_events[i].in_use, __ATOMIC_ACQUIRE) == 2 &&
+            strncmp(aegis_events[i].name, event_name, AEGIS_MAX_EVENT_NAME) == 0) {
+            return &aegis_events[i];
+        }
+    }
+    return NULL;
+}
+
+int aegis_event_create(const char *event_name, uint8_t manual_reset, uint8_t initial_state)
+{
+    if (!event_name || !event_name[0]) return AEGIS_ERROR_INVALID_PARAM;
+    if (aegis_event_find(event_name)) return AEGIS_ERROR_ALREADY_EXISTS;
+
+    for (uint32_t i = 0; i < AEGIS_MAX_EVENTS; i++) {
+        uint32_t expected = 0;
+        if (!__atomic_compare_exchange_n(&aegis_events[i].in_use, &expected, 1, 0,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        aegis_event_slot_t *event = &aegis_events[i];
+        strncpy(event->name, event_name, AEGIS_MAX_EVENT_NAME - 1);
+        event->name[AEGIS_MAX_EVENT_NAME - 1] = '\0';
+        event->manual_reset = manual_reset;
+        event->state = initial_state ? 1 : 0;
+        __atomic_store_n(&event->in_use, 2, __ATOMIC_RELEASE);
+        return AEGIS_ERROR_OK;
+    }
+
+    return AEGIS_ERROR_OUT_OF_MEMORY;
+}
+
+int aegis_event_set(const char *event_name)
+{
+    if (!event_name) return AEGIS_ERROR_INVALID_PARAM;
+
+    aegis_event_slot_t *event = aegis_event_find(event_name);
+    if (!event) return AEGIS_ERROR_NOT_FOUND;
+
+    __atomic_store_n(&event->state, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&event->state, event->manual_reset ? (uint32_t)-1 : 1);
+    return AEGIS_ERROR_OK;
+}
+
+int aegis_event_clear(const char *event_name)
+{
+    if (!event_name) return AEGIS_ERROR_INVALID_PARAM;
+
+    aegis_event_slot_t *event = aegis_event_find(event_name);
+    if (!event) return AEGIS_ERROR_NOT_FOUND;
+
+    __atomic_store_n(&event->state, 0, __ATOMIC_RELEASE);
+    return AEGIS_ERROR_OK;
+}
+
+/*
+ * Manual-reset events release every waiter and stay signalled until
+ * cleared; auto-reset events hand the signal to exactly one waiter.
+ */
+int aegis_event_wait(const char *event_name, uint32_t timeout_ms)
+{
+    if (!event_name) return AEGIS_ERROR_INVALID_PARAM;
+
+    aegis_event_slot_t *event = aegis_event_find(event_name);
+    if (!event) return AEGIS_ERROR_NOT_FOUND;
+
+    uint64_t deadline = 0;
+    if (timeout_ms != AEGIS_TIMEOUT_INFINITE) {
+        deadline = wait_queue_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    }
+
+    for (;;) {
+        if (event->manual_reset) {
+            if (__atomic_load_n(&event->state, __ATOMIC_ACQUIRE)) return AEGIS_ERROR_OK;
+        } else {
+            uint32_t expected = 1;
+            if (__atomic_compare_exchange_n(&event->state, &expected, 0, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                return AEGIS_ERROR_OK;
+            }
+        }
+
+        uint64_t remaining = 0;
+        if (deadline) {
+            uint64_t now = wait_queue_now_ns();
+            if (now >= deadline) return AEGIS_ERROR_TIMEOUT;
+            remaining = deadline - now;
+        }
+
+        futex_wait(&event->state, 0, NULL, remaining);
+    }
+}
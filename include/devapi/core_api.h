@@ -6,6 +6,9 @@
 #define AEGIS_MAX_PROCESS_NAME 64
 #define AEGIS_MAX_THREAD_NAME 32
 #define AEGIS_MAX_ERROR_MSG 256
+#define AEGIS_MAX_EVENT_NAME 64
+#define AEGIS_MAX_EVENTS 64
+#define AEGIS_TIMEOUT_INFINITE 0xFFFFFFFFu
 
 typedef uint32_t aegis_pid_t;
 typedef uint32_t aegis_tid_t;
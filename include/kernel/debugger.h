@@ -93,6 +93,9 @@ int debugger_set_register(const char *reg_name, u64 value);
 stack_frame_t *debugger_get_call_stack(u32 *depth);
 int debugger_print_stack_trace(void);
 int debugger_set_symbol_table(const char *symbol_file);
+int debugger_add_symbol(u64 address, u64 size, const char *name);
+const char *debugger_lookup_symbol(u64 address, u64 *offset);
+void debugger_clear_symbols(void);
 
 int debugger_attach_process(u64 pid);
 int debugger_detach_process(void);
@@ -2,6 +2,9 @@
 #define AEGIS_KERNEL_DRIVER_H
 
 #include <kernel/types.h>
+#include <kernel/rcu.h>
+
+#define DRIVER_MAX_DRIVERS 256
 
 typedef enum {
     DRIVER_TYPE_STORAGE,
@@ -46,6 +49,7 @@ typedef struct {
     int (*remove)(void *dev);
     int (*suspend)(void *dev);
     int (*resume)(void *dev);
+    rcu_head_t rcu;
 } driver_t;
 
 typedef struct {
@@ -0,0 +1,53 @@
+#ifndef AEGIS_KERNEL_EVENT_FILTER_H
+#define AEGIS_KERNEL_EVENT_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EVENT_FILTER_MAX_INSNS 32
+#define EVENT_FILTER_MAX_STACK 16
+
+typedef enum {
+    EVENT_FILTER_OP_IMM,
+    EVENT_FILTER_OP_FIELD,
+    EVENT_FILTER_OP_EQ,
+    EVENT_FILTER_OP_NE,
+    EVENT_FILTER_OP_LT,
+    EVENT_FILTER_OP_LE,
+    EVENT_FILTER_OP_GT,
+    EVENT_FILTER_OP_GE,
+    EVENT_FILTER_OP_BITAND,
+    EVENT_FILTER_OP_AND,
+    EVENT_FILTER_OP_OR,
+    EVENT_FILTER_OP_NOT
+} event_filter_op_t;
+
+typedef enum {
+    EVENT_FIELD_TYPE,
+    EVENT_FIELD_ID,
+    EVENT_FIELD_TIMESTAMP,
+    EVENT_FIELD_SOURCE,
+    EVENT_FIELD_SIZE,
+    EVENT_FIELD_DATA8,
+    EVENT_FIELD_DATA16,
+    EVENT_FIELD_DATA32
+} event_field_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t field;
+    uint16_t offset;
+    int64_t imm;
+} event_filter_insn_t;
+
+typedef struct {
+    uint32_t length;
+    event_filter_insn_t insns[EVENT_FILTER_MAX_INSNS];
+} event_filter_t;
+
+struct kernel_event;
+
+int event_filter_compile(const char *expr, event_filter_t *filter);
+bool event_filter_match(const event_filter_t *filter, const struct kernel_event *event);
+
+#endif
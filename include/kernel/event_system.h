@@ -2,6 +2,8 @@
 #define AEGIS_KERNEL_EVENT_SYSTEM_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <kernel/event_filter.h>
 
 #define MAX_EVENT_TYPES 256
 
@@ -20,23 +22,102 @@
 #define EVENT_SYSCALL_ENTER     12
 #define EVENT_SYSCALL_EXIT      13
 
-typedef struct {
+#define EVENT_ASYNC_QUEUE_DEPTH 64
+#define EVENT_MAX_WORKERS       16
+#define EVENT_WORKER_BATCH      16
+
+typedef struct kernel_event {
     uint32_t event_type;
     uint32_t event_id;
     uint32_t timestamp;
     int source_id;
     uint8_t data[256];
     uint32_t data_size;
+    uint32_t coalesced_count;   /* events merged into this delivery (coalescing subscribers) */
 } kernel_event_t;
 
 typedef int (*event_callback_t)(const kernel_event_t *event, void *context);
 
+typedef enum {
+    EVENT_DELIVERY_SYNC,
+    EVENT_DELIVERY_ASYNC
+} event_delivery_t;
+
+typedef enum {
+    EVENT_BACKPRESSURE_DROP_OLDEST,
+    EVENT_BACKPRESSURE_BLOCK,
+    EVENT_BACKPRESSURE_COALESCE
+} event_backpressure_t;
+
+typedef struct {
+    uint64_t bits[MAX_EVENT_TYPES / 64];
+} event_mask_t;
+
+static inline void event_mask_set(event_mask_t *mask, uint32_t event_type)
+{
+    mask->bits[event_type / 64] |= 1ULL << (event_type % 64);
+}
+
+static inline void event_mask_clear(event_mask_t *mask, uint32_t event_type)
+{
+    mask->bits[event_type / 64] &= ~(1ULL << (event_type % 64));
+}
+
+static inline bool event_mask_test(const event_mask_t *mask, uint32_t event_type)
+{
+    return (mask->bits[event_type / 64] >> (event_type % 64)) & 1;
+}
+
+/*
+ * 'filter' is a compiled event_filter_t evaluated before any delivery work;
+ * it is copied at subscribe time. A non-zero 'coalesce_window_ns' merges a
+ * burst of same-type events into one delivery of the newest event, with
+ * coalesced_count set to the burst size, once the window has elapsed.
+ */
+typedef struct {
+    event_delivery_t delivery;
+    event_backpressure_t backpressure;
+    uint32_t queue_depth;
+    const event_filter_t *filter;
+    uint64_t coalesce_window_ns;
+} event_subscription_opts_t;
+
+typedef struct {
+    uint64_t enqueued;
+    uint64_t delivered;
+    uint64_t dropped;
+    uint64_t coalesced;
+    uint64_t blocked;
+    uint64_t filtered;
+    uint64_t bursts;
+    uint32_t queued;
+    uint32_t max_queued;
+    uint64_t total_lag_ns;
+    uint64_t max_lag_ns;
+} event_subscriber_stats_t;
+
 void event_system_init(void);
 
 int event_subscribe(int subscriber_id, uint32_t event_type, event_callback_t callback, void *context);
 
+int event_subscribe_ex(int subscriber_id, uint32_t event_type, event_callback_t callback,
+                       void *context, const event_subscription_opts_t *opts);
+
+int event_subscribe_mask(int subscriber_id, const event_mask_t *mask, event_callback_t callback,
+                         void *context, const event_subscription_opts_t *opts);
+
 int event_unsubscribe(int subscriber_id, uint32_t event_type);
 
+int event_get_subscriber_stats(int subscriber_id, uint32_t event_type, event_subscriber_stats_t *stats);
+
+int event_dispatch_start(uint32_t workers);
+
+void event_dispatch_stop(void);
+
+int event_dispatch_drain(void);
+
+void event_dispatch_flush(void);
+
 int event_publish(const kernel_event_t *event);
 
 uint32_t event_get_count(uint32_t event_type);
@@ -2,6 +2,9 @@
 #define AEGIS_KERNEL_FILESYSTEM_H
 
 #include <kernel/types.h>
+#include <kernel/memory.h>
+
+#define AEGISFS_MAX_BLOCKS 256
 
 typedef enum {
     INODE_TYPE_FILE,
@@ -55,6 +58,8 @@ inode_t *aegisfs_create_file(const char *path, u32 mode);
 int aegisfs_delete_file(const char *path);
 int aegisfs_write(inode_t *inode, u64 offset, const void *data, u64 size);
 int aegisfs_read(inode_t *inode, u64 offset, void *data, u64 size);
+page_buffer_t *aegisfs_get_page(inode_t *inode, u64 block);
+int aegisfs_attach_page(inode_t *inode, u64 block, page_buffer_t *page, u32 length);
 transaction_t *aegisfs_begin_transaction(void);
 int aegisfs_commit_transaction(transaction_t *txn);
 int aegisfs_rollback_transaction(transaction_t *txn);
@@ -0,0 +1,17 @@
+#ifndef AEGIS_KERNEL_FUTEX_H
+#define AEGIS_KERNEL_FUTEX_H
+
+#include <kernel/types.h>
+#include <kernel/process.h>
+#include <kernel/wait_queue.h>
+
+#define FUTEX_HASH_BUCKETS 256
+
+#define FUTEX_EAGAIN    (-11)
+#define FUTEX_ETIMEDOUT WAIT_QUEUE_TIMEOUT
+
+int futex_init(void);
+int futex_wait(u32 *addr, u32 expected, thread_t *thread, u64 timeout_ns);
+int futex_wake(u32 *addr, u32 count);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef AEGIS_KERNEL_HDR_HISTOGRAM_H
+#define AEGIS_KERNEL_HDR_HISTOGRAM_H
+
+#include <kernel/types.h>
+
+/*
+ * Log-linear ("HDR") histogram. Values below 2^HDR_SUB_BITS get a bucket
+ * each; above that every power of two is split into 2^HDR_SUB_BITS equal
+ * buckets, so a bucket is never wider than 1/32 of the values it holds.
+ * Values of 2^HDR_MAX_BITS and up share the last bucket; 'max' stays exact.
+ */
+#define HDR_SUB_BITS   5
+#define HDR_SUB_COUNT  (1U << HDR_SUB_BITS)
+#define HDR_MAX_BITS   32
+#define HDR_BUCKETS    ((HDR_MAX_BITS - HDR_SUB_BITS + 1) * HDR_SUB_COUNT)
+
+typedef struct {
+    u64 count;
+    u64 sum;
+    u64 max;
+    u32 buckets[HDR_BUCKETS];
+} hdr_hist_t;
+
+/* One histogram per CPU, recorded locally and merged on read. */
+typedef struct {
+    u32 nr_cpus;
+    hdr_hist_t cpu[];
+} hdr_percpu_hist_t;
+
+static inline u32 hdr_bucket(u64 value)
+{
+    if (value >= (1ULL << HDR_MAX_BITS)) return HDR_BUCKETS - 1;
+
+    u32 msb = 63 - (u32)__builtin_clzll(value | 1);
+    u32 shift = msb > HDR_SUB_BITS ? msb - HDR_SUB_BITS : 0;
+
+    return shift * HDR_SUB_COUNT + (u32)(value >> shift);
+}
+
+/* Safe against concurrent recorders, including from interrupt context. */
+static inline void hdr_hist_record(hdr_hist_t *hist, u64 value)
+{
+    __atomic_add_fetch(&hist->buckets[hdr_bucket(value)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->sum, value, __ATOMIC_RELAXED);
+
+    u64 old = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+    while (value > old &&
+           !__atomic_compare_exchange_n(&hist->max, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void hdr_hist_reset(hdr_hist_t *hist);
+void hdr_hist_merge(hdr_hist_t *dst, const hdr_hist_t *src);
+u64 hdr_bucket_upper(u32 bucket);
+
+/* Value at 'per_mille' thousandths (500 = p50, 999 = p99.9), capped at the max. */
+u64 hdr_hist_quantile(const hdr_hist_t *hist, u32 per_mille);
+
+hdr_percpu_hist_t *hdr_percpu_alloc(void);
+void hdr_percpu_free(hdr_percpu_hist_t *hist);
+void hdr_percpu_record(hdr_percpu_hist_t *hist, u64 value);
+void hdr_percpu_merge(const hdr_percpu_hist_t *hist, hdr_hist_t *out);
+void hdr_percpu_reset(hdr_percpu_hist_t *hist);
+
+#endif
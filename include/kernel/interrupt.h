@@ -2,25 +2,101 @@
 #define AEGIS_KERNEL_INTERRUPT_H
 
 #include <kernel/types.h>
+#include <kernel/wait_queue.h>
+#include <kernel/kthread.h>
+
+#define IED_EVENT_QUEUE_SIZE     1024
+#define IED_EVENT_BATCH          64
+#define IED_SOFTIRQ_BUDGET_NS    2000000ULL
+#define IED_SOFTIRQ_MAX_RESTART  10
+#define IED_AFFINITY_CPUS        32
+#define IED_AFFINITY_ALL         0xFFFFFFFFU
 
 typedef enum {
     IRQ_TYPE_LEVEL,
     IRQ_TYPE_EDGE
 } irq_type_t;
 
+/*
+ * Primary (hardirq) handlers return IRQ_WAKE_THREAD to push the rest of the
+ * work to the IRQ's thread. Level-triggered lines stay masked until the
+ * thread handler has finished.
+ */
+typedef enum {
+    IRQ_NONE,
+    IRQ_HANDLED,
+    IRQ_WAKE_THREAD
+} irq_return_t;
+
+typedef irq_return_t (*irq_primary_handler_t)(u32 irq, void *dev_id);
+typedef void (*irq_thread_handler_t)(u32 irq, void *dev_id);
+
 typedef struct {
     u32 irq;
     irq_handler_t handler;
     void *dev_id;
     irq_type_t type;
+    irq_primary_handler_t primary;
+    irq_thread_handler_t thread_fn;
+    kthread_t *thread;
+    wait_queue_t thread_wait;
+    wait_queue_t thread_done;
+    u32 thread_pending;
+    u32 thread_running;
+    u32 thread_exit;
+    u32 masked;
+    u32 cpu;
+    u32 affinity;
 } irq_descriptor_t;
 
 typedef struct {
     u32 irq;
     u64 count;
     u64 last_handled;
+    u64 hardirq_ns;
+    u64 max_hardirq_ns;
+    u64 thread_count;
+    u64 thread_ns;
+    u64 max_thread_ns;
+    u64 unhandled;
+    u64 masked;
 } irq_stat_t;
 
+typedef enum {
+    SOFTIRQ_HI,
+    SOFTIRQ_TIMER,
+    SOFTIRQ_NET_TX,
+    SOFTIRQ_NET_RX,
+    SOFTIRQ_BLOCK,
+    SOFTIRQ_EVENT,
+    SOFTIRQ_TASKLET,
+    NR_SOFTIRQS
+} softirq_nr_t;
+
+typedef void (*softirq_action_t)(u32 cpu);
+
+#define TASKLET_STATE_SCHED 0x1
+#define TASKLET_STATE_RUN   0x2
+
+typedef struct tasklet {
+    struct tasklet *next;
+    u32 state;
+    void (*func)(void *data);
+    void *data;
+} tasklet_t;
+
+typedef struct {
+    u64 irqs;
+    u64 softirq_runs;
+    u64 softirq_ns;
+    u64 softirq_restarts;
+    u64 softirq_deferred;
+    u64 tasklets;
+} ied_cpu_stats_t;
+
+/* Arch hook that routes 'irq' to the CPUs in 'cpu_mask' (e.g. GIC targets). */
+typedef int (*ied_affinity_hook_t)(u32 irq, u32 cpu_mask);
+
 typedef enum {
     EVENT_TYPE_TIMER,
     EVENT_TYPE_IO,
@@ -36,21 +112,39 @@ typedef struct {
 } event_t;
 
 typedef struct {
-    event_t *events[1024];
+    event_t *events[IED_EVENT_QUEUE_SIZE];
     u32 event_count;
     u32 head, tail;
 } event_queue_t;
 
 int ied_init(void);
 int ied_register_irq(u32 irq, irq_handler_t handler, void *dev_id, irq_type_t type);
+int ied_request_threaded_irq(u32 irq, irq_primary_handler_t handler, irq_thread_handler_t thread_fn,
+                             void *dev_id, irq_type_t type);
 int ied_unregister_irq(u32 irq);
 int ied_enable_irq(u32 irq);
 int ied_disable_irq(u32 irq);
 int ied_dispatch_irq(u32 irq);
+int ied_dispatch_irq_on(u32 cpu, u32 irq);
+int ied_synchronize_irq(u32 irq);
+u32 ied_current_cpu(void);
+int ied_open_softirq(u32 nr, softirq_action_t action);
+int ied_raise_softirq(u32 cpu, u32 nr);
+int ied_do_softirq(u32 cpu);
+void ied_tasklet_init(tasklet_t *tasklet, void (*func)(void *data), void *data);
+int ied_tasklet_schedule(tasklet_t *tasklet);
 int ied_post_event(event_t *event);
 event_t *ied_get_event(void);
 int ied_process_events(void);
 int ied_set_irq_affinity(u32 irq, u32 cpu_mask);
+int ied_get_irq_affinity(u32 irq, u32 *cpu_mask, u32 *cpu);
+int ied_set_irq_cpu(u32 irq, u32 cpu);
+void ied_set_affinity_hook(ied_affinity_hook_t hook);
+void ied_set_isolated_cpus(u32 cpu_mask);
+u32 ied_get_isolated_cpus(void);
+int ied_parse_cpulist(const char *list, u32 *cpu_mask);
 u64 ied_get_irq_stat(u32 irq);
+int ied_get_irq_stats(u32 irq, irq_stat_t *stats);
+int ied_get_cpu_stats(u32 cpu, ied_cpu_stats_t *stats);
 
 #endif
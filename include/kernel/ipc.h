@@ -2,6 +2,31 @@
 #define AEGIS_KERNEL_IPC_H
 
 #include <kernel/types.h>
+#include <kernel/memory.h>
+#include <kernel/process.h>
+#include <kernel/filesystem.h>
+#include <kernel/network.h>
+#include <kernel/wait_queue.h>
+
+#define IPC_GRANT_READ  (1 << 0)
+#define IPC_GRANT_WRITE (1 << 1)
+#define IPC_GRANT_MOVE  (1 << 2)
+
+#define IPC_GRANT_WINDOW_BASE 0x0000600000000000UL
+#define IPC_MAX_SHM_ATTACHMENTS 1024
+
+#define IPC_PIPE_DEFAULT_PAGES 16
+#define IPC_PIPE_NONBLOCK (1 << 0)
+
+#define IPC_POLL_IN  (1 << 0)
+#define IPC_POLL_OUT (1 << 1)
+#define IPC_POLL_HUP (1 << 2)
+
+#define IPC_EAGAIN (-11)
+#define IPC_EPIPE  (-32)
+#define IPC_ETIMEDOUT WAIT_QUEUE_TIMEOUT
+
+#define IPC_SEM_SPIN_MAX 200
 
 typedef enum {
     IPC_TYPE_MESSAGE,
@@ -20,6 +45,14 @@ typedef struct {
     u64 timestamp;
 } message_t;
 
+typedef struct {
+    page_buffer_t *page;
+    u32 offset;
+    u32 len;
+} ipc_pipe_buffer_t;
+
+typedef void (*ipc_pipe_notify_t)(u64 pipe_id, u32 events, void *context);
+
 typedef struct {
     u64 id;
     ipc_type_t type;
@@ -29,9 +62,17 @@ typedef struct {
     union {
         message_t msg;
         struct {
-            u8 *buffer;
-            u64 read_pos, write_pos;
-            u64 size;
+            ipc_pipe_buffer_t *slots;
+            u32 slot_count;
+            u32 head, tail;
+            u64 bytes;
+            u32 flags;
+            spinlock_t lock;
+            bool reader_closed, writer_closed;
+            ipc_pipe_notify_t notify;
+            void *notify_context;
+            wait_queue_t readers;
+            wait_queue_t writers;
         } pipe;
         struct {
             void *memory;
@@ -41,10 +82,34 @@ typedef struct {
         struct {
             u32 value;
             u32 owner_pid;
+            u32 waiters;
+            u32 spin_hint;
         } sem;
     } data;
 } ipc_object_t;
 
+#define IPC_FASTPATH_MRS 6
+
+typedef struct {
+    u64 label;
+    u64 mr[IPC_FASTPATH_MRS];
+    u32 length;
+} ipc_fastpath_msg_t;
+
+typedef int (*ipc_endpoint_handler_t)(thread_t *server, ipc_fastpath_msg_t *msg, void *context);
+
+typedef struct {
+    u64 id;
+    thread_t *server;
+    thread_t *caller;
+    ipc_endpoint_handler_t handler;
+    void *context;
+    u32 server_priority;
+    u64 fastpath_calls;
+    u64 failed_calls;
+    u64 total_cycles;
+} ipc_endpoint_t;
+
 typedef struct {
     u64 id;
     int signum;
@@ -59,14 +124,37 @@ message_t *ipc_receive_message(ipc_object_t *obj, u64 timeout);
 ipc_object_t *ipc_create_pipe(u64 src_pid, u64 dst_pid);
 int ipc_write_pipe(ipc_object_t *obj, const void *data, u64 size);
 int ipc_read_pipe(ipc_object_t *obj, void *data, u64 max_size);
+ipc_object_t *ipc_create_pipe_ex(u64 src_pid, u64 dst_pid, u64 capacity, u32 flags);
+int ipc_destroy_pipe(ipc_object_t *obj);
+int ipc_pipe_set_nonblocking(ipc_object_t *obj, bool nonblocking);
+int ipc_pipe_set_notify(ipc_object_t *obj, ipc_pipe_notify_t notify, void *context);
+u32 ipc_pipe_poll(ipc_object_t *obj);
+int ipc_pipe_close_reader(ipc_object_t *obj);
+int ipc_pipe_close_writer(ipc_object_t *obj);
+int ipc_splice_from_file(ipc_object_t *obj, inode_t *inode, u64 offset, u64 size);
+int ipc_splice_to_file(ipc_object_t *obj, inode_t *inode, u64 offset, u64 size);
+int ipc_splice_to_socket(ipc_object_t *obj, socket_t *sock, u64 size);
 ipc_object_t *ipc_create_shared_memory(u64 owner_pid, u64 size);
 void *ipc_attach_shared_memory(ipc_object_t *obj, u64 pid);
 int ipc_detach_shared_memory(ipc_object_t *obj);
+int ipc_destroy_shared_memory(ipc_object_t *obj);
+int ipc_map_shared_memory(ipc_object_t *obj, u64 pid, u32 rights, u64 *virt_addr);
+int ipc_unmap_shared_memory(ipc_object_t *obj, u64 pid, u64 virt_addr);
+int ipc_grant_pages(address_space_t *src, u64 src_virt, address_space_t *dst,
+                    u64 *dst_virt, u32 page_count, u32 flags);
+int ipc_revoke_grant(address_space_t *as, u64 virt_addr, u32 page_count);
 ipc_object_t *ipc_create_semaphore(u32 initial_value);
 int ipc_semaphore_wait(ipc_object_t *obj);
+int ipc_semaphore_timed_wait(ipc_object_t *obj, u64 timeout_ns);
+int ipc_semaphore_try_wait(ipc_object_t *obj);
 int ipc_semaphore_signal(ipc_object_t *obj);
 int ipc_register_signal_handler(int signum, void (*handler)(int), u64 pid);
 int ipc_send_signal(u64 target_pid, int signum);
 int ipc_enforce_process_boundary(u64 src_pid, u64 dst_pid);
+ipc_endpoint_t *ipc_endpoint_create(ipc_endpoint_handler_t handler, void *context);
+void ipc_endpoint_destroy(ipc_endpoint_t *ep);
+int ipc_reply_wait(ipc_endpoint_t *ep, thread_t *server);
+int ipc_call(ipc_endpoint_t *ep, thread_t *caller, ipc_fastpath_msg_t *msg);
+u64 ipc_endpoint_get_average_cycles(ipc_endpoint_t *ep);
 
 #endif
@@ -19,6 +19,8 @@ typedef struct {
     uint32_t timestamp;
 } ipc_message_t;
 
+typedef void (*ipc_bus_notify_t)(int dest_id, int queued, void *context);
+
 void ipc_bus_init(void);
 
 int ipc_bus_register_route(int source_id, int dest_id, int priority);
@@ -27,6 +29,14 @@ int ipc_bus_send_message(const ipc_message_t *msg);
 
 int ipc_bus_receive_message(int dest_id, ipc_message_t *msg);
 
+int ipc_bus_send_batch(const ipc_message_t *msgs, int count);
+
+int ipc_bus_receive_batch(int dest_id, ipc_message_t *msgs, int max_count);
+
+int ipc_bus_set_notify(int dest_id, ipc_bus_notify_t notify, void *context);
+
+uint32_t ipc_bus_get_wakeups(int dest_id);
+
 int ipc_bus_get_queue_size(int dest_id);
 
 uint32_t ipc_bus_get_dropped_messages(int dest_id);
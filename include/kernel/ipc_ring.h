@@ -0,0 +1,40 @@
+#ifndef AEGIS_KERNEL_IPC_RING_H
+#define AEGIS_KERNEL_IPC_RING_H
+
+#include <kernel/types.h>
+#include <kernel/ipc.h>
+
+#define IPC_RING_MAGIC 0x52494E47
+
+typedef struct {
+    u32 magic;
+    u32 flags;
+    u64 capacity;
+    u64 head __attribute__((aligned(64)));
+    u64 tail __attribute__((aligned(64)));
+} __attribute__((aligned(64))) ipc_ring_header_t;
+
+#define IPC_RING_HEADER_SIZE sizeof(ipc_ring_header_t)
+
+typedef struct {
+    ipc_object_t *shm;
+    ipc_ring_header_t *header;
+    u8 *data;
+    u64 mask;
+    u64 pid;
+    u64 virt_addr;
+    bool owner;
+} ipc_ring_t;
+
+ipc_ring_t *ipc_ring_create(u64 owner_pid, u64 capacity);
+ipc_ring_t *ipc_ring_attach(ipc_object_t *shm, u64 pid);
+void ipc_ring_destroy(ipc_ring_t *ring);
+void *ipc_ring_reserve(ipc_ring_t *ring, u64 size, u64 *granted);
+void ipc_ring_commit(ipc_ring_t *ring, u64 size);
+const void *ipc_ring_peek(ipc_ring_t *ring, u64 *available);
+void ipc_ring_consume(ipc_ring_t *ring, u64 size);
+u64 ipc_ring_write(ipc_ring_t *ring, const void *data, u64 size);
+u64 ipc_ring_read(ipc_ring_t *ring, void *data, u64 max_size);
+u64 ipc_ring_used(ipc_ring_t *ring);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef AEGIS_KERNEL_IRQ_BALANCE_H
+#define AEGIS_KERNEL_IRQ_BALANCE_H
+
+#include <kernel/types.h>
+#include <kernel/interrupt.h>
+
+#define IRQ_BALANCE_INTERVAL_NS  1000000000ULL
+#define IRQ_BALANCE_NO_CONSUMER  0xFFFFFFFFU
+
+/*
+ * nr_cpus: CPUs eligible for interrupts (at most IED_AFFINITY_CPUS).
+ * cluster_size: CPUs sharing a last-level cache; an IRQ with a consumer
+ * stays in the consumer's cluster unless that would leave it clearly more
+ * loaded than the rest of the system.
+ * min_rate: IRQs slower than this (per second) are left where they are.
+ */
+typedef struct {
+    u32 nr_cpus;
+    u32 cluster_size;
+    u64 min_rate;
+    u64 interval_ns;
+} irq_balance_config_t;
+
+typedef struct {
+    u32 nr_cpus;
+    u32 hot_irqs;
+    u32 moved;
+    u64 elapsed_ns;
+    u64 load_before[IED_AFFINITY_CPUS];
+    u64 load_after[IED_AFFINITY_CPUS];
+} irq_balance_report_t;
+
+int irq_balance_init(const irq_balance_config_t *config);
+int irq_balance_set_consumer(u32 irq, u32 cpu);
+int irq_balance_run(irq_balance_report_t *report);
+int irq_balance_start(void);
+void irq_balance_stop(void);
+int irq_balance_get_last_report(irq_balance_report_t *report);
+void irq_balance_print_report(const irq_balance_report_t *report);
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef AEGIS_KERNEL_KSYM_H
+#define AEGIS_KERNEL_KSYM_H
+
+#include <kernel/types.h>
+
+/*
+ * Kernel symbol table shared by the debugger, panic traces and the
+ * profiler. ksymgen writes it at build time next to the kernel image as
+ * <image>.ksym: a header, the function symbols sorted by address, the
+ * inlined ranges sorted by address and one string table. It is mapped
+ * read-only on the first lookup; until something else is loaded, that
+ * first lookup tries "/proc/self/exe.ksym".
+ *
+ * Symbols added at run time live in a second sorted table; a lookup
+ * searches both.
+ */
+#define KSYM_MAGIC       "AEGKSYM"
+#define KSYM_VERSION     1
+#define KSYM_MAX_SPAN    0x10000    /* reach of a symbol with no size */
+#define KSYM_MAX_INLINE  8
+#define KSYM_CACHE_SIZE  256        /* per-thread lookup cache entries */
+
+typedef struct {
+    char magic[8];
+    u32 version;
+    u32 symbol_count;
+    u32 inline_count;
+    u32 names_size;
+    u64 reserved;
+} ksym_file_hdr_t;
+
+/* Addresses are link-time; the running image's load bias is added on lookup. */
+typedef struct {
+    u64 address;
+    u32 size;
+    u32 name;       /* offset into the string table */
+} ksym_entry_t;
+
+typedef struct {
+    u64 address;
+    u32 size;
+    u32 name;
+    u32 depth;      /* 1 when inlined straight into the function */
+    u32 reserved;
+} ksym_inline_t;
+
+/* A symbol as ksymgen collects it; depth 0 is a function. */
+typedef struct {
+    u64 address;
+    u64 size;
+    u32 depth;
+    char *name;
+} ksym_symbol_t;
+
+typedef struct {
+    u64 lookups;
+    u64 cache_hits;
+    u32 symbols;    /* mapped plus run-time symbols */
+    u32 inlines;
+} ksym_stats_t;
+
+/*
+ * Use the table at 'path' from the next lookup on. Only the header is
+ * read now. Returns its symbol count, or -1 if it is not a symbol table.
+ */
+int ksym_load(const char *path);
+
+int ksym_add(u64 address, u64 size, const char *name);
+void ksym_clear(void);
+
+/*
+ * Name of the function containing 'address' and the offset into it, or
+ * NULL. A symbol with no size reaches up to KSYM_MAX_SPAN bytes.
+ */
+const char *ksym_lookup(u64 address, u64 *offset);
+
+/*
+ * Fill 'names' with the functions inlined at 'address', innermost first,
+ * followed by the containing function. Returns how many were filled.
+ */
+u32 ksym_lookup_inline(u64 address, const char **names, u32 max);
+
+void ksym_get_stats(ksym_stats_t *stats);
+
+/*
+ * Parse one line of 'nm -n [-S]' output. Returns true for a text symbol
+ * (T/t/W/w) and fills in its address, size and name.
+ */
+bool ksym_parse_nm(const char *line, u64 *address, u64 *size, char *name, size_t name_size);
+
+/* Sort 'symbols' in place and write them as a table. Returns 0 or -1. */
+int ksym_write(const char *path, ksym_symbol_t *symbols, u32 count);
+
+#endif
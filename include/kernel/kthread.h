@@ -0,0 +1,24 @@
+#ifndef AEGIS_KERNEL_KTHREAD_H
+#define AEGIS_KERNEL_KTHREAD_H
+
+#include <kernel/types.h>
+
+#define KTHREAD_NAME_LEN 32
+
+typedef int (*kthread_fn_t)(void *arg);
+
+typedef struct kthread {
+    char name[KTHREAD_NAME_LEN];
+    kthread_fn_t fn;
+    void *arg;
+    u32 should_stop;
+    int exit_code;
+    void *handle;
+} kthread_t;
+
+kthread_t *kthread_run(const char *name, kthread_fn_t fn, void *arg);
+int kthread_stop(kthread_t *kthread);
+bool kthread_should_stop(kthread_t *kthread);
+kthread_t *kthread_current(void);
+
+#endif
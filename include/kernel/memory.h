@@ -31,8 +31,11 @@ typedef struct {
     u64 size;
     prot_flags_t prot;
     bool encrypted;
+    bool shared;
 } vma_t;
 
+#define MMGR_MAX_VMAS 1024
+
 typedef struct {
     u64 pid;
     void *page_table;
@@ -44,6 +47,11 @@ typedef struct {
     u64 stack_end;
 } address_space_t;
 
+typedef struct {
+    u8 *data;
+    u32 ref_count;
+} page_buffer_t;
+
 int mmgr_init(void);
 void *mmgr_alloc_page(void);
 void mmgr_free_page(void *page);
@@ -60,6 +68,12 @@ int mmgr_enable_aslr(address_space_t *as);
 int mmgr_encrypt_page(void *page);
 int mmgr_decrypt_page(void *page);
 u64 mmgr_get_phys_addr(address_space_t *as, u64 virt_addr);
+vma_t *mmgr_find_vma(address_space_t *as, u64 virt_addr);
+int mmgr_page_ref(u64 phys_addr);
+int mmgr_page_unref(u64 phys_addr);
+page_buffer_t *mmgr_page_buffer_alloc(void);
+void mmgr_page_buffer_get(page_buffer_t *page);
+void mmgr_page_buffer_put(page_buffer_t *page);
 int mmgr_secure_zero(void *ptr, size_t size);
 
 #endif
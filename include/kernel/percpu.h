@@ -0,0 +1,78 @@
+#ifndef AEGIS_KERNEL_PERCPU_H
+#define AEGIS_KERNEL_PERCPU_H
+
+#include <kernel/types.h>
+
+/*
+ * Static per-CPU variables live in the "percpu" section. Until percpu_init()
+ * runs every CPU aliases that boot copy; afterwards each CPU owns a copy
+ * starting on its own cache line and the boot copy is no longer touched.
+ * Secondary copies start zeroed, so DEFINE_PER_CPU takes no initializer.
+ *
+ * Host threads can share a CPU id, so updates are relaxed atomics. They
+ * stay cheap because each CPU's line is only ever written by that CPU.
+ */
+#define DEFINE_PER_CPU(type, name) \
+    __attribute__((section("percpu"))) __typeof__(type) name
+
+#define DECLARE_PER_CPU(type, name) \
+    extern __typeof__(type) name
+
+extern char __start_percpu[] __attribute__((weak));
+extern char __stop_percpu[] __attribute__((weak));
+
+extern char *percpu_base;
+extern size_t percpu_stride;
+extern u32 percpu_nr;
+extern __thread u32 percpu_cpu;
+
+static inline void *percpu_ptr_of(void *ptr, u32 cpu)
+{
+    char *base = __atomic_load_n(&percpu_base, __ATOMIC_ACQUIRE);
+
+    if (!base) return ptr;
+    return base + (size_t)(cpu % percpu_nr) * percpu_stride + ((char *)ptr - __start_percpu);
+}
+
+static inline u32 percpu_current_cpu(void)
+{
+    return percpu_cpu;
+}
+
+static inline u32 percpu_nr_cpus(void)
+{
+    return __atomic_load_n(&percpu_base, __ATOMIC_ACQUIRE) ? percpu_nr : 1;
+}
+
+#define per_cpu_ptr(var, cpu) ((__typeof__(&(var)))percpu_ptr_of((void *)&(var), (cpu)))
+#define this_cpu_ptr(var)     per_cpu_ptr(var, percpu_current_cpu())
+#define per_cpu(var, cpu)     (*per_cpu_ptr(var, cpu))
+
+#define for_each_possible_cpu(cpu) \
+    for (u32 cpu = 0; cpu < percpu_nr_cpus(); cpu++)
+
+#define per_cpu_add(var, cpu, val) \
+    __atomic_add_fetch(per_cpu_ptr(var, cpu), (val), __ATOMIC_RELAXED)
+#define this_cpu_add(var, val) per_cpu_add(var, percpu_current_cpu(), val)
+#define this_cpu_inc(var)      this_cpu_add(var, 1)
+
+/* Sum a per-CPU counter over every CPU; the result is not a snapshot. */
+#define per_cpu_sum(var) ({                                              \
+    __typeof__(var) __sum = 0;                                           \
+    for_each_possible_cpu(__cpu) {                                       \
+        __sum += __atomic_load_n(per_cpu_ptr(var, __cpu), __ATOMIC_RELAXED); \
+    }                                                                    \
+    __sum;                                                               \
+})
+
+#define per_cpu_reset(var) do {                                          \
+    for_each_possible_cpu(__cpu) {                                       \
+        __builtin_memset(per_cpu_ptr(var, __cpu), 0, sizeof(var));       \
+    }                                                                    \
+} while (0)
+
+int percpu_init(u32 nr_cpus);
+u32 percpu_set_current_cpu(u32 cpu);
+size_t percpu_area_size(void);
+
+#endif
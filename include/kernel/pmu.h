@@ -0,0 +1,59 @@
+#ifndef AEGIS_KERNEL_PMU_H
+#define AEGIS_KERNEL_PMU_H
+
+#include <kernel/types.h>
+
+/* Vector the local APIC's performance-counter LVT entry is routed to. */
+#define PMU_IRQ 254
+
+typedef enum {
+    PMU_EVENT_CYCLES = 0,
+    PMU_EVENT_INSTRUCTIONS,
+    PMU_EVENT_LLC_MISSES,
+    PMU_EVENT_BRANCH_MISSES,
+    PMU_EVENT_DTLB_MISSES,
+    PMU_EVENT_MAX
+} pmu_event_t;
+
+#define PMU_EVENT_BIT(event) (1U << (event))
+
+typedef struct {
+    u64 count[PMU_EVENT_MAX];
+    u32 valid;      /* PMU_EVENT_BIT() of each event that was counted */
+} pmu_counts_t;
+
+/*
+ * Per-thread counts. The counters run freely on every CPU; a context
+ * snapshots them when its thread is switched in and folds the difference
+ * into 'total' when it is switched out.
+ */
+typedef struct pmu_context {
+    pmu_counts_t total;
+    pmu_counts_t start;
+    bool running;
+} pmu_context_t;
+
+typedef void (*pmu_overflow_handler_t)(pmu_event_t event, u32 cpu, void *data);
+
+int pmu_init(void);
+bool pmu_available(void);
+u32 pmu_supported_events(void);
+const char *pmu_event_name(pmu_event_t event);
+
+int pmu_read(pmu_counts_t *counts);
+int pmu_read_cpu(u32 cpu, pmu_counts_t *counts);
+void pmu_counts_delta(const pmu_counts_t *start, const pmu_counts_t *end, pmu_counts_t *delta);
+
+void pmu_context_init(pmu_context_t *ctx);
+void pmu_switch(pmu_context_t *prev, pmu_context_t *next);
+int pmu_context_read(pmu_context_t *ctx, pmu_counts_t *counts);
+
+/*
+ * Raise PMU_IRQ every 'period' occurrences of 'event' on each CPU and
+ * call 'handler' from the interrupt. Reads of that event stay monotonic.
+ */
+int pmu_set_overflow(pmu_event_t event, u64 period, pmu_overflow_handler_t handler, void *data);
+int pmu_clear_overflow(pmu_event_t event);
+u64 pmu_overflow_count(pmu_event_t event);
+
+#endif
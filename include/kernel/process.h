@@ -3,6 +3,8 @@
 
 #include <kernel/types.h>
 
+struct pmu_context;
+
 typedef enum {
     PROCESS_STATE_NEW,
     PROCESS_STATE_READY,
@@ -40,6 +42,7 @@ typedef struct thread_s {
         x86_64_context_t x86_64;
         arm_context_t arm;
     } context;
+    struct pmu_context *pmu;    /* per-thread PMU counts, or NULL */
     struct thread_s *next;
 } thread_t;
 
@@ -4,26 +4,69 @@
 #include <stdint.h>
 #include <limits.h>
 
+#define PROFILER_MAX_PROBES   128
+#define PROFILER_NAME_LEN     32
+#define PROFILER_RING_SIZE    256
+#define PROFILER_MAX_DEPTH    16
+
+/* Interned probe ID; 0 means "no probe" and is ignored by the recorders. */
+typedef uint32_t profiler_probe_t;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t probe;
+    uint32_t duration;
+} profiler_sample_t;
+
 void profiler_init(void);
 
 uint64_t profiler_get_cpu_cycles(void);
 
+uint64_t profiler_cycles_to_ns(uint64_t cycles);
+
+profiler_probe_t profiler_probe(const char *name);
+
+profiler_probe_t profiler_probe_find(const char *name);
+
+const char *profiler_probe_name(profiler_probe_t probe);
+
+void profiler_start_id(profiler_probe_t probe);
+
+void profiler_end_id(profiler_probe_t probe);
+
+void profiler_record_id(profiler_probe_t probe, uint32_t duration);
+
+/* Record against 'name', interning it once per call site. */
+#define profiler_record(name, duration) do {                  \
+    static profiler_probe_t __probe;                          \
+    if (!__probe) __probe = profiler_probe(name);             \
+    profiler_record_id(__probe, (duration));                  \
+} while (0)
+
 void profiler_start(const char *name);
 
 void profiler_end(const char *name);
 
 void profiler_record_event(const char *name, uint32_t duration);
 
+uint32_t profiler_read_samples(uint32_t cpu, profiler_sample_t *samples, uint32_t max);
+
 void profiler_print_report(void);
 
 void profiler_clear(void);
 
+uint64_t profiler_get_count(const char *name);
+
 uint64_t profiler_get_average_duration(const char *name);
 
 uint32_t profiler_get_max_duration(const char *name);
 
 uint32_t profiler_get_min_duration(const char *name);
 
+uint64_t profiler_probe_quantile(profiler_probe_t probe, uint32_t per_mille);
+
+uint64_t profiler_get_percentile(const char *name, uint32_t per_mille);
+
 int profiler_sample_count(void);
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef AEGIS_KERNEL_RCU_H
+#define AEGIS_KERNEL_RCU_H
+
+#include <kernel/types.h>
+#include <common/list.h>
+
+#define RCU_MAX_READERS       256
+#define RCU_CALLBACK_BATCH    64
+
+typedef struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *head);
+} rcu_head_t;
+
+#define rcu_dereference(p)        __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define rcu_assign_pointer(p, v)  __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+int rcu_init(void);
+void rcu_read_lock(void);
+void rcu_read_unlock(void);
+bool rcu_read_lock_held(void);
+int synchronize_rcu(void);
+void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head));
+int rcu_barrier(void);
+u64 rcu_get_grace_periods(void);
+
+/*
+ * List updates for lists read under rcu_read_lock(). Writers still need
+ * their own mutual exclusion; a removed entry keeps its forward pointer
+ * so readers standing on it can continue, and must not be freed before a
+ * grace period has elapsed.
+ */
+static inline void rcu_list_add_tail(struct list_head *entry, struct list_head *head)
+{
+    struct list_head *prev = head->prev;
+
+    entry->next = head;
+    entry->prev = prev;
+    rcu_assign_pointer(prev->next, entry);
+    head->prev = entry;
+}
+
+static inline void rcu_list_del(struct list_head *entry)
+{
+    entry->next->prev = entry->prev;
+    rcu_assign_pointer(entry->prev->next, entry->next);
+    entry->prev = NULL;
+}
+
+#define rcu_list_for_each(pos, head) \
+    for (pos = rcu_dereference((head)->next); pos != (head); pos = rcu_dereference(pos->next))
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef AEGIS_KERNEL_SAMPLER_H
+#define AEGIS_KERNEL_SAMPLER_H
+
+#include <kernel/types.h>
+
+struct perf_buffer;
+
+#define SAMPLER_DEFAULT_HZ  1000
+#define SAMPLER_MAX_HZ      10000
+#define SAMPLER_STACK_LIMIT (8ULL << 20)
+
+typedef struct {
+    u64 samples;
+    u64 dropped;
+    u64 handler_ns;
+    u64 cpu_ns;         /* CPU time consumed while sampling */
+    u32 hz;
+    u32 overhead_ppm;   /* handler time per million ns of cpu_ns */
+} sampler_stats_t;
+
+/*
+ * Statistical profiler: a periodic per-CPU tick captures the interrupted
+ * PC and its frame-pointer chain as a PERF_EVENT_CPU_SAMPLE in 'buffer',
+ * which must be collecting. 'hz' of 0 means SAMPLER_DEFAULT_HZ. Only one
+ * sampler runs at a time.
+ */
+int sampler_start(struct perf_buffer *buffer, u32 hz);
+int sampler_stop(void);
+bool sampler_running(void);
+void sampler_get_stats(sampler_stats_t *stats);
+
+/* Walk saved frame pointers from 'fp'; stack[0] is 'pc'. Returns the depth. */
+u32 sampler_unwind(u64 pc, u64 fp, u64 sp, u64 *stack, u32 max);
+
+/*
+ * Write the buffer's CPU samples as folded stacks ("root;...;leaf count"
+ * per line), as consumed by flamegraph tools. Frames are symbolized with
+ * ksym_lookup_inline(), inlined calls included, and fall back to hex.
+ * Returns the length the full output needs, like snprintf.
+ */
+size_t sampler_export_folded(struct perf_buffer *buffer, char *out, size_t size);
+
+#endif
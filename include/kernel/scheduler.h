@@ -55,5 +55,6 @@ int scheduler_enable_energy_aware(void);
 u64 scheduler_get_cpu_load(u32 cpu_id);
 int scheduler_balance_load(void);
 void scheduler_switch_context(thread_t *prev, thread_t *next);
+void scheduler_handoff(thread_t *prev, thread_t *next);
 
 #endif
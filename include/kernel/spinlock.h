@@ -0,0 +1,124 @@
+#ifndef AEGIS_KERNEL_SPINLOCK_H
+#define AEGIS_KERNEL_SPINLOCK_H
+
+#include <kernel/types.h>
+
+#define LOCK_NAME_LEN 32
+
+struct perf_buffer;
+
+/*
+ * Optional per-lock statistics. A lock only pays for timing when it has a
+ * stats block attached and lock_stats_enable() is on; the uncontended fast
+ * path never reads the clock.
+ */
+typedef struct lock_stats {
+    char name[LOCK_NAME_LEN];
+    u64 acquisitions;
+    u64 contended;
+    u64 wait_ns;
+    u64 max_wait_ns;
+    struct lock_stats *next;
+} lock_stats_t;
+
+/* FIFO ticket lock. */
+typedef struct {
+    u32 next;
+    u32 owner;
+    lock_stats_t *stats;
+} spinlock_t;
+
+#define SPINLOCK_INIT { 0, 0, NULL }
+
+/*
+ * MCS queued lock: each waiter spins on its own on-stack node, so a hot
+ * global lock does not bounce one cache line between every waiting CPU.
+ */
+typedef struct mcs_node {
+    struct mcs_node *next;
+    u32 locked;
+} mcs_node_t;
+
+typedef struct {
+    mcs_node_t *tail;
+    lock_stats_t *stats;
+} mcs_lock_t;
+
+#define MCS_LOCK_INIT { NULL, NULL }
+
+/* Reader-writer lock; a waiting writer holds off new readers. */
+#define RWLOCK_WRITER  0x80000000U
+#define RWLOCK_WAITING 0x40000000U
+#define RWLOCK_READERS 0x3FFFFFFFU
+
+typedef struct {
+    u32 cnt;
+    spinlock_t wlock;
+    lock_stats_t *stats;
+} rwlock_t;
+
+#define RWLOCK_INIT { 0, SPINLOCK_INIT, NULL }
+
+/*
+ * Sequence lock for small read-mostly data. Readers never write shared
+ * memory; they retry if a writer ran while they were copying.
+ */
+typedef struct {
+    u32 seq;
+    spinlock_t lock;
+} seqlock_t;
+
+#define SEQLOCK_INIT { 0, SPINLOCK_INIT }
+
+void lock_spin_wait(u32 *spins);
+
+void spin_lock_init(spinlock_t *lock);
+void spin_lock(spinlock_t *lock);
+bool spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+bool spin_is_locked(spinlock_t *lock);
+
+void mcs_lock_init(mcs_lock_t *lock);
+void mcs_lock(mcs_lock_t *lock, mcs_node_t *node);
+bool mcs_trylock(mcs_lock_t *lock, mcs_node_t *node);
+void mcs_unlock(mcs_lock_t *lock, mcs_node_t *node);
+
+void rwlock_init(rwlock_t *lock);
+void read_lock(rwlock_t *lock);
+bool read_trylock(rwlock_t *lock);
+void read_unlock(rwlock_t *lock);
+void write_lock(rwlock_t *lock);
+bool write_trylock(rwlock_t *lock);
+void write_unlock(rwlock_t *lock);
+
+void seqlock_init(seqlock_t *lock);
+void write_seqlock(seqlock_t *lock);
+void write_sequnlock(seqlock_t *lock);
+
+static inline u32 read_seqbegin(seqlock_t *lock)
+{
+    u32 seq;
+    u32 spins = 0;
+
+    while ((seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE)) & 1) {
+        lock_spin_wait(&spins);
+    }
+
+    return seq;
+}
+
+static inline bool read_seqretry(seqlock_t *lock, u32 start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != start;
+}
+
+void lock_stats_init(lock_stats_t *stats, const char *name);
+void lock_stats_enable(bool enable);
+bool lock_stats_enabled(void);
+void lock_stats_reset(void);
+lock_stats_t *lock_stats_find(const char *name);
+void lock_stats_set_perf_buffer(struct perf_buffer *buffer);
+void lock_stats_print(void);
+
+#endif
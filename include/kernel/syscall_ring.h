@@ -0,0 +1,142 @@
+#ifndef AEGIS_KERNEL_SYSCALL_RING_H
+#define AEGIS_KERNEL_SYSCALL_RING_H
+
+#include <kernel/types.h>
+#include <kernel/ipc.h>
+#include <kernel/memory.h>
+#include <kernel/timer.h>
+#include <kernel/spinlock.h>
+#include <kernel/wait_queue.h>
+#include <kernel/kthread.h>
+
+#define SYSCALL_RING_MAGIC       0x53514352
+#define SYSCALL_RING_MAX_ENTRIES 4096
+#define SYSCALL_RING_MAX_FILES   64
+#define SYSCALL_RING_POLL_IDLE_NS 2000000ULL
+
+/* syscall_ring_create() flags */
+#define SYSCALL_RING_SQPOLL 0x1
+
+/* sq.flags, set by the poller while it sleeps */
+#define SYSCALL_RING_SQ_NEED_WAKEUP 0x1
+
+/* syscall_ring_enter() flags */
+#define SYSCALL_RING_ENTER_GETEVENTS 0x1
+#define SYSCALL_RING_ENTER_SQ_WAKEUP 0x2
+
+/* sqe->flags */
+#define SQE_F_LINK 0x1
+
+typedef enum {
+    SQE_OP_NOP = 0,
+    SQE_OP_READ,
+    SQE_OP_WRITE,
+    SQE_OP_SEND,
+    SQE_OP_RECV,
+    SQE_OP_BUS_SEND,
+    SQE_OP_TIMEOUT,
+    SQE_OP_MAX
+} syscall_ring_op_t;
+
+/*
+ * 'fd' indexes the files registered with syscall_ring_register_files():
+ * an inode_t for READ/WRITE, a socket_t for SEND/RECV. BUS_SEND takes an
+ * ipc_message_t at 'addr'; TIMEOUT waits 'off' nanoseconds and completes
+ * with -ETIME. 'addr' is an address in the ring owner's address space;
+ * buffers it does not map with the needed access complete with -EFAULT.
+ */
+typedef struct {
+    u8 opcode;
+    u8 flags;
+    u16 ioprio;
+    s32 fd;
+    u64 off;
+    u64 addr;
+    u32 len;
+    u32 rsvd;
+    u64 user_data;
+} syscall_sqe_t;
+
+typedef struct {
+    u64 user_data;
+    s32 res;
+    u32 flags;
+} syscall_cqe_t;
+
+/* Each queue's indices sit on their own cache line. */
+typedef struct {
+    u32 head;
+    u32 tail;
+    u32 mask;
+    u32 entries;
+    u32 flags;
+    u8 pad[44];
+} syscall_ring_queue_t;
+
+typedef struct {
+    u32 magic;
+    u32 flags;
+    u32 sqes_off;
+    u32 cqes_off;
+    u8 pad[48];
+    syscall_ring_queue_t sq;
+    syscall_ring_queue_t cq;
+} syscall_ring_header_t;
+
+typedef struct {
+    u64 submitted;
+    u64 completed;
+    u64 cancelled;
+    u64 enters;
+    u64 poller_wakeups;
+    u64 poller_sleeps;
+} syscall_ring_stats_t;
+
+typedef struct syscall_ring {
+    ipc_object_t *shm;
+    syscall_ring_header_t *header;
+    syscall_sqe_t *sqes;
+    syscall_cqe_t *cqes;
+    u64 pid;
+    address_space_t *as;
+    u64 virt_addr;
+    u32 flags;
+    u32 sqe_tail;
+    void *files[SYSCALL_RING_MAX_FILES];
+    spinlock_t sq_lock;
+    spinlock_t cq_lock;
+    u32 inflight;
+    u32 stopping;
+    kthread_t *poller;
+    wait_queue_t sq_wait;
+    wait_queue_t cq_wait;
+    syscall_ring_stats_t stats;
+} syscall_ring_t;
+
+syscall_ring_t *syscall_ring_create(u64 pid, u32 entries, u32 flags);
+void syscall_ring_destroy(syscall_ring_t *ring);
+int syscall_ring_register_files(syscall_ring_t *ring, void **files, u32 count);
+
+syscall_sqe_t *syscall_ring_get_sqe(syscall_ring_t *ring);
+int syscall_ring_submit(syscall_ring_t *ring);
+int syscall_ring_enter(syscall_ring_t *ring, u32 to_submit, u32 min_complete, u32 flags);
+syscall_cqe_t *syscall_ring_peek_cqe(syscall_ring_t *ring);
+void syscall_ring_cqe_seen(syscall_ring_t *ring);
+int syscall_ring_wait_cqe(syscall_ring_t *ring, syscall_cqe_t **cqe);
+int syscall_ring_get_stats(syscall_ring_t *ring, syscall_ring_stats_t *stats);
+
+static inline void syscall_ring_prep(syscall_sqe_t *sqe, u8 opcode, s32 fd, void *addr,
+                                     u32 len, u64 off, u64 user_data)
+{
+    sqe->opcode = opcode;
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+    sqe->fd = fd;
+    sqe->off = off;
+    sqe->addr = (u64)(uintptr_t)addr;
+    sqe->len = len;
+    sqe->rsvd = 0;
+    sqe->user_data = user_data;
+}
+
+#endif
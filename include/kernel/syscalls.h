@@ -2,9 +2,24 @@
 #define AEGIS_KERNEL_SYSCALLS_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+struct sysfs;
+struct sysfs_entry;
 
 typedef int (*syscall_handler_t)(void);
 
+#define SYSCALL_HIST_BUCKETS 32
+
+/* hist[i] counts calls that took [2^(i-1), 2^i) ns; bucket 0 is < 1 ns. */
+typedef struct {
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t hist[SYSCALL_HIST_BUCKETS];
+} syscall_stats_t;
+
 #define SYSCALL_PRIVILEGE_USER      0
 #define SYSCALL_PRIVILEGE_KERNEL   1
 #define SYSCALL_PRIVILEGE_ADMIN    2
@@ -32,6 +47,27 @@ int syscall_validate_privilege(int syscall_num, int current_privilege);
 
 int syscall_validate_args(int syscall_num, int arg_count);
 
-#define ENOSYS 38
+int syscall_gate_stats_enable(bool enable);
+
+bool syscall_gate_stats_enabled(void);
+
+void syscall_gate_stats_reset(void);
+
+int syscall_gate_get_stats(int syscall_num, syscall_stats_t *stats);
+
+uint64_t syscall_stats_percentile_ns(const syscall_stats_t *stats, uint32_t percentile);
+
+void syscall_gate_print_stats(void);
+
+int syscall_gate_sysfs_register(struct sysfs *sysfs, struct sysfs_entry *parent);
+
+#define EIO        5
+#define EBADF      9
+#define ENOMEM    12
+#define EFAULT    14
+#define EINVAL    22
+#define ENOSYS    38
+#define ETIME     62
+#define ECANCELED 125
 
 #endif
@@ -0,0 +1,27 @@
+#ifndef AEGIS_KERNEL_TIMER_H
+#define AEGIS_KERNEL_TIMER_H
+
+#include <kernel/types.h>
+
+struct ktimer;
+
+typedef void (*ktimer_fn_t)(struct ktimer *timer);
+
+typedef struct ktimer {
+    struct ktimer *next;
+    u64 expires_ns;
+    ktimer_fn_t fn;
+    void *data;
+    u32 pending;
+} ktimer_t;
+
+int timer_init(void);
+void timer_shutdown(void);
+void timer_setup(ktimer_t *timer, ktimer_fn_t fn, void *data);
+int timer_mod(ktimer_t *timer, u64 expires_ns);
+int timer_del(ktimer_t *timer);
+bool timer_pending(const ktimer_t *timer);
+u32 timer_run_expired(u64 now_ns);
+u64 timer_now_ns(void);
+
+#endif
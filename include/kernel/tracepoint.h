@@ -0,0 +1,63 @@
+#ifndef AEGIS_KERNEL_TRACEPOINT_H
+#define AEGIS_KERNEL_TRACEPOINT_H
+
+#include <kernel/types.h>
+
+#define TRACE_MAX_ARGS   4
+#define TRACE_RING_SIZE  256
+
+typedef struct tracepoint {
+    const char *subsys;
+    const char *name;
+    const char *args;   /* the argument expressions, comma separated */
+    u32 enabled;
+    u64 hits;
+} tracepoint_t;
+
+typedef struct {
+    u64 timestamp;
+    const tracepoint_t *tp;
+    u32 tid;
+    u32 nargs;
+    u64 args[TRACE_MAX_ARGS];
+} trace_record_t;
+
+/*
+ * AEGIS_TRACE(subsys, name, args...) records up to TRACE_MAX_ARGS integer
+ * arguments into the current CPU's trace ring while the tracepoint is
+ * enabled. Disabled, it costs one load and a not-taken branch; the
+ * arguments are not evaluated. Every site is listed in the
+ * "aegis_tracepoints" section, so it can be enabled by name at run time
+ * without registering first.
+ */
+#define AEGIS_TRACE(subsys, name, ...) do {                                       \
+    static tracepoint_t __tp = { #subsys, #name, #__VA_ARGS__, 0, 0 };            \
+    static tracepoint_t *__tp_entry                                               \
+        __attribute__((section("aegis_tracepoints"), used)) = &__tp;              \
+    (void)__tp_entry;                                                             \
+    if (__builtin_expect(__atomic_load_n(&__tp.enabled, __ATOMIC_RELAXED), 0)) {  \
+        const u64 __args[] = { 0, ##__VA_ARGS__ };                                \
+        _Static_assert(sizeof(__args) / sizeof(u64) - 1 <= TRACE_MAX_ARGS,       \
+                       "too many tracepoint arguments");                         \
+        trace_emit(&__tp, __args + 1, sizeof(__args) / sizeof(u64) - 1);          \
+    }                                                                             \
+} while (0)
+
+extern tracepoint_t *__start_aegis_tracepoints[] __attribute__((weak));
+extern tracepoint_t *__stop_aegis_tracepoints[] __attribute__((weak));
+
+void trace_emit(tracepoint_t *tp, const u64 *args, u32 nargs);
+
+/* 'name' NULL or "*" matches every tracepoint in 'subsys'. Returns the sites matched. */
+int trace_enable(const char *subsys, const char *name);
+int trace_disable(const char *subsys, const char *name);
+void trace_disable_all(void);
+
+tracepoint_t *trace_find(const char *subsys, const char *name);
+u32 trace_list(tracepoint_t **tps, u32 max);
+
+/* Copy up to 'max' of the most recent records on 'cpu', oldest first. */
+u32 trace_read(u32 cpu, trace_record_t *records, u32 max);
+void trace_clear(void);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef AEGIS_KERNEL_WAIT_QUEUE_H
+#define AEGIS_KERNEL_WAIT_QUEUE_H
+
+#include <kernel/types.h>
+#include <kernel/process.h>
+#include <kernel/spinlock.h>
+
+#define WAIT_QUEUE_TIMEOUT (-110)
+
+typedef struct wait_queue_entry {
+    thread_t *thread;
+    uintptr_t key;
+    u32 woken;
+    struct wait_queue_entry *next;
+    struct wait_queue_entry *prev;
+} wait_queue_entry_t;
+
+typedef struct {
+    spinlock_t lock;
+    u32 waiters;
+    wait_queue_entry_t *head;
+    wait_queue_entry_t *tail;
+} wait_queue_t;
+
+typedef bool (*wait_queue_cond_t)(void *arg);
+
+void wait_queue_init(wait_queue_t *wq);
+void wait_queue_lock(wait_queue_t *wq);
+void wait_queue_unlock(wait_queue_t *wq);
+void wait_queue_add_locked(wait_queue_t *wq, wait_queue_entry_t *entry);
+void wait_queue_remove_locked(wait_queue_t *wq, wait_queue_entry_t *entry);
+int wait_queue_sleep(wait_queue_t *wq, wait_queue_entry_t *entry, u64 timeout_ns);
+int wait_queue_wait(wait_queue_t *wq, thread_t *thread, wait_queue_cond_t cond,
+                    void *arg, u64 timeout_ns);
+u32 wait_queue_wake_key(wait_queue_t *wq, uintptr_t key, u32 count);
+u32 wait_queue_wake(wait_queue_t *wq, u32 count);
+u32 wait_queue_wake_all(wait_queue_t *wq);
+u64 wait_queue_now_ns(void);
+void wait_queue_cpu_relax(void);
+
+#endif
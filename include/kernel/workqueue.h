@@ -0,0 +1,80 @@
+#ifndef AEGIS_KERNEL_WORKQUEUE_H
+#define AEGIS_KERNEL_WORKQUEUE_H
+
+#include <kernel/types.h>
+#include <kernel/timer.h>
+
+#define WQ_NAME_LEN               32
+#define WQ_MAX_ACTIVE             16
+#define WQ_DEFAULT_UNBOUND_ACTIVE 4
+#define WQ_MAX_CPUS               64
+
+#define WQ_UNBOUND  0x1
+
+#define WORK_PENDING 0x1
+
+struct work;
+struct workqueue;
+struct worker_pool;
+
+typedef void (*work_func_t)(struct work *work);
+
+typedef struct work {
+    struct work *next;
+    work_func_t func;
+    void *data;
+    u32 state;
+    u32 cpu;
+    u64 queued_ns;
+    struct worker_pool *pool;
+    struct workqueue *wq;
+    ktimer_t *timer;
+} work_t;
+
+typedef struct {
+    work_t work;
+    ktimer_t timer;
+} delayed_work_t;
+
+typedef struct {
+    u64 queued;
+    u64 executed;
+    u64 cancelled;
+    u64 delayed;
+    u32 depth;
+    u32 max_depth;
+    u32 active;
+    u32 max_active_seen;
+    u64 total_latency_ns;
+    u64 max_latency_ns;
+    u64 total_exec_ns;
+    u64 max_exec_ns;
+} workqueue_stats_t;
+
+typedef struct workqueue workqueue_t;
+
+extern workqueue_t *system_wq;
+extern workqueue_t *system_unbound_wq;
+
+int workqueue_init(u32 nr_cpus);
+void workqueue_shutdown(void);
+workqueue_t *workqueue_create(const char *name, u32 flags, u32 max_active);
+void workqueue_destroy(workqueue_t *wq);
+
+void work_init(work_t *work, work_func_t func, void *data);
+void delayed_work_init(delayed_work_t *dwork, work_func_t func, void *data);
+
+int queue_work(workqueue_t *wq, work_t *work);
+int queue_work_on(u32 cpu, workqueue_t *wq, work_t *work);
+int queue_delayed_work(workqueue_t *wq, delayed_work_t *dwork, u64 delay_ns);
+int queue_delayed_work_on(u32 cpu, workqueue_t *wq, delayed_work_t *dwork, u64 delay_ns);
+
+int cancel_work_sync(work_t *work);
+int cancel_delayed_work_sync(delayed_work_t *dwork);
+int flush_work(work_t *work);
+int flush_workqueue(workqueue_t *wq);
+
+int workqueue_get_stats(workqueue_t *wq, workqueue_stats_t *stats);
+void workqueue_print_stats(workqueue_t *wq);
+
+#endif
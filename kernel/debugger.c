@@ -1,4 +1,5 @@
 #include <kernel/debugger.h>
+#include <kernel/ksym.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -286,11 +287,52 @@ int debugger_print_stack_trace(void)
     return 0;
 }
 
+/* Symbols live in the shared kernel symbol table (see ksym.h). */
+int debugger_add_symbol(u64 address, u64 size, const char *name)
+{
+    return ksym_add(address, size, name);
+}
+
+const char *debugger_lookup_symbol(u64 address, u64 *offset)
+{
+    return ksym_lookup(address, offset);
+}
+
+void debugger_clear_symbols(void)
+{
+    ksym_clear();
+}
+
+/*
+ * Load a table written by ksymgen, or function symbols from 'nm -n' or
+ * 'nm -S -n' output:
+ *   <address> [<size>] <type> <name>
+ * Only text symbols (T/t/W/w) are kept. Returns the number loaded.
+ */
 int debugger_set_symbol_table(const char *symbol_file)
 {
     if (!symbol_file) return -1;
 
-    return 0;
+    int loaded = ksym_load(symbol_file);
+    if (loaded >= 0) return loaded;
+
+    FILE *file = fopen(symbol_file, "r");
+    if (!file) return -1;
+
+    char line[512];
+    char name[256];
+    u64 address, size;
+    loaded = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        if (ksym_parse_nm(line, &address, &size, name, sizeof(name)) && ksym_add(address, size, name) == 0) {
+            loaded++;
+        }
+    }
+
+    fclose(file);
+
+    return loaded;
 }
 
 int debugger_attach_process(u64 pid)
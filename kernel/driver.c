@@ -1,19 +1,83 @@
 #include <kernel/driver.h>
+#include <kernel/spinlock.h>
 #include <string.h>
 #include <stdlib.h>
 
+/*
+ * The registry is a copy-on-write snapshot. Lookups and probing walk the
+ * current table under RCU without locking; register/unregister build a
+ * new table under the writer lock, publish it, and retire the old table
+ * (and any removed driver) after a grace period.
+ */
+
+typedef struct {
+    u32 count;
+    rcu_head_t rcu;
+    driver_t *drivers[DRIVER_MAX_DRIVERS];
+} driver_table_t;
+
 typedef struct {
-    driver_t *drivers[256];
-    u32 driver_count;
-    uint lock;
+    driver_table_t *table;
+    spinlock_t lock;
 } driver_mgr_state_t;
 
 static driver_mgr_state_t driver_state = {0};
 static u64 next_driver_id = 1;
 
+static void driver_write_lock(void)
+{
+    spin_lock(&driver_state.lock);
+}
+
+static void driver_write_unlock(void)
+{
+    spin_unlock(&driver_state.lock);
+}
+
+static void driver_table_free(rcu_head_t *head)
+{
+    free(list_entry(head, driver_table_t, rcu));
+}
+
+static void driver_free(rcu_head_t *head)
+{
+    free(list_entry(head, driver_t, rcu));
+}
+
+static void driver_table_publish(driver_table_t *table)
+{
+    driver_table_t *old = driver_state.table;
+
+    rcu_assign_pointer(driver_state.table, table);
+    if (old) {
+        call_rcu(&old->rcu, driver_table_free);
+    }
+}
+
+/* Must be called under rcu_read_lock(). */
+static driver_t *driver_find(u64 driver_id)
+{
+    driver_table_t *table = rcu_dereference(driver_state.table);
+    if (!table) return NULL;
+
+    for (u32 i = 0; i < table->count; i++) {
+        if (table->drivers[i]->id == driver_id) {
+            return table->drivers[i];
+        }
+    }
+
+    return NULL;
+}
+
 int driver_mgr_init(void)
 {
-    memset(&driver_state, 0, sizeof(driver_state));
+    driver_table_t *table = (driver_table_t *)calloc(1, sizeof(driver_table_t));
+    if (!table) return -1;
+
+    driver_write_lock();
+    driver_table_publish(table);
+    driver_write_unlock();
+
     return 0;
 }
 
@@ -24,7 +88,7 @@ driver_t *driver_register(const char *name, driver_type_t type, driver_ops_t *op
     driver_t *drv = (driver_t *)malloc(sizeof(driver_t));
     if (!drv) return NULL;
 
-    drv->id = next_driver_id++;
+    drv->id = __atomic_fetch_add(&next_driver_id, 1, __ATOMIC_RELAXED);
     drv->name = name;
     drv->type = type;
     drv->state = DRIVER_STATE_UNLOADED;
@@ -36,32 +100,65 @@ driver_t *driver_register(const char *name, driver_type_t type, driver_ops_t *op
     drv->suspend = NULL;
     drv->resume = NULL;
 
-    if (driver_state.driver_count < 256) {
-        driver_state.drivers[driver_state.driver_count++] = drv;
-        return drv;
+    driver_table_t *table = (driver_table_t *)malloc(sizeof(driver_table_t));
+    if (!table) {
+        free(drv);
+        return NULL;
     }
 
-    free(drv);
-    return NULL;
+    driver_write_lock();
+    driver_table_t *old = driver_state.table;
+    u32 count = old ? old->count : 0;
+
+    if (count >= DRIVER_MAX_DRIVERS) {
+        driver_write_unlock();
+        free(table);
+        free(drv);
+        return NULL;
+    }
+
+    if (count) {
+        memcpy(table->drivers, old->drivers, count * sizeof(driver_t *));
+    }
+    table->drivers[count] = drv;
+    table->count = count + 1;
+    driver_table_publish(table);
+    driver_write_unlock();
+
+    return drv;
 }
 
 int driver_unregister(u64 driver_id)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            if (driver_state.drivers[i]->state == DRIVER_STATE_RUNNING) {
-                return -1;
-            }
-
-            for (u32 j = i; j < driver_state.driver_count - 1; j++) {
-                driver_state.drivers[j] = driver_state.drivers[j + 1];
-            }
-            driver_state.driver_count--;
-            return 0;
+    driver_table_t *table = (driver_table_t *)malloc(sizeof(driver_table_t));
+    if (!table) return -1;
+
+    driver_write_lock();
+    driver_table_t *old = driver_state.table;
+    driver_t *removed = NULL;
+    u32 count = 0;
+
+    for (u32 i = 0; old && i < old->count; i++) {
+        driver_t *drv = old->drivers[i];
+        if (!removed && drv->id == driver_id) {
+            removed = drv;
+            continue;
         }
+        table->drivers[count++] = drv;
+    }
+
+    if (!removed || removed->state == DRIVER_STATE_RUNNING) {
+        driver_write_unlock();
+        free(table);
+        return -1;
     }
 
-    return -1;
+    table->count = count;
+    driver_table_publish(table);
+    driver_write_unlock();
+
+    call_rcu(&removed->rcu, driver_free);
+    return 0;
 }
 
 int driver_load(const char *driver_path)
@@ -72,122 +169,134 @@ int driver_load(const char *driver_path)
 
 int driver_unload(u64 driver_id)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_t *drv = driver_state.drivers[i];
-            if (drv->state == DRIVER_STATE_RUNNING) {
-                drv->state = DRIVER_STATE_UNLOADED;
-                return 0;
-            }
-            return -1;
-        }
+    int result = -1;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv && drv->state == DRIVER_STATE_RUNNING) {
+        drv->state = DRIVER_STATE_UNLOADED;
+        result = 0;
     }
+    rcu_read_unlock();
 
-    return -1;
+    return result;
 }
 
 int driver_set_sandbox_mode(u64 driver_id, sandbox_mode_t mode)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_state.drivers[i]->sandbox = mode;
-            return 0;
-        }
+    int result = -1;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv) {
+        drv->sandbox = mode;
+        result = 0;
     }
+    rcu_read_unlock();
 
-    return -1;
+    return result;
 }
 
 int driver_set_permissions(u64 driver_id, u32 permissions)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_state.drivers[i]->permission_mask = permissions;
-            return 0;
-        }
+    int result = -1;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv) {
+        drv->permission_mask = permissions;
+        result = 0;
     }
+    rcu_read_unlock();
 
-    return -1;
+    return result;
 }
 
 int driver_probe_devices(void)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        driver_t *drv = driver_state.drivers[i];
+    rcu_read_lock();
+    driver_table_t *table = rcu_dereference(driver_state.table);
+
+    for (u32 i = 0; table && i < table->count; i++) {
+        driver_t *drv = table->drivers[i];
         if (drv->probe) {
             drv->probe(NULL);
         }
     }
+    rcu_read_unlock();
 
     return 0;
 }
 
 int driver_enable_isolation(u64 driver_id)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_state.drivers[i]->sandbox = SANDBOX_MODE_VM;
-            return 0;
-        }
-    }
-
-    return -1;
+    return driver_set_sandbox_mode(driver_id, SANDBOX_MODE_VM);
 }
 
 int driver_create_wasm_sandbox(u64 driver_id, const u8 *wasm_module, u64 module_size)
 {
     if (!wasm_module) return -1;
 
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_state.drivers[i]->sandbox = SANDBOX_MODE_WASM;
-            driver_state.drivers[i]->module = (void *)wasm_module;
-            return 0;
-        }
+    int result = -1;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv) {
+        drv->sandbox = SANDBOX_MODE_WASM;
+        drv->module = (void *)wasm_module;
+        result = 0;
     }
+    rcu_read_unlock();
 
-    return -1;
+    return result;
 }
 
 driver_state_t driver_get_state(u64 driver_id)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            return driver_state.drivers[i]->state;
-        }
+    driver_state_t state = DRIVER_STATE_ERROR;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv) {
+        state = drv->state;
     }
+    rcu_read_unlock();
 
-    return DRIVER_STATE_ERROR;
+    return state;
 }
 
 int driver_suspend(u64 driver_id)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_t *drv = driver_state.drivers[i];
-            if (drv->suspend) {
-                drv->suspend(NULL);
-            }
-            drv->state = DRIVER_STATE_SUSPENDED;
-            return 0;
+    int result = -1;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv) {
+        if (drv->suspend) {
+            drv->suspend(NULL);
         }
+        drv->state = DRIVER_STATE_SUSPENDED;
+        result = 0;
     }
+    rcu_read_unlock();
 
-    return -1;
+    return result;
 }
 
 int driver_resume(u64 driver_id)
 {
-    for (u32 i = 0; i < driver_state.driver_count; i++) {
-        if (driver_state.drivers[i]->id == driver_id) {
-            driver_t *drv = driver_state.drivers[i];
-            if (drv->resume) {
-                drv->resume(NULL);
-            }
-            drv->state = DRIVER_STATE_RUNNING;
-            return 0;
+    int result = -1;
+
+    rcu_read_lock();
+    driver_t *drv = driver_find(driver_id);
+    if (drv) {
+        if (drv->resume) {
+            drv->resume(NULL);
         }
+        drv->state = DRIVER_STATE_RUNNING;
+        result = 0;
     }
+    rcu_read_unlock();
 
-    return -1;
+    return result;
 }
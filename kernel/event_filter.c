@@ -0,0 +1,334 @@
+#include <kernel/event_filter.h>
+#include <kernel/event_system.h>
+#include <string.h>
+
+/*
+ * Filter expressions are compiled once, at subscribe time, into a short
+ * stack program that event_publish() runs before any delivery work:
+ *
+ *     type == 6 && (source == 3 || data8[0] & 0x80)
+ *
+ * Operands are integer literals and the fields type, id, timestamp, source,
+ * size, data8[n], data16[n] and data32[n] (little-endian payload reads,
+ * zero past data_size). Operators, loosest first: ||, &&, comparisons
+ * (== != < <= > >=), & and unary !. Unlike C, & binds tighter than the
+ * comparisons so "data8[0] & 4 != 0" reads as intended.
+ */
+
+typedef struct {
+    const char *pos;
+    event_filter_t *filter;
+    int depth;
+    int error;
+} event_filter_parser_t;
+
+static void filter_skip_space(event_filter_parser_t *p)
+{
+    while (*p->pos == ' ' || *p->pos == '\t' || *p->pos == '\n') {
+        p->pos++;
+    }
+}
+
+static int filter_accept(event_filter_parser_t *p, const char *token)
+{
+    size_t len = strlen(token);
+
+    filter_skip_space(p);
+    if (strncmp(p->pos, token, len) != 0) {
+        return 0;
+    }
+
+    /* Keep '&' from eating the first half of '&&', '<' of '<=', and so on. */
+    if (len == 1 && (token[0] == '&' ? p->pos[1] == '&' : p->pos[1] == '=')) {
+        return 0;
+    }
+
+    p->pos += len;
+    return 1;
+}
+
+static void filter_emit(event_filter_parser_t *p, uint8_t op, uint8_t field, uint16_t offset, int64_t imm)
+{
+    event_filter_t *filter = p->filter;
+
+    if (filter->length >= EVENT_FILTER_MAX_INSNS) {
+        p->error = 1;
+        return;
+    }
+
+    if (op == EVENT_FILTER_OP_IMM || op == EVENT_FILTER_OP_FIELD) {
+        if (++p->depth > EVENT_FILTER_MAX_STACK) {
+            p->error = 1;
+            return;
+        }
+    } else if (op != EVENT_FILTER_OP_NOT) {
+        p->depth--;
+    }
+
+    event_filter_insn_t *insn = &filter->insns[filter->length++];
+    insn->op = op;
+    insn->field = field;
+    insn->offset = offset;
+    insn->imm = imm;
+}
+
+static int filter_parse_number(event_filter_parser_t *p, int64_t *value)
+{
+    int base = 10;
+    int64_t result = 0;
+    int digits = 0;
+
+    if (p->pos[0] == '0' && (p->pos[1] == 'x' || p->pos[1] == 'X')) {
+        base = 16;
+        p->pos += 2;
+    }
+
+    for (;;) {
+        char c = *p->pos;
+        int digit;
+
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (base == 16 && c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (base == 16 && c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            break;
+        }
+
+        result = result * base + digit;
+        digits++;
+        p->pos++;
+    }
+
+    *value = result;
+    return digits > 0 ? 0 : -1;
+}
+
+static const struct {
+    const char *name;
+    event_field_t field;
+    uint32_t width;
+} filter_fields[] = {
+    { "timestamp", EVENT_FIELD_TIMESTAMP, 0 },
+    { "source",    EVENT_FIELD_SOURCE,    0 },
+    { "data16",    EVENT_FIELD_DATA16,    2 },
+    { "data32",    EVENT_FIELD_DATA32,    4 },
+    { "data8",     EVENT_FIELD_DATA8,     1 },
+    { "type",      EVENT_FIELD_TYPE,      0 },
+    { "size",      EVENT_FIELD_SIZE,      0 },
+    { "id",        EVENT_FIELD_ID,        0 },
+};
+
+static int filter_parse_field(event_filter_parser_t *p)
+{
+    for (size_t i = 0; i < sizeof(filter_fields) / sizeof(filter_fields[0]); i++) {
+        size_t len = strlen(filter_fields[i].name);
+        if (strncmp(p->pos, filter_fields[i].name, len) != 0) continue;
+
+        char next = p->pos[len];
+        if ((next >= 'a' && next <= 'z') || (next >= '0' && next <= '9') || next == '_') continue;
+        p->pos += len;
+
+        int64_t offset = 0;
+        if (filter_fields[i].width) {
+            if (!filter_accept(p, "[")) return -1;
+            filter_skip_space(p);
+            if (filter_parse_number(p, &offset) != 0) return -1;
+            if (!filter_accept(p, "]")) return -1;
+            if (offset < 0 || offset + filter_fields[i].width > (int64_t)sizeof(((kernel_event_t *)0)->data)) {
+                return -1;
+            }
+        }
+
+        filter_emit(p, EVENT_FILTER_OP_FIELD, filter_fields[i].field, (uint16_t)offset, 0);
+        return 0;
+    }
+
+    return -1;
+}
+
+static void filter_parse_or(event_filter_parser_t *p);
+
+static void filter_parse_unary(event_filter_parser_t *p)
+{
+    int64_t value;
+
+    if (p->error) return;
+
+    if (filter_accept(p, "!")) {
+        filter_parse_unary(p);
+        filter_emit(p, EVENT_FILTER_OP_NOT, 0, 0, 0);
+        return;
+    }
+
+    if (filter_accept(p, "(")) {
+        filter_parse_or(p);
+        if (!filter_accept(p, ")")) p->error = 1;
+        return;
+    }
+
+    filter_skip_space(p);
+    if (*p->pos >= '0' && *p->pos <= '9') {
+        if (filter_parse_number(p, &value) != 0) {
+            p->error = 1;
+            return;
+        }
+        filter_emit(p, EVENT_FILTER_OP_IMM, 0, 0, value);
+        return;
+    }
+
+    if (filter_parse_field(p) != 0) {
+        p->error = 1;
+    }
+}
+
+static void filter_parse_bitand(event_filter_parser_t *p)
+{
+    filter_parse_unary(p);
+    while (!p->error && filter_accept(p, "&")) {
+        filter_parse_unary(p);
+        filter_emit(p, EVENT_FILTER_OP_BITAND, 0, 0, 0);
+    }
+}
+
+static void filter_parse_compare(event_filter_parser_t *p)
+{
+    static const struct {
+        const char *token;
+        event_filter_op_t op;
+    } compares[] = {
+        { "==", EVENT_FILTER_OP_EQ }, { "!=", EVENT_FILTER_OP_NE },
+        { "<=", EVENT_FILTER_OP_LE }, { ">=", EVENT_FILTER_OP_GE },
+        { "<",  EVENT_FILTER_OP_LT }, { ">",  EVENT_FILTER_OP_GT },
+    };
+
+    filter_parse_bitand(p);
+    if (p->error) return;
+
+    for (size_t i = 0; i < sizeof(compares) / sizeof(compares[0]); i++) {
+        if (filter_accept(p, compares[i].token)) {
+            filter_parse_bitand(p);
+            filter_emit(p, compares[i].op, 0, 0, 0);
+            return;
+        }
+    }
+}
+
+static void filter_parse_and(event_filter_parser_t *p)
+{
+    filter_parse_compare(p);
+    while (!p->error && filter_accept(p, "&&")) {
+        filter_parse_compare(p);
+        filter_emit(p, EVENT_FILTER_OP_AND, 0, 0, 0);
+    }
+}
+
+static void filter_parse_or(event_filter_parser_t *p)
+{
+    filter_parse_and(p);
+    while (!p->error && filter_accept(p, "||")) {
+        filter_parse_and(p);
+        filter_emit(p, EVENT_FILTER_OP_OR, 0, 0, 0);
+    }
+}
+
+int event_filter_compile(const char *expr, event_filter_t *filter)
+{
+    if (!expr || !filter) {
+        return -1;
+    }
+
+    event_filter_parser_t parser;
+    parser.pos = expr;
+    parser.filter = filter;
+    parser.depth = 0;
+    parser.error = 0;
+
+    memset(filter, 0, sizeof(event_filter_t));
+    filter_parse_or(&parser);
+    filter_skip_space(&parser);
+
+    if (parser.error || *parser.pos != '\0' || parser.depth != 1) {
+        memset(filter, 0, sizeof(event_filter_t));
+        return -1;
+    }
+
+    return 0;
+}
+
+static int64_t filter_load(const event_filter_insn_t *insn, const kernel_event_t *event)
+{
+    uint32_t width = 0;
+
+    switch (insn->field) {
+        case EVENT_FIELD_TYPE:      return event->event_type;
+        case EVENT_FIELD_ID:        return event->event_id;
+        case EVENT_FIELD_TIMESTAMP: return event->timestamp;
+        case EVENT_FIELD_SOURCE:    return event->source_id;
+        case EVENT_FIELD_SIZE:      return event->data_size;
+        case EVENT_FIELD_DATA8:     width = 1; break;
+        case EVENT_FIELD_DATA16:    width = 2; break;
+        case EVENT_FIELD_DATA32:    width = 4; break;
+        default:                    return 0;
+    }
+
+    if (insn->offset + width > event->data_size) {
+        return 0;
+    }
+
+    int64_t value = 0;
+    for (uint32_t i = 0; i < width; i++) {
+        value |= (int64_t)event->data[insn->offset + i] << (8 * i);
+    }
+    return value;
+}
+
+bool event_filter_match(const event_filter_t *filter, const kernel_event_t *event)
+{
+    int64_t stack[EVENT_FILTER_MAX_STACK];
+    int sp = 0;
+
+    if (!filter || filter->length == 0) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < filter->length; i++) {
+        const event_filter_insn_t *insn = &filter->insns[i];
+
+        switch (insn->op) {
+            case EVENT_FILTER_OP_IMM:
+                stack[sp++] = insn->imm;
+                continue;
+            case EVENT_FILTER_OP_FIELD:
+                stack[sp++] = filter_load(insn, event);
+                continue;
+            case EVENT_FILTER_OP_NOT:
+                stack[sp - 1] = !stack[sp - 1];
+                continue;
+            default:
+                break;
+        }
+
+        int64_t rhs = stack[--sp];
+        int64_t lhs = stack[sp - 1];
+        int64_t result;
+
+        switch (insn->op) {
+            case EVENT_FILTER_OP_EQ:     result = lhs == rhs; break;
+            case EVENT_FILTER_OP_NE:     result = lhs != rhs; break;
+            case EVENT_FILTER_OP_LT:     result = lhs < rhs; break;
+            case EVENT_FILTER_OP_LE:     result = lhs <= rhs; break;
+            case EVENT_FILTER_OP_GT:     result = lhs > rhs; break;
+            case EVENT_FILTER_OP_GE:     result = lhs >= rhs; break;
+            case EVENT_FILTER_OP_BITAND: result = lhs & rhs; break;
+            case EVENT_FILTER_OP_AND:    result = lhs && rhs; break;
+            case EVENT_FILTER_OP_OR:     result = lhs || rhs; break;
+            default:                     return false;
+        }
+        stack[sp - 1] = result;
+    }
+
+    return stack[0] != 0;
+}
@@ -1,24 +1,110 @@
 #include <kernel/event_system.h>
+#include <kernel/wait_queue.h>
+#include <kernel/kthread.h>
+#include <kernel/rcu.h>
+#include <kernel/event_filter.h>
+#include <kernel/percpu.h>
+#include <kernel/tracepoint.h>
 #include <common/list.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
+typedef struct {
+    kernel_event_t event;
+    uint64_t enqueued_ns;
+} event_queue_slot_t;
+
 typedef struct event_subscriber {
     struct list_head list;
+    struct list_head ready;
     int subscriber_id;
     event_callback_t callback;
     void *context;
     uint32_t subscribed_events;
+    event_delivery_t delivery;
+    event_backpressure_t backpressure;
+    event_queue_slot_t *queue;
+    uint32_t queue_mask;
+    uint32_t head;
+    uint32_t tail;
+    spinlock_t lock;
+    uint32_t scheduled;
+    uint32_t dead;
+    uint32_t refs;
+    wait_queue_t not_full;
+    event_subscriber_stats_t stats;
+    event_mask_t mask;
+    event_filter_t filter;
+    uint64_t window_ns;
+    kernel_event_t burst;
+    uint32_t burst_count;
+    uint64_t burst_start_ns;
+    uint32_t burst_armed;
+    struct list_head burst_list;
+    rcu_head_t rcu;
 } event_subscriber_t;
 
 typedef struct {
     struct list_head subscribers;
-    uint32_t event_count;
     uint32_t last_timestamp;
+    spinlock_t lock;
 } event_registry_entry_t;
 
+#define EVENT_DEFER_INLINE 4
+
+typedef struct {
+    event_subscriber_t *sub;
+    kernel_event_t event;
+} event_deferred_t;
+
+/*
+ * Events for BLOCK subscribers whose queue was full during an RCU walk.
+ * They are enqueued (and waited for) after rcu_read_unlock(), so a full
+ * queue never holds up a grace period.
+ */
+typedef struct {
+    event_deferred_t inline_items[EVENT_DEFER_INLINE];
+    event_deferred_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} event_defer_list_t;
+
+/*
+ * Subscriber lists are read under RCU: event_publish() and the query
+ * functions never lock. Subscribe/unsubscribe serialize on the entry lock
+ * and removed subscribers are released only after a grace period.
+ *
+ * Mask subscribers hold a single node on event_mask_subscribers and a
+ * bitmap of the types they want, instead of one node per type. Bits are
+ * only ever cleared after subscribe, with atomic and-not on the word.
+ */
+
+/*
+ * Async subscribers with queued events sit on a single ready list. A
+ * subscriber is on the list at most once ('scheduled'), so only one worker
+ * drains it at a time and its events are delivered in publish order.
+ */
+typedef struct {
+    struct list_head ready;
+    uint32_t ready_count;
+    spinlock_t lock;
+    uint32_t pending;
+    uint32_t stopping;
+    uint32_t worker_count;
+    kthread_t *workers[EVENT_MAX_WORKERS];
+    wait_queue_t work;
+    wait_queue_t idle;
+    struct list_head bursts;
+    spinlock_t burst_lock;
+    uint32_t burst_seq;
+} event_dispatch_t;
+
 static event_registry_entry_t event_registry[MAX_EVENT_TYPES];
+static struct list_head event_mask_subscribers;
+static spinlock_t event_mask_lock;
+static event_dispatch_t dispatch;
+static DEFINE_PER_CPU(uint32_t, event_counts[MAX_EVENT_TYPES]);
 static int initialized = 0;
 
 void event_system_init(void)
@@ -27,14 +113,454 @@ void event_system_init(void)
     
     for (int i = 0; i < MAX_EVENT_TYPES; i++) {
         INIT_LIST_HEAD(&event_registry[i].subscribers);
-        event_registry[i].event_count = 0;
         event_registry[i].last_timestamp = 0;
+        spin_lock_init(&event_registry[i].lock);
     }
     
+    memset(&dispatch, 0, sizeof(dispatch));
+    INIT_LIST_HEAD(&dispatch.ready);
+    INIT_LIST_HEAD(&dispatch.bursts);
+    INIT_LIST_HEAD(&event_mask_subscribers);
+    per_cpu_reset(event_counts);
+    spin_lock_init(&event_mask_lock);
+    wait_queue_init(&dispatch.work);
+    wait_queue_init(&dispatch.idle);
+    
     initialized = 1;
 }
 
-int event_subscribe(int subscriber_id, uint32_t event_type, event_callback_t callback, void *context)
+static void event_subscriber_put(event_subscriber_t *sub)
+{
+    if (__atomic_sub_fetch(&sub->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(sub->queue);
+        free(sub);
+    }
+}
+
+static void event_subscriber_rcu_put(rcu_head_t *head)
+{
+    event_subscriber_put(list_entry(head, event_subscriber_t, rcu));
+}
+
+/* Called after the subscriber has been unlinked, without the entry lock. */
+static void event_subscriber_release(event_subscriber_t *sub)
+{
+    __atomic_store_n(&sub->dead, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&sub->not_full);
+    call_rcu(&sub->rcu, event_subscriber_rcu_put);
+}
+
+static void event_pending_done(uint32_t count)
+{
+    if (count && __atomic_sub_fetch(&dispatch.pending, count, __ATOMIC_ACQ_REL) == 0) {
+        wait_queue_wake_all(&dispatch.idle);
+    }
+}
+
+static void event_schedule(event_subscriber_t *sub)
+{
+    __atomic_add_fetch(&sub->refs, 1, __ATOMIC_RELAXED);
+    
+    spin_lock(&dispatch.lock);
+    list_add_tail(&sub->ready, &dispatch.ready);
+    __atomic_store_n(&dispatch.ready_count, dispatch.ready_count + 1, __ATOMIC_RELEASE);
+    spin_unlock(&dispatch.lock);
+    
+    wait_queue_wake(&dispatch.work, 1);
+}
+
+static event_subscriber_t *event_pop_ready(void)
+{
+    event_subscriber_t *sub = NULL;
+    
+    spin_lock(&dispatch.lock);
+    if (!list_empty(&dispatch.ready)) {
+        sub = list_entry(dispatch.ready.next, event_subscriber_t, ready);
+        list_del(&sub->ready);
+        __atomic_store_n(&dispatch.ready_count, dispatch.ready_count - 1, __ATOMIC_RELEASE);
+    }
+    spin_unlock(&dispatch.lock);
+    
+    return sub;
+}
+
+/*
+ * Deliver up to 'budget' queued events. Each event is copied out under the
+ * subscriber lock and the callback runs unlocked, so publishers are never
+ * held up by a slow callback. Returns with 'more' set if the subscriber
+ * still has events and must be rescheduled.
+ */
+static uint32_t event_deliver(event_subscriber_t *sub, uint32_t budget, int *more)
+{
+    kernel_event_t event;
+    uint32_t delivered = 0;
+    
+    for (;;) {
+        spin_lock(&sub->lock);
+        if (sub->head == sub->tail || delivered == budget) break;
+    
+        event_queue_slot_t *slot = &sub->queue[sub->head & sub->queue_mask];
+        uint64_t now = wait_queue_now_ns();
+        uint64_t lag = now > slot->enqueued_ns ? now - slot->enqueued_ns : 0;
+        memcpy(&event, &slot->event, sizeof(kernel_event_t));
+        sub->head++;
+    
+        sub->stats.delivered++;
+        sub->stats.queued = sub->tail - sub->head;
+        sub->stats.total_lag_ns += lag;
+        if (lag > sub->stats.max_lag_ns) {
+            sub->stats.max_lag_ns = lag;
+        }
+        spin_unlock(&sub->lock);
+    
+        if (sub->backpressure == EVENT_BACKPRESSURE_BLOCK) {
+            wait_queue_wake(&sub->not_full, 1);
+        }
+    
+        if (!__atomic_load_n(&sub->dead, __ATOMIC_ACQUIRE)) {
+            sub->callback(&event, sub->context);
+        }
+        event_pending_done(1);
+        delivered++;
+    }
+    
+    *more = sub->head != sub->tail;
+    if (!*more) {
+        sub->scheduled = 0;
+    }
+    spin_unlock(&sub->lock);
+    
+    return delivered;
+}
+
+static bool event_queue_has_room(void *arg)
+{
+    event_subscriber_t *sub = (event_subscriber_t *)arg;
+    
+    spin_lock(&sub->lock);
+    bool room = sub->tail - sub->head <= sub->queue_mask;
+    spin_unlock(&sub->lock);
+    
+    return room || __atomic_load_n(&sub->dead, __ATOMIC_ACQUIRE);
+}
+
+static event_queue_slot_t *event_find_coalesce_slot(event_subscriber_t *sub, const kernel_event_t *event)
+{
+    for (uint32_t i = sub->tail; i != sub->head; i--) {
+        event_queue_slot_t *slot = &sub->queue[(i - 1) & sub->queue_mask];
+        if (slot->event.event_type == event->event_type &&
+            slot->event.source_id == event->source_id) {
+            return slot;
+        }
+    }
+    
+    return &sub->queue[(sub->tail - 1) & sub->queue_mask];
+}
+
+static int event_defer(event_defer_list_t *defer, event_subscriber_t *sub, const kernel_event_t *event)
+{
+    if (defer->count == defer->capacity) {
+        uint32_t capacity = defer->capacity * 2;
+        event_deferred_t *items = (event_deferred_t *)malloc(capacity * sizeof(event_deferred_t));
+        if (!items) return -1;
+    
+        memcpy(items, defer->items, defer->count * sizeof(event_deferred_t));
+        if (defer->items != defer->inline_items) {
+            free(defer->items);
+        }
+        defer->items = items;
+        defer->capacity = capacity;
+    }
+    
+    __atomic_add_fetch(&sub->refs, 1, __ATOMIC_RELAXED);
+    defer->items[defer->count].sub = sub;
+    memcpy(&defer->items[defer->count].event, event, sizeof(kernel_event_t));
+    defer->count++;
+    return 0;
+}
+
+/*
+ * A full BLOCK subscriber waits for room, unless 'defer' is set: then the
+ * caller is inside an RCU read section and the event is handed back to be
+ * enqueued once it has left.
+ */
+static int event_enqueue(event_subscriber_t *sub, const kernel_event_t *event, event_defer_list_t *defer)
+{
+    spin_lock(&sub->lock);
+    
+    while (sub->tail - sub->head > sub->queue_mask) {
+        if (sub->backpressure == EVENT_BACKPRESSURE_DROP_OLDEST) {
+            sub->head++;
+            sub->stats.dropped++;
+            event_pending_done(1);
+            break;
+        }
+    
+        if (sub->backpressure == EVENT_BACKPRESSURE_COALESCE) {
+            event_queue_slot_t *slot = event_find_coalesce_slot(sub, event);
+            memcpy(&slot->event, event, sizeof(kernel_event_t));
+            sub->stats.coalesced++;
+            spin_unlock(&sub->lock);
+            return 0;
+        }
+    
+        if (defer) {
+            spin_unlock(&sub->lock);
+            if (event_defer(defer, sub, event) == 0) {
+                return 0;
+            }
+    
+            spin_lock(&sub->lock);
+            sub->stats.dropped++;
+            spin_unlock(&sub->lock);
+            return -1;
+        }
+    
+        sub->stats.blocked++;
+        spin_unlock(&sub->lock);
+    
+        if (__atomic_load_n(&dispatch.worker_count, __ATOMIC_ACQUIRE) == 0) {
+            event_dispatch_drain();
+        } else {
+            wait_queue_wait(&sub->not_full, NULL, event_queue_has_room, sub, 0);
+        }
+    
+        if (__atomic_load_n(&sub->dead, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+        spin_lock(&sub->lock);
+    }
+    
+    event_queue_slot_t *slot = &sub->queue[sub->tail & sub->queue_mask];
+    memcpy(&slot->event, event, sizeof(kernel_event_t));
+    slot->enqueued_ns = wait_queue_now_ns();
+    sub->tail++;
+    __atomic_add_fetch(&dispatch.pending, 1, __ATOMIC_ACQ_REL);
+    
+    sub->stats.enqueued++;
+    sub->stats.queued = sub->tail - sub->head;
+    if (sub->stats.queued > sub->stats.max_queued) {
+        sub->stats.max_queued = sub->stats.queued;
+    }
+    
+    int schedule = !sub->scheduled;
+    sub->scheduled = 1;
+    spin_unlock(&sub->lock);
+    
+    if (schedule) {
+        event_schedule(sub);
+    }
+    
+    return 0;
+}
+
+static void event_burst_deliver(event_subscriber_t *sub, kernel_event_t *event, uint32_t count,
+                                event_defer_list_t *defer)
+{
+    event->coalesced_count = count;
+    
+    if (__atomic_load_n(&sub->dead, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    
+    if (sub->delivery == EVENT_DELIVERY_ASYNC) {
+        event_enqueue(sub, event, defer);
+    } else {
+        sub->callback(event, sub->context);
+    }
+}
+
+static void event_burst_arm(event_subscriber_t *sub)
+{
+    __atomic_add_fetch(&sub->refs, 1, __ATOMIC_RELAXED);
+    
+    spin_lock(&dispatch.burst_lock);
+    list_add_tail(&sub->burst_list, &dispatch.bursts);
+    spin_unlock(&dispatch.burst_lock);
+    
+    __atomic_add_fetch(&dispatch.burst_seq, 1, __ATOMIC_RELEASE);
+    wait_queue_wake(&dispatch.work, 1);
+}
+
+/*
+ * Merge 'event' into the subscriber's open burst. A burst closes when its
+ * window elapses or an event of another type arrives; closed bursts are
+ * delivered by whoever notices first: this path, a dispatch worker or
+ * event_dispatch_drain()/flush().
+ */
+static void event_coalesce(event_subscriber_t *sub, const kernel_event_t *event, event_defer_list_t *defer)
+{
+    kernel_event_t closed;
+    uint32_t closed_count = 0;
+    uint64_t now = wait_queue_now_ns();
+    
+    spin_lock(&sub->lock);
+    if (sub->burst_count &&
+        (sub->burst.event_type != event->event_type || now - sub->burst_start_ns >= sub->window_ns)) {
+        memcpy(&closed, &sub->burst, sizeof(kernel_event_t));
+        closed_count = sub->burst_count;
+        sub->burst_count = 0;
+    }
+    
+    if (sub->burst_count) {
+        memcpy(&sub->burst, event, sizeof(kernel_event_t));
+        sub->burst_count++;
+        sub->stats.coalesced++;
+        spin_unlock(&sub->lock);
+        return;
+    }
+    
+    memcpy(&sub->burst, event, sizeof(kernel_event_t));
+    sub->burst_count = 1;
+    sub->burst_start_ns = now;
+    sub->stats.bursts++;
+    int arm = !sub->burst_armed;
+    sub->burst_armed = 1;
+    spin_unlock(&sub->lock);
+    
+    if (closed_count) {
+        event_burst_deliver(sub, &closed, closed_count, defer);
+    }
+    
+    if (arm) {
+        event_burst_arm(sub);
+    }
+}
+
+/*
+ * Pop one armed subscriber whose window has closed (any, if 'force') and
+ * copy out its burst. Subscribers whose burst a publisher already flushed
+ * come back with a zero count. 'next_ns' gets the earliest open deadline.
+ */
+static event_subscriber_t *event_burst_take(uint64_t now, int force, kernel_event_t *event,
+                                            uint32_t *count, uint64_t *next_ns)
+{
+    event_subscriber_t *found = NULL;
+    struct list_head *pos;
+    
+    *next_ns = 0;
+    
+    spin_lock(&dispatch.burst_lock);
+    list_for_each(pos, &dispatch.bursts) {
+        event_subscriber_t *sub = list_entry(pos, event_subscriber_t, burst_list);
+        
+        spin_lock(&sub->lock);
+        uint64_t deadline = sub->burst_start_ns + sub->window_ns;
+        if (sub->burst_count == 0 || force || now >= deadline) {
+            memcpy(event, &sub->burst, sizeof(kernel_event_t));
+            *count = sub->burst_count;
+            sub->burst_count = 0;
+            sub->burst_armed = 0;
+            spin_unlock(&sub->lock);
+            
+            list_del(&sub->burst_list);
+            found = sub;
+            break;
+        }
+        spin_unlock(&sub->lock);
+        
+        if (*next_ns == 0 || deadline < *next_ns) {
+            *next_ns = deadline;
+        }
+    }
+    spin_unlock(&dispatch.burst_lock);
+    
+    return found;
+}
+
+/* Deliver closed bursts. Returns the earliest open deadline, 0 if none. */
+static uint64_t event_burst_expire(int force)
+{
+    kernel_event_t event;
+    event_subscriber_t *sub;
+    uint32_t count = 0;
+    uint64_t next_ns = 0;
+    
+    while ((sub = event_burst_take(wait_queue_now_ns(), force, &event, &count, &next_ns)) != NULL) {
+        if (count) {
+            event_burst_deliver(sub, &event, count, NULL);
+        }
+        event_subscriber_put(sub);
+    }
+    
+    return next_ns;
+}
+
+static bool event_subscriber_wants(event_subscriber_t *sub, uint32_t event_type)
+{
+    uint64_t bits = __atomic_load_n(&sub->mask.bits[event_type / 64], __ATOMIC_RELAXED);
+    return (bits >> (event_type % 64)) & 1;
+}
+
+static int event_dispatch_one(event_subscriber_t *sub, const kernel_event_t *event, event_defer_list_t *defer)
+{
+    if (__atomic_load_n(&sub->dead, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    
+    if (sub->filter.length && !event_filter_match(&sub->filter, event)) {
+        __atomic_add_fetch(&sub->stats.filtered, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    
+    if (sub->window_ns) {
+        event_coalesce(sub, event, defer);
+        return 1;
+    }
+    
+    if (sub->delivery == EVENT_DELIVERY_ASYNC) {
+        return event_enqueue(sub, event, defer) == 0;
+    }
+    
+    return sub->callback(event, sub->context) == 0;
+}
+
+static event_subscriber_t *event_subscriber_create(int subscriber_id, uint32_t event_type,
+                                                   event_callback_t callback, void *context,
+                                                   const event_subscription_opts_t *opts)
+{
+    event_subscriber_t *subscriber = (event_subscriber_t *)calloc(1, sizeof(event_subscriber_t));
+    if (!subscriber) {
+        return NULL;
+    }
+    
+    subscriber->subscriber_id = subscriber_id;
+    subscriber->callback = callback;
+    subscriber->context = context;
+    subscriber->subscribed_events = event_type;
+    subscriber->refs = 1;
+    wait_queue_init(&subscriber->not_full);
+    
+    if (opts && opts->delivery == EVENT_DELIVERY_ASYNC) {
+        uint32_t depth = 1;
+        uint32_t wanted = opts->queue_depth ? opts->queue_depth : EVENT_ASYNC_QUEUE_DEPTH;
+        while (depth < wanted) {
+            depth <<= 1;
+        }
+    
+        subscriber->queue = (event_queue_slot_t *)calloc(depth, sizeof(event_queue_slot_t));
+        if (!subscriber->queue) {
+            free(subscriber);
+            return NULL;
+        }
+        subscriber->queue_mask = depth - 1;
+        subscriber->delivery = EVENT_DELIVERY_ASYNC;
+        subscriber->backpressure = opts->backpressure;
+    }
+    
+    if (opts && opts->filter) {
+        memcpy(&subscriber->filter, opts->filter, sizeof(event_filter_t));
+    }
+    
+    if (opts) {
+        subscriber->window_ns = opts->coalesce_window_ns;
+    }
+    
+    return subscriber;
+}
+
+int event_subscribe_ex(int subscriber_id, uint32_t event_type, event_callback_t callback,
+                       void *context, const event_subscription_opts_t *opts)
 {
     if (event_type >= MAX_EVENT_TYPES || !callback) {
         return -1;
@@ -44,21 +570,105 @@ int event_subscribe(int subscriber_id, uint32_t event_type, event_callback_t cal
         return -1;
     }
     
-    event_subscriber_t *subscriber = (event_subscriber_t *)malloc(sizeof(event_subscriber_t));
+    event_subscriber_t *subscriber = event_subscriber_create(subscriber_id, event_type, callback,
+                                                             context, opts);
     if (!subscriber) {
         return -1;
     }
     
-    subscriber->subscriber_id = subscriber_id;
-    subscriber->callback = callback;
-    subscriber->context = context;
-    subscriber->subscribed_events = event_type;
+    event_registry_entry_t *entry = &event_registry[event_type];
+    spin_lock(&entry->lock);
+    rcu_list_add_tail(&subscriber->list, &entry->subscribers);
+    spin_unlock(&entry->lock);
+    
+    return 0;
+}
+
+int event_subscribe(int subscriber_id, uint32_t event_type, event_callback_t callback, void *context)
+{
+    return event_subscribe_ex(subscriber_id, event_type, callback, context, NULL);
+}
+
+int event_subscribe_mask(int subscriber_id, const event_mask_t *mask, event_callback_t callback,
+                         void *context, const event_subscription_opts_t *opts)
+{
+    if (!mask || !callback || !initialized) {
+        return -1;
+    }
+    
+    uint64_t any = 0;
+    for (int i = 0; i < MAX_EVENT_TYPES / 64; i++) {
+        any |= mask->bits[i];
+    }
     
-    list_add_tail(&subscriber->list, &event_registry[event_type].subscribers);
+    if (!any) {
+        return -1;
+    }
+    
+    event_subscriber_t *subscriber = event_subscriber_create(subscriber_id, MAX_EVENT_TYPES, callback,
+                                                             context, opts);
+    if (!subscriber) {
+        return -1;
+    }
+    memcpy(&subscriber->mask, mask, sizeof(event_mask_t));
+    
+    spin_lock(&event_mask_lock);
+    rcu_list_add_tail(&subscriber->list, &event_mask_subscribers);
+    spin_unlock(&event_mask_lock);
     
     return 0;
 }
 
+/*
+ * Drop 'event_type' from the mask subscribers owned by 'subscriber_id' (all
+ * owners if 'any_owner'), or their whole mask for MAX_EVENT_TYPES. Nodes
+ * left with an empty mask are unlinked. Returns the number of types removed.
+ */
+static int event_mask_remove(int subscriber_id, int any_owner, uint32_t event_type)
+{
+    int removed = 0;
+    
+    for (;;) {
+        event_subscriber_t *victim = NULL;
+        struct list_head *pos;
+        
+        spin_lock(&event_mask_lock);
+        list_for_each(pos, &event_mask_subscribers) {
+            event_subscriber_t *sub = list_entry(pos, event_subscriber_t, list);
+            
+            if (!any_owner && sub->subscriber_id != subscriber_id) continue;
+            
+            if (event_type == MAX_EVENT_TYPES) {
+                for (int i = 0; i < MAX_EVENT_TYPES / 64; i++) {
+                    removed += __builtin_popcountll(sub->mask.bits[i]);
+                }
+                victim = sub;
+            } else if (event_subscriber_wants(sub, event_type)) {
+                uint64_t bit = 1ULL << (event_type % 64);
+                uint64_t left = __atomic_and_fetch(&sub->mask.bits[event_type / 64], ~bit, __ATOMIC_RELAXED);
+                removed++;
+                
+                for (int i = 0; i < MAX_EVENT_TYPES / 64 && !left; i++) {
+                    left |= sub->mask.bits[i];
+                }
+                if (!left) victim = sub;
+            }
+            
+            if (victim) {
+                rcu_list_del(&victim->list);
+                break;
+            }
+        }
+        spin_unlock(&event_mask_lock);
+        
+        if (!victim) break;
+        
+        event_subscriber_release(victim);
+    }
+    
+    return removed;
+}
+
 int event_unsubscribe(int subscriber_id, uint32_t event_type)
 {
     if (event_type >= MAX_EVENT_TYPES) {
@@ -70,19 +680,27 @@ int event_unsubscribe(int subscriber_id, uint32_t event_type)
     }
     
     event_registry_entry_t *entry = &event_registry[event_type];
-    struct list_head *pos, *tmp;
+    event_subscriber_t *found = NULL;
+    struct list_head *pos;
     
-    list_for_each_safe(pos, tmp, &entry->subscribers) {
+    spin_lock(&entry->lock);
+    list_for_each(pos, &entry->subscribers) {
         event_subscriber_t *sub = list_entry(pos, event_subscriber_t, list);
         
         if (sub->subscriber_id == subscriber_id) {
-            list_del(&sub->list);
-            free(sub);
-            return 0;
+            rcu_list_del(&sub->list);
+            found = sub;
+            break;
         }
     }
+    spin_unlock(&entry->lock);
+    
+    if (!found) {
+        return event_mask_remove(subscriber_id, 0, event_type) > 0 ? 0 : -1;
+    }
     
-    return -1;
+    event_subscriber_release(found);
+    return 0;
 }
 
 int event_publish(const kernel_event_t *event)
@@ -96,23 +714,40 @@ int event_publish(const kernel_event_t *event)
     }
     
     event_registry_entry_t *entry = &event_registry[event->event_type];
-    entry->event_count++;
-    entry->last_timestamp = event->timestamp;
+    this_cpu_inc(event_counts[event->event_type]);
+    __atomic_store_n(&entry->last_timestamp, event->timestamp, __ATOMIC_RELAXED);
     
     struct list_head *pos;
     int handled = 0;
+    event_defer_list_t defer;
     
-    list_for_each(pos, &entry->subscribers) {
+    defer.items = defer.inline_items;
+    defer.count = 0;
+    defer.capacity = EVENT_DEFER_INLINE;
+    
+    rcu_read_lock();
+    rcu_list_for_each(pos, &entry->subscribers) {
+        handled += event_dispatch_one(list_entry(pos, event_subscriber_t, list), event, &defer);
+    }
+    
+    rcu_list_for_each(pos, &event_mask_subscribers) {
         event_subscriber_t *sub = list_entry(pos, event_subscriber_t, list);
         
-        if (sub->callback) {
-            int result = sub->callback(event, sub->context);
-            if (result == 0) {
-                handled++;
-            }
+        if (event_subscriber_wants(sub, event->event_type)) {
+            handled += event_dispatch_one(sub, event, &defer);
         }
     }
+    rcu_read_unlock();
+    
+    for (uint32_t i = 0; i < defer.count; i++) {
+        event_enqueue(defer.items[i].sub, &defer.items[i].event, NULL);
+        event_subscriber_put(defer.items[i].sub);
+    }
+    if (defer.items != defer.inline_items) {
+        free(defer.items);
+    }
     
+    AEGIS_TRACE(event, publish, event->event_type, event->event_id, event->source_id, handled);
     return handled;
 }
 
@@ -122,7 +757,7 @@ uint32_t event_get_count(uint32_t event_type)
         return 0;
     }
     
-    return event_registry[event_type].event_count;
+    return per_cpu_sum(event_counts[event_type]);
 }
 
 uint32_t event_get_last_timestamp(uint32_t event_type)
@@ -131,7 +766,47 @@ uint32_t event_get_last_timestamp(uint32_t event_type)
         return 0;
     }
     
-    return event_registry[event_type].last_timestamp;
+    return __atomic_load_n(&event_registry[event_type].last_timestamp, __ATOMIC_RELAXED);
+}
+
+int event_get_subscriber_stats(int subscriber_id, uint32_t event_type, event_subscriber_stats_t *stats)
+{
+    if (event_type >= MAX_EVENT_TYPES || !stats) {
+        return -1;
+    }
+    
+    struct list_head *pos;
+    int result = -1;
+    
+    rcu_read_lock();
+    rcu_list_for_each(pos, &event_registry[event_type].subscribers) {
+        event_subscriber_t *sub = list_entry(pos, event_subscriber_t, list);
+    
+        if (sub->subscriber_id == subscriber_id) {
+            spin_lock(&sub->lock);
+            memcpy(stats, &sub->stats, sizeof(event_subscriber_stats_t));
+            spin_unlock(&sub->lock);
+            result = 0;
+            break;
+        }
+    }
+    
+    if (result != 0) {
+        rcu_list_for_each(pos, &event_mask_subscribers) {
+            event_subscriber_t *sub = list_entry(pos, event_subscriber_t, list);
+    
+            if (sub->subscriber_id == subscriber_id && event_subscriber_wants(sub, event_type)) {
+                spin_lock(&sub->lock);
+                memcpy(stats, &sub->stats, sizeof(event_subscriber_stats_t));
+                spin_unlock(&sub->lock);
+                result = 0;
+                break;
+            }
+        }
+    }
+    rcu_read_unlock();
+    
+    return result;
 }
 
 int event_get_subscriber_count(uint32_t event_type)
@@ -143,10 +818,18 @@ int event_get_subscriber_count(uint32_t event_type)
     int count = 0;
     struct list_head *pos;
     
-    list_for_each(pos, &event_registry[event_type].subscribers) {
+    rcu_read_lock();
+    rcu_list_for_each(pos, &event_registry[event_type].subscribers) {
         count++;
     }
     
+    rcu_list_for_each(pos, &event_mask_subscribers) {
+        if (event_subscriber_wants(list_entry(pos, event_subscriber_t, list), event_type)) {
+            count++;
+        }
+    }
+    rcu_read_unlock();
+    
     return count;
 }
 
@@ -157,12 +840,12 @@ void event_print_registry(void)
     printf("-----------|-------------|------------\n");
     
     for (int i = 0; i < MAX_EVENT_TYPES; i++) {
-        event_registry_entry_t *entry = &event_registry[i];
+        uint32_t count = per_cpu_sum(event_counts[i]);
         
-        if (entry->event_count > 0 || event_get_subscriber_count(i) > 0) {
+        if (count > 0 || event_get_subscriber_count(i) > 0) {
             printf("%-10d | %-11u | %-11d\n",
                    i,
-                   entry->event_count,
+                   count,
                    event_get_subscriber_count(i));
         }
     }
@@ -175,17 +858,25 @@ int event_clear_subscribers(uint32_t event_type)
     }
     
     event_registry_entry_t *entry = &event_registry[event_type];
-    struct list_head *pos, *tmp;
     int removed = 0;
     
-    list_for_each_safe(pos, tmp, &entry->subscribers) {
-        event_subscriber_t *sub = list_entry(pos, event_subscriber_t, list);
-        list_del(&sub->list);
-        free(sub);
+    for (;;) {
+        event_subscriber_t *sub = NULL;
+        
+        spin_lock(&entry->lock);
+        if (!list_empty(&entry->subscribers)) {
+            sub = list_entry(entry->subscribers.next, event_subscriber_t, list);
+            rcu_list_del(&sub->list);
+        }
+        spin_unlock(&entry->lock);
+        
+        if (!sub) break;
+        
+        event_subscriber_release(sub);
         removed++;
     }
     
-    return removed;
+    return removed + event_mask_remove(0, 1, event_type);
 }
 
 int event_subscribe_all(int subscriber_id, event_callback_t callback, void *context)
@@ -194,15 +885,14 @@ int event_subscribe_all(int subscriber_id, event_callback_t callback, void *cont
         return -1;
     }
     
-    int subscribed = 0;
+    event_mask_t mask;
+    memset(&mask, 0xff, sizeof(mask));
     
-    for (int i = 0; i < MAX_EVENT_TYPES; i++) {
-        if (event_subscribe(subscriber_id, i, callback, context) == 0) {
-            subscribed++;
-        }
+    if (event_subscribe_mask(subscriber_id, &mask, callback, context, NULL) != 0) {
+        return 0;
     }
     
-    return subscribed;
+    return MAX_EVENT_TYPES;
 }
 
 int event_unsubscribe_all(int subscriber_id)
@@ -215,5 +905,117 @@ int event_unsubscribe_all(int subscriber_id)
         }
     }
     
-    return unsubscribed;
+    return unsubscribed + event_mask_remove(subscriber_id, 0, MAX_EVENT_TYPES);
+}
+
+static bool event_worker_has_work(void *arg)
+{
+    uint32_t *burst_seq = (uint32_t *)arg;
+    
+    return __atomic_load_n(&dispatch.ready_count, __ATOMIC_ACQUIRE) > 0 ||
+           __atomic_load_n(&dispatch.stopping, __ATOMIC_ACQUIRE) ||
+           __atomic_load_n(&dispatch.burst_seq, __ATOMIC_ACQUIRE) != *burst_seq;
+}
+
+static int event_worker_main(void *arg)
+{
+    while (!__atomic_load_n(&dispatch.stopping, __ATOMIC_ACQUIRE)) {
+        event_subscriber_t *sub = event_pop_ready();
+        if (!sub) {
+            /* Idle workers also close coalescing windows, sleeping until the next one is due. */
+            uint32_t burst_seq = __atomic_load_n(&dispatch.burst_seq, __ATOMIC_ACQUIRE);
+            uint64_t deadline = event_burst_expire(0);
+            uint64_t now = wait_queue_now_ns();
+            uint64_t timeout = 0;
+            
+            if (deadline) {
+                timeout = deadline > now ? deadline - now : 1;
+            }
+            wait_queue_wait(&dispatch.work, NULL, event_worker_has_work, &burst_seq, timeout);
+            continue;
+        }
+    
+        int more = 0;
+        event_deliver(sub, EVENT_WORKER_BATCH, &more);
+        if (more) {
+            event_schedule(sub);
+        }
+        event_subscriber_put(sub);
+    }
+    
+    return 0;
+}
+
+int event_dispatch_start(uint32_t workers)
+{
+    if (!initialized || dispatch.worker_count) {
+        return -1;
+    }
+    
+    if (workers == 0 || workers > EVENT_MAX_WORKERS) {
+        workers = workers ? EVENT_MAX_WORKERS : 1;
+    }
+    
+    __atomic_store_n(&dispatch.stopping, 0, __ATOMIC_RELEASE);
+    
+    uint32_t started = 0;
+    for (uint32_t i = 0; i < workers; i++) {
+        dispatch.workers[i] = kthread_run("event_worker", event_worker_main, NULL);
+        if (!dispatch.workers[i]) break;
+        started++;
+    }
+    
+    __atomic_store_n(&dispatch.worker_count, started, __ATOMIC_RELEASE);
+    return (int)started;
+}
+
+void event_dispatch_stop(void)
+{
+    uint32_t workers = dispatch.worker_count;
+    if (!workers) return;
+    
+    __atomic_store_n(&dispatch.stopping, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&dispatch.work);
+    
+    for (uint32_t i = 0; i < workers; i++) {
+        kthread_stop(dispatch.workers[i]);
+        dispatch.workers[i] = NULL;
+    }
+    
+    __atomic_store_n(&dispatch.worker_count, 0, __ATOMIC_RELEASE);
+}
+
+int event_dispatch_drain(void)
+{
+    int delivered = 0;
+    event_subscriber_t *sub;
+    
+    event_burst_expire(0);
+    
+    while ((sub = event_pop_ready()) != NULL) {
+        int more = 0;
+        delivered += (int)event_deliver(sub, (uint32_t)-1, &more);
+        event_subscriber_put(sub);
+    }
+    
+    return delivered;
+}
+
+static bool event_dispatch_idle(void *arg)
+{
+    return __atomic_load_n(&dispatch.pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+void event_dispatch_flush(void)
+{
+    if (!initialized) return;
+    
+    event_burst_expire(1);
+    
+    if (__atomic_load_n(&dispatch.worker_count, __ATOMIC_ACQUIRE) == 0) {
+        event_dispatch_drain();
+        return;
+    }
+    
+    wait_queue_wait(&dispatch.idle, NULL, event_dispatch_idle, NULL, 0);
 }
@@ -1,4 +1,6 @@
 #include <kernel/filesystem.h>
+#include <kernel/spinlock.h>
+#include <kernel/tracepoint.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -8,7 +10,7 @@ typedef struct {
     fs_superblock_t superblock;
     transaction_t *active_transactions[256];
     u32 txn_count;
-    uint lock;
+    spinlock_t lock;
 } fs_state_t;
 
 static fs_state_t fs_state = {0};
@@ -17,6 +19,7 @@ static u64 next_txn_id = 1;
 int aegisfs_init(void)
 {
     memset(&fs_state, 0, sizeof(fs_state));
+    spin_lock_init(&fs_state.lock);
 
     fs_state.superblock.magic = 0x4147495300000000UL;
     fs_state.superblock.total_blocks = 0x100000;
@@ -47,7 +50,6 @@ inode_t *aegisfs_create_file(const char *path, u32 mode)
     inode_t *inode = (inode_t *)malloc(sizeof(inode_t));
     if (!inode) return NULL;
 
-    inode->ino = fs_state.inode_count + 1;
     inode->type = INODE_TYPE_FILE;
     inode->mode = mode;
     inode->size = 0;
@@ -59,26 +61,81 @@ inode_t *aegisfs_create_file(const char *path, u32 mode)
     inode->ctime = 0;
     inode->link_count = 1;
     inode->encrypted = false;
-    inode->block_ptrs = (u64 *)malloc(256 * sizeof(u64));
+    inode->block_ptrs = (u64 *)calloc(AEGISFS_MAX_BLOCKS, sizeof(u64));
 
+    spin_lock(&fs_state.lock);
     if (fs_state.inode_count < 8192) {
+        inode->ino = fs_state.inode_count + 1;
         fs_state.inode_table[fs_state.inode_count++] = inode;
+        spin_unlock(&fs_state.lock);
         return inode;
     }
+    spin_unlock(&fs_state.lock);
 
     free(inode->block_ptrs);
     free(inode);
     return NULL;
 }
 
+static page_buffer_t *aegisfs_block_page(inode_t *inode, u64 block)
+{
+    if (!inode->block_ptrs || block >= AEGISFS_MAX_BLOCKS) return NULL;
+    return (page_buffer_t *)(uintptr_t)inode->block_ptrs[block];
+}
+
+/*
+ * Blocks installed by aegisfs_attach_page may still be referenced by a
+ * pipe or another file. Give the inode a private copy before writing;
+ * bytes past the end of the file are not carried over.
+ */
+static page_buffer_t *aegisfs_unshare_page(inode_t *inode, u64 block, page_buffer_t *page)
+{
+    if (__atomic_load_n(&page->ref_count, __ATOMIC_ACQUIRE) == 1) return page;
+
+    page_buffer_t *copy = mmgr_page_buffer_alloc();
+    if (!copy) return NULL;
+
+    u64 start = block * PAGE_SIZE;
+    u64 valid = 0;
+    if (inode->size > start) {
+        valid = inode->size - start;
+        if (valid > PAGE_SIZE) valid = PAGE_SIZE;
+    }
+
+    memcpy(copy->data, page->data, valid);
+    memset(copy->data + valid, 0, PAGE_SIZE - valid);
+
+    inode->block_ptrs[block] = (u64)(uintptr_t)copy;
+    mmgr_page_buffer_put(page);
+    return copy;
+}
+
+static void aegisfs_release_blocks(inode_t *inode)
+{
+    if (!inode->block_ptrs) return;
+
+    for (u64 i = 0; i < AEGISFS_MAX_BLOCKS; i++) {
+        page_buffer_t *page = aegisfs_block_page(inode, i);
+        if (page) {
+            mmgr_page_buffer_put(page);
+        }
+    }
+
+    free(inode->block_ptrs);
+    inode->block_ptrs = NULL;
+}
+
 int aegisfs_delete_file(const char *path)
 {
     if (!path) return -1;
 
+    spin_lock(&fs_state.lock);
     for (u32 i = 0; i < fs_state.inode_count; i++) {
-        free(fs_state.inode_table[i]->block_ptrs);
+        aegisfs_release_blocks(fs_state.inode_table[i]);
         free(fs_state.inode_table[i]);
     }
+    fs_state.inode_count = 0;
+    spin_unlock(&fs_state.lock);
 
     return 0;
 }
@@ -86,11 +143,43 @@ int aegisfs_delete_file(const char *path)
 int aegisfs_write(inode_t *inode, u64 offset, const void *data, u64 size)
 {
     if (!inode || !data) return -1;
+    if (!inode->block_ptrs) return -1;
+
+    u64 limit = (u64)AEGISFS_MAX_BLOCKS * PAGE_SIZE;
+    if (offset >= limit) return 0;
+    if (size > limit - offset) size = limit - offset;
+
+    u64 written = 0;
+    while (written < size) {
+        u64 pos = offset + written;
+        u64 block = pos / PAGE_SIZE;
+        u64 in_page = pos % PAGE_SIZE;
+        u64 chunk = PAGE_SIZE - in_page;
+        if (chunk > size - written) chunk = size - written;
+
+        page_buffer_t *page = aegisfs_block_page(inode, block);
+        if (!page) {
+            page = mmgr_page_buffer_alloc();
+            if (!page) break;
+            memset(page->data, 0, PAGE_SIZE);
+            inode->block_ptrs[block] = (u64)(uintptr_t)page;
+            inode->blocks++;
+        } else {
+            page = aegisfs_unshare_page(inode, block, page);
+            if (!page) break;
+        }
+
+        memcpy(page->data + in_page, (const u8 *)data + written, chunk);
+        written += chunk;
+    }
 
-    inode->size += size;
+    if (offset + written > inode->size) {
+        inode->size = offset + written;
+    }
     inode->mtime = 0;
 
-    return (int)size;
+    AEGIS_TRACE(aegisfs, write, inode->ino, offset, size, written);
+    return (int)written;
 }
 
 int aegisfs_read(inode_t *inode, u64 offset, void *data, u64 size)
@@ -102,24 +191,84 @@ int aegisfs_read(inode_t *inode, u64 offset, void *data, u64 size)
     u64 readable = inode->size - offset;
     u64 to_read = (size < readable) ? size : readable;
 
+    u64 done = 0;
+    while (done < to_read) {
+        u64 pos = offset + done;
+        u64 in_page = pos % PAGE_SIZE;
+        u64 chunk = PAGE_SIZE - in_page;
+        if (chunk > to_read - done) chunk = to_read - done;
+
+        page_buffer_t *page = aegisfs_block_page(inode, pos / PAGE_SIZE);
+        if (page) {
+            memcpy((u8 *)data + done, page->data + in_page, chunk);
+        } else {
+            memset((u8 *)data + done, 0, chunk);
+        }
+        done += chunk;
+    }
+
+    AEGIS_TRACE(aegisfs, read, inode->ino, offset, size, to_read);
     return (int)to_read;
 }
 
+page_buffer_t *aegisfs_get_page(inode_t *inode, u64 block)
+{
+    if (!inode) return NULL;
+
+    page_buffer_t *page = aegisfs_block_page(inode, block);
+    if (page) {
+        mmgr_page_buffer_get(page);
+    }
+
+    return page;
+}
+
+/*
+ * Install a caller-owned page reference as file block 'block' without
+ * copying it. Any page previously cached at that block is released. The
+ * page may stay shared; aegisfs_write copies it before modifying it.
+ */
+int aegisfs_attach_page(inode_t *inode, u64 block, page_buffer_t *page, u32 length)
+{
+    if (!inode || !page || !inode->block_ptrs) return -1;
+    if (block >= AEGISFS_MAX_BLOCKS || length > PAGE_SIZE) return -1;
+
+    page_buffer_t *old = aegisfs_block_page(inode, block);
+    if (old) {
+        mmgr_page_buffer_put(old);
+    } else {
+        inode->blocks++;
+    }
+
+    inode->block_ptrs[block] = (u64)(uintptr_t)page;
+
+    u64 end = block * PAGE_SIZE + length;
+    if (end > inode->size) {
+        inode->size = end;
+    }
+    inode->mtime = 0;
+
+    return 0;
+}
+
 transaction_t *aegisfs_begin_transaction(void)
 {
     transaction_t *txn = (transaction_t *)malloc(sizeof(transaction_t));
     if (!txn) return NULL;
 
-    txn->txn_id = next_txn_id++;
+    txn->txn_id = __atomic_fetch_add(&next_txn_id, 1, __ATOMIC_RELAXED);
     txn->timestamp = 0;
     txn->state = TXN_BEGIN;
     txn->blocks = (u64 *)malloc(256 * sizeof(u64));
     txn->block_count = 0;
 
+    spin_lock(&fs_state.lock);
     if (fs_state.txn_count < 256) {
         fs_state.active_transactions[fs_state.txn_count++] = txn;
+        spin_unlock(&fs_state.lock);
         return txn;
     }
+    spin_unlock(&fs_state.lock);
 
     free(txn->blocks);
     free(txn);
@@ -132,6 +281,7 @@ int aegisfs_commit_transaction(transaction_t *txn)
 
     txn->state = TXN_COMMIT;
 
+    spin_lock(&fs_state.lock);
     for (u32 i = 0; i < fs_state.txn_count; i++) {
         if (fs_state.active_transactions[i]->txn_id == txn->txn_id) {
             for (u32 j = i; j < fs_state.txn_count - 1; j++) {
@@ -141,6 +291,7 @@ int aegisfs_commit_transaction(transaction_t *txn)
             break;
         }
     }
+    spin_unlock(&fs_state.lock);
 
     return 0;
 }
@@ -151,6 +302,7 @@ int aegisfs_rollback_transaction(transaction_t *txn)
 
     txn->state = TXN_ROLLBACK;
 
+    spin_lock(&fs_state.lock);
     for (u32 i = 0; i < fs_state.txn_count; i++) {
         if (fs_state.active_transactions[i]->txn_id == txn->txn_id) {
             for (u32 j = i; j < fs_state.txn_count - 1; j++) {
@@ -160,6 +312,7 @@ int aegisfs_rollback_transaction(transaction_t *txn)
             break;
         }
     }
+    spin_unlock(&fs_state.lock);
 
     return 0;
 }
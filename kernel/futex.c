@@ -0,0 +1,52 @@
+#include <kernel/futex.h>
+
+/*
+ * Address-keyed wait/wake. Each word hashes to one of a fixed set of wait
+ * queues; the word itself is only compared under the bucket lock, after
+ * the waiter has been queued, so a waker that changes the word and then
+ * calls futex_wake() can never slip between the check and the sleep.
+ */
+
+static wait_queue_t futex_buckets[FUTEX_HASH_BUCKETS];
+
+static wait_queue_t *futex_bucket(const u32 *addr)
+{
+    uintptr_t key = (uintptr_t)addr;
+    key ^= key >> 16;
+    key *= 0x9E3779B1u;
+    return &futex_buckets[(key >> 8) & (FUTEX_HASH_BUCKETS - 1)];
+}
+
+int futex_init(void)
+{
+    for (u32 i = 0; i < FUTEX_HASH_BUCKETS; i++) {
+        wait_queue_init(&futex_buckets[i]);
+    }
+    return 0;
+}
+
+int futex_wait(u32 *addr, u32 expected, thread_t *thread, u64 timeout_ns)
+{
+    if (!addr) return -1;
+
+    wait_queue_t *wq = futex_bucket(addr);
+    wait_queue_entry_t entry = { .thread = thread, .key = (uintptr_t)addr };
+
+    wait_queue_lock(wq);
+    wait_queue_add_locked(wq, &entry);
+    if (__atomic_load_n(addr, __ATOMIC_SEQ_CST) != expected) {
+        wait_queue_remove_locked(wq, &entry);
+        wait_queue_unlock(wq);
+        return FUTEX_EAGAIN;
+    }
+    wait_queue_unlock(wq);
+
+    return wait_queue_sleep(wq, &entry, timeout_ns);
+}
+
+int futex_wake(u32 *addr, u32 count)
+{
+    if (!addr) return -1;
+
+    return (int)wait_queue_wake_key(futex_bucket(addr), (uintptr_t)addr, count);
+}
@@ -0,0 +1,103 @@
+#include <kernel/hdr_histogram.h>
+#include <kernel/percpu.h>
+#include <stdlib.h>
+#include <string.h>
+
+void hdr_hist_reset(hdr_hist_t *hist)
+{
+    if (hist) memset(hist, 0, sizeof(*hist));
+}
+
+/* 'src' may still be recording; the result is then not a snapshot. */
+void hdr_hist_merge(hdr_hist_t *dst, const hdr_hist_t *src)
+{
+    if (!dst || !src) return;
+
+    if (__atomic_load_n(&src->count, __ATOMIC_RELAXED) == 0) return;
+
+    for (u32 b = 0; b < HDR_BUCKETS; b++) {
+        dst->buckets[b] += __atomic_load_n(&src->buckets[b], __ATOMIC_RELAXED);
+    }
+    dst->count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+    dst->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+
+    u64 max = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+    if (max > dst->max) dst->max = max;
+}
+
+u64 hdr_bucket_upper(u32 bucket)
+{
+    if (bucket < 2 * HDR_SUB_COUNT) return bucket;
+    if (bucket >= HDR_BUCKETS - 1) return ~0ULL;
+
+    u32 shift = bucket / HDR_SUB_COUNT - 1;
+    u64 mantissa = bucket - shift * HDR_SUB_COUNT;
+
+    return ((mantissa + 1) << shift) - 1;
+}
+
+u64 hdr_hist_quantile(const hdr_hist_t *hist, u32 per_mille)
+{
+    if (!hist || hist->count == 0) return 0;
+    if (per_mille > 1000) per_mille = 1000;
+
+    u64 target = (hist->count * per_mille + 999) / 1000;
+    if (target == 0) target = 1;
+
+    u64 seen = 0;
+    for (u32 b = 0; b < HDR_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= target) {
+            u64 upper = hdr_bucket_upper(b);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+
+    return hist->max;
+}
+
+/* Sized for the CPUs brought up by percpu_init(); pages for idle CPUs stay untouched. */
+hdr_percpu_hist_t *hdr_percpu_alloc(void)
+{
+    u32 nr_cpus = percpu_nr_cpus();
+    hdr_percpu_hist_t *hist = (hdr_percpu_hist_t *)calloc(1, sizeof(hdr_percpu_hist_t) +
+                                                          nr_cpus * sizeof(hdr_hist_t));
+    if (!hist) return NULL;
+
+    hist->nr_cpus = nr_cpus;
+
+    return hist;
+}
+
+void hdr_percpu_free(hdr_percpu_hist_t *hist)
+{
+    free(hist);
+}
+
+void hdr_percpu_record(hdr_percpu_hist_t *hist, u64 value)
+{
+    if (!hist) return;
+
+    hdr_hist_record(&hist->cpu[percpu_current_cpu() % hist->nr_cpus], value);
+}
+
+void hdr_percpu_merge(const hdr_percpu_hist_t *hist, hdr_hist_t *out)
+{
+    if (!out) return;
+
+    hdr_hist_reset(out);
+    if (!hist) return;
+
+    for (u32 cpu = 0; cpu < hist->nr_cpus; cpu++) {
+        hdr_hist_merge(out, &hist->cpu[cpu]);
+    }
+}
+
+void hdr_percpu_reset(hdr_percpu_hist_t *hist)
+{
+    if (!hist) return;
+
+    for (u32 cpu = 0; cpu < hist->nr_cpus; cpu++) {
+        hdr_hist_reset(&hist->cpu[cpu]);
+    }
+}
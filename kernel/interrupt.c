@@ -1,33 +1,96 @@
 #include <kernel/interrupt.h>
+#include <kernel/percpu.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Per-CPU bottom-half state. Softirqs raised on a CPU run on that CPU when
+ * its outermost interrupt exits, for at most IED_SOFTIRQ_BUDGET_NS; work
+ * left over stays pending for the next exit or ied_process_events().
+ */
+typedef struct {
+    u32 softirq_pending;
+    u32 in_softirq;
+    u32 hardirq_depth;
+    spinlock_t tasklet_lock;
+    tasklet_t *tasklet_head;
+    tasklet_t **tasklet_tail;
+    spinlock_t event_lock;
+    event_queue_t *events;
+    ied_cpu_stats_t stats;
+} ied_cpu_t;
 
 typedef struct {
     irq_descriptor_t irq_table[MAX_IRQ_HANDLERS];
     irq_stat_t irq_stats[MAX_IRQ_HANDLERS];
-    event_queue_t event_queue;
-    uint lock;
+    softirq_action_t softirq_vec[NR_SOFTIRQS];
+    ied_affinity_hook_t affinity_hook;
+    u32 isolated_cpus;
+    spinlock_t lock;
+    seqlock_t affinity_seq;
 } ied_state_t;
 
 static ied_state_t ied_state = {0};
+static ied_cpu_t ied_cpus[MAX_CPUS];
+
+/* Handled-interrupt counts, summed over CPUs by ied_get_irq_stat(). */
+static DEFINE_PER_CPU(u64, ied_irq_count[MAX_IRQ_HANDLERS]);
+
+static void ied_stat_max(u64 *max, u64 value)
+{
+    u64 old = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > old &&
+           !__atomic_compare_exchange_n(max, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void ied_tasklet_action(u32 cpu);
+static void ied_event_action(u32 cpu);
+
+static void ied_stop_irq_thread(irq_descriptor_t *desc)
+{
+    if (!desc->thread) return;
+
+    __atomic_store_n(&desc->thread_exit, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&desc->thread_wait);
+    kthread_stop(desc->thread);
+    desc->thread = NULL;
+}
 
 int ied_init(void)
 {
+    for (u32 i = 0; i < MAX_IRQ_HANDLERS; i++) {
+        ied_stop_irq_thread(&ied_state.irq_table[i]);
+    }
+
+    for (u32 i = 0; i < MAX_CPUS; i++) {
+        free(ied_cpus[i].events);
+    }
+
     memset(ied_state.irq_table, 0, sizeof(ied_state.irq_table));
     memset(ied_state.irq_stats, 0, sizeof(ied_state.irq_stats));
-    memset(&ied_state.event_queue, 0, sizeof(ied_state.event_queue));
-    ied_state.lock = 0;
+    memset(ied_state.softirq_vec, 0, sizeof(ied_state.softirq_vec));
+    memset(ied_cpus, 0, sizeof(ied_cpus));
+    spin_lock_init(&ied_state.lock);
+    seqlock_init(&ied_state.affinity_seq);
 
     for (u32 i = 0; i < MAX_IRQ_HANDLERS; i++) {
         ied_state.irq_table[i].irq = i;
         ied_state.irq_table[i].handler = NULL;
+        ied_state.irq_table[i].affinity = IED_AFFINITY_ALL;
+        wait_queue_init(&ied_state.irq_table[i].thread_wait);
+        wait_queue_init(&ied_state.irq_table[i].thread_done);
         ied_state.irq_stats[i].irq = i;
-        ied_state.irq_stats[i].count = 0;
     }
 
-    ied_state.event_queue.head = 0;
-    ied_state.event_queue.tail = 0;
-    ied_state.event_queue.event_count = 0;
+    for (u32 i = 0; i < MAX_CPUS; i++) {
+        ied_cpus[i].tasklet_tail = &ied_cpus[i].tasklet_head;
+    }
+    per_cpu_reset(ied_irq_count);
+
+    ied_state.softirq_vec[SOFTIRQ_EVENT] = ied_event_action;
+    ied_state.softirq_vec[SOFTIRQ_TASKLET] = ied_tasklet_action;
 
     return 0;
 }
@@ -36,11 +99,110 @@ int ied_register_irq(u32 irq, irq_handler_t handler, void *dev_id, irq_type_t ty
 {
     if (irq >= MAX_IRQ_HANDLERS) return -1;
 
+    spin_lock(&ied_state.lock);
+    if (ied_state.irq_table[irq].primary || ied_state.irq_table[irq].thread_fn) {
+        spin_unlock(&ied_state.lock);
+        return -1;
+    }
     ied_state.irq_table[irq].irq = irq;
     ied_state.irq_table[irq].handler = handler;
     ied_state.irq_table[irq].dev_id = dev_id;
     ied_state.irq_table[irq].type = type;
+    spin_unlock(&ied_state.lock);
+
+    return 0;
+}
+
+static bool ied_irq_thread_has_work(void *arg)
+{
+    irq_descriptor_t *desc = (irq_descriptor_t *)arg;
+
+    return __atomic_load_n(&desc->thread_pending, __ATOMIC_ACQUIRE) ||
+           __atomic_load_n(&desc->thread_exit, __ATOMIC_ACQUIRE);
+}
+
+static int ied_irq_thread_main(void *arg)
+{
+    irq_descriptor_t *desc = (irq_descriptor_t *)arg;
+    irq_stat_t *stat = &ied_state.irq_stats[desc->irq];
+
+    for (;;) {
+        wait_queue_wait(&desc->thread_wait, NULL, ied_irq_thread_has_work, desc, 0);
+
+        if (__atomic_load_n(&desc->thread_exit, __ATOMIC_ACQUIRE)) break;
+
+        __atomic_store_n(&desc->thread_running, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&desc->thread_pending, 0, __ATOMIC_RELEASE);
+
+        u64 start = wait_queue_now_ns();
+        desc->thread_fn(desc->irq, desc->dev_id);
+        u64 elapsed = wait_queue_now_ns() - start;
+
+        __atomic_add_fetch(&stat->thread_count, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stat->thread_ns, elapsed, __ATOMIC_RELAXED);
+        ied_stat_max(&stat->max_thread_ns, elapsed);
+
+        if (desc->type == IRQ_TYPE_LEVEL) {
+            __atomic_store_n(&desc->masked, 0, __ATOMIC_RELEASE);
+        }
+
+        __atomic_store_n(&desc->thread_running, 0, __ATOMIC_RELEASE);
+        wait_queue_wake_all(&desc->thread_done);
+    }
+
+    return 0;
+}
+
+static irq_return_t ied_default_primary(u32 irq, void *dev_id)
+{
+    (void)irq;
+    (void)dev_id;
+    return IRQ_WAKE_THREAD;
+}
+
+int ied_request_threaded_irq(u32 irq, irq_primary_handler_t handler, irq_thread_handler_t thread_fn,
+                             void *dev_id, irq_type_t type)
+{
+    if (irq >= MAX_IRQ_HANDLERS) return -1;
+    if (!handler && !thread_fn) return -1;
+
+    irq_descriptor_t *desc = &ied_state.irq_table[irq];
+
+    /* Claim the line; thread_fn keeps other requests out while the thread starts. */
+    spin_lock(&ied_state.lock);
+    if (desc->handler || desc->primary || desc->thread_fn) {
+        spin_unlock(&ied_state.lock);
+        return -1;
+    }
+
+    desc->irq = irq;
+    desc->dev_id = dev_id;
+    desc->type = type;
+    desc->thread_fn = thread_fn;
+    desc->thread_pending = 0;
+    desc->thread_exit = 0;
+    desc->masked = 0;
+    spin_unlock(&ied_state.lock);
+
+    kthread_t *thread = NULL;
+    if (thread_fn) {
+        char name[KTHREAD_NAME_LEN];
+        snprintf(name, sizeof(name), "irq/%u", irq);
+
+        thread = kthread_run(name, ied_irq_thread_main, desc);
+        if (!thread) {
+            spin_lock(&ied_state.lock);
+            desc->thread_fn = NULL;
+            desc->dev_id = NULL;
+            spin_unlock(&ied_state.lock);
+            return -1;
+        }
+    }
 
+    spin_lock(&ied_state.lock);
+    desc->thread = thread;
+    __atomic_store_n(&desc->primary, handler ? handler : ied_default_primary, __ATOMIC_RELEASE);
+    spin_unlock(&ied_state.lock);
     return 0;
 }
 
@@ -48,8 +210,17 @@ int ied_unregister_irq(u32 irq)
 {
     if (irq >= MAX_IRQ_HANDLERS) return -1;
 
-    ied_state.irq_table[irq].handler = NULL;
-    ied_state.irq_table[irq].dev_id = NULL;
+    irq_descriptor_t *desc = &ied_state.irq_table[irq];
+
+    spin_lock(&ied_state.lock);
+    desc->handler = NULL;
+    __atomic_store_n(&desc->primary, NULL, __ATOMIC_RELEASE);
+    spin_unlock(&ied_state.lock);
+
+    ied_stop_irq_thread(desc);
+    desc->thread_fn = NULL;
+    desc->dev_id = NULL;
+    desc->masked = 0;
 
     return 0;
 }
@@ -57,80 +228,458 @@ int ied_unregister_irq(u32 irq)
 int ied_enable_irq(u32 irq)
 {
     if (irq >= MAX_IRQ_HANDLERS) return -1;
+    __atomic_store_n(&ied_state.irq_table[irq].masked, 0, __ATOMIC_RELEASE);
     return 0;
 }
 
 int ied_disable_irq(u32 irq)
 {
     if (irq >= MAX_IRQ_HANDLERS) return -1;
+    __atomic_store_n(&ied_state.irq_table[irq].masked, 1, __ATOMIC_RELEASE);
     return 0;
 }
 
+u32 ied_current_cpu(void)
+{
+    return percpu_current_cpu();
+}
+
+/*
+ * Top half. The primary handler runs with the CPU marked in hardirq
+ * context; softirqs raised meanwhile run once the outermost handler exits.
+ */
+int ied_dispatch_irq_on(u32 cpu, u32 irq)
+{
+    if (irq >= MAX_IRQ_HANDLERS || cpu >= MAX_CPUS) return -1;
+
+    irq_descriptor_t *desc = &ied_state.irq_table[irq];
+    irq_stat_t *stat = &ied_state.irq_stats[irq];
+    irq_primary_handler_t primary = __atomic_load_n(&desc->primary, __ATOMIC_ACQUIRE);
+    irq_handler_t handler = desc->handler;
+
+    if (!primary && !handler) return -1;
+
+    if (__atomic_load_n(&desc->masked, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&stat->masked, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    ied_cpu_t *c = &ied_cpus[cpu];
+    u32 prev_cpu = percpu_set_current_cpu(cpu);
+    __atomic_add_fetch(&c->hardirq_depth, 1, __ATOMIC_ACQ_REL);
+
+    u64 start = wait_queue_now_ns();
+    irq_return_t ret = IRQ_HANDLED;
+    if (primary) {
+        ret = primary(irq, desc->dev_id);
+    } else {
+        handler(irq);
+    }
+    u64 now = wait_queue_now_ns();
+
+    per_cpu_add(ied_irq_count[irq], cpu, 1);
+    __atomic_add_fetch(&stat->hardirq_ns, now - start, __ATOMIC_RELAXED);
+    __atomic_store_n(&stat->last_handled, now, __ATOMIC_RELAXED);
+    ied_stat_max(&stat->max_hardirq_ns, now - start);
+    __atomic_add_fetch(&c->stats.irqs, 1, __ATOMIC_RELAXED);
+
+    if (ret == IRQ_WAKE_THREAD && desc->thread) {
+        if (desc->type == IRQ_TYPE_LEVEL) {
+            __atomic_store_n(&desc->masked, 1, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&desc->thread_pending, 1, __ATOMIC_RELEASE);
+        wait_queue_wake(&desc->thread_wait, 1);
+    } else if (ret == IRQ_NONE) {
+        __atomic_add_fetch(&stat->unhandled, 1, __ATOMIC_RELAXED);
+    }
+
+    if (__atomic_sub_fetch(&c->hardirq_depth, 1, __ATOMIC_ACQ_REL) == 0 &&
+        __atomic_load_n(&c->softirq_pending, __ATOMIC_ACQUIRE)) {
+        ied_do_softirq(cpu);
+    }
+    percpu_set_current_cpu(prev_cpu);
+
+    return ret == IRQ_NONE ? -1 : 0;
+}
+
 int ied_dispatch_irq(u32 irq)
+{
+    if (irq >= MAX_IRQ_HANDLERS) return -1;
+    return ied_dispatch_irq_on(__atomic_load_n(&ied_state.irq_table[irq].cpu, __ATOMIC_ACQUIRE), irq);
+}
+
+static bool ied_irq_thread_idle(void *arg)
+{
+    irq_descriptor_t *desc = (irq_descriptor_t *)arg;
+
+    return !__atomic_load_n(&desc->thread_pending, __ATOMIC_ACQUIRE) &&
+           !__atomic_load_n(&desc->thread_running, __ATOMIC_ACQUIRE);
+}
+
+/* Wait until any thread handler work already triggered for 'irq' is done. */
+int ied_synchronize_irq(u32 irq)
 {
     if (irq >= MAX_IRQ_HANDLERS) return -1;
 
     irq_descriptor_t *desc = &ied_state.irq_table[irq];
-    if (desc->handler) {
-        desc->handler(irq);
-        ied_state.irq_stats[irq].count++;
-        ied_state.irq_stats[irq].last_handled = 0;
+    if (!desc->thread) return 0;
+
+    return wait_queue_wait(&desc->thread_done, NULL, ied_irq_thread_idle, desc, 0);
+}
+
+int ied_open_softirq(u32 nr, softirq_action_t action)
+{
+    if (nr >= NR_SOFTIRQS || !action) return -1;
+
+    ied_state.softirq_vec[nr] = action;
+    return 0;
+}
+
+int ied_raise_softirq(u32 cpu, u32 nr)
+{
+    if (cpu >= MAX_CPUS || nr >= NR_SOFTIRQS) return -1;
+
+    __atomic_or_fetch(&ied_cpus[cpu].softirq_pending, 1u << nr, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+ * Run pending softirqs on 'cpu' in vector order, restarting while new ones
+ * are raised, until the budget or restart limit is hit. Only one context
+ * processes a CPU's softirqs at a time. Returns the number of actions run.
+ */
+int ied_do_softirq(u32 cpu)
+{
+    if (cpu >= MAX_CPUS) return -1;
+
+    ied_cpu_t *c = &ied_cpus[cpu];
+    if (__atomic_exchange_n(&c->in_softirq, 1, __ATOMIC_ACQUIRE)) return 0;
+
+    u32 prev_cpu = percpu_set_current_cpu(cpu);
+
+    u64 start = wait_queue_now_ns();
+    u32 restarts = 0;
+    int ran = 0;
+    u32 pending;
+
+    while ((pending = __atomic_exchange_n(&c->softirq_pending, 0, __ATOMIC_ACQ_REL)) != 0) {
+        for (u32 nr = 0; nr < NR_SOFTIRQS; nr++) {
+            if (!(pending & (1u << nr)) || !ied_state.softirq_vec[nr]) continue;
+
+            ied_state.softirq_vec[nr](cpu);
+            ran++;
+        }
+
+        if (!__atomic_load_n(&c->softirq_pending, __ATOMIC_ACQUIRE)) break;
+
+        if (wait_queue_now_ns() - start >= IED_SOFTIRQ_BUDGET_NS || ++restarts >= IED_SOFTIRQ_MAX_RESTART) {
+            c->stats.softirq_deferred++;
+            break;
+        }
+        c->stats.softirq_restarts++;
+    }
+
+    c->stats.softirq_runs += ran;
+    c->stats.softirq_ns += wait_queue_now_ns() - start;
+
+    percpu_set_current_cpu(prev_cpu);
+    __atomic_store_n(&c->in_softirq, 0, __ATOMIC_RELEASE);
+
+    return ran;
+}
+
+void ied_tasklet_init(tasklet_t *tasklet, void (*func)(void *data), void *data)
+{
+    if (!tasklet) return;
+
+    tasklet->next = NULL;
+    tasklet->state = 0;
+    tasklet->func = func;
+    tasklet->data = data;
+}
+
+static void ied_tasklet_queue(u32 cpu, tasklet_t *tasklet)
+{
+    ied_cpu_t *c = &ied_cpus[cpu];
+
+    spin_lock(&c->tasklet_lock);
+    tasklet->next = NULL;
+    *c->tasklet_tail = tasklet;
+    c->tasklet_tail = &tasklet->next;
+    spin_unlock(&c->tasklet_lock);
+
+    ied_raise_softirq(cpu, SOFTIRQ_TASKLET);
+}
+
+/* Queue on the current CPU; a tasklet already scheduled is not queued twice. */
+int ied_tasklet_schedule(tasklet_t *tasklet)
+{
+    if (!tasklet || !tasklet->func) return -1;
+
+    if (__atomic_fetch_or(&tasklet->state, TASKLET_STATE_SCHED, __ATOMIC_ACQ_REL) & TASKLET_STATE_SCHED) {
         return 0;
     }
 
-    return -1;
+    ied_tasklet_queue(percpu_current_cpu(), tasklet);
+    return 0;
+}
+
+static void ied_tasklet_action(u32 cpu)
+{
+    ied_cpu_t *c = &ied_cpus[cpu];
+
+    spin_lock(&c->tasklet_lock);
+    tasklet_t *list = c->tasklet_head;
+    c->tasklet_head = NULL;
+    c->tasklet_tail = &c->tasklet_head;
+    spin_unlock(&c->tasklet_lock);
+
+    while (list) {
+        tasklet_t *tasklet = list;
+        list = list->next;
+
+        /* Never run a tasklet concurrently with itself on another CPU. */
+        if (__atomic_fetch_or(&tasklet->state, TASKLET_STATE_RUN, __ATOMIC_ACQUIRE) & TASKLET_STATE_RUN) {
+            ied_tasklet_queue(cpu, tasklet);
+            continue;
+        }
+
+        __atomic_and_fetch(&tasklet->state, ~TASKLET_STATE_SCHED, __ATOMIC_ACQ_REL);
+        tasklet->func(tasklet->data);
+        __atomic_and_fetch(&tasklet->state, ~TASKLET_STATE_RUN, __ATOMIC_RELEASE);
+        c->stats.tasklets++;
+    }
 }
 
 int ied_post_event(event_t *event)
 {
     if (!event) return -1;
 
-    if (ied_state.event_queue.event_count >= 1024) {
+    u32 cpu = percpu_current_cpu();
+    ied_cpu_t *c = &ied_cpus[cpu];
+
+    spin_lock(&c->event_lock);
+    if (!c->events) {
+        c->events = (event_queue_t *)calloc(1, sizeof(event_queue_t));
+    }
+
+    if (!c->events || c->events->event_count >= IED_EVENT_QUEUE_SIZE) {
+        spin_unlock(&c->event_lock);
         return -1;
     }
 
-    u32 idx = (ied_state.event_queue.tail) % 1024;
-    ied_state.event_queue.events[idx] = event;
-    ied_state.event_queue.tail++;
-    ied_state.event_queue.event_count++;
+    u32 idx = c->events->tail % IED_EVENT_QUEUE_SIZE;
+    c->events->events[idx] = event;
+    c->events->tail++;
+    c->events->event_count++;
+    spin_unlock(&c->event_lock);
 
+    ied_raise_softirq(cpu, SOFTIRQ_EVENT);
     return 0;
 }
 
-event_t *ied_get_event(void)
+static event_t *ied_pop_event(u32 cpu)
 {
-    if (ied_state.event_queue.event_count == 0) {
-        return NULL;
-    }
+    ied_cpu_t *c = &ied_cpus[cpu];
+    event_t *event = NULL;
 
-    u32 idx = (ied_state.event_queue.head) % 1024;
-    event_t *event = ied_state.event_queue.events[idx];
-    ied_state.event_queue.head++;
-    ied_state.event_queue.event_count--;
+    spin_lock(&c->event_lock);
+    if (c->events && c->events->event_count > 0) {
+        u32 idx = c->events->head % IED_EVENT_QUEUE_SIZE;
+        event = c->events->events[idx];
+        c->events->head++;
+        c->events->event_count--;
+    }
+    spin_unlock(&c->event_lock);
 
     return event;
 }
 
-int ied_process_events(void)
+event_t *ied_get_event(void)
+{
+    return ied_pop_event(percpu_current_cpu());
+}
+
+/* Events run in batches so one busy queue cannot eat the softirq budget. */
+static void ied_event_action(u32 cpu)
 {
     event_t *event;
-    while ((event = ied_get_event()) != NULL) {
+
+    for (u32 i = 0; i < IED_EVENT_BATCH; i++) {
+        if ((event = ied_pop_event(cpu)) == NULL) return;
+
         if (event->handler) {
             event->handler(event->data);
         }
     }
 
+    ied_raise_softirq(cpu, SOFTIRQ_EVENT);
+}
+
+int ied_process_events(void)
+{
+    for (u32 cpu = 0; cpu < MAX_CPUS; cpu++) {
+        while (__atomic_load_n(&ied_cpus[cpu].softirq_pending, __ATOMIC_ACQUIRE)) {
+            if (ied_do_softirq(cpu) <= 0) break;
+        }
+    }
+
+    return 0;
+}
+
+static int ied_route_irq(irq_descriptor_t *desc, u32 cpu)
+{
+    ied_affinity_hook_t hook = __atomic_load_n(&ied_state.affinity_hook, __ATOMIC_ACQUIRE);
+
+    if (hook && hook(desc->irq, 1U << cpu) != 0) {
+        return -1;
+    }
+
+    __atomic_store_n(&desc->cpu, cpu, __ATOMIC_RELEASE);
     return 0;
 }
 
+/*
+ * Restrict 'irq' to the CPUs in 'cpu_mask'. Isolated CPUs are dropped from
+ * the mask unless they are all that was asked for. The interrupt keeps its
+ * current target if that is still allowed, otherwise it moves to the lowest
+ * allowed CPU.
+ */
 int ied_set_irq_affinity(u32 irq, u32 cpu_mask)
+{
+    if (irq >= MAX_IRQ_HANDLERS || cpu_mask == 0) return -1;
+
+    irq_descriptor_t *desc = &ied_state.irq_table[irq];
+    u32 allowed = cpu_mask & ~ied_state.isolated_cpus;
+    if (!allowed) {
+        allowed = cpu_mask;
+    }
+
+    write_seqlock(&ied_state.affinity_seq);
+
+    u32 cpu = desc->cpu;
+    if (cpu >= IED_AFFINITY_CPUS || !(allowed & (1U << cpu))) {
+        cpu = (u32)__builtin_ctz(allowed);
+    }
+
+    int ret = ied_route_irq(desc, cpu);
+    if (ret == 0) {
+        __atomic_store_n(&desc->affinity, cpu_mask, __ATOMIC_RELAXED);
+    }
+
+    write_sequnlock(&ied_state.affinity_seq);
+    return ret;
+}
+
+int ied_get_irq_affinity(u32 irq, u32 *cpu_mask, u32 *cpu)
 {
     if (irq >= MAX_IRQ_HANDLERS) return -1;
+
+    irq_descriptor_t *desc = &ied_state.irq_table[irq];
+    u32 seq, mask, target;
+
+    do {
+        seq = read_seqbegin(&ied_state.affinity_seq);
+        mask = __atomic_load_n(&desc->affinity, __ATOMIC_RELAXED);
+        target = __atomic_load_n(&desc->cpu, __ATOMIC_RELAXED);
+    } while (read_seqretry(&ied_state.affinity_seq, seq));
+
+    if (cpu_mask) *cpu_mask = mask;
+    if (cpu) *cpu = target;
+    return 0;
+}
+
+/* Move 'irq' to a single CPU within its affinity mask. */
+int ied_set_irq_cpu(u32 irq, u32 cpu)
+{
+    if (irq >= MAX_IRQ_HANDLERS || cpu >= IED_AFFINITY_CPUS) return -1;
+
+    irq_descriptor_t *desc = &ied_state.irq_table[irq];
+    int ret = -1;
+
+    write_seqlock(&ied_state.affinity_seq);
+    if (desc->affinity & (1U << cpu)) {
+        ret = ied_route_irq(desc, cpu);
+    }
+    write_sequnlock(&ied_state.affinity_seq);
+
+    return ret;
+}
+
+void ied_set_affinity_hook(ied_affinity_hook_t hook)
+{
+    __atomic_store_n(&ied_state.affinity_hook, hook, __ATOMIC_RELEASE);
+}
+
+void ied_set_isolated_cpus(u32 cpu_mask)
+{
+    ied_state.isolated_cpus = cpu_mask;
+}
+
+u32 ied_get_isolated_cpus(void)
+{
+    return ied_state.isolated_cpus;
+}
+
+/* Parse a kernel-style CPU list such as "2,4-6" (as in isolcpus=). */
+int ied_parse_cpulist(const char *list, u32 *cpu_mask)
+{
+    if (!list || !cpu_mask) return -1;
+
+    u32 mask = 0;
+    const char *p = list;
+
+    while (*p) {
+        char *end;
+        unsigned long first = strtoul(p, &end, 10);
+        unsigned long last = first;
+
+        if (end == p) return -1;
+        p = end;
+
+        if (*p == '-') {
+            p++;
+            last = strtoul(p, &end, 10);
+            if (end == p) return -1;
+            p = end;
+        }
+
+        if (last < first || last >= IED_AFFINITY_CPUS) return -1;
+
+        for (unsigned long cpu = first; cpu <= last; cpu++) {
+            mask |= 1U << cpu;
+        }
+
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+
+    *cpu_mask = mask;
     return 0;
 }
 
 u64 ied_get_irq_stat(u32 irq)
 {
     if (irq >= MAX_IRQ_HANDLERS) return 0;
-    return ied_state.irq_stats[irq].count;
+    return per_cpu_sum(ied_irq_count[irq]);
+}
+
+int ied_get_irq_stats(u32 irq, irq_stat_t *stats)
+{
+    if (irq >= MAX_IRQ_HANDLERS || !stats) return -1;
+
+    memcpy(stats, &ied_state.irq_stats[irq], sizeof(irq_stat_t));
+    stats->count = per_cpu_sum(ied_irq_count[irq]);
+    return 0;
+}
+
+int ied_get_cpu_stats(u32 cpu, ied_cpu_stats_t *stats)
+{
+    if (cpu >= MAX_CPUS || !stats) return -1;
+
+    memcpy(stats, &ied_cpus[cpu].stats, sizeof(ied_cpu_stats_t));
+    return 0;
 }
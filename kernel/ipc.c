@@ -1,13 +1,24 @@
 #include <kernel/ipc.h>
+#include <kernel/process.h>
+#include <kernel/futex.h>
 #include <string.h>
 #include <stdlib.h>
 
+typedef struct {
+    u64 object_id;
+    address_space_t *as;
+    u64 virt_addr;
+    u32 page_count;
+} ipc_shm_attachment_t;
+
 typedef struct {
     ipc_object_t *objects[4096];
     u32 object_count;
     signal_handler_t handlers[256];
     u32 handler_count;
-    uint lock;
+    ipc_shm_attachment_t attachments[IPC_MAX_SHM_ATTACHMENTS];
+    u32 attachment_count;
+    spinlock_t lock;
 } ipc_state_t;
 
 static ipc_state_t ipc_state = {0};
@@ -16,22 +27,53 @@ static u64 next_ipc_id = 1;
 int ipc_init(void)
 {
     memset(&ipc_state, 0, sizeof(ipc_state));
+    spin_lock_init(&ipc_state.lock);
     return 0;
 }
 
+static u64 ipc_next_id(void)
+{
+    return __atomic_fetch_add(&next_ipc_id, 1, __ATOMIC_RELAXED);
+}
+
+static int ipc_track_object(ipc_object_t *obj)
+{
+    int ret = -1;
+
+    spin_lock(&ipc_state.lock);
+    if (ipc_state.object_count < 4096) {
+        ipc_state.objects[ipc_state.object_count++] = obj;
+        ret = 0;
+    }
+    spin_unlock(&ipc_state.lock);
+
+    return ret;
+}
+
+static void ipc_untrack_object(ipc_object_t *obj)
+{
+    spin_lock(&ipc_state.lock);
+    for (u32 i = 0; i < ipc_state.object_count; i++) {
+        if (ipc_state.objects[i] == obj) {
+            ipc_state.objects[i] = ipc_state.objects[--ipc_state.object_count];
+            break;
+        }
+    }
+    spin_unlock(&ipc_state.lock);
+}
+
 ipc_object_t *ipc_create_message_queue(u64 src_pid, u64 dst_pid)
 {
     ipc_object_t *obj = (ipc_object_t *)malloc(sizeof(ipc_object_t));
     if (!obj) return NULL;
 
-    obj->id = next_ipc_id++;
+    obj->id = ipc_next_id();
     obj->type = IPC_TYPE_MESSAGE;
     obj->sender_pid = src_pid;
     obj->receiver_pid = dst_pid;
     obj->secure = true;
 
-    if (ipc_state.object_count < 4096) {
-        ipc_state.objects[ipc_state.object_count++] = obj;
+    if (ipc_track_object(obj) == 0) {
         return obj;
     }
 
@@ -59,75 +101,496 @@ message_t *ipc_receive_message(ipc_object_t *obj, u64 timeout)
     return &obj->data.msg;
 }
 
-ipc_object_t *ipc_create_pipe(u64 src_pid, u64 dst_pid)
+static void ipc_pipe_lock(ipc_object_t *obj)
+{
+    spin_lock(&obj->data.pipe.lock);
+}
+
+static void ipc_pipe_unlock(ipc_object_t *obj)
+{
+    spin_unlock(&obj->data.pipe.lock);
+}
+
+static void ipc_pipe_notify(ipc_object_t *obj, u32 events)
+{
+    ipc_pipe_notify_t notify = obj->data.pipe.notify;
+    if (notify) {
+        notify(obj->id, events, obj->data.pipe.notify_context);
+    }
+}
+
+static bool ipc_pipe_full(ipc_object_t *obj)
+{
+    return obj->data.pipe.tail - obj->data.pipe.head == obj->data.pipe.slot_count;
+}
+
+static bool ipc_pipe_readable(void *arg)
+{
+    ipc_object_t *obj = (ipc_object_t *)arg;
+    return __atomic_load_n(&obj->data.pipe.tail, __ATOMIC_ACQUIRE) !=
+           __atomic_load_n(&obj->data.pipe.head, __ATOMIC_ACQUIRE) ||
+           __atomic_load_n(&obj->data.pipe.writer_closed, __ATOMIC_ACQUIRE);
+}
+
+static bool ipc_pipe_writable(void *arg)
+{
+    ipc_object_t *obj = (ipc_object_t *)arg;
+    return __atomic_load_n(&obj->data.pipe.tail, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&obj->data.pipe.head, __ATOMIC_ACQUIRE) < obj->data.pipe.slot_count ||
+           __atomic_load_n(&obj->data.pipe.reader_closed, __ATOMIC_ACQUIRE);
+}
+
+static ipc_pipe_buffer_t *ipc_pipe_slot(ipc_object_t *obj, u32 index)
+{
+    return &obj->data.pipe.slots[index & (obj->data.pipe.slot_count - 1)];
+}
+
+ipc_object_t *ipc_create_pipe_ex(u64 src_pid, u64 dst_pid, u64 capacity, u32 flags)
 {
+    u32 slot_count = 1;
+    u64 pages = (capacity + PAGE_SIZE - 1) / PAGE_SIZE;
+    while (slot_count < pages) {
+        slot_count <<= 1;
+    }
+    if (slot_count < 2) slot_count = 2;
+
     ipc_object_t *obj = (ipc_object_t *)malloc(sizeof(ipc_object_t));
     if (!obj) return NULL;
 
-    obj->id = next_ipc_id++;
+    memset(obj, 0, sizeof(ipc_object_t));
+    obj->id = ipc_next_id();
     obj->type = IPC_TYPE_PIPE;
     obj->sender_pid = src_pid;
     obj->receiver_pid = dst_pid;
     obj->secure = true;
 
-    obj->data.pipe.buffer = (u8 *)malloc(4096);
-    obj->data.pipe.size = 4096;
-    obj->data.pipe.read_pos = 0;
-    obj->data.pipe.write_pos = 0;
+    obj->data.pipe.slots = (ipc_pipe_buffer_t *)calloc(slot_count, sizeof(ipc_pipe_buffer_t));
+    if (!obj->data.pipe.slots) {
+        free(obj);
+        return NULL;
+    }
+    obj->data.pipe.slot_count = slot_count;
+    obj->data.pipe.flags = flags;
+    wait_queue_init(&obj->data.pipe.readers);
+    wait_queue_init(&obj->data.pipe.writers);
 
-    if (ipc_state.object_count < 4096) {
-        ipc_state.objects[ipc_state.object_count++] = obj;
+    if (ipc_track_object(obj) == 0) {
         return obj;
     }
 
-    free(obj->data.pipe.buffer);
+    free(obj->data.pipe.slots);
     free(obj);
     return NULL;
 }
 
+ipc_object_t *ipc_create_pipe(u64 src_pid, u64 dst_pid)
+{
+    return ipc_create_pipe_ex(src_pid, dst_pid, IPC_PIPE_DEFAULT_PAGES * PAGE_SIZE, 0);
+}
+
+int ipc_destroy_pipe(ipc_object_t *obj)
+{
+    if (!obj || obj->type != IPC_TYPE_PIPE) return -1;
+
+    for (u32 i = obj->data.pipe.head; i != obj->data.pipe.tail; i++) {
+        mmgr_page_buffer_put(ipc_pipe_slot(obj, i)->page);
+    }
+
+    ipc_untrack_object(obj);
+
+    free(obj->data.pipe.slots);
+    free(obj);
+    return 0;
+}
+
+/*
+ * Copy as much of 'data' as fits. Bytes are appended to the last queued
+ * page while the pipe owns it exclusively; spliced pages are shared with
+ * a file and are never written into.
+ */
+static u64 ipc_pipe_write_locked(ipc_object_t *obj, const u8 *data, u64 size)
+{
+    u64 written = 0;
+
+    if (obj->data.pipe.tail != obj->data.pipe.head) {
+        ipc_pipe_buffer_t *last = ipc_pipe_slot(obj, obj->data.pipe.tail - 1);
+        u32 end = last->offset + last->len;
+
+        if (last->page->ref_count == 1 && end < PAGE_SIZE) {
+            u64 chunk = PAGE_SIZE - end;
+            if (chunk > size) chunk = size;
+            memcpy(last->page->data + end, data, chunk);
+            last->len += (u32)chunk;
+            written += chunk;
+        }
+    }
+
+    while (written < size && !ipc_pipe_full(obj)) {
+        page_buffer_t *page = mmgr_page_buffer_alloc();
+        if (!page) break;
+
+        u64 chunk = size - written;
+        if (chunk > PAGE_SIZE) chunk = PAGE_SIZE;
+        memcpy(page->data, data + written, chunk);
+
+        ipc_pipe_buffer_t *slot = ipc_pipe_slot(obj, obj->data.pipe.tail);
+        slot->page = page;
+        slot->offset = 0;
+        slot->len = (u32)chunk;
+        __atomic_store_n(&obj->data.pipe.tail, obj->data.pipe.tail + 1, __ATOMIC_RELEASE);
+        written += chunk;
+    }
+
+    obj->data.pipe.bytes += written;
+    return written;
+}
+
+static u64 ipc_pipe_read_locked(ipc_object_t *obj, u8 *data, u64 max_size)
+{
+    u64 done = 0;
+
+    while (done < max_size && obj->data.pipe.head != obj->data.pipe.tail) {
+        ipc_pipe_buffer_t *slot = ipc_pipe_slot(obj, obj->data.pipe.head);
+
+        u64 chunk = slot->len;
+        if (chunk > max_size - done) chunk = max_size - done;
+        memcpy(data + done, slot->page->data + slot->offset, chunk);
+
+        slot->offset += (u32)chunk;
+        slot->len -= (u32)chunk;
+        done += chunk;
+
+        if (slot->len == 0) {
+            mmgr_page_buffer_put(slot->page);
+            slot->page = NULL;
+            __atomic_store_n(&obj->data.pipe.head, obj->data.pipe.head + 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    obj->data.pipe.bytes -= done;
+    return done;
+}
+
 int ipc_write_pipe(ipc_object_t *obj, const void *data, u64 size)
 {
     if (!obj || !data) return -1;
     if (obj->type != IPC_TYPE_PIPE) return -1;
 
-    u64 available = obj->data.pipe.size - (obj->data.pipe.write_pos - obj->data.pipe.read_pos);
-    u64 to_write = (size < available) ? size : available;
-
-    if (to_write > 0) {
-        memcpy(obj->data.pipe.buffer + (obj->data.pipe.write_pos % obj->data.pipe.size), data, to_write);
-        obj->data.pipe.write_pos += to_write;
+    u64 written = 0;
+
+    for (;;) {
+        ipc_pipe_lock(obj);
+        if (obj->data.pipe.reader_closed) {
+            ipc_pipe_unlock(obj);
+            return written ? (int)written : IPC_EPIPE;
+        }
+        u64 chunk = ipc_pipe_write_locked(obj, (const u8 *)data + written, size - written);
+        bool nonblock = obj->data.pipe.flags & IPC_PIPE_NONBLOCK;
+        ipc_pipe_unlock(obj);
+
+        if (chunk) {
+            written += chunk;
+            wait_queue_wake_all(&obj->data.pipe.readers);
+            ipc_pipe_notify(obj, IPC_POLL_IN);
+        }
+
+        if (written == size) break;
+        if (nonblock) {
+            return written ? (int)written : IPC_EAGAIN;
+        }
+        wait_queue_wait(&obj->data.pipe.writers, NULL, ipc_pipe_writable, obj, 0);
     }
 
-    return (int)to_write;
+    return (int)written;
 }
 
 int ipc_read_pipe(ipc_object_t *obj, void *data, u64 max_size)
 {
     if (!obj || !data) return -1;
     if (obj->type != IPC_TYPE_PIPE) return -1;
+    if (max_size == 0) return 0;
+
+    for (;;) {
+        ipc_pipe_lock(obj);
+        u64 done = ipc_pipe_read_locked(obj, (u8 *)data, max_size);
+        bool eof = obj->data.pipe.writer_closed;
+        bool nonblock = obj->data.pipe.flags & IPC_PIPE_NONBLOCK;
+        ipc_pipe_unlock(obj);
+
+        if (done) {
+            wait_queue_wake_all(&obj->data.pipe.writers);
+            ipc_pipe_notify(obj, IPC_POLL_OUT);
+            return (int)done;
+        }
+        if (eof) return 0;
+        if (nonblock) return IPC_EAGAIN;
+        wait_queue_wait(&obj->data.pipe.readers, NULL, ipc_pipe_readable, obj, 0);
+    }
+}
 
-    u64 available = obj->data.pipe.write_pos - obj->data.pipe.read_pos;
-    u64 to_read = (max_size < available) ? max_size : available;
+int ipc_pipe_set_nonblocking(ipc_object_t *obj, bool nonblocking)
+{
+    if (!obj || obj->type != IPC_TYPE_PIPE) return -1;
 
-    if (to_read > 0) {
-        memcpy(data, obj->data.pipe.buffer + (obj->data.pipe.read_pos % obj->data.pipe.size), to_read);
-        obj->data.pipe.read_pos += to_read;
+    ipc_pipe_lock(obj);
+    if (nonblocking) {
+        obj->data.pipe.flags |= IPC_PIPE_NONBLOCK;
+    } else {
+        obj->data.pipe.flags &= ~IPC_PIPE_NONBLOCK;
     }
+    ipc_pipe_unlock(obj);
+
+    return 0;
+}
+
+int ipc_pipe_set_notify(ipc_object_t *obj, ipc_pipe_notify_t notify, void *context)
+{
+    if (!obj || obj->type != IPC_TYPE_PIPE) return -1;
+
+    ipc_pipe_lock(obj);
+    obj->data.pipe.notify = notify;
+    obj->data.pipe.notify_context = context;
+    ipc_pipe_unlock(obj);
 
-    return (int)to_read;
+    return 0;
+}
+
+u32 ipc_pipe_poll(ipc_object_t *obj)
+{
+    if (!obj || obj->type != IPC_TYPE_PIPE) return 0;
+
+    u32 events = 0;
+
+    ipc_pipe_lock(obj);
+    if (obj->data.pipe.head != obj->data.pipe.tail) events |= IPC_POLL_IN;
+    if (!ipc_pipe_full(obj) && !obj->data.pipe.reader_closed) events |= IPC_POLL_OUT;
+    if (obj->data.pipe.writer_closed || obj->data.pipe.reader_closed) events |= IPC_POLL_HUP;
+    ipc_pipe_unlock(obj);
+
+    return events;
+}
+
+int ipc_pipe_close_reader(ipc_object_t *obj)
+{
+    if (!obj || obj->type != IPC_TYPE_PIPE) return -1;
+
+    ipc_pipe_lock(obj);
+    __atomic_store_n(&obj->data.pipe.reader_closed, true, __ATOMIC_RELEASE);
+    ipc_pipe_unlock(obj);
+
+    wait_queue_wake_all(&obj->data.pipe.writers);
+    ipc_pipe_notify(obj, IPC_POLL_HUP);
+    return 0;
+}
+
+int ipc_pipe_close_writer(ipc_object_t *obj)
+{
+    if (!obj || obj->type != IPC_TYPE_PIPE) return -1;
+
+    ipc_pipe_lock(obj);
+    __atomic_store_n(&obj->data.pipe.writer_closed, true, __ATOMIC_RELEASE);
+    ipc_pipe_unlock(obj);
+
+    wait_queue_wake_all(&obj->data.pipe.readers);
+    ipc_pipe_notify(obj, IPC_POLL_HUP);
+    return 0;
+}
+
+/*
+ * Queue references to the file's cached pages. Neither side copies; the
+ * page stays shared until both the file and the reader drop it.
+ */
+int ipc_splice_from_file(ipc_object_t *obj, inode_t *inode, u64 offset, u64 size)
+{
+    if (!obj || !inode) return -1;
+    if (obj->type != IPC_TYPE_PIPE) return -1;
+
+    if (offset >= inode->size) return 0;
+    if (size > inode->size - offset) size = inode->size - offset;
+
+    u64 moved = 0;
+
+    ipc_pipe_lock(obj);
+    if (obj->data.pipe.reader_closed) {
+        ipc_pipe_unlock(obj);
+        return IPC_EPIPE;
+    }
+
+    while (moved < size && !ipc_pipe_full(obj)) {
+        u64 pos = offset + moved;
+        u32 in_page = (u32)(pos % PAGE_SIZE);
+        u64 chunk = PAGE_SIZE - in_page;
+        if (chunk > size - moved) chunk = size - moved;
+
+        page_buffer_t *page = aegisfs_get_page(inode, pos / PAGE_SIZE);
+        if (!page) break;
+
+        ipc_pipe_buffer_t *slot = ipc_pipe_slot(obj, obj->data.pipe.tail);
+        slot->page = page;
+        slot->offset = in_page;
+        slot->len = (u32)chunk;
+        __atomic_store_n(&obj->data.pipe.tail, obj->data.pipe.tail + 1, __ATOMIC_RELEASE);
+        moved += chunk;
+    }
+
+    obj->data.pipe.bytes += moved;
+    ipc_pipe_unlock(obj);
+
+    if (moved) {
+        wait_queue_wake_all(&obj->data.pipe.readers);
+        ipc_pipe_notify(obj, IPC_POLL_IN);
+    }
+
+    return (moved || size == 0) ? (int)moved : IPC_EAGAIN;
+}
+
+/*
+ * Drain the pipe into the file. Whole, page-aligned buffers are handed
+ * to the file's page cache as-is; anything else goes through a copy.
+ */
+int ipc_splice_to_file(ipc_object_t *obj, inode_t *inode, u64 offset, u64 size)
+{
+    if (!obj || !inode) return -1;
+    if (obj->type != IPC_TYPE_PIPE) return -1;
+
+    u64 moved = 0;
+
+    ipc_pipe_lock(obj);
+    while (moved < size && obj->data.pipe.head != obj->data.pipe.tail) {
+        ipc_pipe_buffer_t *slot = ipc_pipe_slot(obj, obj->data.pipe.head);
+        u64 pos = offset + moved;
+        u64 chunk = slot->len;
+        if (chunk > size - moved) chunk = size - moved;
+
+        if (pos % PAGE_SIZE == 0 && slot->offset == 0 && chunk == slot->len &&
+            (chunk == PAGE_SIZE || pos + chunk >= inode->size)) {
+            if (aegisfs_attach_page(inode, pos / PAGE_SIZE, slot->page, (u32)chunk) != 0) break;
+            slot->page = NULL;
+        } else {
+            int n = aegisfs_write(inode, pos, slot->page->data + slot->offset, chunk);
+            if (n <= 0) break;
+            chunk = (u64)n;
+        }
+
+        slot->offset += (u32)chunk;
+        slot->len -= (u32)chunk;
+        moved += chunk;
+
+        if (slot->len == 0) {
+            mmgr_page_buffer_put(slot->page);
+            slot->page = NULL;
+            __atomic_store_n(&obj->data.pipe.head, obj->data.pipe.head + 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    obj->data.pipe.bytes -= moved;
+    bool eof = obj->data.pipe.writer_closed;
+    ipc_pipe_unlock(obj);
+
+    if (moved) {
+        wait_queue_wake_all(&obj->data.pipe.writers);
+        ipc_pipe_notify(obj, IPC_POLL_OUT);
+        return (int)moved;
+    }
+
+    return (eof || size == 0) ? 0 : IPC_EAGAIN;
+}
+
+int ipc_splice_to_socket(ipc_object_t *obj, socket_t *sock, u64 size)
+{
+    if (!obj || !sock) return -1;
+    if (obj->type != IPC_TYPE_PIPE) return -1;
+
+    u64 moved = 0;
+    int result = 0;
+
+    ipc_pipe_lock(obj);
+    while (moved < size && obj->data.pipe.head != obj->data.pipe.tail) {
+        ipc_pipe_buffer_t *slot = ipc_pipe_slot(obj, obj->data.pipe.head);
+        u64 chunk = slot->len;
+        if (chunk > size - moved) chunk = size - moved;
+
+        result = network_send(sock, slot->page->data + slot->offset, chunk);
+        if (result <= 0) break;
+        chunk = (u64)result;
+
+        slot->offset += (u32)chunk;
+        slot->len -= (u32)chunk;
+        moved += chunk;
+
+        if (slot->len == 0) {
+            mmgr_page_buffer_put(slot->page);
+            slot->page = NULL;
+            __atomic_store_n(&obj->data.pipe.head, obj->data.pipe.head + 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    obj->data.pipe.bytes -= moved;
+    bool eof = obj->data.pipe.writer_closed;
+    ipc_pipe_unlock(obj);
+
+    if (moved) {
+        wait_queue_wake_all(&obj->data.pipe.writers);
+        ipc_pipe_notify(obj, IPC_POLL_OUT);
+        return (int)moved;
+    }
+    if (result < 0) return -1;
+
+    return (eof || size == 0) ? 0 : IPC_EAGAIN;
+}
+
+static u32 ipc_page_count(u64 size)
+{
+    return (u32)((size + PAGE_SIZE - 1) / PAGE_SIZE);
+}
+
+static prot_flags_t ipc_rights_to_prot(u32 rights)
+{
+    return (rights & IPC_GRANT_WRITE) ? (prot_flags_t)(PROT_READ | PROT_WRITE) : PROT_READ;
+}
+
+static u64 ipc_find_free_range(address_space_t *as, u32 page_count)
+{
+    u64 start = IPC_GRANT_WINDOW_BASE;
+    u64 end = start + (u64)page_count * PAGE_SIZE;
+    bool moved = true;
+
+    while (moved) {
+        moved = false;
+        for (u32 i = 0; i < as->vma_count; i++) {
+            vma_t *vma = &as->vmas[i];
+            if (vma->virt_addr < end && vma->virt_addr + vma->size > start) {
+                start = vma->virt_addr + vma->size;
+                end = start + (u64)page_count * PAGE_SIZE;
+                moved = true;
+            }
+        }
+    }
+
+    return start;
+}
+
+static address_space_t *ipc_get_address_space(u64 pid)
+{
+    process_t *proc = pmgr_get_process(pid);
+    if (!proc) return NULL;
+
+    return (address_space_t *)proc->page_table;
 }
 
 ipc_object_t *ipc_create_shared_memory(u64 owner_pid, u64 size)
 {
+    if (size == 0) return NULL;
+
     ipc_object_t *obj = (ipc_object_t *)malloc(sizeof(ipc_object_t));
     if (!obj) return NULL;
 
-    obj->id = next_ipc_id++;
+    obj->id = ipc_next_id();
     obj->type = IPC_TYPE_SHARED_MEMORY;
     obj->sender_pid = owner_pid;
     obj->secure = true;
 
-    obj->data.shm.memory = malloc(size);
+    obj->data.shm.memory = aligned_alloc(PAGE_SIZE, (u64)ipc_page_count(size) * PAGE_SIZE);
     obj->data.shm.size = size;
     obj->data.shm.owner_pid = owner_pid;
 
@@ -136,8 +599,7 @@ ipc_object_t *ipc_create_shared_memory(u64 owner_pid, u64 size)
         return NULL;
     }
 
-    if (ipc_state.object_count < 4096) {
-        ipc_state.objects[ipc_state.object_count++] = obj;
+    if (ipc_track_object(obj) == 0) {
         return obj;
     }
 
@@ -146,34 +608,215 @@ ipc_object_t *ipc_create_shared_memory(u64 owner_pid, u64 size)
     return NULL;
 }
 
+int ipc_map_shared_memory(ipc_object_t *obj, u64 pid, u32 rights, u64 *virt_addr)
+{
+    if (!obj || !virt_addr) return -1;
+    if (obj->type != IPC_TYPE_SHARED_MEMORY) return -1;
+    if (ipc_state.attachment_count >= IPC_MAX_SHM_ATTACHMENTS) return -1;
+
+    address_space_t *as = ipc_get_address_space(pid);
+    if (!as) return -1;
+
+    u32 pages = ipc_page_count(obj->data.shm.size);
+    if (as->vma_count + pages > MMGR_MAX_VMAS) return -1;
+
+    u64 virt = ipc_find_free_range(as, pages);
+    if (mmgr_map_pages(as, virt, (u64)obj->data.shm.memory, pages, ipc_rights_to_prot(rights)) != 0) {
+        return -1;
+    }
+
+    spin_lock(&ipc_state.lock);
+    if (ipc_state.attachment_count >= IPC_MAX_SHM_ATTACHMENTS) {
+        spin_unlock(&ipc_state.lock);
+        mmgr_unmap_pages(as, virt, pages);
+        return -1;
+    }
+
+    ipc_shm_attachment_t *att = &ipc_state.attachments[ipc_state.attachment_count++];
+    att->object_id = obj->id;
+    att->as = as;
+    att->virt_addr = virt;
+    att->page_count = pages;
+    spin_unlock(&ipc_state.lock);
+
+    *virt_addr = virt;
+    return 0;
+}
+
 void *ipc_attach_shared_memory(ipc_object_t *obj, u64 pid)
 {
     if (!obj) return NULL;
     if (obj->type != IPC_TYPE_SHARED_MEMORY) return NULL;
 
-    return obj->data.shm.memory;
+    u64 virt_addr;
+    if (ipc_map_shared_memory(obj, pid, IPC_GRANT_READ | IPC_GRANT_WRITE, &virt_addr) != 0) {
+        return NULL;
+    }
+
+    return (void *)virt_addr;
 }
 
 int ipc_detach_shared_memory(ipc_object_t *obj)
 {
     if (!obj) return -1;
+
+    spin_lock(&ipc_state.lock);
+    u32 i = 0;
+    while (i < ipc_state.attachment_count) {
+        ipc_shm_attachment_t *att = &ipc_state.attachments[i];
+        if (att->object_id == obj->id) {
+            mmgr_unmap_pages(att->as, att->virt_addr, att->page_count);
+            *att = ipc_state.attachments[--ipc_state.attachment_count];
+            continue;
+        }
+        i++;
+    }
+    spin_unlock(&ipc_state.lock);
+
+    return 0;
+}
+
+int ipc_unmap_shared_memory(ipc_object_t *obj, u64 pid, u64 virt_addr)
+{
+    if (!obj) return -1;
+
+    address_space_t *as = ipc_get_address_space(pid);
+    if (!as) return -1;
+
+    int ret = -1;
+    spin_lock(&ipc_state.lock);
+    for (u32 i = 0; i < ipc_state.attachment_count; i++) {
+        ipc_shm_attachment_t *att = &ipc_state.attachments[i];
+        if (att->object_id == obj->id && att->as == as && att->virt_addr == virt_addr) {
+            mmgr_unmap_pages(att->as, att->virt_addr, att->page_count);
+            *att = ipc_state.attachments[--ipc_state.attachment_count];
+            ret = 0;
+            break;
+        }
+    }
+    spin_unlock(&ipc_state.lock);
+
+    return ret;
+}
+
+int ipc_destroy_shared_memory(ipc_object_t *obj)
+{
+    if (!obj || obj->type != IPC_TYPE_SHARED_MEMORY) return -1;
+
+    ipc_detach_shared_memory(obj);
+    ipc_untrack_object(obj);
+
+    free(obj->data.shm.memory);
+    free(obj);
+    return 0;
+}
+
+/*
+ * Share (or, with IPC_GRANT_MOVE, donate) a page-aligned range of the
+ * sender's mappings with the receiver without copying the contents.
+ * Rights can only be narrowed: a read-only source page cannot be granted
+ * writable. When *dst_virt is 0 a free range in the grant window is chosen.
+ */
+int ipc_grant_pages(address_space_t *src, u64 src_virt, address_space_t *dst,
+                    u64 *dst_virt, u32 page_count, u32 flags)
+{
+    if (!src || !dst || !dst_virt || page_count == 0) return -1;
+    if (src_virt & (PAGE_SIZE - 1)) return -1;
+    if (!(flags & (IPC_GRANT_READ | IPC_GRANT_WRITE))) return -1;
+    if (dst->vma_count + page_count > MMGR_MAX_VMAS) return -1;
+
+    prot_flags_t prot = ipc_rights_to_prot(flags);
+
+    vma_t **pages = (vma_t **)calloc(page_count, sizeof(vma_t *));
+    if (!pages) return -1;
+
+    u32 found = 0;
+    for (u32 j = 0; j < src->vma_count; j++) {
+        vma_t *vma = &src->vmas[j];
+        if (vma->virt_addr < src_virt) continue;
+
+        u64 index = (vma->virt_addr - src_virt) / PAGE_SIZE;
+        if (index < page_count && !pages[index]) {
+            if ((prot & PROT_WRITE) && !(vma->prot & PROT_WRITE)) break;
+            pages[index] = vma;
+            found++;
+        }
+    }
+
+    if (found != page_count) {
+        free(pages);
+        return -1;
+    }
+
+    u64 target = *dst_virt;
+    if (target == 0) {
+        target = ipc_find_free_range(dst, page_count);
+    } else if (target & (PAGE_SIZE - 1)) {
+        free(pages);
+        return -1;
+    }
+
+    u32 run_start = 0;
+    for (u32 i = 0; i < page_count; i++) {
+        u64 phys = pages[i]->phys_addr;
+
+        if (!(flags & IPC_GRANT_MOVE)) {
+            mmgr_page_ref(phys);
+        }
+
+        if (i + 1 == page_count || pages[i + 1]->phys_addr != phys + PAGE_SIZE) {
+            mmgr_map_pages(dst, target + (u64)run_start * PAGE_SIZE, pages[run_start]->phys_addr,
+                           i - run_start + 1, prot);
+            run_start = i + 1;
+        }
+    }
+
+    if (!(flags & IPC_GRANT_MOVE)) {
+        for (u32 i = 0; i < page_count; i++) {
+            vma_t *vma = mmgr_find_vma(dst, target + (u64)i * PAGE_SIZE);
+            if (vma) vma->shared = true;
+        }
+    }
+
+    free(pages);
+
+    if (flags & IPC_GRANT_MOVE) {
+        mmgr_unmap_pages(src, src_virt, page_count);
+    }
+
+    *dst_virt = target;
     return 0;
 }
 
+int ipc_revoke_grant(address_space_t *as, u64 virt_addr, u32 page_count)
+{
+    if (!as || page_count == 0) return -1;
+
+    for (u32 i = 0; i < page_count; i++) {
+        vma_t *vma = mmgr_find_vma(as, virt_addr + (u64)i * PAGE_SIZE);
+        if (vma && vma->shared) {
+            mmgr_page_unref(vma->phys_addr);
+        }
+    }
+
+    return mmgr_unmap_pages(as, virt_addr, page_count);
+}
+
 ipc_object_t *ipc_create_semaphore(u32 initial_value)
 {
     ipc_object_t *obj = (ipc_object_t *)malloc(sizeof(ipc_object_t));
     if (!obj) return NULL;
 
-    obj->id = next_ipc_id++;
+    obj->id = ipc_next_id();
     obj->type = IPC_TYPE_SEMAPHORE;
     obj->secure = true;
 
     obj->data.sem.value = initial_value;
     obj->data.sem.owner_pid = 0;
+    obj->data.sem.waiters = 0;
+    obj->data.sem.spin_hint = 0;
 
-    if (ipc_state.object_count < 4096) {
-        ipc_state.objects[ipc_state.object_count++] = obj;
+    if (ipc_track_object(obj) == 0) {
         return obj;
     }
 
@@ -181,17 +824,79 @@ ipc_object_t *ipc_create_semaphore(u32 initial_value)
     return NULL;
 }
 
-int ipc_semaphore_wait(ipc_object_t *obj)
+static bool ipc_semaphore_try_take(ipc_object_t *obj)
+{
+    u32 value = __atomic_load_n(&obj->data.sem.value, __ATOMIC_RELAXED);
+
+    while (value > 0) {
+        if (__atomic_compare_exchange_n(&obj->data.sem.value, &value, value - 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Spin for roughly as long as recent waits needed before a count showed
+ * up, then sleep on the value word. The hint moves an eighth of the way
+ * towards each new observation, so a semaphore that is usually released
+ * quickly keeps spinning and one held for long stops wasting the CPU.
+ */
+int ipc_semaphore_timed_wait(ipc_object_t *obj, u64 timeout_ns)
 {
     if (!obj) return -1;
     if (obj->type != IPC_TYPE_SEMAPHORE) return -1;
 
-    if (obj->data.sem.value > 0) {
-        obj->data.sem.value--;
-        return 0;
+    if (ipc_semaphore_try_take(obj)) return 0;
+
+    s32 hint = (s32)__atomic_load_n(&obj->data.sem.spin_hint, __ATOMIC_RELAXED);
+    s32 limit = hint * 2 + 10;
+    if (limit > IPC_SEM_SPIN_MAX) limit = IPC_SEM_SPIN_MAX;
+
+    for (s32 spins = 1; spins <= limit; spins++) {
+        wait_queue_cpu_relax();
+        if (ipc_semaphore_try_take(obj)) {
+            __atomic_store_n(&obj->data.sem.spin_hint, (u32)(hint + (spins - hint) / 8), __ATOMIC_RELAXED);
+            return 0;
+        }
     }
+    __atomic_store_n(&obj->data.sem.spin_hint, (u32)(hint + (limit - hint) / 8), __ATOMIC_RELAXED);
 
-    return -1;
+    u64 deadline = timeout_ns ? wait_queue_now_ns() + timeout_ns : 0;
+
+    for (;;) {
+        if (ipc_semaphore_try_take(obj)) return 0;
+
+        u64 remaining = 0;
+        if (deadline) {
+            u64 now = wait_queue_now_ns();
+            if (now >= deadline) return IPC_ETIMEDOUT;
+            remaining = deadline - now;
+        }
+
+        __atomic_add_fetch(&obj->data.sem.waiters, 1, __ATOMIC_SEQ_CST);
+        int result = futex_wait(&obj->data.sem.value, 0, NULL, remaining);
+        __atomic_sub_fetch(&obj->data.sem.waiters, 1, __ATOMIC_RELAXED);
+
+        if (result == FUTEX_ETIMEDOUT && !ipc_semaphore_try_take(obj)) {
+            return IPC_ETIMEDOUT;
+        }
+    }
+}
+
+int ipc_semaphore_wait(ipc_object_t *obj)
+{
+    return ipc_semaphore_timed_wait(obj, 0);
+}
+
+int ipc_semaphore_try_wait(ipc_object_t *obj)
+{
+    if (!obj) return -1;
+    if (obj->type != IPC_TYPE_SEMAPHORE) return -1;
+
+    return ipc_semaphore_try_take(obj) ? 0 : -1;
 }
 
 int ipc_semaphore_signal(ipc_object_t *obj)
@@ -199,7 +904,11 @@ int ipc_semaphore_signal(ipc_object_t *obj)
     if (!obj) return -1;
     if (obj->type != IPC_TYPE_SEMAPHORE) return -1;
 
-    obj->data.sem.value++;
+    __atomic_add_fetch(&obj->data.sem.value, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&obj->data.sem.waiters, __ATOMIC_SEQ_CST)) {
+        futex_wake(&obj->data.sem.value, 1);
+    }
+
     return 0;
 }
 
@@ -1,15 +1,12 @@
 #include <kernel/ipc_bus.h>
+#include <kernel/tracepoint.h>
+#include <kernel/spinlock.h>
 #include <common/list.h>
 #include <common/rbtree.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-typedef struct ipc_message_node {
-    struct list_head list;
-    ipc_message_t message;
-} ipc_message_node_t;
-
 typedef struct ipc_route {
     struct rb_node rb_node;
     int source_id;
@@ -20,10 +17,15 @@ typedef struct ipc_route {
 } ipc_route_t;
 
 typedef struct {
-    struct list_head queue;
-    int queue_size;
+    ipc_message_t *slots;
+    uint32_t head;
+    uint32_t reserve_tail;
+    uint32_t commit_tail;
     int max_queue_size;
     uint32_t dropped_messages;
+    uint32_t wakeups;
+    ipc_bus_notify_t notify;
+    void *notify_context;
 } ipc_message_queue_t;
 
 static ipc_message_queue_t message_queues[MAX_IPC_ROUTES];
@@ -35,10 +37,15 @@ void ipc_bus_init(void)
     if (initialized) return;
     
     for (int i = 0; i < MAX_IPC_ROUTES; i++) {
-        INIT_LIST_HEAD(&message_queues[i].queue);
-        message_queues[i].queue_size = 0;
+        message_queues[i].slots = NULL;
+        message_queues[i].head = 0;
+        message_queues[i].reserve_tail = 0;
+        message_queues[i].commit_tail = 0;
         message_queues[i].max_queue_size = IPC_MAX_QUEUE_SIZE;
         message_queues[i].dropped_messages = 0;
+        message_queues[i].wakeups = 0;
+        message_queues[i].notify = NULL;
+        message_queues[i].notify_context = NULL;
     }
     
     route_tree = RB_ROOT;
@@ -96,6 +103,159 @@ int ipc_bus_register_route(int source_id, int dest_id, int priority)
     return 0;
 }
 
+static ipc_route_t *ipc_bus_find_route(int source_id, int dest_id)
+{
+    if (source_id < 0 || dest_id < 0) {
+        return NULL;
+    }
+    
+    struct rb_node *node = route_tree.rb_node;
+    
+    while (node) {
+        ipc_route_t *entry = container_of(node, ipc_route_t, rb_node);
+        
+        if (entry->source_id == source_id && entry->dest_id == dest_id) {
+            return entry;
+        }
+        
+        int cmp = compare_routes((source_id << 16) | dest_id,
+                                (entry->source_id << 16) | entry->dest_id);
+        if (cmp < 0) {
+            node = node->rb_left;
+        } else {
+            node = node->rb_right;
+        }
+    }
+    
+    return NULL;
+}
+
+static ipc_message_t *ipc_queue_get_slots(ipc_message_queue_t *queue)
+{
+    ipc_message_t *slots = __atomic_load_n(&queue->slots, __ATOMIC_ACQUIRE);
+    if (slots) {
+        return slots;
+    }
+    
+    ipc_message_t *fresh = (ipc_message_t *)malloc(IPC_MAX_QUEUE_SIZE * sizeof(ipc_message_t));
+    if (!fresh) {
+        return NULL;
+    }
+    
+    if (!__atomic_compare_exchange_n(&queue->slots, &slots, fresh, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(fresh);
+        return slots;
+    }
+    
+    return fresh;
+}
+
+/*
+ * Reserve up to 'count' consecutive ring slots with a single CAS on the
+ * reservation tail. Returns the number of slots granted and stores the
+ * first ring index in 'start'.
+ */
+static uint32_t ipc_queue_reserve(ipc_message_queue_t *queue, uint32_t count, uint32_t *start)
+{
+    uint32_t tail = __atomic_load_n(&queue->reserve_tail, __ATOMIC_RELAXED);
+    uint32_t granted;
+    
+    do {
+        uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        uint32_t free_slots = (uint32_t)queue->max_queue_size - (tail - head);
+        
+        granted = (count < free_slots) ? count : free_slots;
+        if (granted == 0) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&queue->reserve_tail, &tail, tail + granted, 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    
+    *start = tail;
+    return granted;
+}
+
+static void ipc_queue_copy_in(ipc_message_t *slots, uint32_t start,
+                              const ipc_message_t *msgs, uint32_t count)
+{
+    uint32_t first = start & (IPC_MAX_QUEUE_SIZE - 1);
+    uint32_t chunk = IPC_MAX_QUEUE_SIZE - first;
+    
+    if (chunk > count) {
+        chunk = count;
+    }
+    
+    memcpy(&slots[first], msgs, chunk * sizeof(ipc_message_t));
+    if (chunk < count) {
+        memcpy(&slots[0], msgs + chunk, (count - chunk) * sizeof(ipc_message_t));
+    }
+}
+
+static void ipc_queue_copy_out(const ipc_message_t *slots, uint32_t start,
+                               ipc_message_t *msgs, uint32_t count)
+{
+    uint32_t first = start & (IPC_MAX_QUEUE_SIZE - 1);
+    uint32_t chunk = IPC_MAX_QUEUE_SIZE - first;
+    
+    if (chunk > count) {
+        chunk = count;
+    }
+    
+    memcpy(msgs, &slots[first], chunk * sizeof(ipc_message_t));
+    if (chunk < count) {
+        memcpy(msgs + chunk, &slots[0], (count - chunk) * sizeof(ipc_message_t));
+    }
+}
+
+static void ipc_queue_commit(ipc_message_queue_t *queue, uint32_t start, uint32_t count)
+{
+    u32 spins = 0;
+    
+    while (__atomic_load_n(&queue->commit_tail, __ATOMIC_ACQUIRE) != start) {
+        /* An earlier reservation is still copying; publish in order. */
+        lock_spin_wait(&spins);
+    }
+    
+    __atomic_store_n(&queue->commit_tail, start + count, __ATOMIC_RELEASE);
+}
+
+static void ipc_queue_wake(ipc_message_queue_t *queue, int dest_id, uint32_t queued)
+{
+    __atomic_fetch_add(&queue->wakeups, 1, __ATOMIC_RELAXED);
+    
+    if (queue->notify) {
+        queue->notify(dest_id, (int)queued, queue->notify_context);
+    }
+}
+
+static uint32_t ipc_queue_enqueue(ipc_message_queue_t *queue, int dest_id,
+                                  const ipc_message_t *msgs, uint32_t count)
+{
+    ipc_message_t *slots = ipc_queue_get_slots(queue);
+    uint32_t start = 0;
+    uint32_t granted = 0;
+    
+    if (slots) {
+        granted = ipc_queue_reserve(queue, count, &start);
+    }
+    
+    if (granted < count) {
+        /* Only reached on overflow, so a shared counter costs nothing. */
+        __atomic_add_fetch(&queue->dropped_messages, count - granted, __ATOMIC_RELAXED);
+    }
+    
+    if (granted == 0) {
+        return 0;
+    }
+    
+    ipc_queue_copy_in(slots, start, msgs, granted);
+    ipc_queue_commit(queue, start, granted);
+    ipc_queue_wake(queue, dest_id, granted);
+    
+    return granted;
+}
+
 int ipc_bus_send_message(const ipc_message_t *msg)
 {
     if (!msg || msg->dest_id < 0 || msg->dest_id >= MAX_IPC_ROUTES) {
@@ -108,27 +268,62 @@ int ipc_bus_send_message(const ipc_message_t *msg)
     
     ipc_message_queue_t *queue = &message_queues[msg->dest_id];
     
-    if (queue->queue_size >= queue->max_queue_size) {
-        queue->dropped_messages++;
+    AEGIS_TRACE(ipc_bus, send, msg->source_id, msg->dest_id, msg->msg_id, 1);
+    if (ipc_queue_enqueue(queue, msg->dest_id, msg, 1) != 1) {
         return -1;
     }
     
-    ipc_message_node_t *node = (ipc_message_node_t *)malloc(sizeof(ipc_message_node_t));
-    if (!node) {
-        queue->dropped_messages++;
+    return 0;
+}
+
+int ipc_bus_send_batch(const ipc_message_t *msgs, int count)
+{
+    if (!msgs || count <= 0) {
         return -1;
     }
     
-    memcpy(&node->message, msg, sizeof(ipc_message_t));
-    list_add_tail(&node->list, &queue->queue);
-    queue->queue_size++;
+    if (!initialized) {
+        return -1;
+    }
     
-    return 0;
+    int source_id = msgs[0].source_id;
+    int dest_id = msgs[0].dest_id;
+    
+    if (dest_id < 0 || dest_id >= MAX_IPC_ROUTES) {
+        return -1;
+    }
+    
+    for (int i = 1; i < count; i++) {
+        if (msgs[i].source_id != source_id || msgs[i].dest_id != dest_id) {
+            return -1;
+        }
+    }
+    
+    ipc_route_t *route = ipc_bus_find_route(source_id, dest_id);
+    if (!route) {
+        return -1;
+    }
+    
+    ipc_message_queue_t *queue = &message_queues[dest_id];
+    uint32_t sent = ipc_queue_enqueue(queue, dest_id, msgs, (uint32_t)count);
+    AEGIS_TRACE(ipc_bus, send, source_id, dest_id, msgs[0].msg_id, sent);
+    
+    __atomic_add_fetch(&route->message_count, sent, __ATOMIC_RELAXED);
+    if (sent < (uint32_t)count) {
+        __atomic_add_fetch(&route->error_count, (uint32_t)count - sent, __ATOMIC_RELAXED);
+    }
+    
+    return (int)sent;
 }
 
 int ipc_bus_receive_message(int dest_id, ipc_message_t *msg)
 {
-    if (dest_id < 0 || dest_id >= MAX_IPC_ROUTES || !msg) {
+    return ipc_bus_receive_batch(dest_id, msg, 1);
+}
+
+int ipc_bus_receive_batch(int dest_id, ipc_message_t *msgs, int max_count)
+{
+    if (dest_id < 0 || dest_id >= MAX_IPC_ROUTES || !msgs || max_count <= 0) {
         return -1;
     }
     
@@ -137,19 +332,40 @@ int ipc_bus_receive_message(int dest_id, ipc_message_t *msg)
     }
     
     ipc_message_queue_t *queue = &message_queues[dest_id];
+    uint32_t head = queue->head;
+    uint32_t available = __atomic_load_n(&queue->commit_tail, __ATOMIC_ACQUIRE) - head;
+    uint32_t count = ((uint32_t)max_count < available) ? (uint32_t)max_count : available;
     
-    if (list_empty(&queue->queue)) {
+    if (count == 0) {
         return 0;
     }
     
-    ipc_message_node_t *node = list_first_entry(&queue->queue, ipc_message_node_t, list);
-    memcpy(msg, &node->message, sizeof(ipc_message_t));
+    ipc_queue_copy_out(queue->slots, head, msgs, count);
+    __atomic_store_n(&queue->head, head + count, __ATOMIC_RELEASE);
+    AEGIS_TRACE(ipc_bus, receive, msgs[0].source_id, dest_id, msgs[0].msg_id, count);
     
-    list_del(&node->list);
-    queue->queue_size--;
-    free(node);
+    return (int)count;
+}
+
+int ipc_bus_set_notify(int dest_id, ipc_bus_notify_t notify, void *context)
+{
+    if (dest_id < 0 || dest_id >= MAX_IPC_ROUTES) {
+        return -1;
+    }
     
-    return 1;
+    message_queues[dest_id].notify = notify;
+    message_queues[dest_id].notify_context = context;
+    
+    return 0;
+}
+
+uint32_t ipc_bus_get_wakeups(int dest_id)
+{
+    if (dest_id < 0 || dest_id >= MAX_IPC_ROUTES) {
+        return 0;
+    }
+    
+    return message_queues[dest_id].wakeups;
 }
 
 int ipc_bus_get_queue_size(int dest_id)
@@ -158,7 +374,9 @@ int ipc_bus_get_queue_size(int dest_id)
         return -1;
     }
     
-    return message_queues[dest_id].queue_size;
+    ipc_message_queue_t *queue = &message_queues[dest_id];
+    
+    return (int)(__atomic_load_n(&queue->commit_tail, __ATOMIC_ACQUIRE) - queue->head);
 }
 
 uint32_t ipc_bus_get_dropped_messages(int dest_id)
@@ -167,7 +385,7 @@ uint32_t ipc_bus_get_dropped_messages(int dest_id)
         return 0;
     }
     
-    return message_queues[dest_id].dropped_messages;
+    return __atomic_load_n(&message_queues[dest_id].dropped_messages, __ATOMIC_RELAXED);
 }
 
 void ipc_bus_clear_queue(int dest_id)
@@ -177,58 +395,35 @@ void ipc_bus_clear_queue(int dest_id)
     }
     
     ipc_message_queue_t *queue = &message_queues[dest_id];
-    struct list_head *pos, *tmp;
     
-    list_for_each_safe(pos, tmp, &queue->queue) {
-        ipc_message_node_t *node = list_entry(pos, ipc_message_node_t, list);
-        list_del(&node->list);
-        free(node);
-    }
-    
-    queue->queue_size = 0;
+    __atomic_store_n(&queue->head,
+                     __atomic_load_n(&queue->commit_tail, __ATOMIC_ACQUIRE),
+                     __ATOMIC_RELEASE);
 }
 
 void ipc_bus_print_stats(void)
 {
     printf("\n=== IPC Bus Statistics ===\n");
-    printf("Route-ID | Queue-Size | Max-Size | Dropped\n");
-    printf("---------|------------|----------|----------\n");
+    printf("Route-ID | Queue-Size | Max-Size | Dropped  | Wakeups\n");
+    printf("---------|------------|----------|----------|----------\n");
     
     for (int i = 0; i < MAX_IPC_ROUTES; i++) {
         ipc_message_queue_t *queue = &message_queues[i];
-        if (queue->queue_size > 0 || queue->dropped_messages > 0) {
-            printf("%-8d | %-10d | %-8d | %-8u\n",
+        int queue_size = ipc_bus_get_queue_size(i);
+        uint32_t dropped = __atomic_load_n(&queue->dropped_messages, __ATOMIC_RELAXED);
+        
+        if (queue_size > 0 || dropped > 0) {
+            printf("%-8d | %-10d | %-8d | %-8u | %-8u\n",
                    i,
-                   queue->queue_size,
+                   queue_size,
                    queue->max_queue_size,
-                   queue->dropped_messages);
+                   dropped,
+                   queue->wakeups);
         }
     }
 }
 
 int ipc_bus_is_route_available(int source_id, int dest_id)
 {
-    if (source_id < 0 || dest_id < 0) {
-        return 0;
-    }
-    
-    struct rb_node *node = route_tree.rb_node;
-    
-    while (node) {
-        ipc_route_t *entry = container_of(node, ipc_route_t, rb_node);
-        
-        if (entry->source_id == source_id && entry->dest_id == dest_id) {
-            return 1;
-        }
-        
-        int cmp = compare_routes((source_id << 16) | dest_id,
-                                (entry->source_id << 16) | entry->dest_id);
-        if (cmp < 0) {
-            node = node->rb_left;
-        } else {
-            node = node->rb_right;
-        }
-    }
-    
-    return 0;
+    return ipc_bus_find_route(source_id, dest_id) != NULL;
 }
@@ -0,0 +1,147 @@
+#include <kernel/ipc.h>
+#include <kernel/scheduler.h>
+#include <kernel/profiler.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Synchronous call/reply fast path. A server parks its thread on an
+ * endpoint with ipc_reply_wait(); ipc_call() then switches straight to
+ * that thread without a scheduler pass, lending it the caller's time
+ * slice and priority. Payloads of up to IPC_FASTPATH_MRS words travel in
+ * the thread's saved argument registers rather than through a queue.
+ */
+
+static u64 next_endpoint_id = 1;
+
+static void ipc_load_registers(thread_t *thread, const ipc_fastpath_msg_t *msg)
+{
+#ifdef __x86_64__
+    x86_64_context_t *ctx = &thread->context.x86_64;
+    ctx->rax = msg->label;
+    ctx->rdi = msg->mr[0];
+    ctx->rsi = msg->mr[1];
+    ctx->rdx = msg->mr[2];
+    ctx->r10 = msg->mr[3];
+    ctx->r8 = msg->mr[4];
+    ctx->r9 = msg->mr[5];
+    ctx->rcx = msg->length;
+#else
+    arm_context_t *ctx = &thread->context.arm;
+    ctx->r7 = (u32)msg->label;
+    ctx->r0 = (u32)msg->mr[0];
+    ctx->r1 = (u32)msg->mr[1];
+    ctx->r2 = (u32)msg->mr[2];
+    ctx->r3 = (u32)msg->mr[3];
+    ctx->r4 = (u32)msg->mr[4];
+    ctx->r5 = (u32)msg->mr[5];
+    ctx->r6 = msg->length;
+#endif
+}
+
+static void ipc_store_registers(const thread_t *thread, ipc_fastpath_msg_t *msg)
+{
+#ifdef __x86_64__
+    const x86_64_context_t *ctx = &thread->context.x86_64;
+    msg->label = ctx->rax;
+    msg->mr[0] = ctx->rdi;
+    msg->mr[1] = ctx->rsi;
+    msg->mr[2] = ctx->rdx;
+    msg->mr[3] = ctx->r10;
+    msg->mr[4] = ctx->r8;
+    msg->mr[5] = ctx->r9;
+    msg->length = (u32)ctx->rcx;
+#else
+    const arm_context_t *ctx = &thread->context.arm;
+    msg->label = ctx->r7;
+    msg->mr[0] = ctx->r0;
+    msg->mr[1] = ctx->r1;
+    msg->mr[2] = ctx->r2;
+    msg->mr[3] = ctx->r3;
+    msg->mr[4] = ctx->r4;
+    msg->mr[5] = ctx->r5;
+    msg->length = ctx->r6;
+#endif
+}
+
+ipc_endpoint_t *ipc_endpoint_create(ipc_endpoint_handler_t handler, void *context)
+{
+    if (!handler) return NULL;
+
+    ipc_endpoint_t *ep = (ipc_endpoint_t *)malloc(sizeof(ipc_endpoint_t));
+    if (!ep) return NULL;
+
+    memset(ep, 0, sizeof(ipc_endpoint_t));
+    ep->id = next_endpoint_id++;
+    ep->handler = handler;
+    ep->context = context;
+
+    return ep;
+}
+
+void ipc_endpoint_destroy(ipc_endpoint_t *ep)
+{
+    free(ep);
+}
+
+int ipc_reply_wait(ipc_endpoint_t *ep, thread_t *server)
+{
+    if (!ep || !server) return -1;
+    if (ep->server && ep->server != server) return -1;
+
+    server->state = PROCESS_STATE_BLOCKED;
+    ep->server = server;
+    ep->server_priority = server->priority;
+
+    return 0;
+}
+
+int ipc_call(ipc_endpoint_t *ep, thread_t *caller, ipc_fastpath_msg_t *msg)
+{
+    if (!ep || !caller || !msg) return -1;
+    if (msg->length > IPC_FASTPATH_MRS) return -1;
+
+    thread_t *server = ep->server;
+    if (!server || server->state != PROCESS_STATE_BLOCKED || ep->caller) {
+        ep->failed_calls++;
+        return -1;
+    }
+
+    u64 start = profiler_get_cpu_cycles();
+
+    ep->caller = caller;
+    ipc_load_registers(server, msg);
+
+    u64 server_slice = server->time_slice_remaining;
+    server->time_slice_remaining = 0;
+    if (caller->priority > server->priority) {
+        server->priority = caller->priority;
+    }
+    scheduler_handoff(caller, server);
+
+    ipc_fastpath_msg_t request;
+    ipc_store_registers(server, &request);
+    int result = ep->handler(server, &request, ep->context);
+
+    ipc_load_registers(caller, &request);
+    scheduler_handoff(server, caller);
+    server->time_slice_remaining = server_slice;
+    server->priority = ep->server_priority;
+    ep->caller = NULL;
+
+    ipc_store_registers(caller, msg);
+
+    u64 cycles = profiler_get_cpu_cycles() - start;
+    ep->fastpath_calls++;
+    ep->total_cycles += cycles;
+    profiler_record("ipc_call", (uint32_t)cycles);
+
+    return result;
+}
+
+u64 ipc_endpoint_get_average_cycles(ipc_endpoint_t *ep)
+{
+    if (!ep || ep->fastpath_calls == 0) return 0;
+
+    return ep->total_cycles / ep->fastpath_calls;
+}
@@ -0,0 +1,180 @@
+#include <kernel/ipc_ring.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Single-producer/single-consumer byte ring living entirely inside a
+ * shared-memory object. head and tail sit on cache lines of their own so
+ * the consumer and producer do not bounce each other's line; both sides
+ * map the same pages, so data is written once by the producer and read in
+ * place by the consumer. The creator owns the memory: attached rings must
+ * be destroyed before the creating one.
+ */
+
+static u64 ipc_ring_round_capacity(u64 capacity)
+{
+    u64 rounded = PAGE_SIZE;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static ipc_ring_t *ipc_ring_bind(ipc_object_t *shm, u64 pid, bool owner)
+{
+    ipc_ring_t *ring = (ipc_ring_t *)malloc(sizeof(ipc_ring_t));
+    if (!ring) return NULL;
+
+    ring->shm = shm;
+    ring->header = (ipc_ring_header_t *)shm->data.shm.memory;
+    ring->data = (u8 *)shm->data.shm.memory + IPC_RING_HEADER_SIZE;
+    ring->mask = ring->header->capacity - 1;
+    ring->pid = pid;
+    ring->owner = owner;
+
+    if (ipc_map_shared_memory(shm, pid, IPC_GRANT_READ | IPC_GRANT_WRITE, &ring->virt_addr) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+ipc_ring_t *ipc_ring_create(u64 owner_pid, u64 capacity)
+{
+    if (capacity == 0) return NULL;
+
+    capacity = ipc_ring_round_capacity(capacity);
+
+    ipc_object_t *shm = ipc_create_shared_memory(owner_pid, IPC_RING_HEADER_SIZE + capacity);
+    if (!shm) return NULL;
+
+    ipc_ring_header_t *header = (ipc_ring_header_t *)shm->data.shm.memory;
+    memset(header, 0, IPC_RING_HEADER_SIZE);
+    header->magic = IPC_RING_MAGIC;
+    header->capacity = capacity;
+
+    ipc_ring_t *ring = ipc_ring_bind(shm, owner_pid, true);
+    if (!ring) {
+        ipc_destroy_shared_memory(shm);
+        return NULL;
+    }
+
+    return ring;
+}
+
+ipc_ring_t *ipc_ring_attach(ipc_object_t *shm, u64 pid)
+{
+    if (!shm || shm->type != IPC_TYPE_SHARED_MEMORY) return NULL;
+
+    ipc_ring_header_t *header = (ipc_ring_header_t *)shm->data.shm.memory;
+    if (header->magic != IPC_RING_MAGIC) return NULL;
+
+    return ipc_ring_bind(shm, pid, false);
+}
+
+void ipc_ring_destroy(ipc_ring_t *ring)
+{
+    if (!ring) return;
+
+    ipc_unmap_shared_memory(ring->shm, ring->pid, ring->virt_addr);
+    if (ring->owner) {
+        ipc_destroy_shared_memory(ring->shm);
+    }
+
+    free(ring);
+}
+
+void *ipc_ring_reserve(ipc_ring_t *ring, u64 size, u64 *granted)
+{
+    if (!ring || !granted) return NULL;
+
+    u64 head = __atomic_load_n(&ring->header->head, __ATOMIC_ACQUIRE);
+    u64 tail = ring->header->tail;
+    u64 free_bytes = ring->header->capacity - (tail - head);
+    u64 offset = tail & ring->mask;
+    u64 contiguous = ring->header->capacity - offset;
+
+    u64 n = size;
+    if (n > free_bytes) n = free_bytes;
+    if (n > contiguous) n = contiguous;
+
+    *granted = n;
+    return n ? ring->data + offset : NULL;
+}
+
+void ipc_ring_commit(ipc_ring_t *ring, u64 size)
+{
+    if (!ring) return;
+    __atomic_store_n(&ring->header->tail, ring->header->tail + size, __ATOMIC_RELEASE);
+}
+
+const void *ipc_ring_peek(ipc_ring_t *ring, u64 *available)
+{
+    if (!ring || !available) return NULL;
+
+    u64 tail = __atomic_load_n(&ring->header->tail, __ATOMIC_ACQUIRE);
+    u64 head = ring->header->head;
+    u64 offset = head & ring->mask;
+    u64 contiguous = ring->header->capacity - offset;
+
+    u64 n = tail - head;
+    if (n > contiguous) n = contiguous;
+
+    *available = n;
+    return n ? ring->data + offset : NULL;
+}
+
+void ipc_ring_consume(ipc_ring_t *ring, u64 size)
+{
+    if (!ring) return;
+    __atomic_store_n(&ring->header->head, ring->header->head + size, __ATOMIC_RELEASE);
+}
+
+u64 ipc_ring_write(ipc_ring_t *ring, const void *data, u64 size)
+{
+    if (!ring || !data) return 0;
+
+    u64 written = 0;
+    while (written < size) {
+        u64 granted;
+        void *dst = ipc_ring_reserve(ring, size - written, &granted);
+        if (!dst) break;
+
+        memcpy(dst, (const u8 *)data + written, granted);
+        ipc_ring_commit(ring, granted);
+        written += granted;
+    }
+
+    return written;
+}
+
+u64 ipc_ring_read(ipc_ring_t *ring, void *data, u64 max_size)
+{
+    if (!ring || !data) return 0;
+
+    u64 read = 0;
+    while (read < max_size) {
+        u64 available;
+        const void *src = ipc_ring_peek(ring, &available);
+        if (!src) break;
+
+        if (available > max_size - read) {
+            available = max_size - read;
+        }
+
+        memcpy((u8 *)data + read, src, available);
+        ipc_ring_consume(ring, available);
+        read += available;
+    }
+
+    return read;
+}
+
+u64 ipc_ring_used(ipc_ring_t *ring)
+{
+    if (!ring) return 0;
+
+    return __atomic_load_n(&ring->header->tail, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&ring->header->head, __ATOMIC_ACQUIRE);
+}
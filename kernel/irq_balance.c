@@ -0,0 +1,283 @@
+#include <kernel/irq_balance.h>
+#include <kernel/wait_queue.h>
+#include <kernel/kthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Interrupt balancing: each pass turns irq_stats counts into per-second
+ * rates, then places the hot IRQs greedily, heaviest first, on the least
+ * loaded CPU their affinity and the isolated set allow. Moves go through
+ * ied_set_irq_cpu() so the arch routing hook sees every change.
+ */
+typedef struct {
+    irq_balance_config_t config;
+    u32 consumer[MAX_IRQ_HANDLERS];
+    u64 last_count[MAX_IRQ_HANDLERS];
+    u64 last_ns;
+    irq_balance_report_t last_report;
+    spinlock_t lock;
+    u32 stopping;
+    kthread_t *thread;
+    wait_queue_t stop_wait;
+} irq_balance_state_t;
+
+typedef struct {
+    u32 irq;
+    u32 cpu;
+    u32 affinity;
+    u64 rate;
+} irq_balance_entry_t;
+
+static irq_balance_state_t balance;
+
+static void irq_balance_lock(void)
+{
+    spin_lock(&balance.lock);
+}
+
+static void irq_balance_unlock(void)
+{
+    spin_unlock(&balance.lock);
+}
+
+int irq_balance_init(const irq_balance_config_t *config)
+{
+    if (!config || config->nr_cpus == 0 || config->nr_cpus > IED_AFFINITY_CPUS) {
+        return -1;
+    }
+
+    irq_balance_stop();
+    memset(&balance, 0, sizeof(balance));
+    memcpy(&balance.config, config, sizeof(irq_balance_config_t));
+
+    if (balance.config.cluster_size == 0) {
+        balance.config.cluster_size = 1;
+    }
+    if (balance.config.interval_ns == 0) {
+        balance.config.interval_ns = IRQ_BALANCE_INTERVAL_NS;
+    }
+
+    for (u32 i = 0; i < MAX_IRQ_HANDLERS; i++) {
+        balance.consumer[i] = IRQ_BALANCE_NO_CONSUMER;
+        balance.last_count[i] = ied_get_irq_stat(i);
+    }
+
+    wait_queue_init(&balance.stop_wait);
+    balance.last_ns = wait_queue_now_ns();
+    return 0;
+}
+
+/* Record the CPU the thread consuming 'irq' runs on, or clear it. */
+int irq_balance_set_consumer(u32 irq, u32 cpu)
+{
+    if (irq >= MAX_IRQ_HANDLERS) return -1;
+    if (cpu != IRQ_BALANCE_NO_CONSUMER && cpu >= balance.config.nr_cpus) return -1;
+
+    balance.consumer[irq] = cpu;
+    return 0;
+}
+
+static u32 irq_balance_pick(const u64 *loads, u32 allowed, u32 current)
+{
+    u32 best = IRQ_BALANCE_NO_CONSUMER;
+
+    for (u32 cpu = 0; cpu < balance.config.nr_cpus; cpu++) {
+        if (!(allowed & (1U << cpu))) continue;
+
+        if (best == IRQ_BALANCE_NO_CONSUMER || loads[cpu] < loads[best] ||
+            (loads[cpu] == loads[best] && cpu == current)) {
+            best = cpu;
+        }
+    }
+
+    return best;
+}
+
+/* CPUs in 'cpu's cluster, clipped to the configured CPUs. */
+static u32 irq_balance_cluster_mask(u32 cpu)
+{
+    u32 size = balance.config.cluster_size;
+    u32 first = cpu - cpu % size;
+    u64 span = size >= 64 ? ~0ULL : (1ULL << size) - 1;
+    u64 online = (1ULL << balance.config.nr_cpus) - 1;
+
+    return (u32)((span << first) & online);
+}
+
+static u32 irq_balance_place(const irq_balance_entry_t *entry, const u64 *loads, u32 online, u32 isolated)
+{
+    u32 allowed = entry->affinity & online & ~isolated;
+    if (!allowed) {
+        allowed = entry->affinity & online;
+    }
+    if (!allowed) {
+        return entry->cpu;
+    }
+
+    u32 best = irq_balance_pick(loads, allowed, entry->cpu);
+    u32 consumer = balance.consumer[entry->irq];
+
+    if (consumer != IRQ_BALANCE_NO_CONSUMER) {
+        u32 local = irq_balance_pick(loads, allowed & irq_balance_cluster_mask(consumer), consumer);
+
+        /* Stay near the consumer unless leaving would gain more than this IRQ costs. */
+        if (local != IRQ_BALANCE_NO_CONSUMER && loads[local] - loads[best] < entry->rate) {
+            best = local;
+        }
+    }
+
+    return best;
+}
+
+int irq_balance_run(irq_balance_report_t *report)
+{
+    static irq_balance_entry_t hot[MAX_IRQ_HANDLERS];
+    irq_balance_report_t result;
+    u64 loads[IED_AFFINITY_CPUS];
+    u32 hot_count = 0;
+
+    if (balance.config.nr_cpus == 0) return -1;
+
+    irq_balance_lock();
+
+    memset(&result, 0, sizeof(result));
+    memset(loads, 0, sizeof(loads));
+    result.nr_cpus = balance.config.nr_cpus;
+
+    u64 now = wait_queue_now_ns();
+    u64 elapsed = now > balance.last_ns ? now - balance.last_ns : 1;
+    balance.last_ns = now;
+    result.elapsed_ns = elapsed;
+
+    u32 online = balance.config.nr_cpus >= 32 ? 0xFFFFFFFFU : (1U << balance.config.nr_cpus) - 1;
+    u32 isolated = ied_get_isolated_cpus();
+
+    for (u32 irq = 0; irq < MAX_IRQ_HANDLERS; irq++) {
+        u64 count = ied_get_irq_stat(irq);
+        u64 delta = count - balance.last_count[irq];
+        balance.last_count[irq] = count;
+
+        if (count == 0) continue;
+
+        irq_balance_entry_t entry;
+        entry.irq = irq;
+        entry.rate = delta * 1000000000ULL / elapsed;
+        ied_get_irq_affinity(irq, &entry.affinity, &entry.cpu);
+
+        if (entry.cpu < result.nr_cpus) {
+            result.load_before[entry.cpu] += entry.rate;
+        }
+
+        /* Cold IRQs stay put unless they sit on an isolated CPU. */
+        if ((entry.rate == 0 || entry.rate < balance.config.min_rate) &&
+            !(entry.cpu < 32 && (isolated & (1U << entry.cpu)))) {
+            if (entry.cpu < result.nr_cpus) {
+                loads[entry.cpu] += entry.rate;
+            }
+            continue;
+        }
+
+        /* Insertion keeps 'hot' sorted by rate, heaviest first. */
+        u32 pos = hot_count++;
+        while (pos > 0 && hot[pos - 1].rate < entry.rate) {
+            hot[pos] = hot[pos - 1];
+            pos--;
+        }
+        hot[pos] = entry;
+    }
+
+    for (u32 i = 0; i < hot_count; i++) {
+        irq_balance_entry_t *entry = &hot[i];
+        u32 target = irq_balance_place(entry, loads, online, isolated);
+
+        if (target != entry->cpu && ied_set_irq_cpu(entry->irq, target) == 0) {
+            entry->cpu = target;
+            result.moved++;
+        }
+
+        if (entry->cpu < result.nr_cpus) {
+            loads[entry->cpu] += entry->rate;
+        }
+    }
+
+    result.hot_irqs = hot_count;
+    memcpy(result.load_after, loads, sizeof(loads));
+    memcpy(&balance.last_report, &result, sizeof(result));
+
+    irq_balance_unlock();
+
+    if (report) {
+        memcpy(report, &result, sizeof(result));
+    }
+
+    return (int)result.moved;
+}
+
+static bool irq_balance_should_stop(void *arg)
+{
+    return __atomic_load_n(&balance.stopping, __ATOMIC_ACQUIRE) != 0;
+}
+
+static int irq_balance_main(void *arg)
+{
+    while (!__atomic_load_n(&balance.stopping, __ATOMIC_ACQUIRE)) {
+        if (wait_queue_wait(&balance.stop_wait, NULL, irq_balance_should_stop, NULL,
+                            balance.config.interval_ns) != WAIT_QUEUE_TIMEOUT) {
+            break;
+        }
+        irq_balance_run(NULL);
+    }
+
+    return 0;
+}
+
+int irq_balance_start(void)
+{
+    if (balance.config.nr_cpus == 0 || balance.thread) return -1;
+
+    __atomic_store_n(&balance.stopping, 0, __ATOMIC_RELEASE);
+    balance.thread = kthread_run("irq_balance", irq_balance_main, NULL);
+
+    return balance.thread ? 0 : -1;
+}
+
+void irq_balance_stop(void)
+{
+    if (!balance.thread) return;
+
+    __atomic_store_n(&balance.stopping, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&balance.stop_wait);
+    kthread_stop(balance.thread);
+    balance.thread = NULL;
+}
+
+int irq_balance_get_last_report(irq_balance_report_t *report)
+{
+    if (!report) return -1;
+
+    irq_balance_lock();
+    memcpy(report, &balance.last_report, sizeof(irq_balance_report_t));
+    irq_balance_unlock();
+
+    return 0;
+}
+
+void irq_balance_print_report(const irq_balance_report_t *report)
+{
+    if (!report) return;
+
+    printf("\n=== IRQ Balance ===\n");
+    printf("CPU | Before (irq/s) | After (irq/s)\n");
+    printf("----|----------------|--------------\n");
+
+    for (u32 cpu = 0; cpu < report->nr_cpus; cpu++) {
+        printf("%-3u | %-14llu | %-13llu%s\n",
+               cpu,
+               (unsigned long long)report->load_before[cpu],
+               (unsigned long long)report->load_after[cpu],
+               (ied_get_isolated_cpus() & (1U << cpu)) ? " (isolated)" : "");
+    }
+
+    printf("Moved %u of %u hot IRQs\n", report->moved, report->hot_irqs);
+}
@@ -0,0 +1,520 @@
+#define _GNU_SOURCE
+#include <kernel/ksym.h>
+#include <kernel/spinlock.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define KSYM_NM_FIELD_LEN 256
+
+typedef struct {
+    u64 address;
+    u64 size;
+    char *name;
+} ksym_runtime_t;
+
+typedef struct {
+    u64 address;
+    u64 generation;
+    const char *name;
+    u64 offset;
+} ksym_cache_t;
+
+/*
+ * Lookups hold the lock shared; loading, adding and clearing take it
+ * exclusively and bump the generation, which retires every thread's
+ * cached results at once. A returned name stays valid until the table
+ * changes.
+ */
+static struct {
+    rwlock_t lock;
+    u64 generation;
+    bool pending;           /* map 'path' (or the default) on the next lookup */
+    char *path;
+    void *map;
+    size_t map_size;
+    u64 bias;
+    const ksym_entry_t *symbols;
+    u32 symbol_count;
+    const ksym_inline_t *inlines;
+    u32 inline_count;
+    const char *names;
+    ksym_runtime_t *runtime;
+    u32 runtime_count;
+    u32 runtime_capacity;
+    u64 lookups;
+    u64 cache_hits;
+} ksym_state = { .lock = RWLOCK_INIT, .generation = 1, .pending = true };
+
+static __thread ksym_cache_t ksym_cache[KSYM_CACHE_SIZE];
+
+static int ksym_main_bias(struct dl_phdr_info *info, size_t size, void *data)
+{
+    (void)size;
+    *(u64 *)data = (u64)info->dlpi_addr;
+    return 1;   /* the main program comes first */
+}
+
+static void ksym_unmap_locked(void)
+{
+    if (ksym_state.map) munmap(ksym_state.map, ksym_state.map_size);
+    ksym_state.map = NULL;
+    ksym_state.map_size = 0;
+    ksym_state.symbols = NULL;
+    ksym_state.symbol_count = 0;
+    ksym_state.inlines = NULL;
+    ksym_state.inline_count = 0;
+    ksym_state.names = NULL;
+}
+
+static bool ksym_valid_header(const ksym_file_hdr_t *hdr, size_t file_size)
+{
+    if (memcmp(hdr->magic, KSYM_MAGIC, sizeof(hdr->magic)) != 0) return false;
+    if (hdr->version != KSYM_VERSION || hdr->names_size == 0) return false;
+
+    u64 need = sizeof(*hdr) + (u64)hdr->symbol_count * sizeof(ksym_entry_t) +
+               (u64)hdr->inline_count * sizeof(ksym_inline_t) + hdr->names_size;
+    return need <= file_size;
+}
+
+static int ksym_map_locked(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ksym_file_hdr_t)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const ksym_file_hdr_t *hdr = (const ksym_file_hdr_t *)map;
+    if (!ksym_valid_header(hdr, (size_t)st.st_size)) {
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    const ksym_entry_t *symbols = (const ksym_entry_t *)(hdr + 1);
+    const ksym_inline_t *inlines = (const ksym_inline_t *)(symbols + hdr->symbol_count);
+    const char *names = (const char *)(inlines + hdr->inline_count);
+    bool valid = names[hdr->names_size - 1] == '\0';
+
+    for (u32 i = 0; valid && i < hdr->symbol_count; i++) {
+        valid = symbols[i].name < hdr->names_size;
+    }
+    for (u32 i = 0; valid && i < hdr->inline_count; i++) {
+        valid = inlines[i].name < hdr->names_size;
+    }
+    if (!valid) {
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    ksym_state.map = map;
+    ksym_state.map_size = (size_t)st.st_size;
+    ksym_state.symbols = symbols;
+    ksym_state.symbol_count = hdr->symbol_count;
+    ksym_state.inlines = inlines;
+    ksym_state.inline_count = hdr->inline_count;
+    ksym_state.names = names;
+    ksym_state.bias = 0;
+    dl_iterate_phdr(ksym_main_bias, &ksym_state.bias);
+
+    return 0;
+}
+
+static void ksym_map_pending(void)
+{
+    if (!__atomic_load_n(&ksym_state.pending, __ATOMIC_ACQUIRE)) return;
+
+    write_lock(&ksym_state.lock);
+    if (ksym_state.pending) {
+        if (ksym_state.path) {
+            ksym_map_locked(ksym_state.path);
+        } else {
+            char exe[4096];
+            ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - sizeof(".ksym"));
+            if (len > 0) {
+                memcpy(exe + len, ".ksym", sizeof(".ksym"));
+                ksym_map_locked(exe);
+            }
+        }
+        __atomic_add_fetch(&ksym_state.generation, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&ksym_state.pending, false, __ATOMIC_RELEASE);
+    }
+    write_unlock(&ksym_state.lock);
+}
+
+int ksym_load(const char *path)
+{
+    if (!path) return -1;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return -1;
+
+    ksym_file_hdr_t hdr;
+    bool valid = fread(&hdr, sizeof(hdr), 1, file) == 1 && fseek(file, 0, SEEK_END) == 0 &&
+                 ksym_valid_header(&hdr, (size_t)ftell(file));
+    fclose(file);
+    if (!valid) return -1;
+
+    char *copy = strdup(path);
+    if (!copy) return -1;
+
+    write_lock(&ksym_state.lock);
+    ksym_unmap_locked();
+    free(ksym_state.path);
+    ksym_state.path = copy;
+    __atomic_add_fetch(&ksym_state.generation, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ksym_state.pending, true, __ATOMIC_RELEASE);
+    write_unlock(&ksym_state.lock);
+
+    return (int)hdr.symbol_count;
+}
+
+/* Run-time symbols are kept sorted by address; 'nm -n' order appends. */
+int ksym_add(u64 address, u64 size, const char *name)
+{
+    if (!name || !*name) return -1;
+
+    char *copy = strdup(name);
+    if (!copy) return -1;
+
+    write_lock(&ksym_state.lock);
+    if (ksym_state.runtime_count == ksym_state.runtime_capacity) {
+        u32 capacity = ksym_state.runtime_capacity ? ksym_state.runtime_capacity * 2 : 256;
+        ksym_runtime_t *runtime = (ksym_runtime_t *)realloc(ksym_state.runtime,
+                                                            capacity * sizeof(ksym_runtime_t));
+        if (!runtime) {
+            write_unlock(&ksym_state.lock);
+            free(copy);
+            return -1;
+        }
+
+        ksym_state.runtime = runtime;
+        ksym_state.runtime_capacity = capacity;
+    }
+
+    u32 pos = ksym_state.runtime_count;
+    while (pos > 0 && ksym_state.runtime[pos - 1].address > address) {
+        pos--;
+    }
+
+    memmove(&ksym_state.runtime[pos + 1], &ksym_state.runtime[pos],
+            (ksym_state.runtime_count - pos) * sizeof(ksym_runtime_t));
+    ksym_state.runtime[pos].address = address;
+    ksym_state.runtime[pos].size = size;
+    ksym_state.runtime[pos].name = copy;
+    ksym_state.runtime_count++;
+    __atomic_add_fetch(&ksym_state.generation, 1, __ATOMIC_RELEASE);
+    write_unlock(&ksym_state.lock);
+
+    return 0;
+}
+
+void ksym_clear(void)
+{
+    write_lock(&ksym_state.lock);
+    for (u32 i = 0; i < ksym_state.runtime_count; i++) {
+        free(ksym_state.runtime[i].name);
+    }
+    free(ksym_state.runtime);
+    ksym_state.runtime = NULL;
+    ksym_state.runtime_count = 0;
+    ksym_state.runtime_capacity = 0;
+
+    ksym_unmap_locked();
+    free(ksym_state.path);
+    ksym_state.path = NULL;
+    __atomic_add_fetch(&ksym_state.generation, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ksym_state.pending, false, __ATOMIC_RELEASE);
+    write_unlock(&ksym_state.lock);
+}
+
+/* Index of the last entry starting at or below 'address', or -1. */
+#define KSYM_SEARCH(array, count, addr) ({                       \
+    u32 __lo = 0, __hi = (count);                                \
+    while (__lo < __hi) {                                        \
+        u32 __mid = __lo + (__hi - __lo) / 2;                    \
+        if ((array)[__mid].address <= (addr)) __lo = __mid + 1;  \
+        else __hi = __mid;                                       \
+    }                                                            \
+    (int64_t)__lo - 1;                                           \
+})
+
+static bool ksym_covers(u64 start, u64 size, u64 address)
+{
+    return address - start < (size ? size : KSYM_MAX_SPAN);
+}
+
+/*
+ * Find the function containing 'address' in either table; the closer
+ * start wins when both match. 'mapped' is set to the mapped entry used,
+ * if any, so its inlined ranges can be searched.
+ */
+static const char *ksym_find_locked(u64 address, u64 *offset, const ksym_entry_t **mapped)
+{
+    const char *name = NULL;
+    u64 start = 0;
+
+    *mapped = NULL;
+
+    if (ksym_state.symbol_count && address >= ksym_state.bias) {
+        u64 link = address - ksym_state.bias;
+        int64_t i = KSYM_SEARCH(ksym_state.symbols, ksym_state.symbol_count, link);
+        if (i >= 0 && ksym_covers(ksym_state.symbols[i].address, ksym_state.symbols[i].size, link)) {
+            name = ksym_state.names + ksym_state.symbols[i].name;
+            start = ksym_state.symbols[i].address + ksym_state.bias;
+            *mapped = &ksym_state.symbols[i];
+        }
+    }
+
+    int64_t i = KSYM_SEARCH(ksym_state.runtime, ksym_state.runtime_count, address);
+    if (i >= 0 && ksym_covers(ksym_state.runtime[i].address, ksym_state.runtime[i].size, address) &&
+        (!name || ksym_state.runtime[i].address > start)) {
+        name = ksym_state.runtime[i].name;
+        start = ksym_state.runtime[i].address;
+        *mapped = NULL;
+    }
+
+    if (name) *offset = address - start;
+    return name;
+}
+
+const char *ksym_lookup(u64 address, u64 *offset)
+{
+    ksym_map_pending();
+    __atomic_add_fetch(&ksym_state.lookups, 1, __ATOMIC_RELAXED);
+
+    ksym_cache_t *slot = &ksym_cache[(address ^ (address >> 12)) & (KSYM_CACHE_SIZE - 1)];
+    if (slot->address == address &&
+        slot->generation == __atomic_load_n(&ksym_state.generation, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&ksym_state.cache_hits, 1, __ATOMIC_RELAXED);
+        if (slot->name && offset) *offset = slot->offset;
+        return slot->name;
+    }
+
+    const ksym_entry_t *mapped;
+    u64 off = 0;
+
+    read_lock(&ksym_state.lock);
+    const char *name = ksym_find_locked(address, &off, &mapped);
+    slot->address = address;
+    slot->generation = ksym_state.generation;
+    slot->name = name;
+    slot->offset = off;
+    read_unlock(&ksym_state.lock);
+
+    if (name && offset) *offset = off;
+    return name;
+}
+
+u32 ksym_lookup_inline(u64 address, const char **names, u32 max)
+{
+    if (!names || max == 0) return 0;
+
+    ksym_map_pending();
+
+    const ksym_entry_t *mapped;
+    const ksym_inline_t *found[KSYM_MAX_INLINE];
+    u32 count = 0;
+    u64 offset;
+
+    read_lock(&ksym_state.lock);
+    const char *function = ksym_find_locked(address, &offset, &mapped);
+    if (!function) {
+        read_unlock(&ksym_state.lock);
+        return 0;
+    }
+
+    /* Inlined ranges nest, so every range from the function start up to 'address' is a candidate. */
+    if (mapped) {
+        u64 link = address - ksym_state.bias;
+        int64_t i = KSYM_SEARCH(ksym_state.inlines, ksym_state.inline_count, link);
+
+        for (; i >= 0 && ksym_state.inlines[i].address >= mapped->address; i--) {
+            const ksym_inline_t *range = &ksym_state.inlines[i];
+            if (link - range->address >= range->size || count == KSYM_MAX_INLINE) continue;
+
+            u32 pos = count++;
+            while (pos > 0 && found[pos - 1]->depth < range->depth) {
+                found[pos] = found[pos - 1];
+                pos--;
+            }
+            found[pos] = range;
+        }
+    }
+
+    u32 n = 0;
+    for (u32 i = 0; i < count && n + 1 < max; i++) {
+        names[n++] = ksym_state.names + found[i]->name;
+    }
+    names[n++] = function;
+    read_unlock(&ksym_state.lock);
+
+    return n;
+}
+
+void ksym_get_stats(ksym_stats_t *stats)
+{
+    if (!stats) return;
+
+    read_lock(&ksym_state.lock);
+    stats->lookups = __atomic_load_n(&ksym_state.lookups, __ATOMIC_RELAXED);
+    stats->cache_hits = __atomic_load_n(&ksym_state.cache_hits, __ATOMIC_RELAXED);
+    stats->symbols = ksym_state.symbol_count + ksym_state.runtime_count;
+    stats->inlines = ksym_state.inline_count;
+    read_unlock(&ksym_state.lock);
+}
+
+bool ksym_parse_nm(const char *line, u64 *address, u64 *size, char *name, size_t name_size)
+{
+    char field[4][KSYM_NM_FIELD_LEN];
+    int fields = sscanf(line, "%255s %255s %255s %255s", field[0], field[1], field[2], field[3]);
+    if (fields < 3) return false;
+
+    const char *type = field[fields - 2];
+    if (type[1] != '\0' || !strchr("TtWw", type[0])) return false;
+
+    *address = strtoull(field[0], NULL, 16);
+    *size = fields == 4 ? strtoull(field[1], NULL, 16) : 0;
+    snprintf(name, name_size, "%s", field[fields - 1]);
+
+    return true;
+}
+
+static int ksym_symbol_cmp(const void *a, const void *b)
+{
+    const ksym_symbol_t *x = (const ksym_symbol_t *)a;
+    const ksym_symbol_t *y = (const ksym_symbol_t *)b;
+
+    if (x->address != y->address) return x->address < y->address ? -1 : 1;
+    return x->depth < y->depth ? -1 : x->depth > y->depth;
+}
+
+static u32 ksym_hash_name(const char *name)
+{
+    u32 hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (u8)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+static u32 ksym_size32(u64 size)
+{
+    return size > UINT32_MAX ? UINT32_MAX : (u32)size;
+}
+
+/* A function without a size runs up to the next one. */
+static u64 ksym_fill_size(const ksym_symbol_t *symbols, u32 count, u32 i)
+{
+    if (symbols[i].size) return symbols[i].size;
+
+    for (u32 j = i + 1; j < count; j++) {
+        if (!symbols[j].depth && symbols[j].address > symbols[i].address) {
+            u64 gap = symbols[j].address - symbols[i].address;
+            return gap < KSYM_MAX_SPAN ? gap : KSYM_MAX_SPAN;
+        }
+    }
+
+    return 0;
+}
+
+int ksym_write(const char *path, ksym_symbol_t *symbols, u32 count)
+{
+    if (!path || (!symbols && count)) return -1;
+
+    qsort(symbols, count, sizeof(ksym_symbol_t), ksym_symbol_cmp);
+
+    /* Names are deduplicated: an inlined helper usually shows up many times. */
+    size_t slots = 16;
+    while (slots < (size_t)count * 2) slots <<= 1;
+
+    u32 *offsets = (u32 *)malloc(slots * sizeof(u32));
+    u32 *name_of = (u32 *)malloc((count ? count : 1) * sizeof(u32));
+    char *names = NULL;
+    size_t names_size = 0, names_capacity = 0;
+    u32 symbol_count = 0, inline_count = 0;
+    int ret = -1;
+
+    if (!offsets || !name_of) goto out;
+    memset(offsets, 0xff, slots * sizeof(u32));
+
+    for (u32 i = 0; i < count; i++) {
+        const char *name = symbols[i].name ? symbols[i].name : "";
+        size_t slot = ksym_hash_name(name) & (slots - 1);
+
+        while (offsets[slot] != UINT32_MAX && strcmp(names + offsets[slot], name) != 0) {
+            slot = (slot + 1) & (slots - 1);
+        }
+
+        if (offsets[slot] == UINT32_MAX) {
+            size_t len = strlen(name) + 1;
+            if (names_size + len > UINT32_MAX) goto out;
+            if (names_size + len > names_capacity) {
+                size_t capacity = names_capacity ? names_capacity * 2 : 4096;
+                while (capacity < names_size + len) capacity *= 2;
+                char *grown = (char *)realloc(names, capacity);
+                if (!grown) goto out;
+                names = grown;
+                names_capacity = capacity;
+            }
+            memcpy(names + names_size, name, len);
+            offsets[slot] = (u32)names_size;
+            names_size += len;
+        }
+
+        name_of[i] = offsets[slot];
+        if (symbols[i].depth) inline_count++;
+        else symbol_count++;
+    }
+
+    if (names_size == 0) {
+        names = (char *)calloc(1, 1);
+        if (!names) goto out;
+        names_size = 1;
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (!out) goto out;
+
+    ksym_file_hdr_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, KSYM_MAGIC, sizeof(KSYM_MAGIC));
+    hdr.version = KSYM_VERSION;
+    hdr.symbol_count = symbol_count;
+    hdr.inline_count = inline_count;
+    hdr.names_size = (u32)names_size;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+
+    for (u32 i = 0; ok && i < count; i++) {
+        if (symbols[i].depth) continue;
+
+        ksym_entry_t entry = { symbols[i].address, ksym_size32(ksym_fill_size(symbols, count, i)), name_of[i] };
+        ok = fwrite(&entry, sizeof(entry), 1, out) == 1;
+    }
+
+    for (u32 i = 0; ok && i < count; i++) {
+        if (!symbols[i].depth) continue;
+
+        ksym_inline_t entry = { symbols[i].address, ksym_size32(symbols[i].size), name_of[i], symbols[i].depth, 0 };
+        ok = fwrite(&entry, sizeof(entry), 1, out) == 1;
+    }
+
+    ok = ok && fwrite(names, names_size, 1, out) == 1;
+    ret = fclose(out) == 0 && ok ? 0 : -1;
+
+out:
+    free(offsets);
+    free(name_of);
+    free(names);
+    return ret;
+}
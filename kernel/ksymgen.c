@@ -0,0 +1,450 @@
+#define _GNU_SOURCE
+#include <kernel/ksym.h>
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Build-time generator for the kernel symbol table:
+ *
+ *   ksymgen [--nm NM] [--objdump OBJDUMP] <image> <output>
+ *
+ * Functions come from 'nm -n -S'. When the image carries DWARF, every
+ * DW_TAG_inlined_subroutine in 'objdump --dwarf=info' contributes its pc
+ * range at its nesting depth, named after its abstract origin. Range
+ * lists are decoded straight from the image's .debug_rnglists or
+ * .debug_ranges, since objdump does not print all of them. An empty
+ * OBJDUMP skips inlined ranges.
+ */
+
+#define KSYMGEN_MAX_NEST 64
+
+typedef struct {
+    ksym_symbol_t *items;
+    u32 count;
+    u32 capacity;
+} ksymgen_symbols_t;
+
+/* A DIE that can name an inlined call: its own name or the DIE it refers to. */
+typedef struct {
+    u64 offset;
+    u64 origin;
+    char *name;
+} ksymgen_die_t;
+
+typedef struct {
+    u64 origin;
+    u64 low;
+    u64 high;
+    u64 ranges;
+    u64 cu_base;    /* range list entries are relative to the unit's low_pc */
+    u32 cu_version;
+    bool has_low, has_high, has_ranges;
+    u32 depth;
+} ksymgen_inline_t;
+
+typedef struct {
+    ksymgen_die_t *dies;
+    u32 die_count, die_capacity;
+    ksymgen_inline_t *inlines;
+    u32 inline_count, inline_capacity;
+} ksymgen_dwarf_t;
+
+typedef struct {
+    u8 *image;
+    const u8 *rnglists;
+    u64 rnglists_size;
+    const u8 *ranges;
+    u64 ranges_size;
+} ksymgen_sections_t;
+
+#define KSYMGEN_PUSH(array, count, capacity) ({                              \
+    bool __ok = true;                                                        \
+    if ((count) == (capacity)) {                                             \
+        u32 __cap = (capacity) ? (capacity) * 2 : 1024;                      \
+        void *__grown = realloc((array), __cap * sizeof(*(array)));          \
+        if (__grown) {                                                       \
+            (array) = __grown;                                               \
+            (capacity) = __cap;                                              \
+        } else {                                                             \
+            __ok = false;                                                    \
+        }                                                                    \
+    }                                                                        \
+    __ok ? &(array)[(count)++] : NULL;                                       \
+})
+
+static int ksymgen_add(ksymgen_symbols_t *symbols, u64 address, u64 size, u32 depth, const char *name)
+{
+    char *copy = strdup(name);
+    ksym_symbol_t *sym = copy ? KSYMGEN_PUSH(symbols->items, symbols->count, symbols->capacity) : NULL;
+    if (!sym) {
+        free(copy);
+        return -1;
+    }
+
+    sym->address = address;
+    sym->size = size;
+    sym->depth = depth;
+    sym->name = copy;
+    return 0;
+}
+
+static FILE *ksymgen_run(const char *tool, const char *args, const char *image)
+{
+    char command[8192];
+    snprintf(command, sizeof(command), "'%s' %s '%s' 2>/dev/null", tool, args, image);
+    return popen(command, "r");
+}
+
+static int ksymgen_read_nm(ksymgen_symbols_t *symbols, const char *nm, const char *image)
+{
+    FILE *in = ksymgen_run(nm, "-n -S --defined-only", image);
+    if (!in) return -1;
+
+    char *line = NULL;
+    size_t line_size = 0;
+    char name[256];
+    u64 address, size;
+    int loaded = 0;
+
+    while (getline(&line, &line_size, in) > 0) {
+        if (ksym_parse_nm(line, &address, &size, name, sizeof(name)) &&
+            ksymgen_add(symbols, address, size, 0, name) == 0) {
+            loaded++;
+        }
+    }
+
+    free(line);
+    return pclose(in) == 0 ? loaded : -1;
+}
+
+/* The text after "DW_AT_xxx :", without objdump's "(indirect string, offset: 0x..): " prefix. */
+static char *ksymgen_attr_value(char *attr)
+{
+    char *value = strchr(attr, ':');
+    if (!value) return NULL;
+
+    value++;
+    while (*value == ' ' || *value == '\t') value++;
+    if (*value == '(') {
+        char *end = strstr(value, "): ");
+        if (end) value = end + 3;
+    }
+
+    value[strcspn(value, "\r\n")] = '\0';
+    return value;
+}
+
+static u64 ksymgen_hex(const char *value)
+{
+    while (*value == '<' || *value == ' ') value++;
+    return strtoull(value, NULL, 16);
+}
+
+static ksymgen_die_t *ksymgen_find_die(ksymgen_dwarf_t *dwarf, u64 offset)
+{
+    u32 lo = 0, hi = dwarf->die_count;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (dwarf->dies[mid].offset < offset) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo < dwarf->die_count && dwarf->dies[lo].offset == offset ? &dwarf->dies[lo] : NULL;
+}
+
+static const char *ksymgen_die_name(ksymgen_dwarf_t *dwarf, u64 offset)
+{
+    for (int hops = 0; hops < 4; hops++) {
+        ksymgen_die_t *die = ksymgen_find_die(dwarf, offset);
+        if (!die) return NULL;
+        if (die->name) return die->name;
+        offset = die->origin;
+    }
+    return NULL;
+}
+
+static void ksymgen_parse_dwarf(ksymgen_dwarf_t *dwarf, FILE *in)
+{
+    char *line = NULL;
+    size_t line_size = 0;
+    u32 nest_level[KSYMGEN_MAX_NEST];
+    u32 nest = 0;
+    ksymgen_die_t *die = NULL;
+    ksymgen_inline_t *inl = NULL;
+    bool in_unit_die = false;
+    u64 cu_base = 0;
+    u32 cu_version = 0;
+
+    while (getline(&line, &line_size, in) > 0) {
+        u32 level;
+        unsigned long long offset;
+        char tag[64];
+
+        if (sscanf(line, " Version: %u", &level) == 1) {
+            cu_version = level;
+            cu_base = 0;
+            continue;
+        }
+
+        if (sscanf(line, " <%u><%llx>: Abbrev Number: %*u (%63[^)])", &level, &offset, tag) == 3) {
+            die = NULL;
+            inl = NULL;
+            in_unit_die = strcmp(tag, "DW_TAG_compile_unit") == 0;
+            while (nest > 0 && nest_level[nest - 1] >= level) nest--;
+
+            if (strcmp(tag, "DW_TAG_inlined_subroutine") == 0) {
+                inl = KSYMGEN_PUSH(dwarf->inlines, dwarf->inline_count, dwarf->inline_capacity);
+                if (inl) {
+                    memset(inl, 0, sizeof(*inl));
+                    inl->cu_base = cu_base;
+                    inl->cu_version = cu_version;
+                    inl->depth = nest + 1;
+                }
+                if (nest < KSYMGEN_MAX_NEST) nest_level[nest++] = level;
+            } else if (strcmp(tag, "DW_TAG_subprogram") == 0) {
+                die = KSYMGEN_PUSH(dwarf->dies, dwarf->die_count, dwarf->die_capacity);
+                if (die) {
+                    die->offset = offset;
+                    die->origin = 0;
+                    die->name = NULL;
+                }
+            }
+            continue;
+        }
+
+        char *attr = strstr(line, "DW_AT_");
+        if (!attr || (!die && !inl && !in_unit_die)) continue;
+
+        char *value = ksymgen_attr_value(attr);
+        if (!value) continue;
+
+        if (in_unit_die) {
+            if (strncmp(attr, "DW_AT_low_pc", 12) == 0) cu_base = ksymgen_hex(value);
+        } else if (die) {
+            if (strncmp(attr, "DW_AT_name ", 11) == 0 && !die->name) {
+                die->name = strdup(value);
+            } else if (strncmp(attr, "DW_AT_abstract_origin", 21) == 0 ||
+                       strncmp(attr, "DW_AT_specification", 19) == 0) {
+                die->origin = ksymgen_hex(value);
+            }
+        } else if (strncmp(attr, "DW_AT_abstract_origin", 21) == 0) {
+            inl->origin = ksymgen_hex(value);
+        } else if (strncmp(attr, "DW_AT_low_pc", 12) == 0) {
+            inl->low = ksymgen_hex(value);
+            inl->has_low = true;
+        } else if (strncmp(attr, "DW_AT_high_pc", 13) == 0) {
+            inl->high = ksymgen_hex(value);
+            inl->has_high = true;
+        } else if (strncmp(attr, "DW_AT_ranges", 12) == 0 && value[0] == '0') {
+            inl->ranges = ksymgen_hex(value);
+            inl->has_ranges = true;
+        }
+    }
+
+    free(line);
+}
+
+/* Map the image and find its range list sections; only 64-bit little-endian ELF is read. */
+static void ksymgen_load_sections(ksymgen_sections_t *sec, const char *image)
+{
+    memset(sec, 0, sizeof(*sec));
+
+    FILE *in = fopen(image, "rb");
+    if (!in) return;
+
+    long size = fseek(in, 0, SEEK_END) == 0 ? ftell(in) : -1;
+    if (size > (long)sizeof(Elf64_Ehdr) && fseek(in, 0, SEEK_SET) == 0) {
+        sec->image = (u8 *)malloc((size_t)size);
+        if (sec->image && fread(sec->image, (size_t)size, 1, in) != 1) {
+            free(sec->image);
+            sec->image = NULL;
+        }
+    }
+    fclose(in);
+    if (!sec->image) return;
+
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)sec->image;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_ident[EI_DATA] != ELFDATA2LSB || eh->e_shoff == 0 || eh->e_shstrndx >= eh->e_shnum ||
+        eh->e_shoff + (u64)eh->e_shnum * sizeof(Elf64_Shdr) > (u64)size) {
+        return;
+    }
+
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(sec->image + eh->e_shoff);
+    const Elf64_Shdr *strtab = &sh[eh->e_shstrndx];
+    if (strtab->sh_offset + strtab->sh_size > (u64)size) return;
+
+    for (u32 i = 0; i < eh->e_shnum; i++) {
+        if (sh[i].sh_name >= strtab->sh_size || sh[i].sh_offset + sh[i].sh_size > (u64)size) continue;
+
+        const char *name = (const char *)sec->image + strtab->sh_offset + sh[i].sh_name;
+        if (strcmp(name, ".debug_rnglists") == 0) {
+            sec->rnglists = sec->image + sh[i].sh_offset;
+            sec->rnglists_size = sh[i].sh_size;
+        } else if (strcmp(name, ".debug_ranges") == 0) {
+            sec->ranges = sec->image + sh[i].sh_offset;
+            sec->ranges_size = sh[i].sh_size;
+        }
+    }
+}
+
+static bool ksymgen_uleb(const u8 **p, const u8 *end, u64 *value)
+{
+    u32 shift = 0;
+
+    *value = 0;
+    while (*p < end && shift < 64) {
+        u8 byte = *(*p)++;
+        *value |= (u64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+        shift += 7;
+    }
+    return false;
+}
+
+static bool ksymgen_addr(const u8 **p, const u8 *end, u64 *value)
+{
+    if (end - *p < 8) return false;
+    memcpy(value, *p, 8);
+    *p += 8;
+    return true;
+}
+
+static int ksymgen_add_range(ksymgen_symbols_t *symbols, const ksymgen_inline_t *inl, const char *name,
+                             u64 begin, u64 end)
+{
+    return begin < end && ksymgen_add(symbols, begin, end - begin, inl->depth, name) == 0;
+}
+
+/* Decode one range list; entries that need .debug_addr (the *x forms) end it early. */
+static int ksymgen_add_range_list(ksymgen_symbols_t *symbols, const ksymgen_sections_t *sec,
+                                  const ksymgen_inline_t *inl, const char *name)
+{
+    u64 base = inl->cu_base;
+    u64 a, b;
+    int added = 0;
+
+    if (inl->cu_version >= 5) {
+        if (!sec->rnglists || inl->ranges >= sec->rnglists_size) return 0;
+
+        const u8 *p = sec->rnglists + inl->ranges;
+        const u8 *end = sec->rnglists + sec->rnglists_size;
+
+        while (p < end) {
+            u8 kind = *p++;
+            if (kind == 4 && ksymgen_uleb(&p, end, &a) && ksymgen_uleb(&p, end, &b)) {
+                added += ksymgen_add_range(symbols, inl, name, base + a, base + b);
+            } else if (kind == 5 && ksymgen_addr(&p, end, &a)) {
+                base = a;
+            } else if (kind == 6 && ksymgen_addr(&p, end, &a) && ksymgen_addr(&p, end, &b)) {
+                added += ksymgen_add_range(symbols, inl, name, a, b);
+            } else if (kind == 7 && ksymgen_addr(&p, end, &a) && ksymgen_uleb(&p, end, &b)) {
+                added += ksymgen_add_range(symbols, inl, name, a, a + b);
+            } else {
+                break;
+            }
+        }
+    } else {
+        if (!sec->ranges) return 0;
+
+        for (u64 off = inl->ranges; off + 16 <= sec->ranges_size; off += 16) {
+            memcpy(&a, sec->ranges + off, 8);
+            memcpy(&b, sec->ranges + off + 8, 8);
+            if (!a && !b) break;
+            if (a == UINT64_MAX) base = b;
+            else added += ksymgen_add_range(symbols, inl, name, base + a, base + b);
+        }
+    }
+
+    return added;
+}
+
+static int ksymgen_read_inlines(ksymgen_symbols_t *symbols, const char *objdump, const char *image)
+{
+    FILE *in = ksymgen_run(objdump, "--dwarf=info", image);
+    if (!in) return 0;
+
+    ksymgen_dwarf_t dwarf;
+    memset(&dwarf, 0, sizeof(dwarf));
+    ksymgen_parse_dwarf(&dwarf, in);
+    pclose(in);
+
+    ksymgen_sections_t sec;
+    ksymgen_load_sections(&sec, image);
+
+    int added = 0;
+    for (u32 i = 0; i < dwarf.inline_count; i++) {
+        const ksymgen_inline_t *inl = &dwarf.inlines[i];
+        const char *name = ksymgen_die_name(&dwarf, inl->origin);
+        if (!name) continue;
+
+        if (inl->has_low && inl->has_high) {
+            /* DWARF 4+ usually stores high_pc as a length. */
+            u64 high = inl->high >= inl->low ? inl->high : inl->low + inl->high;
+            added += ksymgen_add_range(symbols, inl, name, inl->low, high);
+        } else if (inl->has_ranges) {
+            added += ksymgen_add_range_list(symbols, &sec, inl, name);
+        }
+    }
+
+    for (u32 i = 0; i < dwarf.die_count; i++) {
+        free(dwarf.dies[i].name);
+    }
+    free(dwarf.dies);
+    free(dwarf.inlines);
+    free(sec.image);
+
+    return added;
+}
+
+int main(int argc, char **argv)
+{
+    const char *nm = "nm";
+    const char *objdump = "objdump";
+    const char *paths[2];
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--nm") == 0 && i + 1 < argc) {
+            if (*argv[++i]) nm = argv[i];
+        } else if (strcmp(argv[i], "--objdump") == 0 && i + 1 < argc) {
+            objdump = argv[++i];
+        } else if (path_count < 2) {
+            paths[path_count++] = argv[i];
+        } else {
+            path_count = 3;
+        }
+    }
+
+    if (path_count != 2) {
+        fprintf(stderr, "usage: %s [--nm NM] [--objdump OBJDUMP] <image> <output>\n", argv[0]);
+        return 2;
+    }
+
+    ksymgen_symbols_t symbols;
+    memset(&symbols, 0, sizeof(symbols));
+
+    int functions = ksymgen_read_nm(&symbols, nm, paths[0]);
+    if (functions < 0) {
+        fprintf(stderr, "ksymgen: cannot read symbols from %s\n", paths[0]);
+        return 1;
+    }
+    int inlines = *objdump ? ksymgen_read_inlines(&symbols, objdump, paths[0]) : 0;
+
+    if (ksym_write(paths[1], symbols.items, symbols.count) != 0) {
+        fprintf(stderr, "ksymgen: cannot write %s\n", paths[1]);
+        return 1;
+    }
+
+    printf("ksymgen: %d functions, %d inlined ranges -> %s\n", functions, inlines, paths[1]);
+
+    for (u32 i = 0; i < symbols.count; i++) {
+        free(symbols.items[i].name);
+    }
+    free(symbols.items);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <kernel/kthread.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Kernel threads for background work (dispatch workers, pollers). Until
+ * thread_t carries a switchable context these run on host threads; the
+ * interface is what callers should depend on.
+ */
+
+static __thread kthread_t *current_kthread = NULL;
+
+static void *kthread_entry(void *arg)
+{
+    kthread_t *kthread = (kthread_t *)arg;
+
+    current_kthread = kthread;
+    kthread->exit_code = kthread->fn(kthread->arg);
+    current_kthread = NULL;
+
+    return NULL;
+}
+
+kthread_t *kthread_run(const char *name, kthread_fn_t fn, void *arg)
+{
+    if (!fn) return NULL;
+
+    kthread_t *kthread = (kthread_t *)calloc(1, sizeof(kthread_t));
+    if (!kthread) return NULL;
+
+    pthread_t *handle = (pthread_t *)malloc(sizeof(pthread_t));
+    if (!handle) {
+        free(kthread);
+        return NULL;
+    }
+
+    if (name) {
+        strncpy(kthread->name, name, KTHREAD_NAME_LEN - 1);
+    }
+    kthread->fn = fn;
+    kthread->arg = arg;
+    kthread->handle = handle;
+
+    if (pthread_create(handle, NULL, kthread_entry, kthread) != 0) {
+        free(handle);
+        free(kthread);
+        return NULL;
+    }
+
+    return kthread;
+}
+
+int kthread_stop(kthread_t *kthread)
+{
+    if (!kthread) return -1;
+
+    __atomic_store_n(&kthread->should_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(*(pthread_t *)kthread->handle, NULL);
+
+    int exit_code = kthread->exit_code;
+    free(kthread->handle);
+    free(kthread);
+
+    return exit_code;
+}
+
+bool kthread_should_stop(kthread_t *kthread)
+{
+    if (!kthread) return false;
+    return __atomic_load_n(&kthread->should_stop, __ATOMIC_ACQUIRE) != 0;
+}
+
+kthread_t *kthread_current(void)
+{
+    return current_kthread;
+}
@@ -7,6 +7,10 @@
 #include <kernel/network.h>
 #include <kernel/driver.h>
 #include <kernel/security.h>
+#include <kernel/rcu.h>
+#include <kernel/futex.h>
+#include <kernel/percpu.h>
+#include <kernel/pmu.h>
 
 void printk(const char *fmt, ...);
 
@@ -14,12 +18,24 @@ int kernel_main(void)
 {
     printk("Aegis OS Kernel Initializing...\n");
     
+    if (percpu_init(MAX_CPUS) != 0) {
+        printk("ERROR: Per-CPU area init failed\n");
+        return -1;
+    }
+    printk("Per-CPU areas initialized\n");
+    
     if (mmgr_init() != 0) {
         printk("ERROR: Memory manager init failed\n");
         return -1;
     }
     printk("Memory manager initialized\n");
     
+    if (rcu_init() != 0 || futex_init() != 0) {
+        printk("ERROR: Synchronization init failed\n");
+        return -1;
+    }
+    printk("RCU and futex tables initialized\n");
+    
     if (pmgr_init() != 0) {
         printk("ERROR: Process manager init failed\n");
         return -1;
@@ -38,6 +54,12 @@ int kernel_main(void)
     }
     printk("Interrupt dispatcher initialized\n");
     
+    if (pmu_init() == 0) {
+        printk("PMU counters programmed\n");
+    } else {
+        printk("PMU not available, perf_stat falls back to the TSC\n");
+    }
+    
     if (aegisfs_init() != 0) {
         printk("ERROR: AegisFS init failed\n");
         return -1;
@@ -1,4 +1,6 @@
 #include <kernel/memory.h>
+#include <kernel/spinlock.h>
+#include <kernel/tracepoint.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -7,7 +9,7 @@ typedef struct {
     u64 total_pages;
     u64 free_pages;
     u8 *page_bitmap;
-    uint lock;
+    mcs_lock_t lock;
 } mmgr_state_t;
 
 static mmgr_state_t mmgr_state = {0};
@@ -16,7 +18,7 @@ int mmgr_init(void)
 {
     mmgr_state.total_pages = 0x100000;
     mmgr_state.free_pages = mmgr_state.total_pages;
-    mmgr_state.lock = 0;
+    mcs_lock_init(&mmgr_state.lock);
 
     mmgr_state.pages = (page_info_t *)calloc(mmgr_state.total_pages, sizeof(page_info_t));
     if (!mmgr_state.pages) return -1;
@@ -35,6 +37,10 @@ int mmgr_init(void)
 
 void *mmgr_alloc_page(void)
 {
+    mcs_node_t node;
+    void *page = NULL;
+
+    mcs_lock(&mmgr_state.lock, &node);
     for (u64 i = 0; i < mmgr_state.total_pages; i++) {
         u32 byte_idx = i / 8;
         u32 bit_idx = i % 8;
@@ -43,10 +49,14 @@ void *mmgr_alloc_page(void)
             mmgr_state.page_bitmap[byte_idx] |= (1 << bit_idx);
             mmgr_state.pages[i].ref_count = 1;
             mmgr_state.free_pages--;
-            return (void *)mmgr_state.pages[i].phys_addr;
+            page = (void *)mmgr_state.pages[i].phys_addr;
+            break;
         }
     }
-    return NULL;
+    mcs_unlock(&mmgr_state.lock, &node);
+
+    AEGIS_TRACE(mmgr, alloc_page, (u64)page);
+    return page;
 }
 
 void mmgr_free_page(void *page)
@@ -56,13 +66,18 @@ void mmgr_free_page(void *page)
     u64 phys_addr = (u64)page;
     u64 page_num = phys_addr / PAGE_SIZE;
 
+    AEGIS_TRACE(mmgr, free_page, phys_addr);
+
     if (page_num < mmgr_state.total_pages) {
         u32 byte_idx = page_num / 8;
         u32 bit_idx = page_num % 8;
+        mcs_node_t node;
 
+        mcs_lock(&mmgr_state.lock, &node);
         mmgr_state.page_bitmap[byte_idx] &= ~(1 << bit_idx);
         mmgr_state.pages[page_num].ref_count = 0;
         mmgr_state.free_pages++;
+        mcs_unlock(&mmgr_state.lock, &node);
     }
 }
 
@@ -100,20 +115,38 @@ void mmgr_free_kernel_pages(void *pages, u32 count)
     mmgr_free_pages(pages, count);
 }
 
+static bool mmgr_range_contains(u64 start, u32 count, u64 virt_addr)
+{
+    if (virt_addr < start) return false;
+
+    u64 offset = virt_addr - start;
+    return offset < (u64)count * PAGE_SIZE && (offset & (PAGE_SIZE - 1)) == 0;
+}
+
 int mmgr_map_pages(address_space_t *as, u64 virt_addr, u64 phys_addr, u32 count, prot_flags_t prot)
 {
     if (!as) return -1;
 
+    bool overlaps = false;
+    for (u32 j = 0; j < as->vma_count; j++) {
+        if (mmgr_range_contains(virt_addr, count, as->vmas[j].virt_addr)) {
+            overlaps = true;
+            break;
+        }
+    }
+
     for (u32 i = 0; i < count; i++) {
         vma_t *vma = NULL;
-        for (u32 j = 0; j < as->vma_count; j++) {
-            if (as->vmas[j].virt_addr == virt_addr + (i * PAGE_SIZE)) {
-                vma = &as->vmas[j];
-                break;
+        if (overlaps) {
+            for (u32 j = 0; j < as->vma_count; j++) {
+                if (as->vmas[j].virt_addr == virt_addr + (i * PAGE_SIZE)) {
+                    vma = &as->vmas[j];
+                    break;
+                }
             }
         }
 
-        if (!vma && as->vma_count < 1024) {
+        if (!vma && as->vma_count < MMGR_MAX_VMAS) {
             vma = &as->vmas[as->vma_count++];
         }
 
@@ -123,6 +156,7 @@ int mmgr_map_pages(address_space_t *as, u64 virt_addr, u64 phys_addr, u32 count,
             vma->size = PAGE_SIZE;
             vma->prot = prot;
             vma->encrypted = false;
+            vma->shared = false;
         }
     }
 
@@ -133,17 +167,16 @@ int mmgr_unmap_pages(address_space_t *as, u64 virt_addr, u32 count)
 {
     if (!as) return -1;
 
-    for (u32 i = 0; i < count; i++) {
-        for (u32 j = 0; j < as->vma_count; j++) {
-            if (as->vmas[j].virt_addr == virt_addr + (i * PAGE_SIZE)) {
-                for (u32 k = j; k < as->vma_count - 1; k++) {
-                    as->vmas[k] = as->vmas[k + 1];
-                }
-                as->vma_count--;
-                break;
+    u32 kept = 0;
+    for (u32 j = 0; j < as->vma_count; j++) {
+        if (!mmgr_range_contains(virt_addr, count, as->vmas[j].virt_addr)) {
+            if (kept != j) {
+                as->vmas[kept] = as->vmas[j];
             }
+            kept++;
         }
     }
+    as->vma_count = kept;
 
     return 0;
 }
@@ -169,7 +202,7 @@ address_space_t *mmgr_create_address_space(void)
     address_space_t *as = (address_space_t *)malloc(sizeof(address_space_t));
     if (!as) return NULL;
 
-    as->vmas = (vma_t *)malloc(1024 * sizeof(vma_t));
+    as->vmas = (vma_t *)malloc(MMGR_MAX_VMAS * sizeof(vma_t));
     if (!as->vmas) {
         free(as);
         return NULL;
@@ -212,15 +245,51 @@ int mmgr_decrypt_page(void *page)
 
 u64 mmgr_get_phys_addr(address_space_t *as, u64 virt_addr)
 {
-    if (!as) return 0;
+    vma_t *vma = mmgr_find_vma(as, virt_addr);
+    if (!vma) return 0;
+
+    return vma->phys_addr;
+}
+
+vma_t *mmgr_find_vma(address_space_t *as, u64 virt_addr)
+{
+    if (!as) return NULL;
 
     for (u32 i = 0; i < as->vma_count; i++) {
         if (as->vmas[i].virt_addr == virt_addr) {
-            return as->vmas[i].phys_addr;
+            return &as->vmas[i];
         }
     }
 
-    return 0;
+    return NULL;
+}
+
+int mmgr_page_ref(u64 phys_addr)
+{
+    u64 page_num = phys_addr / PAGE_SIZE;
+    if (!mmgr_state.pages || page_num >= mmgr_state.total_pages) return -1;
+
+    return (int)__atomic_add_fetch(&mmgr_state.pages[page_num].ref_count, 1, __ATOMIC_RELAXED);
+}
+
+int mmgr_page_unref(u64 phys_addr)
+{
+    u64 page_num = phys_addr / PAGE_SIZE;
+    if (!mmgr_state.pages || page_num >= mmgr_state.total_pages) return -1;
+
+    page_info_t *page = &mmgr_state.pages[page_num];
+    u32 refs = __atomic_load_n(&page->ref_count, __ATOMIC_RELAXED);
+
+    do {
+        if (refs == 0) return 0;
+    } while (!__atomic_compare_exchange_n(&page->ref_count, &refs, refs - 1, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    if (refs == 1) {
+        mmgr_free_page((void *)page->phys_addr);
+    }
+
+    return (int)(refs - 1);
 }
 
 int mmgr_secure_zero(void *ptr, size_t size)
@@ -231,3 +300,34 @@ int mmgr_secure_zero(void *ptr, size_t size)
     }
     return 0;
 }
+
+page_buffer_t *mmgr_page_buffer_alloc(void)
+{
+    page_buffer_t *page = (page_buffer_t *)malloc(sizeof(page_buffer_t));
+    if (!page) return NULL;
+
+    page->data = (u8 *)aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    if (!page->data) {
+        free(page);
+        return NULL;
+    }
+
+    page->ref_count = 1;
+    return page;
+}
+
+void mmgr_page_buffer_get(page_buffer_t *page)
+{
+    if (!page) return;
+    __atomic_fetch_add(&page->ref_count, 1, __ATOMIC_RELAXED);
+}
+
+void mmgr_page_buffer_put(page_buffer_t *page)
+{
+    if (!page) return;
+
+    if (__atomic_sub_fetch(&page->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(page->data);
+        free(page);
+    }
+}
@@ -1,4 +1,6 @@
 #include <kernel/panic.h>
+#include <kernel/ksym.h>
+#include <kernel/sampler.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -205,9 +207,38 @@ int panic_clear_history(void)
     return 0;
 }
 
+#define PANIC_STACK_DEPTH 32
+
+/*
+ * Walk the frame-pointer chain from 'base_pointer' (or from here if it is
+ * 0) and print one symbolized return address per line, inlined callers
+ * first: "#1 0x... helper in caller+0x1c".
+ */
 int panic_dump_stack_trace(u64 base_pointer)
 {
-    printf("Stack trace (base pointer: 0x%llx):\n", base_pointer);
+    u64 fp = base_pointer ? base_pointer : (u64)(uintptr_t)__builtin_frame_address(0);
+    u64 stack[PANIC_STACK_DEPTH];
+    u32 depth = sampler_unwind((u64)(uintptr_t)panic_dump_stack_trace, fp, fp, stack, PANIC_STACK_DEPTH);
+
+    printf("Stack trace (base pointer: 0x%llx):\n", (unsigned long long)fp);
+
+    /* stack[0] is this function; the rest are return addresses, so look up the call itself. */
+    for (u32 i = 1; i < depth; i++) {
+        const char *names[KSYM_MAX_INLINE + 1];
+        u64 offset = 0;
+        u32 count = ksym_lookup_inline(stack[i] - 1, names, KSYM_MAX_INLINE + 1);
+
+        printf("  #%u 0x%016llx ", i, (unsigned long long)stack[i]);
+        if (count == 0 || !ksym_lookup(stack[i] - 1, &offset)) {
+            printf("?\n");
+            continue;
+        }
+        for (u32 n = 0; n + 1 < count; n++) {
+            printf("%s in ", names[n]);
+        }
+        printf("%s+0x%llx\n", names[count - 1], (unsigned long long)offset + 1);
+    }
+
     return 0;
 }
 
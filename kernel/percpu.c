@@ -0,0 +1,70 @@
+#include <kernel/percpu.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+char *percpu_base = NULL;
+size_t percpu_stride = 0;
+u32 percpu_nr = 1;
+
+/* The CPU this host thread is currently running kernel code for. */
+__thread u32 percpu_cpu = 0;
+
+size_t percpu_area_size(void)
+{
+    if (!__start_percpu || !__stop_percpu) return 0;
+    return (size_t)(__stop_percpu - __start_percpu);
+}
+
+/* The boot copy may sit next to instrumented globals; copy it byte by byte. */
+__attribute__((no_sanitize_address))
+static void percpu_copy_boot_area(char *dst, size_t size)
+{
+    const volatile char *src = __start_percpu;
+
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = src[i];
+    }
+}
+
+/*
+ * Give each of 'nr_cpus' CPUs its own copy of the per-CPU section, rounded
+ * up to the cache line size (at least 64 bytes) so no two CPUs share a line. CPU 0 inherits
+ * whatever was recorded in the boot copy.
+ */
+int percpu_init(u32 nr_cpus)
+{
+    if (__atomic_load_n(&percpu_base, __ATOMIC_ACQUIRE)) return 0;
+    if (nr_cpus == 0 || nr_cpus > MAX_CPUS) return -1;
+
+    long reported = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+    size_t line = 64;
+    if (reported > 64 && !(reported & (reported - 1))) {
+        line = (size_t)reported;
+    }
+
+    size_t size = percpu_area_size();
+    size_t stride = (size + line - 1) & ~(line - 1);
+    if (stride == 0) {
+        stride = line;
+    }
+
+    char *base = (char *)aligned_alloc(line, stride * nr_cpus);
+    if (!base) return -1;
+
+    memset(base, 0, stride * nr_cpus);
+    percpu_copy_boot_area(base, size);
+
+    percpu_stride = stride;
+    percpu_nr = nr_cpus;
+    __atomic_store_n(&percpu_base, base, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Switch this thread to 'cpu' (e.g. while dispatching its interrupt); returns the previous CPU. */
+u32 percpu_set_current_cpu(u32 cpu)
+{
+    u32 prev = percpu_cpu;
+    percpu_cpu = cpu;
+    return prev;
+}
@@ -0,0 +1,330 @@
+#include "perf_chrome.h"
+#include "perf_trace.h"
+#include <kernel/ksym.h>
+#include <kernel/percpu.h>
+#include <kernel/profiler.h>
+#include <kernel/tracepoint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Trace-event pids are 1-based so CPU 0 does not look like the idle process. */
+#define PERF_CHROME_PID(cpu) ((cpu) + 1)
+
+typedef struct {
+    bool seen;
+    bool switched;
+    u32 running;
+    u64 since;
+    u64 last_ts;
+} perf_chrome_cpu_t;
+
+struct perf_chrome {
+    FILE *out;
+    u64 events;
+    perf_chrome_cpu_t cpus[MAX_CPUS];
+};
+
+static void perf_chrome_string(FILE *out, const char *str)
+{
+    fputc('"', out);
+    for (; *str; str++) {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\') {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* Trace-event times are microseconds; keep the nanoseconds as a fraction. */
+static void perf_chrome_us(FILE *out, const char *key, u64 ns)
+{
+    fprintf(out, ",\"%s\":%llu.%03llu", key, (unsigned long long)(ns / 1000),
+            (unsigned long long)(ns % 1000));
+}
+
+static void perf_chrome_next(perf_chrome_t *chrome)
+{
+    fputs(chrome->events++ ? ",\n" : "\n", chrome->out);
+}
+
+/* Open an event; the caller adds any fields after "tid" and closes it with '}'. */
+static void perf_chrome_begin(perf_chrome_t *chrome, const char *name, const char *cat,
+                              char phase, u64 ts, u32 cpu, u32 track)
+{
+    FILE *out = chrome->out;
+
+    perf_chrome_next(chrome);
+    fputs("{\"name\":", out);
+    perf_chrome_string(out, name);
+    fprintf(out, ",\"cat\":\"%s\",\"ph\":\"%c\"", cat, phase);
+    perf_chrome_us(out, "ts", ts);
+    fprintf(out, ",\"pid\":%u,\"tid\":%u", PERF_CHROME_PID(cpu), track);
+    chrome->cpus[cpu].seen = true;
+}
+
+static void perf_chrome_slice(perf_chrome_t *chrome, const char *name, const char *cat,
+                              u64 ts, u64 dur, u32 cpu, u32 track)
+{
+    perf_chrome_begin(chrome, name, cat, 'X', ts, cpu, track);
+    perf_chrome_us(chrome->out, "dur", dur);
+}
+
+static int perf_chrome_running(perf_chrome_t *chrome, u32 cpu, u64 end)
+{
+    perf_chrome_cpu_t *pc = &chrome->cpus[cpu];
+    char name[32];
+
+    if (!pc->switched || end <= pc->since) return 0;
+
+    snprintf(name, sizeof(name), "tid %u", pc->running);
+    perf_chrome_slice(chrome, name, "sched", pc->since, end - pc->since, cpu, PERF_CHROME_TRACK_SCHED);
+    fprintf(chrome->out, ",\"args\":{\"tid\":%u}}", pc->running);
+    return 1;
+}
+
+perf_chrome_t *perf_chrome_open(const char *path)
+{
+    if (!path) return NULL;
+
+    perf_chrome_t *chrome = (perf_chrome_t *)calloc(1, sizeof(perf_chrome_t));
+    if (!chrome) return NULL;
+
+    chrome->out = fopen(path, "w");
+    if (!chrome->out) {
+        free(chrome);
+        return NULL;
+    }
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", chrome->out);
+    return chrome;
+}
+
+int perf_chrome_add_sample(perf_chrome_t *chrome, const perf_sample_t *sample)
+{
+    if (!chrome || !sample || sample->cpu_id >= MAX_CPUS) return -1;
+
+    FILE *out = chrome->out;
+    u32 cpu = sample->cpu_id;
+    perf_chrome_cpu_t *pc = &chrome->cpus[cpu];
+    const char *name = perf_event_type_name(sample->event_type);
+    int written;
+
+    if (sample->timestamp > pc->last_ts) pc->last_ts = sample->timestamp;
+
+    switch (sample->event_type) {
+    case PERF_EVENT_CONTEXT_SWITCH:
+        /* The switched-out thread ran from the previous switch to this one. */
+        if (pc->switched) pc->running = sample->tid;
+        written = perf_chrome_running(chrome, cpu, sample->timestamp);
+        pc->switched = true;
+        pc->running = (u32)sample->event_value;
+        pc->since = sample->timestamp;
+
+        perf_chrome_begin(chrome, name, "sched", 'i', sample->timestamp, cpu, PERF_CHROME_TRACK_SCHED);
+        fprintf(out, ",\"s\":\"t\",\"args\":{\"prev\":%u,\"next\":%u,\"cost_ns\":%llu}}",
+                sample->tid, (u32)sample->event_value, (unsigned long long)sample->duration_ns);
+        return written + 1;
+
+    case PERF_EVENT_IPC_MESSAGE: {
+        bool recv = sample->event_value & PERF_IPC_RECV;
+        unsigned long long id = PERF_IPC_ID(sample->event_value);
+
+        /* Flow events bind to the slice around them, so the message gets at least 1 ns. */
+        perf_chrome_slice(chrome, recv ? "ipc_recv" : "ipc_send", "ipc", sample->timestamp,
+                          sample->duration_ns ? sample->duration_ns : 1, cpu, PERF_CHROME_TRACK_EVENTS);
+        fprintf(out, ",\"args\":{\"msg\":%llu,\"pid\":%u,\"tid\":%u}}", id, sample->pid, sample->tid);
+
+        perf_chrome_begin(chrome, "ipc", "ipc", recv ? 'f' : 's', sample->timestamp, cpu,
+                          PERF_CHROME_TRACK_EVENTS);
+        fprintf(out, ",\"id\":%llu%s}", id, recv ? ",\"bp\":\"e\"" : "");
+        return 2;
+    }
+
+    case PERF_EVENT_CPU_SAMPLE: {
+        u64 offset;
+        const char *symbol = sample->call_depth ? ksym_lookup(sample->call_stack[0], &offset) : NULL;
+
+        perf_chrome_begin(chrome, symbol ? symbol : name, "sample", 'i', sample->timestamp, cpu,
+                          PERF_CHROME_TRACK_EVENTS);
+        fprintf(out, ",\"s\":\"t\",\"args\":{\"pc\":\"0x%llx\",\"tid\":%u}}",
+                (unsigned long long)sample->event_value, sample->tid);
+        return 1;
+    }
+
+    default:
+        if (sample->duration_ns) {
+            perf_chrome_slice(chrome, name, "perf", sample->timestamp, sample->duration_ns, cpu,
+                              PERF_CHROME_TRACK_EVENTS);
+        } else {
+            perf_chrome_begin(chrome, name, "perf", 'i', sample->timestamp, cpu, PERF_CHROME_TRACK_EVENTS);
+            fputs(",\"s\":\"t\"", out);
+        }
+        fprintf(out, ",\"args\":{\"value\":%llu,\"pid\":%u,\"tid\":%u}}",
+                (unsigned long long)sample->event_value, sample->pid, sample->tid);
+        return 1;
+    }
+}
+
+int perf_chrome_add_buffer(perf_chrome_t *chrome, perf_buffer_t *buffer)
+{
+    if (!chrome || !buffer) return -1;
+
+    size_t count = __atomic_load_n(&buffer->sample_count, __ATOMIC_ACQUIRE);
+    if (count > buffer->capacity) count = buffer->capacity;
+
+    int events = 0;
+    for (size_t i = 0; i < count; i++) {
+        int written = perf_chrome_add_sample(chrome, &buffer->samples[i]);
+        if (written > 0) events += written;
+    }
+
+    return events;
+}
+
+/* Streams the trace file through the exporter without loading it. */
+int perf_chrome_add_trace(perf_chrome_t *chrome, const char *trace_path)
+{
+    if (!chrome) return -1;
+
+    perf_trace_reader_t *reader = perf_trace_open(trace_path);
+    if (!reader) return -1;
+
+    perf_sample_t sample;
+    int events = 0;
+    while (perf_trace_next(reader, &sample) > 0) {
+        int written = perf_chrome_add_sample(chrome, &sample);
+        if (written > 0) events += written;
+    }
+    perf_trace_reader_close(reader);
+
+    return events;
+}
+
+/* Profiler samples are stamped when a region ends and carry its length in cycles. */
+int perf_chrome_add_profiler(perf_chrome_t *chrome)
+{
+    if (!chrome) return -1;
+
+    profiler_sample_t *samples = (profiler_sample_t *)malloc(PROFILER_RING_SIZE * sizeof(profiler_sample_t));
+    if (!samples) return -1;
+
+    int events = 0;
+    for (u32 cpu = 0; cpu < percpu_nr_cpus() && cpu < MAX_CPUS; cpu++) {
+        u32 count = profiler_read_samples(cpu, samples, PROFILER_RING_SIZE);
+
+        for (u32 i = 0; i < count; i++) {
+            const char *name = profiler_probe_name(samples[i].probe);
+            if (!name) continue;
+
+            u64 start = profiler_cycles_to_ns(samples[i].timestamp - samples[i].duration);
+            u64 end = profiler_cycles_to_ns(samples[i].timestamp);
+            perf_chrome_slice(chrome, name, "profiler", start, end > start ? end - start : 0, cpu,
+                              PERF_CHROME_TRACK_PROFILER);
+            fprintf(chrome->out, ",\"args\":{\"cycles\":%u}}", samples[i].duration);
+            events++;
+        }
+    }
+
+    free(samples);
+    return events;
+}
+
+/* Write the next top-level comma-separated expression of 'list' as a JSON key. */
+static const char *perf_chrome_arg_name(FILE *out, const char *list)
+{
+    int depth = 0;
+
+    while (*list == ' ') list++;
+    fputc('"', out);
+    for (; *list && (depth || *list != ','); list++) {
+        if (*list == '(' || *list == '[') depth++;
+        if ((*list == ')' || *list == ']') && depth) depth--;
+        if (*list == '"' || *list == '\\') fputc('\\', out);
+        fputc(*list, out);
+    }
+    fputc('"', out);
+
+    return *list ? list + 1 : list;
+}
+
+/* Tracepoint records become instants named "subsys:name", keyed by their argument expressions. */
+int perf_chrome_add_tracepoints(perf_chrome_t *chrome)
+{
+    if (!chrome) return -1;
+
+    trace_record_t *records = (trace_record_t *)malloc(TRACE_RING_SIZE * sizeof(trace_record_t));
+    if (!records) return -1;
+
+    int events = 0;
+    for (u32 cpu = 0; cpu < percpu_nr_cpus() && cpu < MAX_CPUS; cpu++) {
+        u32 count = trace_read(cpu, records, TRACE_RING_SIZE);
+
+        for (u32 i = 0; i < count; i++) {
+            const tracepoint_t *tp = records[i].tp;
+            char name[64];
+            if (!tp) continue;
+
+            snprintf(name, sizeof(name), "%s:%s", tp->subsys, tp->name);
+            perf_chrome_begin(chrome, name, "tracepoint", 'i', records[i].timestamp, cpu,
+                              PERF_CHROME_TRACK_EVENTS);
+            fprintf(chrome->out, ",\"s\":\"t\",\"args\":{\"tid\":%u", records[i].tid);
+
+            const char *arg = tp->args;
+            for (u32 a = 0; a < records[i].nargs && a < TRACE_MAX_ARGS && *arg; a++) {
+                fputc(',', chrome->out);
+                arg = perf_chrome_arg_name(chrome->out, arg);
+                fprintf(chrome->out, ":%llu", (unsigned long long)records[i].args[a]);
+            }
+            fputs("}}", chrome->out);
+            events++;
+        }
+    }
+
+    free(records);
+    return events;
+}
+
+int perf_chrome_close(perf_chrome_t *chrome)
+{
+    if (!chrome) return -1;
+
+    static const char *const tracks[] = {
+        [PERF_CHROME_TRACK_SCHED] = "sched",
+        [PERF_CHROME_TRACK_PROFILER] = "profiler",
+        [PERF_CHROME_TRACK_EVENTS] = "events",
+    };
+    FILE *out = chrome->out;
+
+    for (u32 cpu = 0; cpu < MAX_CPUS; cpu++) {
+        perf_chrome_cpu_t *pc = &chrome->cpus[cpu];
+        if (!pc->seen) continue;
+
+        perf_chrome_running(chrome, cpu, pc->last_ts);
+
+        perf_chrome_next(chrome);
+        fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"CPU %u\"}}",
+                PERF_CHROME_PID(cpu), cpu);
+        perf_chrome_next(chrome);
+        fprintf(out, "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"sort_index\":%u}}",
+                PERF_CHROME_PID(cpu), cpu);
+        for (u32 track = PERF_CHROME_TRACK_SCHED; track <= PERF_CHROME_TRACK_EVENTS; track++) {
+            perf_chrome_next(chrome);
+            fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    PERF_CHROME_PID(cpu), track, tracks[track]);
+        }
+    }
+
+    fputs("\n]}\n", out);
+
+    int ret = ferror(out) ? -1 : 0;
+    if (fclose(out) != 0) ret = -1;
+    free(chrome);
+    return ret;
+}
@@ -0,0 +1,32 @@
+#ifndef AEGIS_PERF_CHROME_H
+#define AEGIS_PERF_CHROME_H
+
+#include "perf_optimize.h"
+
+/*
+ * Chrome trace-event JSON, as loaded by chrome://tracing and
+ * ui.perfetto.dev. Each CPU shows up as a process with three tracks:
+ * "sched" (which thread ran, from context switches), "profiler"
+ * (profiler regions) and "events" (every other perf sample and the
+ * tracepoint records). An IPC send and its receive are joined by a flow
+ * arrow.
+ */
+#define PERF_CHROME_TRACK_SCHED     1
+#define PERF_CHROME_TRACK_PROFILER  2
+#define PERF_CHROME_TRACK_EVENTS    3
+
+typedef struct perf_chrome perf_chrome_t;
+
+perf_chrome_t *perf_chrome_open(const char *path);
+
+/* Each returns the number of trace events written, or -1. */
+int perf_chrome_add_sample(perf_chrome_t *chrome, const perf_sample_t *sample);
+int perf_chrome_add_buffer(perf_chrome_t *chrome, perf_buffer_t *buffer);
+int perf_chrome_add_trace(perf_chrome_t *chrome, const char *trace_path);
+int perf_chrome_add_profiler(perf_chrome_t *chrome);
+int perf_chrome_add_tracepoints(perf_chrome_t *chrome);
+
+/* Close running sched slices, name the tracks and finish the file. */
+int perf_chrome_close(perf_chrome_t *chrome);
+
+#endif
@@ -1,9 +1,16 @@
 #include "perf_optimize.h"
+#include "perf_trace.h"
+#include <kernel/profiler.h>
+#include <kernel/wait_queue.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 perf_buffer_t *perf_create_buffer(void) {
+    return perf_create_buffer_sized(PERF_MAX_SAMPLES);
+}
+
+perf_buffer_t *perf_create_buffer_sized(size_t capacity) {
     perf_buffer_t *buffer = malloc(sizeof(perf_buffer_t));
     if (!buffer) return NULL;
     
@@ -11,6 +18,37 @@ perf_buffer_t *perf_create_buffer(void) {
     buffer->collection_start = 0;
     buffer->is_active = false;
     
+    if (capacity > 0) {
+        buffer->samples = calloc(capacity, sizeof(perf_sample_t));
+        if (!buffer->samples) {
+            free(buffer);
+            return NULL;
+        }
+        buffer->capacity = capacity;
+    }
+    
+    for (int type = 0; type < PERF_EVENT_TYPES; type++) {
+        buffer->event_hist[type] = hdr_percpu_alloc();
+        if (!buffer->event_hist[type]) {
+            perf_free_buffer(buffer);
+            return NULL;
+        }
+    }
+    
+    return buffer;
+}
+
+/* Samples spill to an mmap-backed trace at 'path'; read it back with perf_trace_load(). */
+perf_buffer_t *perf_create_stream_buffer(const char *path) {
+    perf_buffer_t *buffer = perf_create_buffer_sized(0);
+    if (!buffer) return NULL;
+    
+    buffer->stream = perf_trace_create(path);
+    if (!buffer->stream) {
+        perf_free_buffer(buffer);
+        return NULL;
+    }
+    
     return buffer;
 }
 
@@ -20,6 +58,10 @@ void perf_start_collection(perf_buffer_t *buffer) {
     buffer->is_active = true;
     buffer->sample_count = 0;
     buffer->collection_start = 0;
+    
+    for (int type = 0; type < PERF_EVENT_TYPES; type++) {
+        hdr_percpu_reset(buffer->event_hist[type]);
+    }
 }
 
 void perf_stop_collection(perf_buffer_t *buffer) {
@@ -29,22 +71,66 @@ void perf_stop_collection(perf_buffer_t *buffer) {
     buffer->collection_end = 0;
 }
 
-void perf_record_sample(perf_buffer_t *buffer, const perf_sample_t *sample) {
-    if (!buffer || !sample || !buffer->is_active) return;
+/* Lock-free so it can be called from the sampling timer as well as from threads. */
+bool perf_record_sample(perf_buffer_t *buffer, const perf_sample_t *sample) {
+    if (!buffer || !sample || !buffer->is_active) return false;
     
-    if (buffer->sample_count >= PERF_MAX_SAMPLES) {
-        return;
+    if ((uint32_t)sample->event_type < PERF_EVENT_TYPES) {
+        hdr_percpu_record(buffer->event_hist[sample->event_type], sample->duration_ns);
     }
     
-    memcpy(&buffer->samples[buffer->sample_count], sample, sizeof(perf_sample_t));
-    buffer->sample_count++;
+    if (buffer->stream) {
+        return perf_trace_write(buffer->stream, sample);
+    }
+    
+    size_t slot = __atomic_load_n(&buffer->sample_count, __ATOMIC_RELAXED);
+    do {
+        if (slot >= buffer->capacity) return false;
+    } while (!__atomic_compare_exchange_n(&buffer->sample_count, &slot, slot + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    
+    memcpy(&buffer->samples[slot], sample, sizeof(perf_sample_t));
+    return true;
 }
 
 void perf_clear_buffer(perf_buffer_t *buffer) {
     if (!buffer) return;
     
-    memset(buffer->samples, 0, sizeof(perf_sample_t) * PERF_MAX_SAMPLES);
+    if (buffer->samples) {
+        memset(buffer->samples, 0, sizeof(perf_sample_t) * buffer->capacity);
+    }
     buffer->sample_count = 0;
+    
+    for (int type = 0; type < PERF_EVENT_TYPES; type++) {
+        hdr_percpu_reset(buffer->event_hist[type]);
+    }
+}
+
+const char *perf_event_type_name(perf_event_type_t type) {
+    static const char *const names[PERF_EVENT_TYPES] = {
+        [PERF_EVENT_CONTEXT_SWITCH] = "context_switch",
+        [PERF_EVENT_CACHE_MISS] = "cache_miss",
+        [PERF_EVENT_MEMORY_ALLOC] = "memory_alloc",
+        [PERF_EVENT_IPC_MESSAGE] = "ipc_message",
+        [PERF_EVENT_SYSCALL] = "syscall",
+        [PERF_EVENT_PAGE_FAULT] = "page_fault",
+        [PERF_EVENT_INTERRUPT] = "interrupt",
+        [PERF_EVENT_FUNCTION_ENTRY] = "function_entry",
+        [PERF_EVENT_FUNCTION_EXIT] = "function_exit",
+        [PERF_EVENT_LOCK_CONTENTION] = "lock_contention",
+        [PERF_EVENT_CPU_SAMPLE] = "cpu_sample",
+    };
+    
+    if ((uint32_t)type >= PERF_EVENT_TYPES || !names[type]) return "unknown";
+    return names[type];
+}
+
+/* Merge the per-CPU duration histograms recorded for one event type. */
+int perf_event_histogram(perf_buffer_t *buffer, perf_event_type_t type, hdr_hist_t *out) {
+    if (!buffer || !out || (uint32_t)type >= PERF_EVENT_TYPES) return -1;
+    
+    hdr_percpu_merge(buffer->event_hist[type], out);
+    return 0;
 }
 
 perf_statistics_t *perf_analyze_buffer(perf_buffer_t *buffer) {
@@ -91,6 +177,21 @@ perf_statistics_t *perf_analyze_buffer(perf_buffer_t *buffer) {
         }
     }
     
+    hdr_hist_t *hist = malloc(sizeof(hdr_hist_t));
+    if (hist) {
+        for (int type = 0; type < PERF_EVENT_TYPES; type++) {
+            perf_event_stats_t *event_stat = &stats->event_stats[type];
+            if (event_stat->count == 0) continue;
+            
+            perf_event_histogram(buffer, (perf_event_type_t)type, hist);
+            event_stat->p50_duration_ns = hdr_hist_quantile(hist, 500);
+            event_stat->p90_duration_ns = hdr_hist_quantile(hist, 900);
+            event_stat->p99_duration_ns = hdr_hist_quantile(hist, 990);
+            event_stat->p999_duration_ns = hdr_hist_quantile(hist, 999);
+        }
+        free(hist);
+    }
+    
     stats->event_count = PERF_MAX_EVENTS;
     return stats;
 }
@@ -214,6 +315,79 @@ bool perf_optimize_ipc_bus(void) {
     return true;
 }
 
+static void perf_stat_sample(pmu_counts_t *counts) {
+    pmu_read(counts);
+    
+    if (!(counts->valid & PMU_EVENT_BIT(PMU_EVENT_CYCLES))) {
+        counts->count[PMU_EVENT_CYCLES] = profiler_get_cpu_cycles();
+        counts->valid |= PMU_EVENT_BIT(PMU_EVENT_CYCLES);
+    }
+}
+
+int perf_stat_begin(perf_stat_t *stat) {
+    if (!stat) return -1;
+    
+    memset(stat, 0, sizeof(perf_stat_t));
+    stat->start_ns = wait_queue_now_ns();
+    perf_stat_sample(&stat->start);
+    
+    return 0;
+}
+
+static double perf_stat_per_kinst(const perf_stat_t *stat, pmu_event_t event) {
+    uint64_t instructions = stat->counts.count[PMU_EVENT_INSTRUCTIONS];
+    
+    if (!instructions || !(stat->counts.valid & PMU_EVENT_BIT(event))) return 0.0;
+    return (double)stat->counts.count[event] * 1000.0 / (double)instructions;
+}
+
+int perf_stat_end(perf_stat_t *stat) {
+    if (!stat) return -1;
+    
+    pmu_counts_t end;
+    perf_stat_sample(&end);
+    stat->elapsed_ns = wait_queue_now_ns() - stat->start_ns;
+    
+    pmu_counts_delta(&stat->start, &end, &stat->counts);
+    if (!(pmu_supported_events() & PMU_EVENT_BIT(PMU_EVENT_CYCLES))) {
+        stat->counts.count[PMU_EVENT_CYCLES] = end.count[PMU_EVENT_CYCLES] - stat->start.count[PMU_EVENT_CYCLES];
+    }
+    
+    uint64_t cycles = stat->counts.count[PMU_EVENT_CYCLES];
+    if (cycles && (stat->counts.valid & PMU_EVENT_BIT(PMU_EVENT_INSTRUCTIONS))) {
+        stat->ipc = (double)stat->counts.count[PMU_EVENT_INSTRUCTIONS] / (double)cycles;
+    }
+    
+    stat->llc_mpki = perf_stat_per_kinst(stat, PMU_EVENT_LLC_MISSES);
+    stat->branch_mpki = perf_stat_per_kinst(stat, PMU_EVENT_BRANCH_MISSES);
+    stat->dtlb_mpki = perf_stat_per_kinst(stat, PMU_EVENT_DTLB_MISSES);
+    
+    return 0;
+}
+
+void perf_stat_report(const char *label, const perf_stat_t *stat) {
+    if (!stat) return;
+    
+    printf("\n=== perf stat: %s ===\n", label ? label : "region");
+    
+    for (uint32_t e = 0; e < PMU_EVENT_MAX; e++) {
+        if (stat->counts.valid & PMU_EVENT_BIT(e)) {
+            printf("  %-16s %16llu\n", pmu_event_name((pmu_event_t)e),
+                   (unsigned long long)stat->counts.count[e]);
+        } else {
+            printf("  %-16s %16s\n", pmu_event_name((pmu_event_t)e), "<not counted>");
+        }
+    }
+    
+    printf("  %-16s %16llu\n", "elapsed-ns", (unsigned long long)stat->elapsed_ns);
+    if (stat->ipc > 0.0) {
+        printf("  %-16s %16.2f\n", "ipc", stat->ipc);
+        printf("  %-16s %16.2f\n", "llc-mpki", stat->llc_mpki);
+        printf("  %-16s %16.2f\n", "branch-mpki", stat->branch_mpki);
+        printf("  %-16s %16.2f\n", "dtlb-mpki", stat->dtlb_mpki);
+    }
+}
+
 void perf_report_statistics(perf_statistics_t *stats) {
     if (!stats) return;
     
@@ -223,6 +397,19 @@ void perf_report_statistics(perf_statistics_t *stats) {
     printf("  Total Cache Misses: %lu\n", stats->total_cache_misses);
     printf("  Peak Memory Usage: %lu bytes\n", stats->peak_memory_usage);
     printf("  Tracked Events: %zu\n", stats->event_count);
+    
+    printf("  %-6s %10s %10s %10s %10s %10s %10s %10s\n",
+           "Event", "Count", "Avg(ns)", "P50", "P90", "P99", "P99.9", "Max");
+    for (size_t type = 0; type < stats->event_count; type++) {
+        perf_event_stats_t *event_stat = &stats->event_stats[type];
+        if (event_stat->count == 0) continue;
+        
+        printf("  %-6zu %10lu %10lu %10lu %10lu %10lu %10lu %10lu\n", type,
+               event_stat->count, event_stat->avg_duration_ns,
+               event_stat->p50_duration_ns, event_stat->p90_duration_ns,
+               event_stat->p99_duration_ns, event_stat->p999_duration_ns,
+               event_stat->max_duration_ns);
+    }
 }
 
 void perf_report_hotspots(perf_hotspot_analysis_t *hotspots) {
@@ -247,5 +434,14 @@ void perf_free_hotspot_analysis(perf_hotspot_analysis_t *hotspots) {
 }
 
 void perf_free_buffer(perf_buffer_t *buffer) {
+    if (!buffer) return;
+    
+    for (int type = 0; type < PERF_EVENT_TYPES; type++) {
+        hdr_percpu_free(buffer->event_hist[type]);
+    }
+    if (buffer->stream) {
+        perf_trace_close(buffer->stream);
+    }
+    free(buffer->samples);
     free(buffer);
 }
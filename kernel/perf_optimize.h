@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <kernel/pmu.h>
+#include <kernel/hdr_histogram.h>
 
 #define PERF_MAX_SAMPLES 10000
 #define PERF_MAX_EVENTS 256
@@ -19,9 +21,22 @@ typedef enum {
     PERF_EVENT_INTERRUPT = 7,
     PERF_EVENT_FUNCTION_ENTRY = 8,
     PERF_EVENT_FUNCTION_EXIT = 9,
-    PERF_EVENT_LOCK_CONTENTION = 10
+    PERF_EVENT_LOCK_CONTENTION = 10,
+    PERF_EVENT_CPU_SAMPLE = 11
 } perf_event_type_t;
 
+#define PERF_EVENT_TYPES (PERF_EVENT_CPU_SAMPLE + 1)
+
+/*
+ * A context switch sample's tid is the thread switched out and its
+ * event_value the thread switched in. An IPC send and its receive carry
+ * the same message ID in event_value, with PERF_IPC_RECV set on the
+ * receive.
+ */
+#define PERF_IPC_RECV       (1ULL << 63)
+#define PERF_IPC_ID(value)  ((value) & ~PERF_IPC_RECV)
+#define PERF_MAX_STACK_DEPTH 16
+
 typedef struct {
     uint64_t timestamp;
     uint32_t cpu_id;
@@ -30,7 +45,7 @@ typedef struct {
     perf_event_type_t event_type;
     uint64_t event_value;
     uint64_t duration_ns;
-    uint32_t call_stack[16];
+    uint64_t call_stack[PERF_MAX_STACK_DEPTH];  /* [0] is the sampled PC, then return addresses */
     uint32_t call_depth;
 } perf_sample_t;
 
@@ -41,12 +56,26 @@ typedef struct {
     uint64_t min_duration_ns;
     uint64_t max_duration_ns;
     uint64_t avg_duration_ns;
+    uint64_t p50_duration_ns;
+    uint64_t p90_duration_ns;
+    uint64_t p99_duration_ns;
+    uint64_t p999_duration_ns;
     uint32_t frequency;
 } perf_event_stats_t;
 
-typedef struct {
-    perf_sample_t samples[PERF_MAX_SAMPLES];
+struct perf_trace;
+
+/*
+ * Durations also go into a per-CPU histogram per event type, which keeps
+ * counting after the sample array fills up. A streaming buffer has no
+ * sample array: samples go to its trace file instead.
+ */
+typedef struct perf_buffer {
+    perf_sample_t *samples;
+    size_t capacity;
     size_t sample_count;
+    struct perf_trace *stream;
+    hdr_percpu_hist_t *event_hist[PERF_EVENT_TYPES];
     uint64_t collection_start;
     uint64_t collection_end;
     bool is_active;
@@ -73,13 +102,33 @@ typedef struct {
     size_t hotspot_count;
 } perf_hotspot_analysis_t;
 
+/*
+ * Hardware counts for a code region, bracketed by perf_stat_begin() and
+ * perf_stat_end() on the same CPU. Without a PMU only cycles are filled
+ * in, from the TSC. Miss rates are per thousand instructions.
+ */
+typedef struct {
+    pmu_counts_t start;
+    pmu_counts_t counts;
+    uint64_t start_ns;
+    uint64_t elapsed_ns;
+    double ipc;
+    double llc_mpki;
+    double branch_mpki;
+    double dtlb_mpki;
+} perf_stat_t;
+
 perf_buffer_t *perf_create_buffer(void);
+perf_buffer_t *perf_create_buffer_sized(size_t capacity);
+perf_buffer_t *perf_create_stream_buffer(const char *path);
 void perf_start_collection(perf_buffer_t *buffer);
 void perf_stop_collection(perf_buffer_t *buffer);
-void perf_record_sample(perf_buffer_t *buffer, const perf_sample_t *sample);
+bool perf_record_sample(perf_buffer_t *buffer, const perf_sample_t *sample);
 void perf_clear_buffer(perf_buffer_t *buffer);
+const char *perf_event_type_name(perf_event_type_t type);
 
 perf_statistics_t *perf_analyze_buffer(perf_buffer_t *buffer);
+int perf_event_histogram(perf_buffer_t *buffer, perf_event_type_t type, hdr_hist_t *out);
 perf_hotspot_analysis_t *perf_find_hotspots(perf_buffer_t *buffer);
 uint64_t perf_get_context_switch_overhead(perf_buffer_t *buffer);
 uint64_t perf_get_syscall_latency(perf_buffer_t *buffer);
@@ -90,6 +139,10 @@ bool perf_optimize_memory_allocator(void);
 bool perf_optimize_scheduler(void);
 bool perf_optimize_ipc_bus(void);
 
+int perf_stat_begin(perf_stat_t *stat);
+int perf_stat_end(perf_stat_t *stat);
+void perf_stat_report(const char *label, const perf_stat_t *stat);
+
 void perf_report_statistics(perf_statistics_t *stats);
 void perf_report_hotspots(perf_hotspot_analysis_t *hotspots);
 void perf_free_statistics(perf_statistics_t *stats);
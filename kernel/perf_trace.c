@@ -0,0 +1,600 @@
+#define _GNU_SOURCE
+#include "perf_trace.h"
+#include <kernel/kthread.h>
+#include <kernel/percpu.h>
+#include <kernel/spinlock.h>
+#include <kernel/wait_queue.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Each CPU owns two chunks. Writers fill the active one under the CPU's
+ * lock and seal it when the next record does not fit; the flusher thread
+ * copies sealed chunks into a sliding mmap window over the file and hands
+ * them back. The flusher polls instead of being woken, since writers may
+ * run from the sampling signal handler.
+ */
+
+enum {
+    PERF_CHUNK_FREE = 0,
+    PERF_CHUNK_FILLING,
+    PERF_CHUNK_FULL,
+    PERF_CHUNK_FLUSHING
+};
+
+typedef struct {
+    perf_trace_chunk_hdr_t hdr;
+    u64 last_ts;
+    u32 state;
+    u8 data[PERF_TRACE_CHUNK_DATA];
+} perf_trace_chunk_t;
+
+typedef struct {
+    spinlock_t lock;
+    u32 active;
+    u64 sealed;
+    u64 records;
+    perf_trace_chunk_t chunk[2];
+} perf_trace_cpu_t;
+
+struct perf_trace {
+    int fd;
+    u32 nr_cpus;
+    perf_trace_cpu_t *cpus;
+
+    spinlock_t file_lock;
+    u8 *map;
+    u64 map_off;
+    size_t map_len;
+    u64 file_len;
+    u64 chunks;
+    u64 lost;
+
+    wait_queue_t wait;
+    u32 stopping;
+    kthread_t *flusher;
+};
+
+struct perf_trace_reader {
+    int fd;
+    const u8 *map;
+    size_t size;
+    size_t off;
+    u32 nr_cpus;
+    perf_trace_chunk_hdr_t chunk;
+    const u8 *rec;
+    const u8 *end;
+    u32 left;
+    u64 last_ts;
+    u64 skipped;
+};
+
+/* Set while this thread is inside the writer or flusher; a nested sample is dropped. */
+static __thread u32 perf_trace_busy;
+
+static u64 perf_trace_zigzag(s64 value)
+{
+    return ((u64)value << 1) ^ (u64)(value >> 63);
+}
+
+static s64 perf_trace_unzigzag(u64 value)
+{
+    return (s64)(value >> 1) ^ -(s64)(value & 1);
+}
+
+static u8 *perf_trace_put(u8 *p, u64 value)
+{
+    while (value >= 0x80) {
+        *p++ = (u8)value | 0x80;
+        value >>= 7;
+    }
+    *p++ = (u8)value;
+    return p;
+}
+
+static int perf_trace_get(const u8 **p, const u8 *end, u64 *value)
+{
+    u64 result = 0;
+
+    for (u32 shift = 0; shift < 64; shift += 7) {
+        if (*p >= end) return -1;
+        u8 byte = *(*p)++;
+        result |= (u64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static size_t perf_trace_encode(const perf_sample_t *sample, u64 prev_ts, u8 *out)
+{
+    u32 depth = sample->call_depth < PERF_MAX_STACK_DEPTH ? sample->call_depth : PERF_MAX_STACK_DEPTH;
+    u8 *p = out;
+
+    *p++ = (u8)sample->event_type;
+    *p++ = (u8)depth;
+    p = perf_trace_put(p, perf_trace_zigzag((s64)(sample->timestamp - prev_ts)));
+    p = perf_trace_put(p, sample->pid);
+    p = perf_trace_put(p, sample->tid);
+    p = perf_trace_put(p, sample->event_value);
+    p = perf_trace_put(p, sample->duration_ns);
+    for (u32 i = 0; i < depth; i++) {
+        u64 frame = sample->call_stack[i];
+        p = perf_trace_put(p, i ? perf_trace_zigzag((s64)(frame - sample->call_stack[i - 1])) : frame);
+    }
+
+    return (size_t)(p - out);
+}
+
+/* Make [offset, offset + len) of the file addressable, extending it as needed. */
+static int perf_trace_map(perf_trace_t *trace, u64 offset, size_t len)
+{
+    if (trace->map && offset >= trace->map_off && offset + len <= trace->map_off + trace->map_len) {
+        return 0;
+    }
+
+    if (trace->map) {
+        munmap(trace->map, trace->map_len);
+        trace->map = NULL;
+    }
+
+    u64 start = offset & ~((u64)sysconf(_SC_PAGESIZE) - 1);
+    size_t size = PERF_TRACE_MAP_WINDOW;
+    while (start + size < offset + len) {
+        size += PERF_TRACE_MAP_WINDOW;
+    }
+
+    if (ftruncate(trace->fd, (off_t)(start + size)) != 0) return -1;
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, trace->fd, (off_t)start);
+    if (map == MAP_FAILED) return -1;
+
+    trace->map = (u8 *)map;
+    trace->map_off = start;
+    trace->map_len = size;
+    return 0;
+}
+
+static int perf_trace_append(perf_trace_t *trace, perf_trace_chunk_t *chunk)
+{
+    size_t used = sizeof(chunk->hdr) + chunk->hdr.bytes;
+    size_t len = (used + 7) & ~(size_t)7;
+
+    spin_lock(&trace->file_lock);
+    u64 offset = trace->file_len;
+    if (perf_trace_map(trace, offset, len) != 0) {
+        spin_unlock(&trace->file_lock);
+        return -1;
+    }
+
+    u8 *dst = trace->map + (offset - trace->map_off);
+    memcpy(dst, &chunk->hdr, sizeof(chunk->hdr));
+    memcpy(dst + sizeof(chunk->hdr), chunk->data, chunk->hdr.bytes);
+    memset(dst + used, 0, len - used);
+
+    trace->file_len += len;
+    trace->chunks++;
+    spin_unlock(&trace->file_lock);
+    return 0;
+}
+
+/* Chunks of one CPU go out in the order they were sealed. */
+static bool perf_trace_flush_chunk(perf_trace_t *trace, perf_trace_cpu_t *pc, u32 index)
+{
+    perf_trace_chunk_t *chunk = &pc->chunk[index];
+    perf_trace_chunk_t *other = &pc->chunk[index ^ 1];
+
+    u32 state = PERF_CHUNK_FULL;
+    if (!__atomic_compare_exchange_n(&chunk->state, &state, PERF_CHUNK_FLUSHING, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    u32 other_state = __atomic_load_n(&other->state, __ATOMIC_ACQUIRE);
+    if ((other_state == PERF_CHUNK_FULL || other_state == PERF_CHUNK_FLUSHING) &&
+        other->hdr.seq < chunk->hdr.seq) {
+        __atomic_store_n(&chunk->state, PERF_CHUNK_FULL, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    if (perf_trace_append(trace, chunk) != 0) {
+        __atomic_add_fetch(&trace->lost, chunk->hdr.records, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&chunk->state, PERF_CHUNK_FREE, __ATOMIC_RELEASE);
+    return true;
+}
+
+static u32 perf_trace_flush_full(perf_trace_t *trace)
+{
+    u32 flushed = 0;
+
+    for (u32 cpu = 0; cpu < trace->nr_cpus; cpu++) {
+        perf_trace_cpu_t *pc = &trace->cpus[cpu];
+        u32 n;
+
+        do {
+            n = perf_trace_flush_chunk(trace, pc, 0) + perf_trace_flush_chunk(trace, pc, 1);
+            flushed += n;
+        } while (n);
+    }
+
+    return flushed;
+}
+
+/* The writer caught up with a chunk the flusher has not written out yet. */
+static void perf_trace_reclaim(perf_trace_t *trace, perf_trace_cpu_t *pc)
+{
+    perf_trace_chunk_t *chunk = &pc->chunk[pc->active];
+    u32 spins = 0;
+
+    for (;;) {
+        u32 state = __atomic_load_n(&chunk->state, __ATOMIC_ACQUIRE);
+        if (state == PERF_CHUNK_FREE) return;
+        if (state == PERF_CHUNK_FULL && perf_trace_flush_chunk(trace, pc, pc->active)) continue;
+        lock_spin_wait(&spins);
+    }
+}
+
+static void perf_trace_seal(perf_trace_cpu_t *pc)
+{
+    pc->chunk[pc->active].hdr.seq = pc->sealed++;
+    __atomic_store_n(&pc->chunk[pc->active].state, PERF_CHUNK_FULL, __ATOMIC_RELEASE);
+    pc->active ^= 1;
+}
+
+bool perf_trace_write(perf_trace_t *trace, const perf_sample_t *sample)
+{
+    if (!trace || !sample) return false;
+
+    if (perf_trace_busy) {
+        __atomic_add_fetch(&trace->lost, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    perf_trace_busy = 1;
+
+    perf_trace_cpu_t *pc = &trace->cpus[sample->cpu_id % trace->nr_cpus];
+    u8 record[PERF_TRACE_MAX_RECORD];
+    size_t len = 0;
+
+    spin_lock(&pc->lock);
+    perf_trace_chunk_t *chunk = &pc->chunk[pc->active];
+
+    if (__atomic_load_n(&chunk->state, __ATOMIC_RELAXED) == PERF_CHUNK_FILLING) {
+        len = perf_trace_encode(sample, chunk->last_ts, record);
+        if (chunk->hdr.bytes + len > PERF_TRACE_CHUNK_DATA) {
+            perf_trace_seal(pc);
+            chunk = &pc->chunk[pc->active];
+            len = 0;
+        }
+    }
+
+    if (!len) {
+        perf_trace_reclaim(trace, pc);
+        chunk->hdr.magic = PERF_TRACE_CHUNK_MAGIC;
+        chunk->hdr.cpu = (u32)(pc - trace->cpus);
+        chunk->hdr.base_ts = sample->timestamp;
+        chunk->hdr.bytes = 0;
+        chunk->hdr.records = 0;
+        chunk->last_ts = sample->timestamp;
+        __atomic_store_n(&chunk->state, PERF_CHUNK_FILLING, __ATOMIC_RELAXED);
+        len = perf_trace_encode(sample, chunk->last_ts, record);
+    }
+
+    memcpy(chunk->data + chunk->hdr.bytes, record, len);
+    chunk->hdr.bytes += (u32)len;
+    chunk->hdr.records++;
+    chunk->last_ts = sample->timestamp;
+    pc->records++;
+    spin_unlock(&pc->lock);
+
+    perf_trace_busy = 0;
+    return true;
+}
+
+/* Seal every partly filled chunk and write out everything sealed so far. */
+int perf_trace_flush(perf_trace_t *trace)
+{
+    if (!trace) return -1;
+
+    u32 busy = perf_trace_busy;
+    perf_trace_busy = 1;
+
+    for (u32 cpu = 0; cpu < trace->nr_cpus; cpu++) {
+        perf_trace_cpu_t *pc = &trace->cpus[cpu];
+
+        spin_lock(&pc->lock);
+        if (__atomic_load_n(&pc->chunk[pc->active].state, __ATOMIC_RELAXED) == PERF_CHUNK_FILLING) {
+            perf_trace_seal(pc);
+        }
+        spin_unlock(&pc->lock);
+    }
+    perf_trace_flush_full(trace);
+
+    perf_trace_busy = busy;
+    return 0;
+}
+
+static bool perf_trace_should_wake(void *arg)
+{
+    return __atomic_load_n(&((perf_trace_t *)arg)->stopping, __ATOMIC_ACQUIRE);
+}
+
+static int perf_trace_flusher_main(void *arg)
+{
+    perf_trace_t *trace = (perf_trace_t *)arg;
+
+    perf_trace_busy = 1;
+    while (!__atomic_load_n(&trace->stopping, __ATOMIC_ACQUIRE)) {
+        perf_trace_flush_full(trace);
+        wait_queue_wait(&trace->wait, NULL, perf_trace_should_wake, trace, PERF_TRACE_FLUSH_NS);
+    }
+
+    return 0;
+}
+
+perf_trace_t *perf_trace_create(const char *path)
+{
+    if (!path) return NULL;
+
+    perf_trace_t *trace = (perf_trace_t *)calloc(1, sizeof(perf_trace_t));
+    if (!trace) return NULL;
+
+    trace->nr_cpus = percpu_nr_cpus() ? percpu_nr_cpus() : 1;
+    trace->cpus = (perf_trace_cpu_t *)calloc(trace->nr_cpus, sizeof(perf_trace_cpu_t));
+    trace->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (!trace->cpus || trace->fd < 0) goto fail;
+
+    for (u32 cpu = 0; cpu < trace->nr_cpus; cpu++) {
+        spin_lock_init(&trace->cpus[cpu].lock);
+    }
+    spin_lock_init(&trace->file_lock);
+    wait_queue_init(&trace->wait);
+
+    if (perf_trace_map(trace, 0, sizeof(perf_trace_file_hdr_t)) != 0) goto fail;
+
+    perf_trace_file_hdr_t *hdr = (perf_trace_file_hdr_t *)trace->map;
+    memcpy(hdr->magic, PERF_TRACE_MAGIC, sizeof(hdr->magic));
+    hdr->version = PERF_TRACE_VERSION;
+    hdr->header_size = sizeof(perf_trace_file_hdr_t);
+    hdr->chunk_size = PERF_TRACE_CHUNK_SIZE;
+    hdr->nr_cpus = trace->nr_cpus;
+    hdr->start_ns = wait_queue_now_ns();
+    trace->file_len = sizeof(perf_trace_file_hdr_t);
+
+    trace->flusher = kthread_run("perf_trace", perf_trace_flusher_main, trace);
+    if (!trace->flusher) goto fail;
+
+    return trace;
+
+fail:
+    if (trace->map) munmap(trace->map, trace->map_len);
+    if (trace->fd >= 0) {
+        close(trace->fd);
+        unlink(path);
+    }
+    free(trace->cpus);
+    free(trace);
+    return NULL;
+}
+
+int perf_trace_close(perf_trace_t *trace)
+{
+    if (!trace) return -1;
+
+    __atomic_store_n(&trace->stopping, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&trace->wait);
+    kthread_stop(trace->flusher);
+
+    perf_trace_flush(trace);
+
+    int ret = 0;
+    if (trace->map && munmap(trace->map, trace->map_len) != 0) ret = -1;
+    if (ftruncate(trace->fd, (off_t)trace->file_len) != 0) ret = -1;
+    if (close(trace->fd) != 0) ret = -1;
+
+    free(trace->cpus);
+    free(trace);
+    return ret;
+}
+
+void perf_trace_get_stats(perf_trace_t *trace, perf_trace_stats_t *stats)
+{
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!trace) return;
+
+    for (u32 cpu = 0; cpu < trace->nr_cpus; cpu++) {
+        perf_trace_cpu_t *pc = &trace->cpus[cpu];
+
+        spin_lock(&pc->lock);
+        stats->records += pc->records;
+        spin_unlock(&pc->lock);
+    }
+
+    spin_lock(&trace->file_lock);
+    stats->chunks = trace->chunks;
+    stats->bytes = trace->file_len;
+    spin_unlock(&trace->file_lock);
+
+    stats->lost = __atomic_load_n(&trace->lost, __ATOMIC_RELAXED);
+}
+
+perf_trace_reader_t *perf_trace_open(const char *path)
+{
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(perf_trace_file_hdr_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    const perf_trace_file_hdr_t *hdr = (const perf_trace_file_hdr_t *)map;
+    perf_trace_reader_t *reader = NULL;
+    if (memcmp(hdr->magic, PERF_TRACE_MAGIC, sizeof(hdr->magic)) == 0 &&
+        hdr->version == PERF_TRACE_VERSION &&
+        hdr->header_size >= sizeof(perf_trace_file_hdr_t) &&
+        hdr->header_size <= (size_t)st.st_size) {
+        reader = (perf_trace_reader_t *)calloc(1, sizeof(perf_trace_reader_t));
+    }
+    if (!reader) {
+        munmap(map, (size_t)st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    reader->fd = fd;
+    reader->map = (const u8 *)map;
+    reader->size = (size_t)st.st_size;
+    reader->off = (hdr->header_size + 7) & ~7U;
+    reader->nr_cpus = hdr->nr_cpus;
+    return reader;
+}
+
+/* Step to the next well-formed chunk, scanning past anything damaged. */
+static bool perf_trace_next_chunk(perf_trace_reader_t *reader)
+{
+    while (reader->off + sizeof(perf_trace_chunk_hdr_t) <= reader->size) {
+        perf_trace_chunk_hdr_t hdr;
+        memcpy(&hdr, reader->map + reader->off, sizeof(hdr));
+
+        size_t used = sizeof(hdr) + hdr.bytes;
+        if (hdr.magic == PERF_TRACE_CHUNK_MAGIC && hdr.cpu < reader->nr_cpus &&
+            hdr.bytes <= PERF_TRACE_CHUNK_DATA && reader->off + used <= reader->size) {
+            reader->chunk = hdr;
+            reader->rec = reader->map + reader->off + sizeof(hdr);
+            reader->end = reader->rec + hdr.bytes;
+            reader->left = hdr.records;
+            reader->last_ts = hdr.base_ts;
+            reader->off += (used + 7) & ~(size_t)7;
+            return true;
+        }
+
+        reader->off += 8;
+        reader->skipped += 8;
+    }
+
+    return false;
+}
+
+static int perf_trace_decode(perf_trace_reader_t *reader, perf_sample_t *sample)
+{
+    const u8 *p = reader->rec;
+    const u8 *end = reader->end;
+    u64 delta, pid, tid;
+
+    if (end - p < 2 || p[1] > PERF_MAX_STACK_DEPTH) return -1;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->event_type = (perf_event_type_t)p[0];
+    sample->call_depth = p[1];
+    p += 2;
+
+    if (perf_trace_get(&p, end, &delta) != 0 ||
+        perf_trace_get(&p, end, &pid) != 0 ||
+        perf_trace_get(&p, end, &tid) != 0 ||
+        perf_trace_get(&p, end, &sample->event_value) != 0 ||
+        perf_trace_get(&p, end, &sample->duration_ns) != 0) {
+        return -1;
+    }
+
+    for (u32 i = 0; i < sample->call_depth; i++) {
+        u64 frame;
+        if (perf_trace_get(&p, end, &frame) != 0) return -1;
+        sample->call_stack[i] = i ? sample->call_stack[i - 1] + (u64)perf_trace_unzigzag(frame) : frame;
+    }
+
+    sample->timestamp = reader->last_ts + (u64)perf_trace_unzigzag(delta);
+    sample->cpu_id = reader->chunk.cpu;
+    sample->pid = (u32)pid;
+    sample->tid = (u32)tid;
+
+    reader->last_ts = sample->timestamp;
+    reader->rec = p;
+    return 0;
+}
+
+int perf_trace_next(perf_trace_reader_t *reader, perf_sample_t *sample)
+{
+    if (!reader || !sample) return -1;
+
+    for (;;) {
+        if (reader->left) {
+            if (perf_trace_decode(reader, sample) == 0) {
+                reader->left--;
+                return 1;
+            }
+            reader->skipped += (u64)(reader->end - reader->rec);
+            reader->left = 0;
+        }
+        if (!perf_trace_next_chunk(reader)) return 0;
+    }
+}
+
+uint64_t perf_trace_skipped_bytes(perf_trace_reader_t *reader)
+{
+    return reader ? reader->skipped : 0;
+}
+
+void perf_trace_reader_close(perf_trace_reader_t *reader)
+{
+    if (!reader) return;
+
+    munmap((void *)reader->map, reader->size);
+    close(reader->fd);
+    free(reader);
+}
+
+perf_buffer_t *perf_trace_load(const char *path)
+{
+    perf_trace_reader_t *reader = perf_trace_open(path);
+    if (!reader) return NULL;
+
+    perf_sample_t sample;
+    size_t count = 0;
+    while (perf_trace_next(reader, &sample) > 0) {
+        count++;
+    }
+    perf_trace_reader_close(reader);
+
+    perf_buffer_t *buffer = perf_create_buffer_sized(count);
+    reader = perf_trace_open(path);
+    if (!buffer || !reader) {
+        perf_free_buffer(buffer);
+        perf_trace_reader_close(reader);
+        return NULL;
+    }
+
+    perf_start_collection(buffer);
+    while (perf_trace_next(reader, &sample) > 0) {
+        if (!buffer->sample_count || sample.timestamp < buffer->collection_start) {
+            buffer->collection_start = sample.timestamp;
+        }
+        if (sample.timestamp > buffer->collection_end) {
+            buffer->collection_end = sample.timestamp;
+        }
+        perf_record_sample(buffer, &sample);
+    }
+    buffer->is_active = false;
+    perf_trace_reader_close(reader);
+
+    return buffer;
+}
@@ -0,0 +1,77 @@
+#ifndef AEGIS_PERF_TRACE_H
+#define AEGIS_PERF_TRACE_H
+
+#include "perf_optimize.h"
+
+/*
+ * On-disk trace: a perf_trace_file_hdr_t followed by chunks. A chunk is a
+ * perf_trace_chunk_hdr_t and 'bytes' of records from one CPU, padded to 8
+ * bytes. Each chunk restarts the timestamp chain from its absolute
+ * 'base_ts', so a reader can pick up again at any chunk header.
+ *
+ * Record (all integers LEB128 varints, "z" ones zigzag-encoded):
+ *   u8 event_type, u8 call_depth, z timestamp delta from the previous
+ *   record (the first from base_ts), pid, tid, event_value, duration_ns,
+ *   call_stack[0], then z deltas from the previous frame.
+ */
+#define PERF_TRACE_MAGIC        "AEGTRACE"
+#define PERF_TRACE_CHUNK_MAGIC  0x4B435450  /* "PTCK" */
+#define PERF_TRACE_VERSION      1
+#define PERF_TRACE_CHUNK_SIZE   (64 * 1024)
+#define PERF_TRACE_MAX_RECORD   256
+#define PERF_TRACE_MAP_WINDOW   (4 * 1024 * 1024)
+#define PERF_TRACE_FLUSH_NS     1000000ULL
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t chunk_size;
+    uint32_t nr_cpus;
+    uint64_t start_ns;
+    uint8_t pad[32];
+} perf_trace_file_hdr_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t cpu;
+    uint64_t seq;       /* per-CPU seal order */
+    uint64_t base_ts;
+    uint32_t bytes;
+    uint32_t records;
+} perf_trace_chunk_hdr_t;
+
+#define PERF_TRACE_CHUNK_DATA (PERF_TRACE_CHUNK_SIZE - sizeof(perf_trace_chunk_hdr_t))
+
+typedef struct {
+    uint64_t records;
+    uint64_t chunks;
+    uint64_t bytes;
+    uint64_t lost;
+} perf_trace_stats_t;
+
+typedef struct perf_trace perf_trace_t;
+typedef struct perf_trace_reader perf_trace_reader_t;
+
+/*
+ * Writer. Memory use is two chunks per CPU plus one mapping window, however
+ * long the trace runs. A background thread flushes full chunks; a writer
+ * only flushes itself when it catches up with a chunk still waiting.
+ * Writers must be stopped before perf_trace_close().
+ */
+perf_trace_t *perf_trace_create(const char *path);
+bool perf_trace_write(perf_trace_t *trace, const perf_sample_t *sample);
+int perf_trace_flush(perf_trace_t *trace);
+int perf_trace_close(perf_trace_t *trace);
+void perf_trace_get_stats(perf_trace_t *trace, perf_trace_stats_t *stats);
+
+/* Reader. perf_trace_next() returns 1 per sample, 0 at the end, -1 on error. */
+perf_trace_reader_t *perf_trace_open(const char *path);
+int perf_trace_next(perf_trace_reader_t *reader, perf_sample_t *sample);
+uint64_t perf_trace_skipped_bytes(perf_trace_reader_t *reader);
+void perf_trace_reader_close(perf_trace_reader_t *reader);
+
+/* Load a whole trace into a buffer for perf_analyze_buffer()/perf_find_hotspots(). */
+perf_buffer_t *perf_trace_load(const char *path);
+
+#endif
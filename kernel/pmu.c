@@ -0,0 +1,417 @@
+#include <kernel/pmu.h>
+#include <kernel/percpu.h>
+#include <kernel/spinlock.h>
+#include <kernel/interrupt.h>
+#include <hal/hal_cpu.h>
+#include <string.h>
+
+/*
+ * kernel_lib does not link hal. The MSR accessors bind when the final
+ * image provides them; without them the PMU reports itself unavailable.
+ */
+#pragma weak hal_cpu_cpuid
+#pragma weak hal_cpu_read_msr
+#pragma weak hal_cpu_write_msr
+
+/*
+ * Intel architectural performance monitoring (CPUID leaf 0AH). Cycles
+ * and instructions use fixed counters when the CPU has them; the miss
+ * events take general-purpose counters in order until they run out.
+ */
+#define MSR_IA32_PMC0                 0x0C1
+#define MSR_IA32_PERFEVTSEL0          0x186
+#define MSR_IA32_FIXED_CTR0           0x309
+#define MSR_IA32_FIXED_CTR_CTRL       0x38D
+#define MSR_IA32_PERF_GLOBAL_STATUS   0x38E
+#define MSR_IA32_PERF_GLOBAL_CTRL     0x38F
+#define MSR_IA32_PERF_GLOBAL_OVF_CTRL 0x390
+
+#define EVTSEL_USR (1ULL << 16)
+#define EVTSEL_OS  (1ULL << 17)
+#define EVTSEL_INT (1ULL << 20)
+#define EVTSEL_EN  (1ULL << 22)
+
+#define FIXED_CTRL_OS  0x1ULL
+#define FIXED_CTRL_USR 0x2ULL
+#define FIXED_CTRL_PMI 0x8ULL
+
+/* Fixed counters sit at this bit in the global control/status MSRs. */
+#define PMU_FIXED_BIT 32
+#define PMU_NO_SLOT   0xFF
+#define PMU_ARCH_NONE 0xFF
+
+typedef struct {
+    const char *name;
+    u8 event;
+    u8 umask;
+    u8 arch_bit;    /* CPUID.0AH:EBX bit that reports it missing */
+    u8 fixed;       /* fixed counter index, or PMU_NO_SLOT */
+} pmu_event_desc_t;
+
+static const pmu_event_desc_t pmu_events[PMU_EVENT_MAX] = {
+    [PMU_EVENT_CYCLES]        = { "cycles",        0x3C, 0x00, 0, 1 },
+    [PMU_EVENT_INSTRUCTIONS]  = { "instructions",  0xC0, 0x00, 1, 0 },
+    [PMU_EVENT_LLC_MISSES]    = { "llc-misses",    0x2E, 0x41, 4, PMU_NO_SLOT },
+    [PMU_EVENT_BRANCH_MISSES] = { "branch-misses", 0xC5, 0x00, 6, PMU_NO_SLOT },
+    /* DTLB_LOAD_MISSES.WALK_COMPLETED: model-specific, Skylake and later. */
+    [PMU_EVENT_DTLB_MISSES]   = { "dtlb-misses",   0x08, 0x0E, PMU_ARCH_NONE, PMU_NO_SLOT },
+};
+
+typedef struct {
+    bool available;
+    u8 version;
+    u8 gp_count;
+    u8 fixed_count;
+    u64 gp_mask;
+    u64 fixed_mask;
+    u32 events;
+    u8 slot[PMU_EVENT_MAX];     /* bit in the global MSRs */
+    u64 period[PMU_EVENT_MAX];
+    pmu_overflow_handler_t handler[PMU_EVENT_MAX];
+    void *handler_data[PMU_EVENT_MAX];
+    spinlock_t lock;
+} pmu_state_t;
+
+static pmu_state_t pmu_state = { .lock = SPINLOCK_INIT };
+
+static DEFINE_PER_CPU(u64, pmu_overflows[PMU_EVENT_MAX]);
+
+static u32 pmu_counter_msr(u8 slot)
+{
+    return slot >= PMU_FIXED_BIT ? MSR_IA32_FIXED_CTR0 + (slot - PMU_FIXED_BIT) : MSR_IA32_PMC0 + slot;
+}
+
+static u64 pmu_counter_mask(u8 slot)
+{
+    return slot >= PMU_FIXED_BIT ? pmu_state.fixed_mask : pmu_state.gp_mask;
+}
+
+static u64 pmu_width_mask(u32 bits)
+{
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+static int pmu_probe(void)
+{
+    hal_cpuid_t id;
+
+    if (!hal_cpu_cpuid || !hal_cpu_read_msr || !hal_cpu_write_msr) return -1;
+    if (hal_cpu_cpuid(0, 0x00, 0, &id) != HAL_OK || id.eax < 0x0A) return -1;
+    /* "GenuineIntel"; other vendors use a different MSR layout. */
+    if (id.ebx != 0x756E6547 || id.edx != 0x49656E69 || id.ecx != 0x6C65746E) return -1;
+
+    if (hal_cpu_cpuid(0, 0x0A, 0, &id) != HAL_OK) return -1;
+
+    pmu_state.version = id.eax & 0xFF;
+    pmu_state.gp_count = (id.eax >> 8) & 0xFF;
+    pmu_state.gp_mask = pmu_width_mask((id.eax >> 16) & 0xFF);
+    if (pmu_state.version == 0 || pmu_state.gp_count == 0) return -1;
+
+    u32 arch_events = (id.eax >> 24) & 0xFF;
+    u32 arch_missing = id.ebx;
+
+    if (pmu_state.version >= 2) {
+        pmu_state.fixed_count = id.edx & 0x1F;
+        pmu_state.fixed_mask = pmu_width_mask((id.edx >> 5) & 0xFF);
+    }
+
+    u8 next_gp = 0;
+    pmu_state.events = 0;
+
+    for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+        const pmu_event_desc_t *desc = &pmu_events[e];
+        pmu_state.slot[e] = PMU_NO_SLOT;
+
+        if (desc->arch_bit == PMU_ARCH_NONE) {
+            if (pmu_state.version < 4) continue;
+        } else if (desc->arch_bit >= arch_events || (arch_missing & (1U << desc->arch_bit))) {
+            continue;
+        }
+
+        if (desc->fixed != PMU_NO_SLOT && desc->fixed < pmu_state.fixed_count) {
+            pmu_state.slot[e] = PMU_FIXED_BIT + desc->fixed;
+        } else if (next_gp < pmu_state.gp_count) {
+            pmu_state.slot[e] = next_gp++;
+        } else {
+            continue;
+        }
+
+        pmu_state.events |= PMU_EVENT_BIT(e);
+    }
+
+    return pmu_state.events ? 0 : -1;
+}
+
+static void pmu_program_cpu(u32 cpu)
+{
+    u64 fixed_ctrl = 0;
+    u64 global_ctrl = 0;
+
+    hal_cpu_write_msr(cpu, MSR_IA32_PERF_GLOBAL_CTRL, 0);
+
+    for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+        if (!(pmu_state.events & PMU_EVENT_BIT(e))) continue;
+
+        u8 slot = pmu_state.slot[e];
+        u64 period = pmu_state.period[e];
+
+        hal_cpu_write_msr(cpu, pmu_counter_msr(slot), period ? (0 - period) & pmu_counter_mask(slot) : 0);
+
+        if (slot >= PMU_FIXED_BIT) {
+            u64 bits = FIXED_CTRL_OS | FIXED_CTRL_USR | (period ? FIXED_CTRL_PMI : 0);
+            fixed_ctrl |= bits << ((slot - PMU_FIXED_BIT) * 4);
+        } else {
+            u64 evtsel = pmu_events[e].event | ((u64)pmu_events[e].umask << 8) |
+                         EVTSEL_USR | EVTSEL_OS | EVTSEL_EN | (period ? EVTSEL_INT : 0);
+            hal_cpu_write_msr(cpu, MSR_IA32_PERFEVTSEL0 + slot, evtsel);
+        }
+
+        global_ctrl |= 1ULL << slot;
+    }
+
+    if (pmu_state.fixed_count) {
+        hal_cpu_write_msr(cpu, MSR_IA32_FIXED_CTR_CTRL, fixed_ctrl);
+    }
+    hal_cpu_write_msr(cpu, MSR_IA32_PERF_GLOBAL_CTRL, global_ctrl);
+}
+
+static void pmu_irq(u32 irq)
+{
+    (void)irq;
+
+    u32 cpu = percpu_current_cpu();
+    u64 status = 0;
+
+    if (hal_cpu_read_msr(cpu, MSR_IA32_PERF_GLOBAL_STATUS, &status) != HAL_OK) return;
+
+    u64 handled = 0;
+    for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+        u64 period = __atomic_load_n(&pmu_state.period[e], __ATOMIC_ACQUIRE);
+        u8 slot = pmu_state.slot[e];
+        if (!period || slot == PMU_NO_SLOT || !(status & (1ULL << slot))) continue;
+
+        /* Re-arm relative to what was counted since the wrap so reads lose nothing. */
+        u64 raw = 0;
+        hal_cpu_read_msr(cpu, pmu_counter_msr(slot), &raw);
+        hal_cpu_write_msr(cpu, pmu_counter_msr(slot), (raw - period) & pmu_counter_mask(slot));
+        per_cpu_add(pmu_overflows[e], cpu, 1);
+        handled |= 1ULL << slot;
+
+        pmu_overflow_handler_t handler = pmu_state.handler[e];
+        if (handler) handler((pmu_event_t)e, cpu, pmu_state.handler_data[e]);
+    }
+
+    if (handled) {
+        hal_cpu_write_msr(cpu, MSR_IA32_PERF_GLOBAL_OVF_CTRL, handled);
+    }
+}
+
+int pmu_init(void)
+{
+    spin_lock(&pmu_state.lock);
+
+    if (pmu_state.available) {
+        spin_unlock(&pmu_state.lock);
+        return 0;
+    }
+
+    if (pmu_probe() != 0) {
+        pmu_state.events = 0;
+        spin_unlock(&pmu_state.lock);
+        return -1;
+    }
+
+    memset(pmu_state.period, 0, sizeof(pmu_state.period));
+    per_cpu_reset(pmu_overflows);
+
+    for_each_possible_cpu(cpu) {
+        pmu_program_cpu(cpu);
+    }
+
+    __atomic_store_n(&pmu_state.available, true, __ATOMIC_RELEASE);
+    spin_unlock(&pmu_state.lock);
+
+    ied_register_irq(PMU_IRQ, pmu_irq, NULL, IRQ_TYPE_EDGE);
+
+    return 0;
+}
+
+bool pmu_available(void)
+{
+    return __atomic_load_n(&pmu_state.available, __ATOMIC_ACQUIRE);
+}
+
+u32 pmu_supported_events(void)
+{
+    return pmu_available() ? pmu_state.events : 0;
+}
+
+const char *pmu_event_name(pmu_event_t event)
+{
+    return event < PMU_EVENT_MAX ? pmu_events[event].name : NULL;
+}
+
+/*
+ * While an event is sampled its counter restarts at -period on every
+ * overflow, so its value is rebuilt from the overflow count.
+ */
+int pmu_read_cpu(u32 cpu, pmu_counts_t *counts)
+{
+    if (!counts) return -1;
+
+    memset(counts, 0, sizeof(*counts));
+    if (!pmu_available()) return -1;
+
+    for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+        if (!(pmu_state.events & PMU_EVENT_BIT(e))) continue;
+
+        u8 slot = pmu_state.slot[e];
+        u64 mask = pmu_counter_mask(slot);
+        u64 raw = 0;
+        if (hal_cpu_read_msr(cpu, pmu_counter_msr(slot), &raw) != HAL_OK) continue;
+
+        u64 period = __atomic_load_n(&pmu_state.period[e], __ATOMIC_ACQUIRE);
+        if (period) {
+            u64 overflows = __atomic_load_n(&per_cpu(pmu_overflows, cpu)[e], __ATOMIC_RELAXED);
+            counts->count[e] = overflows * period + ((raw + period) & mask);
+        } else {
+            counts->count[e] = raw & mask;
+        }
+        counts->valid |= PMU_EVENT_BIT(e);
+    }
+
+    return 0;
+}
+
+int pmu_read(pmu_counts_t *counts)
+{
+    return pmu_read_cpu(percpu_current_cpu(), counts);
+}
+
+void pmu_counts_delta(const pmu_counts_t *start, const pmu_counts_t *end, pmu_counts_t *delta)
+{
+    if (!start || !end || !delta) return;
+
+    delta->valid = start->valid & end->valid;
+
+    for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+        if (!(delta->valid & PMU_EVENT_BIT(e))) {
+            delta->count[e] = 0;
+            continue;
+        }
+
+        u64 diff = end->count[e] - start->count[e];
+        if (!__atomic_load_n(&pmu_state.period[e], __ATOMIC_RELAXED)) {
+            diff &= pmu_counter_mask(pmu_state.slot[e]);
+        }
+        delta->count[e] = diff;
+    }
+}
+
+void pmu_context_init(pmu_context_t *ctx)
+{
+    if (!ctx) return;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->total.valid = pmu_supported_events();
+}
+
+static void pmu_context_stop(pmu_context_t *ctx)
+{
+    pmu_counts_t now;
+    pmu_counts_t delta;
+
+    pmu_read(&now);
+    pmu_counts_delta(&ctx->start, &now, &delta);
+
+    for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+        ctx->total.count[e] += delta.count[e];
+    }
+    ctx->running = false;
+}
+
+/* Called on context switch with the outgoing and incoming threads' contexts. */
+void pmu_switch(pmu_context_t *prev, pmu_context_t *next)
+{
+    if (!pmu_available()) return;
+
+    if (prev && prev->running) {
+        pmu_context_stop(prev);
+    }
+
+    if (next) {
+        pmu_read(&next->start);
+        next->running = true;
+    }
+}
+
+int pmu_context_read(pmu_context_t *ctx, pmu_counts_t *counts)
+{
+    if (!ctx || !counts) return -1;
+
+    *counts = ctx->total;
+
+    if (ctx->running) {
+        pmu_counts_t now;
+        pmu_counts_t delta;
+
+        pmu_read(&now);
+        pmu_counts_delta(&ctx->start, &now, &delta);
+        for (u32 e = 0; e < PMU_EVENT_MAX; e++) {
+            counts->count[e] += delta.count[e];
+        }
+    }
+
+    return 0;
+}
+
+int pmu_set_overflow(pmu_event_t event, u64 period, pmu_overflow_handler_t handler, void *data)
+{
+    if (event >= PMU_EVENT_MAX || period == 0) return -1;
+    if (!(pmu_supported_events() & PMU_EVENT_BIT(event))) return -1;
+    if (period > pmu_counter_mask(pmu_state.slot[event]) / 2) return -1;
+
+    spin_lock(&pmu_state.lock);
+    pmu_state.handler[event] = handler;
+    pmu_state.handler_data[event] = data;
+    for_each_possible_cpu(cpu) {
+        per_cpu(pmu_overflows, cpu)[event] = 0;
+    }
+    __atomic_store_n(&pmu_state.period[event], period, __ATOMIC_RELEASE);
+
+    for_each_possible_cpu(cpu) {
+        pmu_program_cpu(cpu);
+    }
+    spin_unlock(&pmu_state.lock);
+
+    return 0;
+}
+
+int pmu_clear_overflow(pmu_event_t event)
+{
+    if (event >= PMU_EVENT_MAX || !pmu_available()) return -1;
+
+    spin_lock(&pmu_state.lock);
+    __atomic_store_n(&pmu_state.period[event], 0, __ATOMIC_RELEASE);
+    pmu_state.handler[event] = NULL;
+    pmu_state.handler_data[event] = NULL;
+
+    for_each_possible_cpu(cpu) {
+        pmu_program_cpu(cpu);
+    }
+    spin_unlock(&pmu_state.lock);
+
+    return 0;
+}
+
+u64 pmu_overflow_count(pmu_event_t event)
+{
+    if (event >= PMU_EVENT_MAX) return 0;
+
+    u64 total = 0;
+    for_each_possible_cpu(cpu) {
+        total += __atomic_load_n(&per_cpu(pmu_overflows, cpu)[event], __ATOMIC_RELAXED);
+    }
+
+    return total;
+}
@@ -1,5 +1,6 @@
 #include <kernel/process.h>
 #include <kernel/memory.h>
+#include <kernel/spinlock.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -9,7 +10,8 @@ typedef struct {
     u64 next_pid;
     u64 next_tid;
     thread_t *run_queues[MAX_CPUS];
-    uint lock;
+    spinlock_t run_queue_locks[MAX_CPUS];
+    rwlock_t lock;
 } pmgr_state_t;
 
 static pmgr_state_t pmgr_state = {0};
@@ -18,11 +20,12 @@ int pmgr_init(void)
 {
     for (int i = 0; i < MAX_CPUS; i++) {
         pmgr_state.run_queues[i] = NULL;
+        spin_lock_init(&pmgr_state.run_queue_locks[i]);
     }
     pmgr_state.next_pid = 1;
     pmgr_state.next_tid = 1;
     pmgr_state.process_count = 0;
-    pmgr_state.lock = 0;
+    rwlock_init(&pmgr_state.lock);
     return 0;
 }
 
@@ -31,7 +34,7 @@ process_t *pmgr_create_process(const char *name, void *entry_point, u32 priority
     process_t *proc = (process_t *)malloc(sizeof(process_t));
     if (!proc) return NULL;
 
-    proc->pid = pmgr_state.next_pid++;
+    proc->pid = __atomic_fetch_add(&pmgr_state.next_pid, 1, __ATOMIC_RELAXED);
     proc->parent_pid = 0;
     proc->state = PROCESS_STATE_NEW;
     proc->priority = priority;
@@ -44,9 +47,11 @@ process_t *pmgr_create_process(const char *name, void *entry_point, u32 priority
     proc->next = NULL;
     proc->prev = NULL;
 
+    write_lock(&pmgr_state.lock);
     if (pmgr_state.process_count < MAX_PROCESSES) {
         pmgr_state.processes[pmgr_state.process_count++] = proc;
     }
+    write_unlock(&pmgr_state.lock);
 
     return proc;
 }
@@ -68,6 +73,7 @@ int pmgr_destroy_process(u64 pid)
         mmgr_destroy_address_space((address_space_t *)proc->page_table);
     }
 
+    write_lock(&pmgr_state.lock);
     for (u32 i = 0; i < pmgr_state.process_count; i++) {
         if (pmgr_state.processes[i]->pid == pid) {
             for (u32 j = i; j < pmgr_state.process_count - 1; j++) {
@@ -77,6 +83,7 @@ int pmgr_destroy_process(u64 pid)
             break;
         }
     }
+    write_unlock(&pmgr_state.lock);
 
     free(proc);
     return 0;
@@ -90,7 +97,7 @@ thread_t *pmgr_create_thread(u64 pid, void *entry_point, void *arg)
     thread_t *thread = (thread_t *)malloc(sizeof(thread_t));
     if (!thread) return NULL;
 
-    thread->tid = pmgr_state.next_tid++;
+    thread->tid = __atomic_fetch_add(&pmgr_state.next_tid, 1, __ATOMIC_RELAXED);
     thread->pid = pid;
     thread->state = PROCESS_STATE_NEW;
     thread->priority = proc->priority;
@@ -100,17 +107,20 @@ thread_t *pmgr_create_thread(u64 pid, void *entry_point, void *arg)
     thread->user_stack = mmgr_alloc_pages(4);
     thread->next = NULL;
 
+    write_lock(&pmgr_state.lock);
     if (proc->thread_count < MAX_THREADS_PER_PROCESS) {
         thread->next = proc->threads;
         proc->threads = thread;
         proc->thread_count++;
     }
+    write_unlock(&pmgr_state.lock);
 
     return thread;
 }
 
 int pmgr_destroy_thread(u64 tid)
 {
+    write_lock(&pmgr_state.lock);
     for (u32 i = 0; i < pmgr_state.process_count; i++) {
         process_t *proc = pmgr_state.processes[i];
         thread_t *thread = proc->threads;
@@ -123,16 +133,19 @@ int pmgr_destroy_thread(u64 tid)
                 } else {
                     proc->threads = thread->next;
                 }
+                proc->thread_count--;
+                write_unlock(&pmgr_state.lock);
+
                 free(thread->kernel_stack);
                 free(thread->user_stack);
                 free(thread);
-                proc->thread_count--;
                 return 0;
             }
             prev = thread;
             thread = thread->next;
         }
     }
+    write_unlock(&pmgr_state.lock);
     return -1;
 }
 
@@ -156,27 +169,39 @@ int pmgr_set_cpu_affinity(u64 tid, u32 cpu_mask)
 
 process_t *pmgr_get_process(u64 pid)
 {
+    process_t *proc = NULL;
+
+    read_lock(&pmgr_state.lock);
     for (u32 i = 0; i < pmgr_state.process_count; i++) {
         if (pmgr_state.processes[i]->pid == pid) {
-            return pmgr_state.processes[i];
+            proc = pmgr_state.processes[i];
+            break;
         }
     }
-    return NULL;
+    read_unlock(&pmgr_state.lock);
+
+    return proc;
 }
 
 thread_t *pmgr_get_thread(u64 tid)
 {
-    for (u32 i = 0; i < pmgr_state.process_count; i++) {
+    thread_t *found = NULL;
+
+    read_lock(&pmgr_state.lock);
+    for (u32 i = 0; i < pmgr_state.process_count && !found; i++) {
         process_t *proc = pmgr_state.processes[i];
         thread_t *thread = proc->threads;
         while (thread) {
             if (thread->tid == tid) {
-                return thread;
+                found = thread;
+                break;
             }
             thread = thread->next;
         }
     }
-    return NULL;
+    read_unlock(&pmgr_state.lock);
+
+    return found;
 }
 
 int pmgr_schedule_thread(thread_t *thread)
@@ -187,8 +212,10 @@ int pmgr_schedule_thread(thread_t *thread)
     u32 cpu = thread->cpu_affinity & 0xFF;
     if (cpu >= MAX_CPUS) cpu = 0;
 
+    spin_lock(&pmgr_state.run_queue_locks[cpu]);
     thread->next = pmgr_state.run_queues[cpu];
     pmgr_state.run_queues[cpu] = thread;
+    spin_unlock(&pmgr_state.run_queue_locks[cpu]);
     return 0;
 }
 
@@ -196,10 +223,12 @@ thread_t *pmgr_get_next_runnable_thread(u32 cpu_id)
 {
     if (cpu_id >= MAX_CPUS) return NULL;
 
+    spin_lock(&pmgr_state.run_queue_locks[cpu_id]);
     thread_t *thread = pmgr_state.run_queues[cpu_id];
     if (thread) {
         pmgr_state.run_queues[cpu_id] = thread->next;
         thread->next = NULL;
     }
+    spin_unlock(&pmgr_state.run_queue_locks[cpu_id]);
     return thread;
 }
@@ -1,234 +1,408 @@
 #include <kernel/profiler.h>
-#include <common/list.h>
+#include <kernel/percpu.h>
+#include <kernel/spinlock.h>
+#include <kernel/hdr_histogram.h>
+#include <kernel/wait_queue.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-typedef struct profile_sample {
-    struct list_head list;
-    const char *name;
-    uint64_t start_time;
-    uint64_t end_time;
-    uint64_t duration;
-    uint32_t sample_count;
-    uint32_t max_duration;
-    uint32_t min_duration;
-} profile_sample_t;
+/*
+ * Probe names are interned once into small integer IDs. Recording a
+ * sample never allocates: it is written into a fixed ring on the current
+ * CPU and folded into that CPU's count/sum/min/max for the probe. The
+ * aggregates are summed over CPUs on read; the rings keep the most recent
+ * PROFILER_RING_SIZE samples per CPU for tracing and export. Each probe
+ * also gets a per-CPU latency histogram when it is interned.
+ */
+#define PROFILER_HASH_SIZE (PROFILER_MAX_PROBES * 2)
+#define PROFILER_CALIBRATE_NS 1000000ULL
 
-static struct list_head profile_samples;
-static int profiler_initialized = 0;
+#define PROFILER_RATE_NONE    0
+#define PROFILER_RATE_WRITING 1
+#define PROFILER_RATE_READY   2
 
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint32_t max;
+    uint32_t min_inv;   /* ~min, so a zeroed slot reads as "no minimum yet" */
+} profiler_stat_t;
+
+typedef struct {
+    uint64_t head;
+    profiler_sample_t ring[PROFILER_RING_SIZE];
+    profiler_stat_t stats[PROFILER_MAX_PROBES];
+} profiler_cpu_t;
+
+typedef struct {
+    profiler_probe_t probe;
+    uint64_t start;
+} profiler_frame_t;
+
+static DEFINE_PER_CPU(profiler_cpu_t, profiler_cpu);
+
+static char probe_names[PROFILER_MAX_PROBES][PROFILER_NAME_LEN];
+static hdr_percpu_hist_t *probe_hist[PROFILER_MAX_PROBES];
+static uint32_t probe_hash[PROFILER_HASH_SIZE];
+static uint32_t probe_count = 0;
+static spinlock_t probe_lock = SPINLOCK_INIT;
+
+/* Cycle counter and monotonic clock read together when the first probe is interned. */
+static uint64_t profiler_anchor_cycles = 0;
+static uint64_t profiler_anchor_ns = 0;
+
+/* Published once by the first conversion to finish measuring. */
+static double profiler_ns_per_cycle = 0;
+static uint32_t profiler_rate_state = PROFILER_RATE_NONE;
+
+static __thread profiler_frame_t profiler_stack[PROFILER_MAX_DEPTH];
+static __thread uint32_t profiler_depth = 0;
+
+/* Everything is static; kept so existing callers need not change. */
 void profiler_init(void)
 {
-    if (profiler_initialized) return;
-    
-    INIT_LIST_HEAD(&profile_samples);
-    profiler_initialized = 1;
 }
 
 uint64_t profiler_get_cpu_cycles(void)
 {
-    uint64_t cycles;
-    asm volatile("rdtsc" : "=A" (cycles));
-    return cycles;
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
 }
 
-void profiler_start(const char *name)
+/*
+ * Measure without holding any lock; callers racing the first measurement
+ * each use their own result, and only one of them publishes it.
+ */
+static double profiler_calibrate(uint64_t anchor_ns)
 {
-    if (!profiler_initialized) {
-        profiler_init();
+    uint64_t now_ns, now_cycles;
+    do {
+        now_ns = wait_queue_now_ns();
+        now_cycles = profiler_get_cpu_cycles();
+    } while (now_ns - anchor_ns < PROFILER_CALIBRATE_NS || now_cycles == profiler_anchor_cycles);
+    
+    double ns_per_cycle = (double)(now_ns - anchor_ns) / (double)(now_cycles - profiler_anchor_cycles);
+    
+    uint32_t expected = PROFILER_RATE_NONE;
+    if (__atomic_compare_exchange_n(&profiler_rate_state, &expected, PROFILER_RATE_WRITING,
+                                    false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        profiler_ns_per_cycle = ns_per_cycle;
+        __atomic_store_n(&profiler_rate_state, PROFILER_RATE_READY, __ATOMIC_RELEASE);
     }
     
-    profile_sample_t *sample = (profile_sample_t *)malloc(sizeof(profile_sample_t));
-    if (!sample) return;
+    return ns_per_cycle;
+}
+
+/*
+ * Map a sample timestamp in cycles onto wait_queue_now_ns() time. The rate
+ * is measured over at least PROFILER_CALIBRATE_NS after the anchor, once.
+ */
+uint64_t profiler_cycles_to_ns(uint64_t cycles)
+{
+    uint64_t anchor_ns = __atomic_load_n(&profiler_anchor_ns, __ATOMIC_ACQUIRE);
+    if (!anchor_ns) return 0;
     
-    sample->name = name;
-    sample->start_time = profiler_get_cpu_cycles();
-    sample->end_time = 0;
-    sample->duration = 0;
-    sample->sample_count = 1;
-    sample->max_duration = 0;
-    sample->min_duration = UINT32_MAX;
+    double ns_per_cycle;
+    if (__atomic_load_n(&profiler_rate_state, __ATOMIC_ACQUIRE) == PROFILER_RATE_READY) {
+        ns_per_cycle = profiler_ns_per_cycle;
+    } else {
+        ns_per_cycle = profiler_calibrate(anchor_ns);
+    }
     
-    list_add_tail(&sample->list, &profile_samples);
+    int64_t delta = (int64_t)(cycles - profiler_anchor_cycles);
+    return anchor_ns + (int64_t)((double)delta * ns_per_cycle);
 }
 
-void profiler_end(const char *name)
+static uint32_t profiler_hash_name(const char *name)
 {
-    if (!profiler_initialized) {
-        return;
+    uint32_t hash = 2166136261u;
+    
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
     }
     
-    uint64_t end_time = profiler_get_cpu_cycles();
-    struct list_head *pos;
+    return hash;
+}
+
+static profiler_probe_t profiler_probe_lookup(const char *name, uint32_t *slot_out)
+{
+    uint32_t slot = profiler_hash_name(name) & (PROFILER_HASH_SIZE - 1);
     
-    list_for_each(pos, &profile_samples) {
-        profile_sample_t *sample = list_entry(pos, profile_sample_t, list);
-        
-        if (strcmp(sample->name, name) == 0 && sample->end_time == 0) {
-            sample->end_time = end_time;
-            sample->duration = end_time - sample->start_time;
-            
-            if (sample->duration > sample->max_duration) {
-                sample->max_duration = sample->duration;
-            }
-            
-            if (sample->duration < sample->min_duration) {
-                sample->min_duration = sample->duration;
-            }
-            
-            break;
+    for (uint32_t i = 0; i < PROFILER_HASH_SIZE; i++) {
+        uint32_t id = __atomic_load_n(&probe_hash[slot], __ATOMIC_ACQUIRE);
+        if (id == 0) {
+            if (slot_out) *slot_out = slot;
+            return 0;
         }
+        if (strncmp(probe_names[id - 1], name, PROFILER_NAME_LEN - 1) == 0) {
+            return id;
+        }
+        slot = (slot + 1) & (PROFILER_HASH_SIZE - 1);
     }
+    
+    return 0;
 }
 
-void profiler_record_event(const char *name, uint32_t duration)
+profiler_probe_t profiler_probe_find(const char *name)
 {
-    if (!profiler_initialized) {
-        profiler_init();
-    }
+    if (!name) return 0;
+    
+    return profiler_probe_lookup(name, NULL);
+}
+
+/* Intern 'name'. Returns 0 once PROFILER_MAX_PROBES names are in use. */
+profiler_probe_t profiler_probe(const char *name)
+{
+    if (!name) return 0;
     
-    profile_sample_t *sample = (profile_sample_t *)malloc(sizeof(profile_sample_t));
-    if (!sample) return;
+    profiler_probe_t id = profiler_probe_lookup(name, NULL);
+    if (id) return id;
     
-    sample->name = name;
-    sample->start_time = 0;
-    sample->end_time = 0;
-    sample->duration = duration;
-    sample->sample_count = 1;
-    sample->max_duration = duration;
-    sample->min_duration = duration;
+    spin_lock(&probe_lock);
+    uint32_t slot;
+    id = profiler_probe_lookup(name, &slot);
+    if (!id && probe_count < PROFILER_MAX_PROBES) {
+        if (!profiler_anchor_ns) {
+            profiler_anchor_cycles = profiler_get_cpu_cycles();
+            __atomic_store_n(&profiler_anchor_ns, wait_queue_now_ns(), __ATOMIC_RELEASE);
+        }
+        id = probe_count + 1;
+        strncpy(probe_names[id - 1], name, PROFILER_NAME_LEN - 1);
+        probe_hist[id - 1] = hdr_percpu_alloc();
+        __atomic_store_n(&probe_hash[slot], id, __ATOMIC_RELEASE);
+        __atomic_store_n(&probe_count, id, __ATOMIC_RELEASE);
+    }
+    spin_unlock(&probe_lock);
     
-    list_add_tail(&sample->list, &profile_samples);
+    return id;
 }
 
-void profiler_print_report(void)
+const char *profiler_probe_name(profiler_probe_t probe)
 {
-    if (!profiler_initialized || list_empty(&profile_samples)) {
-        printf("Profiler not initialized or no samples recorded\n");
-        return;
+    if (probe == 0 || probe > __atomic_load_n(&probe_count, __ATOMIC_ACQUIRE)) return NULL;
+    
+    return probe_names[probe - 1];
+}
+
+static void profiler_stat_max(uint32_t *max, uint32_t value)
+{
+    uint32_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > old &&
+           !__atomic_compare_exchange_n(max, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
     }
+}
+
+void profiler_record_id(profiler_probe_t probe, uint32_t duration)
+{
+    if (probe == 0 || probe > PROFILER_MAX_PROBES) return;
     
-    printf("\n=== Performance Profile Report ===\n");
-    printf("%-30s | %-12s | %-12s | %-12s\n", "Operation", "Duration", "Max", "Min");
-    printf("-------|-----------|-----------|-----------|------\n");
+    profiler_cpu_t *cpu = this_cpu_ptr(profiler_cpu);
     
-    struct list_head *pos;
-    uint64_t total_time = 0;
-    int sample_count = 0;
+    uint64_t pos = __atomic_fetch_add(&cpu->head, 1, __ATOMIC_RELAXED);
+    profiler_sample_t *sample = &cpu->ring[pos & (PROFILER_RING_SIZE - 1)];
+    __atomic_store_n(&sample->timestamp, profiler_get_cpu_cycles(), __ATOMIC_RELAXED);
+    __atomic_store_n(&sample->probe, probe, __ATOMIC_RELAXED);
+    __atomic_store_n(&sample->duration, duration, __ATOMIC_RELAXED);
     
-    list_for_each(pos, &profile_samples) {
-        profile_sample_t *sample = list_entry(pos, profile_sample_t, list);
-        
-        printf("%-30s | %12llu | %12u | %12u\n",
-               sample->name,
-               sample->duration,
-               sample->max_duration,
-               sample->min_duration);
-        
-        total_time += sample->duration;
-        sample_count++;
-    }
+    profiler_stat_t *stat = &cpu->stats[probe - 1];
+    __atomic_add_fetch(&stat->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stat->sum, duration, __ATOMIC_RELAXED);
+    profiler_stat_max(&stat->max, duration);
+    profiler_stat_max(&stat->min_inv, ~duration);
     
-    printf("\n");
-    printf("Total Samples: %d\n", sample_count);
-    printf("Total Time: %llu cycles\n", total_time);
-    printf("Average Time: %llu cycles\n", sample_count > 0 ? total_time / sample_count : 0);
+    hdr_percpu_record(probe_hist[probe - 1], duration);
 }
 
-void profiler_clear(void)
+void profiler_start_id(profiler_probe_t probe)
 {
-    if (!profiler_initialized) {
-        return;
-    }
+    if (profiler_depth >= PROFILER_MAX_DEPTH) return;
     
-    struct list_head *pos, *tmp;
+    profiler_stack[profiler_depth].probe = probe;
+    profiler_stack[profiler_depth].start = profiler_get_cpu_cycles();
+    profiler_depth++;
+}
+
+/* Close the innermost open section for 'probe', dropping any left open inside it. */
+void profiler_end_id(profiler_probe_t probe)
+{
+    uint64_t end = profiler_get_cpu_cycles();
     
-    list_for_each_safe(pos, tmp, &profile_samples) {
-        profile_sample_t *sample = list_entry(pos, profile_sample_t, list);
-        list_del(&sample->list);
-        free(sample);
+    for (uint32_t i = profiler_depth; i > 0; i--) {
+        profiler_frame_t *frame = &profiler_stack[i - 1];
+        if (frame->probe == probe) {
+            uint64_t duration = end - frame->start;
+            profiler_depth = i - 1;
+            profiler_record_id(probe, duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration);
+            return;
+        }
     }
 }
 
-uint64_t profiler_get_average_duration(const char *name)
+void profiler_start(const char *name)
 {
-    if (!profiler_initialized) {
-        return 0;
-    }
+    profiler_start_id(profiler_probe(name));
+}
+
+void profiler_end(const char *name)
+{
+    profiler_end_id(profiler_probe_find(name));
+}
+
+void profiler_record_event(const char *name, uint32_t duration)
+{
+    profiler_record_id(profiler_probe(name), duration);
+}
+
+/* Copy up to 'max' of the most recent samples recorded on 'cpu', oldest first. */
+uint32_t profiler_read_samples(uint32_t cpu, profiler_sample_t *samples, uint32_t max)
+{
+    if (!samples || cpu >= percpu_nr_cpus()) return 0;
     
-    struct list_head *pos;
-    uint64_t total = 0;
-    int count = 0;
+    profiler_cpu_t *pcpu = per_cpu_ptr(profiler_cpu, cpu);
+    uint64_t head = __atomic_load_n(&pcpu->head, __ATOMIC_RELAXED);
+    uint64_t available = head < PROFILER_RING_SIZE ? head : PROFILER_RING_SIZE;
+    uint32_t count = available < max ? (uint32_t)available : max;
     
-    list_for_each(pos, &profile_samples) {
-        profile_sample_t *sample = list_entry(pos, profile_sample_t, list);
-        
-        if (strcmp(sample->name, name) == 0) {
-            total += sample->duration;
-            count++;
-        }
+    for (uint32_t i = 0; i < count; i++) {
+        profiler_sample_t *sample = &pcpu->ring[(head - count + i) & (PROFILER_RING_SIZE - 1)];
+        samples[i].timestamp = __atomic_load_n(&sample->timestamp, __ATOMIC_RELAXED);
+        samples[i].probe = __atomic_load_n(&sample->probe, __ATOMIC_RELAXED);
+        samples[i].duration = __atomic_load_n(&sample->duration, __ATOMIC_RELAXED);
     }
     
-    return count > 0 ? total / count : 0;
+    return count;
 }
 
-uint32_t profiler_get_max_duration(const char *name)
+static void profiler_sum_stats(profiler_probe_t probe, profiler_stat_t *out)
 {
-    if (!profiler_initialized) {
-        return 0;
-    }
-    
-    struct list_head *pos;
-    uint32_t max = 0;
+    memset(out, 0, sizeof(*out));
+    if (probe == 0 || probe > PROFILER_MAX_PROBES) return;
     
-    list_for_each(pos, &profile_samples) {
-        profile_sample_t *sample = list_entry(pos, profile_sample_t, list);
+    for_each_possible_cpu(cpu) {
+        profiler_stat_t *stat = &per_cpu_ptr(profiler_cpu, cpu)->stats[probe - 1];
+        uint32_t max = __atomic_load_n(&stat->max, __ATOMIC_RELAXED);
+        uint32_t min_inv = __atomic_load_n(&stat->min_inv, __ATOMIC_RELAXED);
         
-        if (strcmp(sample->name, name) == 0) {
-            if (sample->max_duration > max) {
-                max = sample->max_duration;
-            }
-        }
+        out->count += __atomic_load_n(&stat->count, __ATOMIC_RELAXED);
+        out->sum += __atomic_load_n(&stat->sum, __ATOMIC_RELAXED);
+        if (max > out->max) out->max = max;
+        if (min_inv > out->min_inv) out->min_inv = min_inv;
     }
+}
+
+/* Cycles at 'per_mille' thousandths of the probe's durations (990 = p99). */
+uint64_t profiler_probe_quantile(profiler_probe_t probe, uint32_t per_mille)
+{
+    if (probe == 0 || probe > __atomic_load_n(&probe_count, __ATOMIC_ACQUIRE)) return 0;
     
-    return max;
+    hdr_hist_t *hist = malloc(sizeof(hdr_hist_t));
+    if (!hist) return 0;
+    
+    hdr_percpu_merge(probe_hist[probe - 1], hist);
+    uint64_t value = hdr_hist_quantile(hist, per_mille);
+    free(hist);
+    
+    return value;
 }
 
-uint32_t profiler_get_min_duration(const char *name)
+uint64_t profiler_get_percentile(const char *name, uint32_t per_mille)
 {
-    if (!profiler_initialized) {
-        return UINT32_MAX;
-    }
+    return profiler_probe_quantile(profiler_probe_find(name), per_mille);
+}
+
+void profiler_print_report(void)
+{
+    uint32_t probes = __atomic_load_n(&probe_count, __ATOMIC_ACQUIRE);
+    uint64_t total_time = 0;
+    uint64_t sample_count = 0;
     
-    struct list_head *pos;
-    uint32_t min = UINT32_MAX;
+    printf("\n=== Performance Profile Report ===\n");
+    printf("%-30s | %-10s | %-12s | %-12s | %-12s | %-12s | %-12s\n",
+           "Operation", "Count", "Average", "P50", "P99", "Max", "Min");
+    printf("-------------------------------|------------|--------------|--------------|--------------|"
+           "--------------|-------------\n");
     
-    list_for_each(pos, &profile_samples) {
-        profile_sample_t *sample = list_entry(pos, profile_sample_t, list);
+    for (profiler_probe_t probe = 1; probe <= probes; probe++) {
+        profiler_stat_t stat;
+        profiler_sum_stats(probe, &stat);
+        if (stat.count == 0) continue;
         
-        if (strcmp(sample->name, name) == 0) {
-            if (sample->min_duration < min) {
-                min = sample->min_duration;
-            }
-        }
+        printf("%-30s | %10llu | %12llu | %12llu | %12llu | %12u | %12u\n",
+               probe_names[probe - 1],
+               (unsigned long long)stat.count,
+               (unsigned long long)(stat.sum / stat.count),
+               (unsigned long long)profiler_probe_quantile(probe, 500),
+               (unsigned long long)profiler_probe_quantile(probe, 990),
+               stat.max,
+               ~stat.min_inv);
+        
+        total_time += stat.sum;
+        sample_count += stat.count;
+    }
+    
+    if (sample_count == 0) {
+        printf("No samples recorded\n");
+        return;
     }
     
-    return min;
+    printf("\n");
+    printf("Total Samples: %llu\n", (unsigned long long)sample_count);
+    printf("Total Time: %llu cycles\n", (unsigned long long)total_time);
+    printf("Average Time: %llu cycles\n", (unsigned long long)(total_time / sample_count));
 }
 
-int profiler_sample_count(void)
+/* Drop all samples and aggregates. Interned probe IDs stay valid. */
+void profiler_clear(void)
 {
-    if (!profiler_initialized) {
-        return 0;
-    }
+    per_cpu_reset(profiler_cpu);
+    profiler_depth = 0;
     
-    int count = 0;
-    struct list_head *pos;
+    uint32_t probes = __atomic_load_n(&probe_count, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < probes; i++) {
+        hdr_percpu_reset(probe_hist[i]);
+    }
+}
+
+uint64_t profiler_get_count(const char *name)
+{
+    profiler_stat_t stat;
+    profiler_sum_stats(profiler_probe_find(name), &stat);
+    return stat.count;
+}
+
+uint64_t profiler_get_average_duration(const char *name)
+{
+    profiler_stat_t stat;
+    profiler_sum_stats(profiler_probe_find(name), &stat);
+    return stat.count > 0 ? stat.sum / stat.count : 0;
+}
+
+uint32_t profiler_get_max_duration(const char *name)
+{
+    profiler_stat_t stat;
+    profiler_sum_stats(profiler_probe_find(name), &stat);
+    return stat.max;
+}
+
+uint32_t profiler_get_min_duration(const char *name)
+{
+    profiler_stat_t stat;
+    profiler_sum_stats(profiler_probe_find(name), &stat);
+    return ~stat.min_inv;
+}
+
+int profiler_sample_count(void)
+{
+    uint32_t probes = __atomic_load_n(&probe_count, __ATOMIC_ACQUIRE);
+    uint64_t count = 0;
     
-    list_for_each(pos, &profile_samples) {
-        count++;
+    for (profiler_probe_t probe = 1; probe <= probes; probe++) {
+        profiler_stat_t stat;
+        profiler_sum_stats(probe, &stat);
+        count += stat.count;
     }
     
-    return count;
+    return (int)count;
 }
@@ -0,0 +1,176 @@
+#include <kernel/rcu.h>
+#include <kernel/wait_queue.h>
+#include <pthread.h>
+#include <sched.h>
+
+/*
+ * Epoch-based read-copy-update. Each reader thread owns a record holding
+ * the global epoch it entered its outermost read-side section at, or 0
+ * while quiescent. Entering and leaving are a couple of plain stores, so
+ * readers never wait. synchronize_rcu() advances the epoch and waits for
+ * every record that entered under an older epoch to go quiescent.
+ *
+ * call_rcu() only queues: callbacks run from rcu_barrier(), or once a
+ * batch has built up and the caller is outside any read-side section.
+ * That keeps it safe to call from inside a reader, e.g. an event callback
+ * that unsubscribes itself.
+ */
+
+typedef struct {
+    u64 epoch;
+    u32 nesting;
+    u32 in_use;
+} __attribute__((aligned(64))) rcu_reader_t;
+
+typedef struct {
+    u64 global_epoch;
+    u64 grace_periods;
+    rcu_reader_t readers[RCU_MAX_READERS];
+    rcu_head_t *callbacks;
+    u32 callback_count;
+    u32 gp_lock;
+} rcu_state_t;
+
+static rcu_state_t rcu_state = { .global_epoch = 1 };
+static __thread rcu_reader_t *current_reader = NULL;
+static pthread_key_t rcu_reader_key;
+static pthread_once_t rcu_key_once = PTHREAD_ONCE_INIT;
+
+static void rcu_reader_exit(void *arg)
+{
+    rcu_reader_t *reader = (rcu_reader_t *)arg;
+
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    reader->nesting = 0;
+    __atomic_store_n(&reader->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void rcu_make_key(void)
+{
+    pthread_key_create(&rcu_reader_key, rcu_reader_exit);
+}
+
+static rcu_reader_t *rcu_reader(void)
+{
+    if (current_reader) return current_reader;
+
+    pthread_once(&rcu_key_once, rcu_make_key);
+
+    for (;;) {
+        for (u32 i = 0; i < RCU_MAX_READERS; i++) {
+            u32 expected = 0;
+            if (__atomic_compare_exchange_n(&rcu_state.readers[i].in_use, &expected, 1, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                current_reader = &rcu_state.readers[i];
+                pthread_setspecific(rcu_reader_key, current_reader);
+                return current_reader;
+            }
+        }
+        sched_yield();
+    }
+}
+
+int rcu_init(void)
+{
+    __atomic_store_n(&rcu_state.global_epoch, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void rcu_read_lock(void)
+{
+    rcu_reader_t *reader = rcu_reader();
+
+    if (reader->nesting++ == 0) {
+        __atomic_store_n(&reader->epoch, __atomic_load_n(&rcu_state.global_epoch, __ATOMIC_ACQUIRE),
+                         __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+void rcu_read_unlock(void)
+{
+    rcu_reader_t *reader = current_reader;
+    if (!reader || reader->nesting == 0) return;
+
+    if (--reader->nesting == 0) {
+        __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+bool rcu_read_lock_held(void)
+{
+    return current_reader && current_reader->nesting > 0;
+}
+
+int synchronize_rcu(void)
+{
+    if (rcu_read_lock_held()) return -1;
+
+    while (__atomic_exchange_n(&rcu_state.gp_lock, 1, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    u64 target = __atomic_add_fetch(&rcu_state.global_epoch, 1, __ATOMIC_SEQ_CST);
+
+    for (u32 i = 0; i < RCU_MAX_READERS; i++) {
+        rcu_reader_t *reader = &rcu_state.readers[i];
+        u32 spins = 0;
+
+        for (;;) {
+            u64 epoch = __atomic_load_n(&reader->epoch, __ATOMIC_ACQUIRE);
+            if (epoch == 0 || epoch >= target) break;
+
+            if (++spins < 64) {
+                wait_queue_cpu_relax();
+            } else {
+                sched_yield();
+            }
+        }
+    }
+
+    __atomic_add_fetch(&rcu_state.grace_periods, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&rcu_state.gp_lock, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head))
+{
+    if (!head || !func) return;
+
+    head->func = func;
+    head->next = __atomic_load_n(&rcu_state.callbacks, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&rcu_state.callbacks, &head->next, head, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+
+    u32 queued = __atomic_add_fetch(&rcu_state.callback_count, 1, __ATOMIC_RELAXED);
+    if (queued >= RCU_CALLBACK_BATCH && !rcu_read_lock_held()) {
+        rcu_barrier();
+    }
+}
+
+int rcu_barrier(void)
+{
+    if (rcu_read_lock_held()) return -1;
+
+    rcu_head_t *list = __atomic_exchange_n(&rcu_state.callbacks, NULL, __ATOMIC_ACQUIRE);
+    if (!list) return 0;
+
+    synchronize_rcu();
+
+    int invoked = 0;
+    while (list) {
+        rcu_head_t *next = list->next;
+        list->func(list);
+        list = next;
+        invoked++;
+    }
+
+    __atomic_sub_fetch(&rcu_state.callback_count, (u32)invoked, __ATOMIC_RELAXED);
+    return invoked;
+}
+
+u64 rcu_get_grace_periods(void)
+{
+    return __atomic_load_n(&rcu_state.grace_periods, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,343 @@
+#define _GNU_SOURCE
+#include <kernel/sampler.h>
+#include <kernel/percpu.h>
+#include <kernel/ksym.h>
+#include <kernel/spinlock.h>
+#include <kernel/wait_queue.h>
+#include "perf_optimize.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/*
+ * On the host build the per-CPU sampling tick is ITIMER_PROF: it expires
+ * after every 1/hz of CPU time the process consumes and SIGPROF lands on
+ * the thread that was running, which stands in for the interrupted CPU.
+ * The handler stays installed once set up, so a tick that is already in
+ * flight when sampling stops is ignored instead of killing the process.
+ */
+
+static perf_buffer_t *sampler_buffer = NULL;
+static u32 sampler_hz = 0;
+static u32 sampler_inflight = 0;
+static bool sampler_installed = false;
+static u64 sampler_cpu_start_ns = 0;
+static u64 sampler_cpu_end_ns = 0;
+
+static DEFINE_PER_CPU(u64, sampler_samples);
+static DEFINE_PER_CPU(u64, sampler_dropped);
+static DEFINE_PER_CPU(u64, sampler_handler_ns);
+
+/* CPU time consumed by every thread, which is what the tick samples. */
+static u64 sampler_cpu_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static void sampler_context_regs(const ucontext_t *uc, u64 *pc, u64 *fp, u64 *sp)
+{
+#if defined(__x86_64__)
+    *pc = (u64)uc->uc_mcontext.gregs[REG_RIP];
+    *fp = (u64)uc->uc_mcontext.gregs[REG_RBP];
+    *sp = (u64)uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+    *pc = uc->uc_mcontext.pc;
+    *fp = uc->uc_mcontext.regs[29];
+    *sp = uc->uc_mcontext.sp;
+#else
+    *pc = 0;
+    *fp = 0;
+    *sp = 0;
+#endif
+}
+
+/*
+ * Each frame holds the caller's frame pointer followed by the return
+ * address. A frame is only followed while it lies on the interrupted
+ * stack above 'sp' and the chain keeps moving towards the stack base, so
+ * a frame-pointer-less leaf or a clobbered chain ends the walk early
+ * instead of faulting.
+ */
+u32 sampler_unwind(u64 pc, u64 fp, u64 sp, u64 *stack, u32 max)
+{
+    if (!stack || max == 0 || !pc) return 0;
+
+    u32 depth = 0;
+    stack[depth++] = pc;
+
+    while (depth < max) {
+        if (fp < sp || fp - sp >= SAMPLER_STACK_LIMIT || (fp & (sizeof(u64) - 1))) break;
+
+        const u64 *frame = (const u64 *)(uintptr_t)fp;
+        u64 next = frame[0];
+        u64 ret = frame[1];
+        if (!ret) break;
+
+        stack[depth++] = ret;
+        if (next <= fp) break;
+        fp = next;
+    }
+
+    return depth;
+}
+
+static void sampler_tick(int sig, siginfo_t *info, void *context)
+{
+    (void)sig;
+    (void)info;
+
+    int saved_errno = errno;
+    u64 start = wait_queue_now_ns();
+
+    __atomic_add_fetch(&sampler_inflight, 1, __ATOMIC_SEQ_CST);
+    perf_buffer_t *buffer = __atomic_load_n(&sampler_buffer, __ATOMIC_SEQ_CST);
+
+    if (buffer) {
+        u64 pc, fp, sp;
+        sampler_context_regs((const ucontext_t *)context, &pc, &fp, &sp);
+
+        perf_sample_t sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.timestamp = start;
+        sample.cpu_id = percpu_current_cpu();
+        sample.pid = (uint32_t)getpid();
+        sample.tid = (uint32_t)syscall(SYS_gettid);
+        sample.event_type = PERF_EVENT_CPU_SAMPLE;
+        sample.event_value = pc;
+        sample.duration_ns = 1000000000ULL / __atomic_load_n(&sampler_hz, __ATOMIC_RELAXED);
+        sample.call_depth = sampler_unwind(pc, fp, sp, sample.call_stack, PERF_MAX_STACK_DEPTH);
+
+        if (sample.call_depth && perf_record_sample(buffer, &sample)) {
+            this_cpu_inc(sampler_samples);
+        } else {
+            this_cpu_inc(sampler_dropped);
+        }
+        this_cpu_add(sampler_handler_ns, wait_queue_now_ns() - start);
+    }
+
+    __atomic_sub_fetch(&sampler_inflight, 1, __ATOMIC_SEQ_CST);
+    errno = saved_errno;
+}
+
+int sampler_start(perf_buffer_t *buffer, u32 hz)
+{
+    if (!buffer) return -1;
+    if (hz == 0) hz = SAMPLER_DEFAULT_HZ;
+    if (hz > SAMPLER_MAX_HZ) return -1;
+
+    if (__atomic_load_n(&sampler_buffer, __ATOMIC_ACQUIRE)) return -1;
+
+    if (!sampler_installed) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = sampler_tick;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, NULL) != 0) return -1;
+        sampler_installed = true;
+    }
+
+    per_cpu_reset(sampler_samples);
+    per_cpu_reset(sampler_dropped);
+    per_cpu_reset(sampler_handler_ns);
+    __atomic_store_n(&sampler_hz, hz, __ATOMIC_RELAXED);
+    sampler_cpu_start_ns = sampler_cpu_time_ns();
+    sampler_cpu_end_ns = 0;
+    __atomic_store_n(&sampler_buffer, buffer, __ATOMIC_SEQ_CST);
+
+    struct itimerval period;
+    period.it_interval.tv_sec = 0;
+    period.it_interval.tv_usec = 1000000 / hz;
+    period.it_value = period.it_interval;
+    if (setitimer(ITIMER_PROF, &period, NULL) != 0) {
+        __atomic_store_n(&sampler_buffer, NULL, __ATOMIC_SEQ_CST);
+        return -1;
+    }
+
+    return 0;
+}
+
+int sampler_stop(void)
+{
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_PROF, &off, NULL);
+
+    if (!__atomic_exchange_n(&sampler_buffer, NULL, __ATOMIC_SEQ_CST)) return -1;
+    sampler_cpu_end_ns = sampler_cpu_time_ns();
+
+    /* Let ticks that already saw the buffer finish writing into it. */
+    u32 spins = 0;
+    while (__atomic_load_n(&sampler_inflight, __ATOMIC_SEQ_CST)) {
+        lock_spin_wait(&spins);
+    }
+
+    return 0;
+}
+
+bool sampler_running(void)
+{
+    return __atomic_load_n(&sampler_buffer, __ATOMIC_ACQUIRE) != NULL;
+}
+
+void sampler_get_stats(sampler_stats_t *stats)
+{
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->samples = per_cpu_sum(sampler_samples);
+    stats->dropped = per_cpu_sum(sampler_dropped);
+    stats->handler_ns = per_cpu_sum(sampler_handler_ns);
+    stats->hz = __atomic_load_n(&sampler_hz, __ATOMIC_RELAXED);
+
+    u64 end = sampler_running() ? sampler_cpu_time_ns() : sampler_cpu_end_ns;
+    if (end > sampler_cpu_start_ns) {
+        stats->cpu_ns = end - sampler_cpu_start_ns;
+        stats->overhead_ppm = (u32)(stats->handler_ns * 1000000ULL / stats->cpu_ns);
+    }
+}
+
+typedef struct {
+    u64 count;
+    u32 depth;
+    u64 stack[PERF_MAX_STACK_DEPTH];
+} sampler_folded_t;
+
+static u64 sampler_stack_hash(const perf_sample_t *sample)
+{
+    u64 hash = 14695981039346656037ULL;
+
+    for (u32 i = 0; i < sample->call_depth; i++) {
+        hash = (hash ^ sample->call_stack[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+typedef struct {
+    char *line;
+    u64 count;
+} sampler_line_t;
+
+static int sampler_line_cmp(const void *a, const void *b)
+{
+    return strcmp(((const sampler_line_t *)a)->line, ((const sampler_line_t *)b)->line);
+}
+
+static void sampler_append(char *out, size_t size, size_t *len, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void sampler_append(char *out, size_t size, size_t *len, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(*len < size ? out + *len : NULL, *len < size ? size - *len : 0, fmt, args);
+    va_end(args);
+
+    if (n > 0) *len += (size_t)n;
+}
+
+/* Symbolize one stack, root first. Returns a malloc'd line without the count. */
+static char *sampler_fold_stack(const sampler_folded_t *entry)
+{
+    char line[PERF_MAX_STACK_DEPTH * 80] = "";
+    size_t len = 0;
+
+    for (u32 frame = entry->depth; frame > 0; frame--) {
+        u64 pc = entry->stack[frame - 1];
+        /* Return addresses point past the call; look up the call itself. */
+        const char *names[KSYM_MAX_INLINE + 1];
+        u32 count = ksym_lookup_inline(frame > 1 ? pc - 1 : pc, names, KSYM_MAX_INLINE + 1);
+        const char *sep = frame == entry->depth ? "" : ";";
+
+        if (count) {
+            /* Inlined callees become frames of their own below the function. */
+            while (count > 0) {
+                sampler_append(line, sizeof(line), &len, "%s%s", sep, names[--count]);
+                sep = ";";
+            }
+        } else {
+            sampler_append(line, sizeof(line), &len, "%s0x%llx", sep, (unsigned long long)pc);
+        }
+    }
+
+    return strdup(line);
+}
+
+size_t sampler_export_folded(perf_buffer_t *buffer, char *out, size_t size)
+{
+    if (out && size) out[0] = '\0';
+    if (!buffer) return 0;
+    if (!out) size = 0;
+
+    size_t count = __atomic_load_n(&buffer->sample_count, __ATOMIC_ACQUIRE);
+    if (count > buffer->capacity) count = buffer->capacity;
+
+    size_t slots = 16;
+    while (slots < count * 2) slots <<= 1;
+
+    sampler_folded_t *stacks = (sampler_folded_t *)calloc(slots, sizeof(sampler_folded_t));
+    if (!stacks) return 0;
+
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        const perf_sample_t *sample = &buffer->samples[i];
+        if (sample->event_type != PERF_EVENT_CPU_SAMPLE || sample->call_depth == 0) continue;
+
+        u32 depth = sample->call_depth < PERF_MAX_STACK_DEPTH ? sample->call_depth : PERF_MAX_STACK_DEPTH;
+        size_t slot = sampler_stack_hash(sample) & (slots - 1);
+        while (stacks[slot].count &&
+               (stacks[slot].depth != depth ||
+                memcmp(stacks[slot].stack, sample->call_stack, depth * sizeof(u64)) != 0)) {
+            slot = (slot + 1) & (slots - 1);
+        }
+
+        if (!stacks[slot].count) {
+            stacks[slot].depth = depth;
+            memcpy(stacks[slot].stack, sample->call_stack, depth * sizeof(u64));
+            unique++;
+        }
+        stacks[slot].count++;
+    }
+
+    /* Different PCs in the same functions fold to the same line; merge them. */
+    sampler_line_t *lines = (sampler_line_t *)calloc(unique ? unique : 1, sizeof(sampler_line_t));
+    size_t nlines = 0;
+    for (size_t i = 0; lines && i < slots; i++) {
+        if (!stacks[i].count) continue;
+
+        lines[nlines].line = sampler_fold_stack(&stacks[i]);
+        lines[nlines].count = stacks[i].count;
+        if (lines[nlines].line) nlines++;
+    }
+    free(stacks);
+    if (!lines) return 0;
+
+    qsort(lines, nlines, sizeof(sampler_line_t), sampler_line_cmp);
+
+    size_t len = 0;
+    for (size_t i = 0; i < nlines; i++) {
+        u64 count = lines[i].count;
+        while (i + 1 < nlines && strcmp(lines[i].line, lines[i + 1].line) == 0) {
+            free(lines[i].line);
+            count += lines[++i].count;
+        }
+
+        sampler_append(out, size, &len, "%s %llu\n", lines[i].line, (unsigned long long)count);
+        free(lines[i].line);
+    }
+
+    free(lines);
+
+    return len;
+}
@@ -1,4 +1,8 @@
 #include <kernel/scheduler.h>
+#include <kernel/percpu.h>
+#include <kernel/pmu.h>
+#include <kernel/spinlock.h>
+#include <kernel/tracepoint.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -7,10 +11,11 @@ typedef struct {
     u32 entity_count;
     u64 min_vruntime;
     u64 total_weight;
+    spinlock_t lock;    /* the run queue is shared by every CPU */
 } scheduler_state_t;
 
-static scheduler_state_t sched_state = {0};
-static u64 cpu_loads[MAX_CPUS] = {0};
+static scheduler_state_t sched_state = { .lock = SPINLOCK_INIT };
+static DEFINE_PER_CPU(u64, cpu_loads);
 
 int scheduler_init(void)
 {
@@ -20,10 +25,9 @@ int scheduler_init(void)
     sched_state.entity_count = 0;
     sched_state.min_vruntime = 0;
     sched_state.total_weight = 0;
+    spin_lock_init(&sched_state.lock);
 
-    for (u32 i = 0; i < MAX_CPUS; i++) {
-        cpu_loads[i] = 0;
-    }
+    per_cpu_reset(cpu_loads);
 
     return 0;
 }
@@ -31,7 +35,10 @@ int scheduler_init(void)
 int scheduler_enqueue(sched_entity_t *entity)
 {
     if (!entity) return -1;
+
+    spin_lock(&sched_state.lock);
     if (sched_state.entity_count >= MAX_PROCESSES * MAX_THREADS_PER_PROCESS) {
+        spin_unlock(&sched_state.lock);
         return -1;
     }
 
@@ -43,6 +50,7 @@ int scheduler_enqueue(sched_entity_t *entity)
             sched_state.min_vruntime = entity->ctx.cfs.vruntime;
         }
     }
+    spin_unlock(&sched_state.lock);
 
     return 0;
 }
@@ -51,6 +59,7 @@ int scheduler_dequeue(sched_entity_t *entity)
 {
     if (!entity) return -1;
 
+    spin_lock(&sched_state.lock);
     for (u32 i = 0; i < sched_state.entity_count; i++) {
         if (sched_state.entities[i] == entity) {
             for (u32 j = i; j < sched_state.entity_count - 1; j++) {
@@ -62,9 +71,11 @@ int scheduler_dequeue(sched_entity_t *entity)
                 sched_state.total_weight -= 1024;
             }
 
+            spin_unlock(&sched_state.lock);
             return 0;
         }
     }
+    spin_unlock(&sched_state.lock);
 
     return -1;
 }
@@ -74,11 +85,13 @@ sched_entity_t *scheduler_pick_next(u32 cpu_id)
     sched_entity_t *next = NULL;
     u64 min_vruntime_ent = -1;
 
+    spin_lock(&sched_state.lock);
     for (u32 i = 0; i < sched_state.entity_count; i++) {
         sched_entity_t *entity = sched_state.entities[i];
 
         if (entity->sched_class == SCHED_CLASS_RT && entity->thread->state == PROCESS_STATE_READY) {
-            return entity;
+            next = entity;
+            break;
         }
 
         if (entity->sched_class == SCHED_CLASS_FAIR && entity->thread->state == PROCESS_STATE_READY) {
@@ -88,17 +101,30 @@ sched_entity_t *scheduler_pick_next(u32 cpu_id)
             }
         }
     }
+    spin_unlock(&sched_state.lock);
 
     return next;
 }
 
+/* The CPU a thread runs on, by the rule pmgr_schedule_thread() uses to pick its run queue. */
+static u32 sched_thread_cpu(const thread_t *thread)
+{
+    u32 cpu = thread->cpu_affinity & 0xFF;
+    return cpu < MAX_CPUS ? cpu : 0;
+}
+
+/* Charge the threads running on 'cpu_id' one tick and record how many there are. */
 void scheduler_tick(u32 cpu_id)
 {
     if (cpu_id >= MAX_CPUS) return;
 
+    u64 running = 0;
+
+    spin_lock(&sched_state.lock);
     for (u32 i = 0; i < sched_state.entity_count; i++) {
         sched_entity_t *entity = sched_state.entities[i];
-        if (entity->thread->state == PROCESS_STATE_RUNNING) {
+        if (entity->thread->state == PROCESS_STATE_RUNNING && sched_thread_cpu(entity->thread) == cpu_id) {
+            running++;
             entity->thread->time_slice_remaining--;
             entity->ctx.cfs.sum_exec_runtime++;
 
@@ -114,18 +140,26 @@ void scheduler_tick(u32 cpu_id)
             }
         }
     }
+    spin_unlock(&sched_state.lock);
+
+    __atomic_store_n(per_cpu_ptr(cpu_loads, cpu_id), running, __ATOMIC_RELAXED);
 }
 
 int scheduler_set_class(u64 tid, sched_class_t sched_class)
 {
+    int ret = -1;
+
+    spin_lock(&sched_state.lock);
     for (u32 i = 0; i < sched_state.entity_count; i++) {
         if (sched_state.entities[i]->thread->tid == tid) {
             sched_state.entities[i]->sched_class = sched_class;
-            return 0;
+            ret = 0;
+            break;
         }
     }
+    spin_unlock(&sched_state.lock);
 
-    return -1;
+    return ret;
 }
 
 int scheduler_enable_energy_aware(void)
@@ -136,7 +170,7 @@ int scheduler_enable_energy_aware(void)
 u64 scheduler_get_cpu_load(u32 cpu_id)
 {
     if (cpu_id >= MAX_CPUS) return 0;
-    return cpu_loads[cpu_id];
+    return __atomic_load_n(per_cpu_ptr(cpu_loads, cpu_id), __ATOMIC_RELAXED);
 }
 
 int scheduler_balance_load(void)
@@ -146,16 +180,17 @@ int scheduler_balance_load(void)
     u32 underloaded_cpus[MAX_CPUS];
     u32 over_count = 0, under_count = 0;
 
-    for (u32 i = 0; i < MAX_CPUS; i++) {
-        avg_load += cpu_loads[i];
+    for_each_possible_cpu(cpu) {
+        avg_load += scheduler_get_cpu_load(cpu);
     }
-    avg_load /= MAX_CPUS;
-
-    for (u32 i = 0; i < MAX_CPUS; i++) {
-        if (cpu_loads[i] > avg_load + 2) {
-            overloaded_cpus[over_count++] = i;
-        } else if (cpu_loads[i] < avg_load - 2) {
-            underloaded_cpus[under_count++] = i;
+    avg_load /= percpu_nr_cpus();
+
+    for_each_possible_cpu(cpu) {
+        u64 load = scheduler_get_cpu_load(cpu);
+        if (load > avg_load + 2) {
+            overloaded_cpus[over_count++] = cpu;
+        } else if (load < avg_load - 2) {
+            underloaded_cpus[under_count++] = cpu;
         }
     }
 
@@ -166,6 +201,24 @@ void scheduler_switch_context(thread_t *prev, thread_t *next)
 {
     if (!prev || !next) return;
 
+    AEGIS_TRACE(sched, switch, prev->tid, next->tid, percpu_current_cpu());
+
     prev->state = PROCESS_STATE_READY;
     next->state = PROCESS_STATE_RUNNING;
+
+    if (prev->pmu || next->pmu) pmu_switch(prev->pmu, next->pmu);
+}
+
+void scheduler_handoff(thread_t *prev, thread_t *next)
+{
+    if (!prev || !next) return;
+
+    AEGIS_TRACE(sched, handoff, prev->tid, next->tid, prev->time_slice_remaining);
+
+    prev->state = PROCESS_STATE_BLOCKED;
+    next->state = PROCESS_STATE_RUNNING;
+    next->time_slice_remaining += prev->time_slice_remaining;
+    prev->time_slice_remaining = 0;
+
+    if (prev->pmu || next->pmu) pmu_switch(prev->pmu, next->pmu);
 }
@@ -0,0 +1,421 @@
+#include <kernel/spinlock.h>
+#include <kernel/wait_queue.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include "perf_optimize.h"
+
+/*
+ * Host builds run kernel threads as preemptible pthreads, so a lock holder
+ * can be descheduled mid critical section. Waiters back off to the host
+ * scheduler after LOCK_SPIN_YIELD spins instead of burning their slice.
+ */
+#define LOCK_SPIN_YIELD 128
+
+static u32 lock_stats_on = 0;
+static u32 lock_stats_lock = 0;
+static lock_stats_t *lock_stats_head = NULL;
+static perf_buffer_t *lock_perf_buffer = NULL;
+static u32 lock_perf_lock = 0;
+
+static void lock_raw_acquire(u32 *lock)
+{
+    u32 spins = 0;
+
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+        lock_spin_wait(&spins);
+    }
+}
+
+static void lock_raw_release(u32 *lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+void lock_spin_wait(u32 *spins)
+{
+    wait_queue_cpu_relax();
+    if (++*spins % LOCK_SPIN_YIELD == 0) {
+        sched_yield();
+    }
+}
+
+static bool lock_stats_active(lock_stats_t *stats)
+{
+    return stats && __atomic_load_n(&lock_stats_on, __ATOMIC_RELAXED);
+}
+
+static void lock_stats_acquired(lock_stats_t *stats)
+{
+    if (lock_stats_active(stats)) {
+        __atomic_add_fetch(&stats->acquisitions, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static u64 lock_wait_start(lock_stats_t *stats)
+{
+    return lock_stats_active(stats) ? wait_queue_now_ns() : 0;
+}
+
+static void lock_stats_contended(lock_stats_t *stats, u64 start)
+{
+    if (!start || !lock_stats_active(stats)) return;
+
+    u64 now = wait_queue_now_ns();
+    u64 wait = now - start;
+
+    __atomic_add_fetch(&stats->acquisitions, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->contended, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->wait_ns, wait, __ATOMIC_RELAXED);
+
+    u64 old = __atomic_load_n(&stats->max_wait_ns, __ATOMIC_RELAXED);
+    while (wait > old &&
+           !__atomic_compare_exchange_n(&stats->max_wait_ns, &old, wait, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    perf_buffer_t *buffer = __atomic_load_n(&lock_perf_buffer, __ATOMIC_ACQUIRE);
+    if (buffer) {
+        perf_sample_t sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.timestamp = now;
+        sample.event_type = PERF_EVENT_LOCK_CONTENTION;
+        sample.event_value = (uint64_t)(uintptr_t)stats;
+        sample.duration_ns = wait;
+
+        lock_raw_acquire(&lock_perf_lock);
+        perf_record_sample(buffer, &sample);
+        lock_raw_release(&lock_perf_lock);
+    }
+}
+
+void spin_lock_init(spinlock_t *lock)
+{
+    if (!lock) return;
+
+    lock->next = 0;
+    lock->owner = 0;
+    lock->stats = NULL;
+}
+
+void spin_lock(spinlock_t *lock)
+{
+    u32 ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+
+    if (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) == ticket) {
+        lock_stats_acquired(lock->stats);
+        return;
+    }
+
+    u64 start = lock_wait_start(lock->stats);
+    u32 spins = 0;
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+        lock_spin_wait(&spins);
+    }
+    lock_stats_contended(lock->stats, start);
+}
+
+bool spin_trylock(spinlock_t *lock)
+{
+    u32 owner = __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE);
+
+    if (!__atomic_compare_exchange_n(&lock->next, &owner, owner + 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    lock_stats_acquired(lock->stats);
+    return true;
+}
+
+void spin_unlock(spinlock_t *lock)
+{
+    __atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+bool spin_is_locked(spinlock_t *lock)
+{
+    return __atomic_load_n(&lock->owner, __ATOMIC_RELAXED) != __atomic_load_n(&lock->next, __ATOMIC_RELAXED);
+}
+
+void mcs_lock_init(mcs_lock_t *lock)
+{
+    if (!lock) return;
+
+    lock->tail = NULL;
+    lock->stats = NULL;
+}
+
+void mcs_lock(mcs_lock_t *lock, mcs_node_t *node)
+{
+    node->next = NULL;
+    node->locked = 0;
+
+    mcs_node_t *prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (!prev) {
+        lock_stats_acquired(lock->stats);
+        return;
+    }
+
+    u64 start = lock_wait_start(lock->stats);
+    u32 spins = 0;
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+        lock_spin_wait(&spins);
+    }
+    lock_stats_contended(lock->stats, start);
+}
+
+bool mcs_trylock(mcs_lock_t *lock, mcs_node_t *node)
+{
+    mcs_node_t *expected = NULL;
+
+    node->next = NULL;
+    node->locked = 0;
+
+    if (!__atomic_compare_exchange_n(&lock->tail, &expected, node, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    lock_stats_acquired(lock->stats);
+    return true;
+}
+
+void mcs_unlock(mcs_lock_t *lock, mcs_node_t *node)
+{
+    mcs_node_t *next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+
+    if (!next) {
+        mcs_node_t *expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+
+        /* A successor swapped the tail but has not linked itself yet. */
+        u32 spins = 0;
+        while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))) {
+            lock_spin_wait(&spins);
+        }
+    }
+
+    __atomic_store_n(&next->locked, 1, __ATOMIC_RELEASE);
+}
+
+void rwlock_init(rwlock_t *lock)
+{
+    if (!lock) return;
+
+    lock->cnt = 0;
+    spin_lock_init(&lock->wlock);
+    lock->stats = NULL;
+}
+
+void read_lock(rwlock_t *lock)
+{
+    u64 start = 0;
+    u32 spins = 0;
+
+    for (;;) {
+        u32 cnt = __atomic_load_n(&lock->cnt, __ATOMIC_RELAXED);
+
+        if (!(cnt & (RWLOCK_WRITER | RWLOCK_WAITING))) {
+            if (__atomic_compare_exchange_n(&lock->cnt, &cnt, cnt + 1, true,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue;
+        }
+
+        if (!start) start = lock_wait_start(lock->stats);
+        lock_spin_wait(&spins);
+    }
+
+    if (start) {
+        lock_stats_contended(lock->stats, start);
+    } else {
+        lock_stats_acquired(lock->stats);
+    }
+}
+
+bool read_trylock(rwlock_t *lock)
+{
+    u32 cnt = __atomic_load_n(&lock->cnt, __ATOMIC_RELAXED);
+
+    if (cnt & (RWLOCK_WRITER | RWLOCK_WAITING)) return false;
+    if (!__atomic_compare_exchange_n(&lock->cnt, &cnt, cnt + 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    lock_stats_acquired(lock->stats);
+    return true;
+}
+
+void read_unlock(rwlock_t *lock)
+{
+    __atomic_sub_fetch(&lock->cnt, 1, __ATOMIC_RELEASE);
+}
+
+/* Writers queue FIFO on 'wlock', then announce themselves and wait for readers to drain. */
+void write_lock(rwlock_t *lock)
+{
+    u64 start = 0;
+    u32 spins = 0;
+
+    if (!spin_trylock(&lock->wlock)) {
+        start = lock_wait_start(lock->stats);
+        spin_lock(&lock->wlock);
+    }
+
+    __atomic_or_fetch(&lock->cnt, RWLOCK_WAITING, __ATOMIC_RELAXED);
+
+    for (;;) {
+        u32 cnt = __atomic_load_n(&lock->cnt, __ATOMIC_RELAXED);
+
+        if (!(cnt & RWLOCK_READERS) &&
+            __atomic_compare_exchange_n(&lock->cnt, &cnt, RWLOCK_WRITER, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+
+        if (!start) start = lock_wait_start(lock->stats);
+        lock_spin_wait(&spins);
+    }
+
+    if (start) {
+        lock_stats_contended(lock->stats, start);
+    } else {
+        lock_stats_acquired(lock->stats);
+    }
+}
+
+bool write_trylock(rwlock_t *lock)
+{
+    u32 cnt = 0;
+
+    if (!spin_trylock(&lock->wlock)) return false;
+
+    if (!__atomic_compare_exchange_n(&lock->cnt, &cnt, RWLOCK_WRITER, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        spin_unlock(&lock->wlock);
+        return false;
+    }
+
+    lock_stats_acquired(lock->stats);
+    return true;
+}
+
+void write_unlock(rwlock_t *lock)
+{
+    __atomic_store_n(&lock->cnt, 0, __ATOMIC_RELEASE);
+    spin_unlock(&lock->wlock);
+}
+
+void seqlock_init(seqlock_t *lock)
+{
+    if (!lock) return;
+
+    lock->seq = 0;
+    spin_lock_init(&lock->lock);
+}
+
+void write_seqlock(seqlock_t *lock)
+{
+    spin_lock(&lock->lock);
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void write_sequnlock(seqlock_t *lock)
+{
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+    spin_unlock(&lock->lock);
+}
+
+void lock_stats_init(lock_stats_t *stats, const char *name)
+{
+    if (!stats) return;
+
+    lock_raw_acquire(&lock_stats_lock);
+
+    lock_stats_t *iter = lock_stats_head;
+    while (iter && iter != stats) {
+        iter = iter->next;
+    }
+
+    stats->acquisitions = 0;
+    stats->contended = 0;
+    stats->wait_ns = 0;
+    stats->max_wait_ns = 0;
+    memset(stats->name, 0, LOCK_NAME_LEN);
+    if (name) {
+        strncpy(stats->name, name, LOCK_NAME_LEN - 1);
+    }
+
+    if (!iter) {
+        stats->next = lock_stats_head;
+        lock_stats_head = stats;
+    }
+
+    lock_raw_release(&lock_stats_lock);
+}
+
+void lock_stats_enable(bool enable)
+{
+    __atomic_store_n(&lock_stats_on, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+bool lock_stats_enabled(void)
+{
+    return __atomic_load_n(&lock_stats_on, __ATOMIC_ACQUIRE) != 0;
+}
+
+void lock_stats_reset(void)
+{
+    lock_raw_acquire(&lock_stats_lock);
+    for (lock_stats_t *stats = lock_stats_head; stats; stats = stats->next) {
+        __atomic_store_n(&stats->acquisitions, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats->contended, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats->wait_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats->max_wait_ns, 0, __ATOMIC_RELAXED);
+    }
+    lock_raw_release(&lock_stats_lock);
+}
+
+lock_stats_t *lock_stats_find(const char *name)
+{
+    if (!name) return NULL;
+
+    lock_raw_acquire(&lock_stats_lock);
+    lock_stats_t *stats = lock_stats_head;
+    while (stats && strcmp(stats->name, name) != 0) {
+        stats = stats->next;
+    }
+    lock_raw_release(&lock_stats_lock);
+
+    return stats;
+}
+
+/* Record every contended acquisition as a PERF_EVENT_LOCK_CONTENTION sample, or stop with NULL. */
+void lock_stats_set_perf_buffer(struct perf_buffer *buffer)
+{
+    __atomic_store_n(&lock_perf_buffer, buffer, __ATOMIC_RELEASE);
+}
+
+void lock_stats_print(void)
+{
+    printf("\n=== Lock Statistics ===\n");
+    printf("%-24s %12s %12s %14s %14s\n", "Lock", "Acquired", "Contended", "Wait (ns)", "Max wait (ns)");
+
+    lock_raw_acquire(&lock_stats_lock);
+    for (lock_stats_t *stats = lock_stats_head; stats; stats = stats->next) {
+        printf("%-24s %12llu %12llu %14llu %14llu\n",
+               stats->name,
+               (unsigned long long)__atomic_load_n(&stats->acquisitions, __ATOMIC_RELAXED),
+               (unsigned long long)__atomic_load_n(&stats->contended, __ATOMIC_RELAXED),
+               (unsigned long long)__atomic_load_n(&stats->wait_ns, __ATOMIC_RELAXED),
+               (unsigned long long)__atomic_load_n(&stats->max_wait_ns, __ATOMIC_RELAXED));
+    }
+    lock_raw_release(&lock_stats_lock);
+}
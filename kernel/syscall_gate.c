@@ -4,8 +4,15 @@
 #include <kernel/ipc.h>
 #include <kernel/filesystem.h>
 #include <kernel/interrupt.h>
+#include <kernel/rcu.h>
+#include <kernel/spinlock.h>
+#include <kernel/percpu.h>
+#include <kernel/tracepoint.h>
+#include <kernel/wait_queue.h>
 #include <common/string.h>
+#include "sysfs.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 typedef int (*syscall_handler_t)(void);
 
@@ -14,16 +21,63 @@ typedef struct {
     const char *name;
     int privilege_level;
     int arg_count;
+    rcu_head_t rcu;
 } syscall_entry_t;
 
+/*
+ * Entries are immutable once published. Dispatch and the lookup helpers
+ * read the table under RCU; register/unregister swap the slot pointer
+ * under syscall_table_lock and retire the old entry after a grace period.
+ */
 #define MAX_SYSCALLS 512
-static syscall_entry_t syscall_table[MAX_SYSCALLS];
+static syscall_entry_t *syscall_table[MAX_SYSCALLS];
 static int syscall_count = 0;
+static spinlock_t syscall_table_lock = SPINLOCK_INIT;
+
+/*
+ * Per-syscall statistics, kept per CPU and summed on read. The block for
+ * each CPU is allocated the first time stats are enabled; while they are
+ * off dispatch only pays for one predictable load and branch.
+ */
+typedef struct {
+    u64 calls;
+    u64 errors;
+    u64 total_ns;
+    u64 max_ns;
+    u32 hist[SYSCALL_HIST_BUCKETS];
+} syscall_cpu_stat_t;
+
+static syscall_cpu_stat_t *syscall_stats = NULL;
+static u32 syscall_stats_cpus = 0;
+static u32 syscall_stats_on = 0;
+
+static void syscall_table_write_lock(void)
+{
+    spin_lock(&syscall_table_lock);
+}
+
+static void syscall_table_write_unlock(void)
+{
+    spin_unlock(&syscall_table_lock);
+}
+
+static void syscall_entry_free(rcu_head_t *head)
+{
+    free(list_entry(head, syscall_entry_t, rcu));
+}
 
 void syscall_gate_init(void)
 {
-    memset(syscall_table, 0, sizeof(syscall_table));
-    syscall_count = 0;
+    syscall_table_write_lock();
+    for (int i = 0; i < MAX_SYSCALLS; i++) {
+        syscall_entry_t *entry = syscall_table[i];
+        if (entry) {
+            rcu_assign_pointer(syscall_table[i], NULL);
+            call_rcu(&entry->rcu, syscall_entry_free);
+        }
+    }
+    __atomic_store_n(&syscall_count, 0, __ATOMIC_RELAXED);
+    syscall_table_write_unlock();
 }
 
 int syscall_register(int syscall_num, syscall_handler_t handler, const char *name, 
@@ -33,16 +87,26 @@ int syscall_register(int syscall_num, syscall_handler_t handler, const char *nam
         return -1;
     }
     
-    if (syscall_table[syscall_num].handler != NULL) {
+    syscall_entry_t *entry = (syscall_entry_t *)malloc(sizeof(syscall_entry_t));
+    if (!entry) {
         return -1;
     }
     
-    syscall_table[syscall_num].handler = handler;
-    syscall_table[syscall_num].name = name;
-    syscall_table[syscall_num].privilege_level = privilege_level;
-    syscall_table[syscall_num].arg_count = arg_count;
+    entry->handler = handler;
+    entry->name = name;
+    entry->privilege_level = privilege_level;
+    entry->arg_count = arg_count;
+    
+    syscall_table_write_lock();
+    if (syscall_table[syscall_num] != NULL) {
+        syscall_table_write_unlock();
+        free(entry);
+        return -1;
+    }
+    rcu_assign_pointer(syscall_table[syscall_num], entry);
+    __atomic_add_fetch(&syscall_count, 1, __ATOMIC_RELAXED);
+    syscall_table_write_unlock();
     
-    syscall_count++;
     return 0;
 }
 
@@ -52,32 +116,81 @@ int syscall_unregister(int syscall_num)
         return -1;
     }
     
-    if (syscall_table[syscall_num].handler == NULL) {
+    syscall_table_write_lock();
+    syscall_entry_t *entry = syscall_table[syscall_num];
+    if (entry == NULL) {
+        syscall_table_write_unlock();
         return -1;
     }
+    rcu_assign_pointer(syscall_table[syscall_num], NULL);
+    __atomic_sub_fetch(&syscall_count, 1, __ATOMIC_RELAXED);
+    syscall_table_write_unlock();
     
-    syscall_table[syscall_num].handler = NULL;
-    syscall_table[syscall_num].name = NULL;
-    syscall_count--;
+    call_rcu(&entry->rcu, syscall_entry_free);
     return 0;
 }
 
+static u32 syscall_hist_bucket(u64 ns)
+{
+    if (ns == 0) return 0;
+    
+    u32 bucket = 64 - (u32)__builtin_clzll(ns);
+    return bucket < SYSCALL_HIST_BUCKETS ? bucket : SYSCALL_HIST_BUCKETS - 1;
+}
+
+static void syscall_stats_record(int syscall_num, int result, u64 ns)
+{
+    syscall_cpu_stat_t *base = __atomic_load_n(&syscall_stats, __ATOMIC_ACQUIRE);
+    if (!base) return;
+    
+    u32 cpu = percpu_current_cpu() % syscall_stats_cpus;
+    syscall_cpu_stat_t *stat = &base[(size_t)cpu * MAX_SYSCALLS + syscall_num];
+    
+    __atomic_add_fetch(&stat->calls, 1, __ATOMIC_RELAXED);
+    if (result < 0) {
+        __atomic_add_fetch(&stat->errors, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&stat->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stat->hist[syscall_hist_bucket(ns)], 1, __ATOMIC_RELAXED);
+    
+    u64 max = __atomic_load_n(&stat->max_ns, __ATOMIC_RELAXED);
+    while (ns > max &&
+           !__atomic_compare_exchange_n(&stat->max_ns, &max, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
 int syscall_dispatch(int syscall_num, void *args)
 {
     if (syscall_num < 0 || syscall_num >= MAX_SYSCALLS) {
         return -ENOSYS;
     }
     
-    if (syscall_table[syscall_num].handler == NULL) {
+    /* Handlers may block, so only the lookup runs inside the read section. */
+    rcu_read_lock();
+    syscall_entry_t *entry = rcu_dereference(syscall_table[syscall_num]);
+    syscall_handler_t handler = entry ? entry->handler : NULL;
+    rcu_read_unlock();
+    
+    if (handler == NULL) {
         return -ENOSYS;
     }
     
-    return syscall_table[syscall_num].handler();
+    int result;
+    if (__builtin_expect(__atomic_load_n(&syscall_stats_on, __ATOMIC_RELAXED), 0)) {
+        u64 start = wait_queue_now_ns();
+        result = handler();
+        syscall_stats_record(syscall_num, result, wait_queue_now_ns() - start);
+    } else {
+        result = handler();
+    }
+    
+    AEGIS_TRACE(syscall, dispatch, syscall_num, result);
+    return result;
 }
 
 int syscall_get_count(void)
 {
-    return syscall_count;
+    return __atomic_load_n(&syscall_count, __ATOMIC_RELAXED);
 }
 
 const char *syscall_get_name(int syscall_num)
@@ -86,7 +199,12 @@ const char *syscall_get_name(int syscall_num)
         return NULL;
     }
     
-    return syscall_table[syscall_num].name;
+    rcu_read_lock();
+    syscall_entry_t *entry = rcu_dereference(syscall_table[syscall_num]);
+    const char *name = entry ? entry->name : NULL;
+    rcu_read_unlock();
+    
+    return name;
 }
 
 int syscall_get_privilege_level(int syscall_num)
@@ -95,7 +213,12 @@ int syscall_get_privilege_level(int syscall_num)
         return -1;
     }
     
-    return syscall_table[syscall_num].privilege_level;
+    rcu_read_lock();
+    syscall_entry_t *entry = rcu_dereference(syscall_table[syscall_num]);
+    int privilege_level = entry ? entry->privilege_level : 0;
+    rcu_read_unlock();
+    
+    return privilege_level;
 }
 
 int syscall_is_registered(int syscall_num)
@@ -104,7 +227,7 @@ int syscall_is_registered(int syscall_num)
         return 0;
     }
     
-    return syscall_table[syscall_num].handler != NULL;
+    return rcu_dereference(syscall_table[syscall_num]) != NULL;
 }
 
 void syscall_gate_print_table(void)
@@ -113,17 +236,20 @@ void syscall_gate_print_table(void)
     printf("%-4s | %-25s | %-4s | %-4s\n", "Num", "Name", "Priv", "Args");
     printf("-----|---------------------------|------|-----\n");
     
+    rcu_read_lock();
     for (int i = 0; i < MAX_SYSCALLS; i++) {
-        if (syscall_table[i].handler != NULL) {
+        syscall_entry_t *entry = rcu_dereference(syscall_table[i]);
+        if (entry != NULL) {
             printf("%-4d | %-25s | %-4d | %-4d\n",
                    i,
-                   syscall_table[i].name,
-                   syscall_table[i].privilege_level,
-                   syscall_table[i].arg_count);
+                   entry->name,
+                   entry->privilege_level,
+                   entry->arg_count);
         }
     }
+    rcu_read_unlock();
     
-    printf("\nTotal: %d syscalls registered\n", syscall_count);
+    printf("\nTotal: %d syscalls registered\n", syscall_get_count());
 }
 
 int syscall_validate_privilege(int syscall_num, int current_privilege)
@@ -132,11 +258,12 @@ int syscall_validate_privilege(int syscall_num, int current_privilege)
         return 0;
     }
     
-    if (syscall_table[syscall_num].handler == NULL) {
-        return 0;
-    }
+    rcu_read_lock();
+    syscall_entry_t *entry = rcu_dereference(syscall_table[syscall_num]);
+    int allowed = entry != NULL && current_privilege >= entry->privilege_level;
+    rcu_read_unlock();
     
-    return current_privilege >= syscall_table[syscall_num].privilege_level;
+    return allowed;
 }
 
 int syscall_validate_args(int syscall_num, int arg_count)
@@ -145,9 +272,233 @@ int syscall_validate_args(int syscall_num, int arg_count)
         return 0;
     }
     
-    if (syscall_table[syscall_num].handler == NULL) {
-        return 0;
+    rcu_read_lock();
+    syscall_entry_t *entry = rcu_dereference(syscall_table[syscall_num]);
+    int valid = entry != NULL && arg_count >= entry->arg_count;
+    rcu_read_unlock();
+    
+    return valid;
+}
+
+int syscall_gate_stats_enable(bool enable)
+{
+    if (enable && !__atomic_load_n(&syscall_stats, __ATOMIC_ACQUIRE)) {
+        syscall_table_write_lock();
+        if (!syscall_stats) {
+            u32 cpus = percpu_nr_cpus();
+            size_t size = (size_t)cpus * MAX_SYSCALLS * sizeof(syscall_cpu_stat_t);
+            syscall_cpu_stat_t *stats = (syscall_cpu_stat_t *)aligned_alloc(64, size);
+            if (!stats) {
+                syscall_table_write_unlock();
+                return -1;
+            }
+            memset(stats, 0, size);
+            syscall_stats_cpus = cpus;
+            __atomic_store_n(&syscall_stats, stats, __ATOMIC_RELEASE);
+        }
+        syscall_table_write_unlock();
+    }
+    
+    __atomic_store_n(&syscall_stats_on, enable ? 1 : 0, __ATOMIC_RELAXED);
+    return 0;
+}
+
+bool syscall_gate_stats_enabled(void)
+{
+    return __atomic_load_n(&syscall_stats_on, __ATOMIC_RELAXED) != 0;
+}
+
+/* Counters updated concurrently with a reset may survive it. */
+void syscall_gate_stats_reset(void)
+{
+    syscall_cpu_stat_t *base = __atomic_load_n(&syscall_stats, __ATOMIC_ACQUIRE);
+    if (!base) return;
+    
+    size_t count = (size_t)syscall_stats_cpus * MAX_SYSCALLS;
+    for (size_t i = 0; i < count; i++) {
+        syscall_cpu_stat_t *stat = &base[i];
+        __atomic_store_n(&stat->calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stat->errors, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stat->total_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stat->max_ns, 0, __ATOMIC_RELAXED);
+        for (u32 b = 0; b < SYSCALL_HIST_BUCKETS; b++) {
+            __atomic_store_n(&stat->hist[b], 0, __ATOMIC_RELAXED);
+        }
     }
+}
+
+int syscall_gate_get_stats(int syscall_num, syscall_stats_t *stats)
+{
+    if (syscall_num < 0 || syscall_num >= MAX_SYSCALLS || !stats) {
+        return -1;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    
+    syscall_cpu_stat_t *base = __atomic_load_n(&syscall_stats, __ATOMIC_ACQUIRE);
+    if (!base) return 0;
     
-    return arg_count >= syscall_table[syscall_num].arg_count;
+    for (u32 cpu = 0; cpu < syscall_stats_cpus; cpu++) {
+        syscall_cpu_stat_t *stat = &base[(size_t)cpu * MAX_SYSCALLS + syscall_num];
+        u64 max = __atomic_load_n(&stat->max_ns, __ATOMIC_RELAXED);
+        
+        stats->calls += __atomic_load_n(&stat->calls, __ATOMIC_RELAXED);
+        stats->errors += __atomic_load_n(&stat->errors, __ATOMIC_RELAXED);
+        stats->total_ns += __atomic_load_n(&stat->total_ns, __ATOMIC_RELAXED);
+        if (max > stats->max_ns) {
+            stats->max_ns = max;
+        }
+        for (u32 b = 0; b < SYSCALL_HIST_BUCKETS; b++) {
+            stats->hist[b] += __atomic_load_n(&stat->hist[b], __ATOMIC_RELAXED);
+        }
+    }
+    
+    return 0;
+}
+
+/* Upper bound of the histogram bucket holding the given percentile, capped at the max. */
+uint64_t syscall_stats_percentile_ns(const syscall_stats_t *stats, uint32_t percentile)
+{
+    if (!stats || stats->calls == 0) return 0;
+    if (percentile > 100) percentile = 100;
+    
+    u64 target = (stats->calls * percentile + 99) / 100;
+    if (target == 0) target = 1;
+    
+    u64 seen = 0;
+    for (u32 b = 0; b < SYSCALL_HIST_BUCKETS; b++) {
+        seen += stats->hist[b];
+        if (seen >= target) {
+            u64 bound = b ? 1ULL << b : 1;
+            return bound < stats->max_ns ? bound : stats->max_ns;
+        }
+    }
+    
+    return stats->max_ns;
+}
+
+typedef struct {
+    int num;
+    const char *name;
+    syscall_stats_t stats;
+} syscall_stats_row_t;
+
+static int syscall_stats_row_cmp(const void *a, const void *b)
+{
+    const syscall_stats_row_t *ra = (const syscall_stats_row_t *)a;
+    const syscall_stats_row_t *rb = (const syscall_stats_row_t *)b;
+    
+    if (ra->stats.total_ns != rb->stats.total_ns) {
+        return ra->stats.total_ns < rb->stats.total_ns ? 1 : -1;
+    }
+    return ra->num - rb->num;
+}
+
+/* Format every syscall that has been called, most total time first. */
+static int syscall_stats_format(char *buf, size_t size)
+{
+    syscall_stats_row_t *rows = (syscall_stats_row_t *)malloc(MAX_SYSCALLS * sizeof(syscall_stats_row_t));
+    if (!rows) return -1;
+    
+    int count = 0;
+    rcu_read_lock();
+    for (int i = 0; i < MAX_SYSCALLS; i++) {
+        syscall_entry_t *entry = rcu_dereference(syscall_table[i]);
+        if (entry == NULL) continue;
+        
+        syscall_gate_get_stats(i, &rows[count].stats);
+        if (rows[count].stats.calls == 0) continue;
+        
+        rows[count].num = i;
+        rows[count].name = entry->name;
+        count++;
+    }
+    rcu_read_unlock();
+    
+    qsort(rows, count, sizeof(syscall_stats_row_t), syscall_stats_row_cmp);
+    
+    size_t len = 0;
+    len += snprintf(buf + len, size - len, "%-4s | %-20s | %10s | %8s | %12s | %10s | %10s | %10s | %10s\n",
+                    "Num", "Name", "Calls", "Errors", "Total us", "Avg ns", "p50 ns", "p99 ns", "Max ns");
+    for (int i = 0; i < count && len < size; i++) {
+        syscall_stats_t *stats = &rows[i].stats;
+        len += snprintf(buf + len, size - len,
+                        "%-4d | %-20s | %10llu | %8llu | %12llu | %10llu | %10llu | %10llu | %10llu\n",
+                        rows[i].num,
+                        rows[i].name ? rows[i].name : "?",
+                        (unsigned long long)stats->calls,
+                        (unsigned long long)stats->errors,
+                        (unsigned long long)(stats->total_ns / 1000),
+                        (unsigned long long)(stats->total_ns / stats->calls),
+                        (unsigned long long)syscall_stats_percentile_ns(stats, 50),
+                        (unsigned long long)syscall_stats_percentile_ns(stats, 99),
+                        (unsigned long long)stats->max_ns);
+    }
+    
+    free(rows);
+    return len < size ? (int)len : (int)size - 1;
+}
+
+void syscall_gate_print_stats(void)
+{
+    size_t size = MAX_SYSCALLS * 128;
+    char *buf = (char *)malloc(size);
+    if (!buf) return;
+    
+    printf("\n=== System Call Statistics (%s) ===\n", syscall_gate_stats_enabled() ? "enabled" : "disabled");
+    if (syscall_stats_format(buf, size) >= 0) {
+        printf("%s", buf);
+    }
+    
+    free(buf);
+}
+
+static int syscall_sysfs_read_enable(sysfs_entry_t *entry, void *buffer, size_t size)
+{
+    (void)entry;
+    return snprintf((char *)buffer, size, "%d\n", syscall_gate_stats_enabled() ? 1 : 0);
+}
+
+static int syscall_sysfs_write_enable(sysfs_entry_t *entry, const void *buffer, size_t size)
+{
+    (void)entry;
+    if (size == 0) return -1;
+    
+    char c = ((const char *)buffer)[0];
+    if (c != '0' && c != '1') return -1;
+    
+    return syscall_gate_stats_enable(c == '1') == 0 ? (int)size : -1;
+}
+
+static int syscall_sysfs_read_stats(sysfs_entry_t *entry, void *buffer, size_t size)
+{
+    (void)entry;
+    return syscall_stats_format((char *)buffer, size);
+}
+
+static int syscall_sysfs_write_reset(sysfs_entry_t *entry, const void *buffer, size_t size)
+{
+    (void)entry;
+    (void)buffer;
+    syscall_gate_stats_reset();
+    return (int)size;
+}
+
+/* Creates <parent>/syscalls/{enable,stats,reset}. */
+int syscall_gate_sysfs_register(sysfs_t *sysfs, sysfs_entry_t *parent)
+{
+    sysfs_operations_t enable_ops = { syscall_sysfs_read_enable, syscall_sysfs_write_enable };
+    sysfs_operations_t stats_ops = { syscall_sysfs_read_stats, NULL };
+    sysfs_operations_t reset_ops = { NULL, syscall_sysfs_write_reset };
+    
+    sysfs_entry_t *dir = sysfs_create_dir(sysfs, "syscalls", parent);
+    if (!dir) return -1;
+    
+    if (!sysfs_create_file(sysfs, "enable", dir, &enable_ops) ||
+        !sysfs_create_file(sysfs, "stats", dir, &stats_ops) ||
+        !sysfs_create_file(sysfs, "reset", dir, &reset_ops)) {
+        return -1;
+    }
+    
+    return 0;
 }
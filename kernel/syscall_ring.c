@@ -0,0 +1,527 @@
+#include <kernel/syscall_ring.h>
+#include <kernel/syscalls.h>
+#include <kernel/filesystem.h>
+#include <kernel/network.h>
+#include <kernel/ipc_bus.h>
+#include <kernel/process.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Submission/completion rings shared between a process and the kernel.
+ * The process fills SQEs and advances sq.tail; the kernel consumes them
+ * either in syscall_ring_enter() or, with SYSCALL_RING_SQPOLL, from a
+ * poller thread that only sleeps (and sets SQ_NEED_WAKEUP) after the
+ * ring has been idle for SYSCALL_RING_POLL_IDLE_NS.
+ *
+ * SQEs are copied out before sq.head moves, and an SQE is only consumed
+ * when its completion is guaranteed a CQ slot, so the CQ never overflows.
+ * A chain of SQE_F_LINK entries runs in order; a failure cancels the rest
+ * of the chain, while a timeout defers the rest until it expires. A chain
+ * longer than SYSCALL_RING_MAX_LINK is rejected whole with -EINVAL.
+ */
+#define SYSCALL_RING_MAX_LINK 32
+
+typedef struct {
+    ktimer_t timer;
+    syscall_ring_t *ring;
+    u64 user_data;
+    u32 count;
+    syscall_sqe_t sqes[];
+} syscall_ring_link_t;
+
+static void syscall_ring_run_chain(syscall_ring_t *ring, const syscall_sqe_t *sqes, u32 count);
+
+static u32 syscall_ring_round_entries(u32 entries)
+{
+    u32 rounded = 1;
+    while (rounded < entries) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static void syscall_ring_post_cqe(syscall_ring_t *ring, u64 user_data, s32 res)
+{
+    syscall_ring_queue_t *cq = &ring->header->cq;
+
+    spin_lock(&ring->cq_lock);
+    u32 tail = cq->tail;
+    syscall_cqe_t *cqe = &ring->cqes[tail & cq->mask];
+    cqe->user_data = user_data;
+    cqe->res = res;
+    cqe->flags = 0;
+    __atomic_store_n(&cq->tail, tail + 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&ring->stats.completed, 1, __ATOMIC_RELAXED);
+
+    /* Still under cq_lock, so destroy cannot free the ring before the wake is done. */
+    __atomic_sub_fetch(&ring->inflight, 1, __ATOMIC_ACQ_REL);
+    wait_queue_wake_all(&ring->cq_wait);
+    spin_unlock(&ring->cq_lock);
+}
+
+static void syscall_ring_cancel(syscall_ring_t *ring, const syscall_sqe_t *sqes, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        syscall_ring_post_cqe(ring, sqes[i].user_data, -ECANCELED);
+    }
+    __atomic_add_fetch(&ring->stats.cancelled, count, __ATOMIC_RELAXED);
+}
+
+/*
+ * Turn a buffer in the ring owner's address space into a kernel pointer.
+ * Every page must be mapped with 'prot' and backed contiguously, as
+ * shared memory and granted ranges are.
+ */
+static void *syscall_ring_user_ptr(syscall_ring_t *ring, u64 addr, u64 len, prot_flags_t prot)
+{
+    if (len == 0) len = 1;
+    if (addr + len < addr) return NULL;
+
+    u64 first = addr & PAGE_MASK;
+    u64 base = 0;
+
+    for (u64 page = first; page < addr + len; page += PAGE_SIZE) {
+        vma_t *vma = mmgr_find_vma(ring->as, page);
+        if (!vma || (vma->prot & prot) != prot) return NULL;
+
+        if (page == first) {
+            base = vma->phys_addr;
+        } else if (vma->phys_addr != base + (page - first)) {
+            return NULL;
+        }
+    }
+
+    return (void *)(uintptr_t)(base + (addr - first));
+}
+
+static s32 syscall_ring_issue(syscall_ring_t *ring, const syscall_sqe_t *sqe)
+{
+    void *file = NULL;
+    void *addr = NULL;
+    int res;
+
+    if (sqe->opcode >= SQE_OP_READ && sqe->opcode <= SQE_OP_RECV) {
+        if (sqe->fd < 0 || sqe->fd >= SYSCALL_RING_MAX_FILES) return -EBADF;
+        file = __atomic_load_n(&ring->files[sqe->fd], __ATOMIC_ACQUIRE);
+        if (!file) return -EBADF;
+
+        bool to_user = sqe->opcode == SQE_OP_READ || sqe->opcode == SQE_OP_RECV;
+        addr = syscall_ring_user_ptr(ring, sqe->addr, sqe->len, to_user ? PROT_WRITE : PROT_READ);
+        if (!addr) return -EFAULT;
+    } else if (sqe->opcode == SQE_OP_BUS_SEND) {
+        addr = syscall_ring_user_ptr(ring, sqe->addr, sizeof(ipc_message_t), PROT_READ);
+        if (!addr) return -EFAULT;
+    }
+
+    switch (sqe->opcode) {
+        case SQE_OP_NOP:
+            return 0;
+        case SQE_OP_READ:
+            res = aegisfs_read((inode_t *)file, sqe->off, addr, sqe->len);
+            break;
+        case SQE_OP_WRITE:
+            res = aegisfs_write((inode_t *)file, sqe->off, addr, sqe->len);
+            break;
+        case SQE_OP_SEND:
+            res = network_send((socket_t *)file, addr, sqe->len);
+            break;
+        case SQE_OP_RECV:
+            res = network_receive((socket_t *)file, addr, sqe->len);
+            break;
+        case SQE_OP_BUS_SEND:
+            res = ipc_bus_send_message((const ipc_message_t *)addr);
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    return res < 0 ? -EIO : res;
+}
+
+static void syscall_ring_timeout_fn(ktimer_t *timer)
+{
+    syscall_ring_link_t *link = (syscall_ring_link_t *)timer->data;
+
+    syscall_ring_post_cqe(link->ring, link->user_data, -ETIME);
+    syscall_ring_run_chain(link->ring, link->sqes, link->count);
+    free(link);
+}
+
+/* Arm a timeout; whatever is linked behind it runs from the timer once it expires. */
+static int syscall_ring_arm_timeout(syscall_ring_t *ring, const syscall_sqe_t *sqe,
+                                    const syscall_sqe_t *rest, u32 count)
+{
+    syscall_ring_link_t *link = (syscall_ring_link_t *)malloc(sizeof(syscall_ring_link_t) +
+                                                              count * sizeof(syscall_sqe_t));
+    if (!link) return -1;
+
+    link->ring = ring;
+    link->user_data = sqe->user_data;
+    link->count = count;
+    memcpy(link->sqes, rest, count * sizeof(syscall_sqe_t));
+
+    timer_setup(&link->timer, syscall_ring_timeout_fn, link);
+    timer_mod(&link->timer, timer_now_ns() + sqe->off);
+    return 0;
+}
+
+static void syscall_ring_run_chain(syscall_ring_t *ring, const syscall_sqe_t *sqes, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        const syscall_sqe_t *sqe = &sqes[i];
+
+        if (sqe->opcode == SQE_OP_TIMEOUT) {
+            if (syscall_ring_arm_timeout(ring, sqe, sqes + i + 1, count - i - 1) != 0) {
+                syscall_ring_post_cqe(ring, sqe->user_data, -ENOMEM);
+                syscall_ring_cancel(ring, sqes + i + 1, count - i - 1);
+            }
+            return;
+        }
+
+        s32 res = syscall_ring_issue(ring, sqe);
+        syscall_ring_post_cqe(ring, sqe->user_data, res);
+        if (res < 0) {
+            syscall_ring_cancel(ring, sqes + i + 1, count - i - 1);
+            return;
+        }
+    }
+}
+
+static u32 syscall_ring_cq_space(syscall_ring_t *ring)
+{
+    syscall_ring_queue_t *cq = &ring->header->cq;
+
+    /*
+     * Read inflight before the tail so a racing completion is counted at
+     * least once; it may be counted twice, so clamp rather than wrap.
+     */
+    u32 inflight = __atomic_load_n(&ring->inflight, __ATOMIC_ACQUIRE);
+    u32 used = __atomic_load_n(&cq->tail, __ATOMIC_ACQUIRE) -
+               __atomic_load_n(&cq->head, __ATOMIC_ACQUIRE);
+
+    if (used + inflight >= cq->entries) return 0;
+    return cq->entries - used - inflight;
+}
+
+/* Complete every SQE of an over-long chain with -EINVAL; none of it runs. */
+static void syscall_ring_reject(syscall_ring_t *ring, u32 head, u32 count)
+{
+    syscall_ring_queue_t *sq = &ring->header->sq;
+
+    for (u32 i = 0; i < count; i++) {
+        syscall_ring_post_cqe(ring, ring->sqes[(head + i) & sq->mask].user_data, -EINVAL);
+    }
+}
+
+/* Consume up to 'max' SQEs, one chain at a time. Returns how many were consumed. */
+static u32 syscall_ring_submit_sqes(syscall_ring_t *ring, u32 max)
+{
+    syscall_ring_queue_t *sq = &ring->header->sq;
+    syscall_sqe_t chain[SYSCALL_RING_MAX_LINK];
+    u32 submitted = 0;
+
+    spin_lock(&ring->sq_lock);
+    while (submitted < max) {
+        u32 head = sq->head;
+        u32 avail = __atomic_load_n(&sq->tail, __ATOMIC_ACQUIRE) - head;
+        if (avail > max - submitted) avail = max - submitted;
+        if (avail == 0) break;
+
+        u32 count = 0;
+        bool linked = true;
+        while (count < avail && linked) {
+            syscall_sqe_t sqe = ring->sqes[(head + count) & sq->mask];
+            if (count < SYSCALL_RING_MAX_LINK) {
+                chain[count] = sqe;
+            }
+            linked = sqe.flags & SQE_F_LINK;
+            count++;
+        }
+
+        if (syscall_ring_cq_space(ring) < count) break;
+
+        __atomic_add_fetch(&ring->inflight, count, __ATOMIC_RELAXED);
+        if (count > SYSCALL_RING_MAX_LINK) {
+            syscall_ring_reject(ring, head, count);
+            __atomic_store_n(&sq->head, head + count, __ATOMIC_RELEASE);
+        } else {
+            __atomic_store_n(&sq->head, head + count, __ATOMIC_RELEASE);
+            syscall_ring_run_chain(ring, chain, count);
+        }
+        submitted += count;
+    }
+    spin_unlock(&ring->sq_lock);
+
+    if (submitted) {
+        __atomic_add_fetch(&ring->stats.submitted, submitted, __ATOMIC_RELAXED);
+    }
+    return submitted;
+}
+
+static bool syscall_ring_sq_ready(void *arg)
+{
+    syscall_ring_t *ring = (syscall_ring_t *)arg;
+    syscall_ring_queue_t *sq = &ring->header->sq;
+
+    if (__atomic_load_n(&ring->stopping, __ATOMIC_ACQUIRE)) return true;
+    return __atomic_load_n(&sq->tail, __ATOMIC_SEQ_CST) != sq->head &&
+           syscall_ring_cq_space(ring) > 0;
+}
+
+static int syscall_ring_poll_main(void *arg)
+{
+    syscall_ring_t *ring = (syscall_ring_t *)arg;
+    syscall_ring_queue_t *sq = &ring->header->sq;
+    u64 idle_since = timer_now_ns();
+    u32 spins = 0;
+
+    while (!__atomic_load_n(&ring->stopping, __ATOMIC_ACQUIRE)) {
+        if (syscall_ring_submit_sqes(ring, (u32)-1) > 0) {
+            idle_since = timer_now_ns();
+            spins = 0;
+            continue;
+        }
+
+        if (timer_now_ns() - idle_since < SYSCALL_RING_POLL_IDLE_NS) {
+            lock_spin_wait(&spins);
+            continue;
+        }
+
+        __atomic_or_fetch(&sq->flags, SYSCALL_RING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&ring->stats.poller_sleeps, 1, __ATOMIC_RELAXED);
+        wait_queue_wait(&ring->sq_wait, NULL, syscall_ring_sq_ready, ring, 0);
+        __atomic_and_fetch(&sq->flags, ~SYSCALL_RING_SQ_NEED_WAKEUP, __ATOMIC_RELAXED);
+        idle_since = timer_now_ns();
+    }
+
+    return 0;
+}
+
+syscall_ring_t *syscall_ring_create(u64 pid, u32 entries, u32 flags)
+{
+    if (entries == 0 || entries > SYSCALL_RING_MAX_ENTRIES) return NULL;
+
+    u32 sq_entries = syscall_ring_round_entries(entries);
+    u32 cq_entries = sq_entries * 2;
+    u64 size = sizeof(syscall_ring_header_t) + sq_entries * sizeof(syscall_sqe_t) +
+               cq_entries * sizeof(syscall_cqe_t);
+
+    if (timer_init() != 0) return NULL;
+
+    process_t *proc = pmgr_get_process(pid);
+    if (!proc) return NULL;
+
+    ipc_object_t *shm = ipc_create_shared_memory(pid, size);
+    if (!shm) return NULL;
+
+    syscall_ring_t *ring = (syscall_ring_t *)calloc(1, sizeof(syscall_ring_t));
+    if (!ring) {
+        ipc_destroy_shared_memory(shm);
+        return NULL;
+    }
+
+    syscall_ring_header_t *header = (syscall_ring_header_t *)shm->data.shm.memory;
+    memset(header, 0, size);
+    header->magic = SYSCALL_RING_MAGIC;
+    header->flags = flags;
+    header->sqes_off = sizeof(syscall_ring_header_t);
+    header->cqes_off = header->sqes_off + sq_entries * sizeof(syscall_sqe_t);
+    header->sq.entries = sq_entries;
+    header->sq.mask = sq_entries - 1;
+    header->cq.entries = cq_entries;
+    header->cq.mask = cq_entries - 1;
+
+    ring->shm = shm;
+    ring->header = header;
+    ring->sqes = (syscall_sqe_t *)((u8 *)header + header->sqes_off);
+    ring->cqes = (syscall_cqe_t *)((u8 *)header + header->cqes_off);
+    ring->pid = pid;
+    ring->as = (address_space_t *)proc->page_table;
+    ring->flags = flags;
+    spin_lock_init(&ring->sq_lock);
+    spin_lock_init(&ring->cq_lock);
+    wait_queue_init(&ring->sq_wait);
+    wait_queue_init(&ring->cq_wait);
+
+    if (ipc_map_shared_memory(shm, pid, IPC_GRANT_READ | IPC_GRANT_WRITE, &ring->virt_addr) != 0) {
+        ipc_destroy_shared_memory(shm);
+        free(ring);
+        return NULL;
+    }
+
+    if (flags & SYSCALL_RING_SQPOLL) {
+        char name[KTHREAD_NAME_LEN];
+        snprintf(name, sizeof(name), "sqpoll/%llu", (unsigned long long)shm->id);
+        ring->poller = kthread_run(name, syscall_ring_poll_main, ring);
+        if (!ring->poller) {
+            ipc_destroy_shared_memory(shm);
+            free(ring);
+            return NULL;
+        }
+    }
+
+    return ring;
+}
+
+static bool syscall_ring_idle(void *arg)
+{
+    return __atomic_load_n(&((syscall_ring_t *)arg)->inflight, __ATOMIC_ACQUIRE) == 0;
+}
+
+/* Stops the poller and waits for pending timeouts (and their chains) to complete. */
+void syscall_ring_destroy(syscall_ring_t *ring)
+{
+    if (!ring) return;
+
+    if (ring->poller) {
+        __atomic_store_n(&ring->stopping, 1, __ATOMIC_RELEASE);
+        wait_queue_wake_all(&ring->sq_wait);
+        kthread_stop(ring->poller);
+    }
+
+    wait_queue_wait(&ring->cq_wait, NULL, syscall_ring_idle, ring, 0);
+    spin_lock(&ring->cq_lock);
+    spin_unlock(&ring->cq_lock);
+
+    ipc_destroy_shared_memory(ring->shm);
+    free(ring);
+}
+
+int syscall_ring_register_files(syscall_ring_t *ring, void **files, u32 count)
+{
+    if (!ring || (!files && count) || count > SYSCALL_RING_MAX_FILES) return -1;
+
+    spin_lock(&ring->sq_lock);
+    for (u32 i = 0; i < SYSCALL_RING_MAX_FILES; i++) {
+        __atomic_store_n(&ring->files[i], i < count ? files[i] : NULL, __ATOMIC_RELEASE);
+    }
+    spin_unlock(&ring->sq_lock);
+
+    return 0;
+}
+
+syscall_sqe_t *syscall_ring_get_sqe(syscall_ring_t *ring)
+{
+    if (!ring) return NULL;
+
+    syscall_ring_queue_t *sq = &ring->header->sq;
+    if (ring->sqe_tail - __atomic_load_n(&sq->head, __ATOMIC_ACQUIRE) >= sq->entries) {
+        return NULL;
+    }
+
+    return &ring->sqes[ring->sqe_tail++ & sq->mask];
+}
+
+/*
+ * Publish the SQEs handed out by syscall_ring_get_sqe(). With a poller
+ * this only enters the kernel when the poller has gone to sleep.
+ */
+int syscall_ring_submit(syscall_ring_t *ring)
+{
+    if (!ring) return -EINVAL;
+
+    syscall_ring_queue_t *sq = &ring->header->sq;
+    u32 pending = ring->sqe_tail - sq->tail;
+
+    __atomic_store_n(&sq->tail, ring->sqe_tail, __ATOMIC_SEQ_CST);
+
+    if (ring->flags & SYSCALL_RING_SQPOLL) {
+        if (__atomic_load_n(&sq->flags, __ATOMIC_SEQ_CST) & SYSCALL_RING_SQ_NEED_WAKEUP) {
+            syscall_ring_enter(ring, 0, 0, SYSCALL_RING_ENTER_SQ_WAKEUP);
+        }
+        return (int)pending;
+    }
+
+    return syscall_ring_enter(ring, pending, 0, 0);
+}
+
+typedef struct {
+    syscall_ring_t *ring;
+    u32 min_complete;
+} syscall_ring_wait_t;
+
+static bool syscall_ring_cq_ready(void *arg)
+{
+    syscall_ring_wait_t *wait = (syscall_ring_wait_t *)arg;
+    syscall_ring_queue_t *cq = &wait->ring->header->cq;
+
+    return __atomic_load_n(&cq->tail, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&cq->head, __ATOMIC_ACQUIRE) >= wait->min_complete;
+}
+
+/*
+ * The ring's system call: consume up to 'to_submit' SQEs (or wake the
+ * poller) and, with ENTER_GETEVENTS, wait for 'min_complete' CQEs.
+ * Returns the number of SQEs consumed.
+ */
+int syscall_ring_enter(syscall_ring_t *ring, u32 to_submit, u32 min_complete, u32 flags)
+{
+    if (!ring) return -EINVAL;
+
+    __atomic_add_fetch(&ring->stats.enters, 1, __ATOMIC_RELAXED);
+
+    int submitted = 0;
+    if (ring->flags & SYSCALL_RING_SQPOLL) {
+        bool asleep = __atomic_load_n(&ring->header->sq.flags, __ATOMIC_SEQ_CST) &
+                      SYSCALL_RING_SQ_NEED_WAKEUP;
+        if ((flags & SYSCALL_RING_ENTER_SQ_WAKEUP) ||
+            (asleep && (flags & SYSCALL_RING_ENTER_GETEVENTS))) {
+            __atomic_add_fetch(&ring->stats.poller_wakeups, 1, __ATOMIC_RELAXED);
+            wait_queue_wake_all(&ring->sq_wait);
+        }
+    } else if (to_submit) {
+        submitted = (int)syscall_ring_submit_sqes(ring, to_submit);
+    }
+
+    if ((flags & SYSCALL_RING_ENTER_GETEVENTS) && min_complete) {
+        syscall_ring_wait_t wait = { .ring = ring, .min_complete = min_complete };
+        wait_queue_wait(&ring->cq_wait, NULL, syscall_ring_cq_ready, &wait, 0);
+    }
+
+    return submitted;
+}
+
+syscall_cqe_t *syscall_ring_peek_cqe(syscall_ring_t *ring)
+{
+    if (!ring) return NULL;
+
+    syscall_ring_queue_t *cq = &ring->header->cq;
+    u32 head = cq->head;
+    if (head == __atomic_load_n(&cq->tail, __ATOMIC_ACQUIRE)) return NULL;
+
+    return &ring->cqes[head & cq->mask];
+}
+
+void syscall_ring_cqe_seen(syscall_ring_t *ring)
+{
+    if (!ring) return;
+
+    syscall_ring_queue_t *cq = &ring->header->cq;
+    __atomic_store_n(&cq->head, cq->head + 1, __ATOMIC_RELEASE);
+}
+
+int syscall_ring_wait_cqe(syscall_ring_t *ring, syscall_cqe_t **cqe)
+{
+    if (!ring || !cqe) return -EINVAL;
+
+    while (!(*cqe = syscall_ring_peek_cqe(ring))) {
+        syscall_ring_enter(ring, 0, 1, SYSCALL_RING_ENTER_GETEVENTS);
+    }
+
+    return 0;
+}
+
+int syscall_ring_get_stats(syscall_ring_t *ring, syscall_ring_stats_t *stats)
+{
+    if (!ring || !stats) return -1;
+
+    stats->submitted = __atomic_load_n(&ring->stats.submitted, __ATOMIC_RELAXED);
+    stats->completed = __atomic_load_n(&ring->stats.completed, __ATOMIC_RELAXED);
+    stats->cancelled = __atomic_load_n(&ring->stats.cancelled, __ATOMIC_RELAXED);
+    stats->enters = __atomic_load_n(&ring->stats.enters, __ATOMIC_RELAXED);
+    stats->poller_wakeups = __atomic_load_n(&ring->stats.poller_wakeups, __ATOMIC_RELAXED);
+    stats->poller_sleeps = __atomic_load_n(&ring->stats.poller_sleeps, __ATOMIC_RELAXED);
+    return 0;
+}
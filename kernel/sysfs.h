@@ -43,7 +43,7 @@ typedef struct sysfs_entry {
     size_t observer_count;
 } sysfs_entry_t;
 
-typedef struct {
+typedef struct sysfs {
     sysfs_entry_t *root;
     sysfs_entry_t **entries;
     size_t entry_count;
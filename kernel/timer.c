@@ -0,0 +1,185 @@
+#include <kernel/timer.h>
+#include <kernel/wait_queue.h>
+#include <kernel/kthread.h>
+#include <stddef.h>
+
+/*
+ * One-shot kernel timers on a list sorted by expiry. Expired timers are
+ * run by ktimerd, which sleeps until the earliest deadline and stands in
+ * for the clock-event interrupt until the arch timers drive this directly.
+ * Callbacks run without the timer lock held and may re-arm their timer.
+ */
+typedef struct {
+    ktimer_t *head;
+    spinlock_t lock;
+    u32 seq;
+    u32 stopping;
+    kthread_t *thread;
+    wait_queue_t wait;
+} timer_base_t;
+
+static timer_base_t timer_base;
+
+static void timer_lock(void)
+{
+    spin_lock(&timer_base.lock);
+}
+
+static void timer_unlock(void)
+{
+    spin_unlock(&timer_base.lock);
+}
+
+u64 timer_now_ns(void)
+{
+    return wait_queue_now_ns();
+}
+
+void timer_setup(ktimer_t *timer, ktimer_fn_t fn, void *data)
+{
+    if (!timer) return;
+
+    timer->next = NULL;
+    timer->expires_ns = 0;
+    timer->fn = fn;
+    timer->data = data;
+    timer->pending = 0;
+}
+
+static int timer_unlink_locked(ktimer_t *timer)
+{
+    ktimer_t **link = &timer_base.head;
+
+    while (*link) {
+        if (*link == timer) {
+            *link = timer->next;
+            timer->next = NULL;
+            __atomic_store_n(&timer->pending, 0, __ATOMIC_RELEASE);
+            return 1;
+        }
+        link = &(*link)->next;
+    }
+
+    return 0;
+}
+
+/* Arm (or re-arm) 'timer' for the absolute time 'expires_ns'. Returns 1 if it was pending. */
+int timer_mod(ktimer_t *timer, u64 expires_ns)
+{
+    if (!timer || !timer->fn) return -1;
+
+    timer_lock();
+    int was_pending = timer_unlink_locked(timer);
+
+    ktimer_t **link = &timer_base.head;
+    while (*link && (*link)->expires_ns <= expires_ns) {
+        link = &(*link)->next;
+    }
+
+    timer->expires_ns = expires_ns;
+    timer->next = *link;
+    *link = timer;
+    __atomic_store_n(&timer->pending, 1, __ATOMIC_RELEASE);
+
+    bool first = timer_base.head == timer;
+    timer_unlock();
+
+    if (first) {
+        __atomic_add_fetch(&timer_base.seq, 1, __ATOMIC_RELEASE);
+        wait_queue_wake_all(&timer_base.wait);
+    }
+
+    return was_pending;
+}
+
+/* Disarm 'timer'. Returns 1 if it was pending, 0 if it had fired or was never armed. */
+int timer_del(ktimer_t *timer)
+{
+    if (!timer) return -1;
+
+    timer_lock();
+    int was_pending = timer_unlink_locked(timer);
+    timer_unlock();
+
+    return was_pending;
+}
+
+bool timer_pending(const ktimer_t *timer)
+{
+    return timer && __atomic_load_n(&timer->pending, __ATOMIC_ACQUIRE);
+}
+
+u32 timer_run_expired(u64 now_ns)
+{
+    u32 ran = 0;
+
+    for (;;) {
+        timer_lock();
+        ktimer_t *timer = timer_base.head;
+        if (!timer || timer->expires_ns > now_ns) {
+            timer_unlock();
+            break;
+        }
+        timer_base.head = timer->next;
+        timer->next = NULL;
+        __atomic_store_n(&timer->pending, 0, __ATOMIC_RELEASE);
+        timer_unlock();
+
+        timer->fn(timer);
+        ran++;
+    }
+
+    return ran;
+}
+
+static bool timer_should_wake(void *arg)
+{
+    return __atomic_load_n(&timer_base.seq, __ATOMIC_ACQUIRE) != *(u32 *)arg ||
+           __atomic_load_n(&timer_base.stopping, __ATOMIC_ACQUIRE);
+}
+
+static int timer_thread_main(void *arg)
+{
+    while (!__atomic_load_n(&timer_base.stopping, __ATOMIC_ACQUIRE)) {
+        u32 seq = __atomic_load_n(&timer_base.seq, __ATOMIC_ACQUIRE);
+        u64 now = timer_now_ns();
+
+        timer_run_expired(now);
+
+        timer_lock();
+        u64 next = timer_base.head ? timer_base.head->expires_ns : 0;
+        timer_unlock();
+
+        u64 timeout = 0;
+        if (next) {
+            now = timer_now_ns();
+            timeout = next > now ? next - now : 1;
+        }
+        wait_queue_wait(&timer_base.wait, NULL, timer_should_wake, &seq, timeout);
+    }
+
+    return 0;
+}
+
+int timer_init(void)
+{
+    if (timer_base.thread) return 0;
+
+    timer_base.head = NULL;
+    spin_lock_init(&timer_base.lock);
+    timer_base.stopping = 0;
+    wait_queue_init(&timer_base.wait);
+
+    timer_base.thread = kthread_run("ktimerd", timer_thread_main, NULL);
+    return timer_base.thread ? 0 : -1;
+}
+
+void timer_shutdown(void)
+{
+    if (!timer_base.thread) return;
+
+    __atomic_store_n(&timer_base.stopping, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&timer_base.wait);
+    kthread_stop(timer_base.thread);
+    timer_base.thread = NULL;
+}
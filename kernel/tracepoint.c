@@ -0,0 +1,151 @@
+#define _GNU_SOURCE
+#include <kernel/tracepoint.h>
+#include <kernel/percpu.h>
+#include <kernel/wait_queue.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Records go into a fixed per-CPU ring that overwrites its oldest entry,
+ * the same way the profiler's sample rings work; a reader racing a
+ * writer on the same slot can see a torn record.
+ */
+
+typedef struct {
+    u64 head;
+    trace_record_t ring[TRACE_RING_SIZE];
+} trace_cpu_t;
+
+static DEFINE_PER_CPU(trace_cpu_t, trace_cpu);
+
+static __thread u32 trace_tid;
+
+static u32 trace_sites(tracepoint_t ***start)
+{
+    *start = __start_aegis_tracepoints;
+    if (!__start_aegis_tracepoints || !__stop_aegis_tracepoints) return 0;
+    return (u32)(__stop_aegis_tracepoints - __start_aegis_tracepoints);
+}
+
+void trace_emit(tracepoint_t *tp, const u64 *args, u32 nargs)
+{
+    if (!trace_tid) trace_tid = (u32)syscall(SYS_gettid);
+    if (nargs > TRACE_MAX_ARGS) nargs = TRACE_MAX_ARGS;
+
+    trace_cpu_t *cpu = this_cpu_ptr(trace_cpu);
+    u64 pos = __atomic_fetch_add(&cpu->head, 1, __ATOMIC_RELAXED);
+    trace_record_t *record = &cpu->ring[pos & (TRACE_RING_SIZE - 1)];
+
+    __atomic_store_n(&record->timestamp, wait_queue_now_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&record->tp, tp, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->tid, trace_tid, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->nargs, nargs, __ATOMIC_RELAXED);
+    for (u32 i = 0; i < nargs; i++) {
+        __atomic_store_n(&record->args[i], args[i], __ATOMIC_RELAXED);
+    }
+
+    __atomic_add_fetch(&tp->hits, 1, __ATOMIC_RELAXED);
+}
+
+static bool trace_match(const tracepoint_t *tp, const char *subsys, const char *name)
+{
+    if (subsys && strcmp(tp->subsys, subsys) != 0) return false;
+    return !name || strcmp(name, "*") == 0 || strcmp(tp->name, name) == 0;
+}
+
+static int trace_set(const char *subsys, const char *name, u32 enabled)
+{
+    tracepoint_t **sites;
+    u32 count = trace_sites(&sites);
+    int matched = 0;
+
+    if (!subsys) return -1;
+
+    for (u32 i = 0; i < count; i++) {
+        if (sites[i] && trace_match(sites[i], subsys, name)) {
+            __atomic_store_n(&sites[i]->enabled, enabled, __ATOMIC_RELAXED);
+            matched++;
+        }
+    }
+
+    return matched;
+}
+
+int trace_enable(const char *subsys, const char *name)
+{
+    return trace_set(subsys, name, 1);
+}
+
+int trace_disable(const char *subsys, const char *name)
+{
+    return trace_set(subsys, name, 0);
+}
+
+void trace_disable_all(void)
+{
+    tracepoint_t **sites;
+    u32 count = trace_sites(&sites);
+
+    for (u32 i = 0; i < count; i++) {
+        if (sites[i]) __atomic_store_n(&sites[i]->enabled, 0, __ATOMIC_RELAXED);
+    }
+}
+
+tracepoint_t *trace_find(const char *subsys, const char *name)
+{
+    tracepoint_t **sites;
+    u32 count = trace_sites(&sites);
+
+    if (!subsys || !name) return NULL;
+
+    for (u32 i = 0; i < count; i++) {
+        if (sites[i] && trace_match(sites[i], subsys, name)) return sites[i];
+    }
+
+    return NULL;
+}
+
+u32 trace_list(tracepoint_t **tps, u32 max)
+{
+    tracepoint_t **sites;
+    u32 count = trace_sites(&sites);
+
+    if (!tps) return count;
+
+    u32 n = 0;
+    for (u32 i = 0; i < count && n < max; i++) {
+        if (sites[i]) tps[n++] = sites[i];
+    }
+
+    return n;
+}
+
+u32 trace_read(u32 cpu, trace_record_t *records, u32 max)
+{
+    if (!records || cpu >= percpu_nr_cpus()) return 0;
+
+    trace_cpu_t *pcpu = per_cpu_ptr(trace_cpu, cpu);
+    u64 head = __atomic_load_n(&pcpu->head, __ATOMIC_RELAXED);
+    u64 available = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+    u32 count = available < max ? (u32)available : max;
+
+    for (u32 i = 0; i < count; i++) {
+        trace_record_t *record = &pcpu->ring[(head - count + i) & (TRACE_RING_SIZE - 1)];
+
+        records[i].timestamp = __atomic_load_n(&record->timestamp, __ATOMIC_RELAXED);
+        records[i].tp = __atomic_load_n(&record->tp, __ATOMIC_RELAXED);
+        records[i].tid = __atomic_load_n(&record->tid, __ATOMIC_RELAXED);
+        records[i].nargs = __atomic_load_n(&record->nargs, __ATOMIC_RELAXED);
+        for (u32 arg = 0; arg < TRACE_MAX_ARGS; arg++) {
+            records[i].args[arg] = __atomic_load_n(&record->args[arg], __ATOMIC_RELAXED);
+        }
+    }
+
+    return count;
+}
+
+void trace_clear(void)
+{
+    per_cpu_reset(trace_cpu);
+}
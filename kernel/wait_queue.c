@@ -0,0 +1,201 @@
+#include <kernel/wait_queue.h>
+#include <sched.h>
+#include <time.h>
+
+/*
+ * FIFO wait queues. Waiters link an on-stack entry under the queue lock,
+ * then park until a waker unlinks it and sets 'woken'. The waker never
+ * touches the entry after that store, so the sleeper may return and reuse
+ * its stack as soon as it observes the flag.
+ *
+ * Waiters are counted before they check their condition and wakers fence
+ * before reading the count, so a wake with no queued waiters can skip the
+ * lock without losing a concurrent sleeper.
+ *
+ * Threads do not have switchable contexts yet, so parking yields the host
+ * CPU instead of calling into the scheduler; the thread state is still
+ * tracked so the scheduler sees blocked waiters.
+ */
+
+#define WAIT_QUEUE_PARK_SPINS 64
+
+void wait_queue_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+u64 wait_queue_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+void wait_queue_init(wait_queue_t *wq)
+{
+    if (!wq) return;
+
+    spin_lock_init(&wq->lock);
+    wq->waiters = 0;
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+void wait_queue_lock(wait_queue_t *wq)
+{
+    spin_lock(&wq->lock);
+}
+
+void wait_queue_unlock(wait_queue_t *wq)
+{
+    spin_unlock(&wq->lock);
+}
+
+void wait_queue_add_locked(wait_queue_t *wq, wait_queue_entry_t *entry)
+{
+    entry->woken = 0;
+    entry->next = NULL;
+    entry->prev = wq->tail;
+
+    if (wq->tail) {
+        wq->tail->next = entry;
+    } else {
+        wq->head = entry;
+    }
+    wq->tail = entry;
+    __atomic_add_fetch(&wq->waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void wait_queue_remove_locked(wait_queue_t *wq, wait_queue_entry_t *entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        wq->head = entry->next;
+    }
+
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        wq->tail = entry->prev;
+    }
+
+    entry->next = NULL;
+    entry->prev = NULL;
+    __atomic_sub_fetch(&wq->waiters, 1, __ATOMIC_RELAXED);
+}
+
+int wait_queue_sleep(wait_queue_t *wq, wait_queue_entry_t *entry, u64 timeout_ns)
+{
+    if (!wq || !entry) return -1;
+
+    u64 deadline = timeout_ns ? wait_queue_now_ns() + timeout_ns : 0;
+    u32 spins = 0;
+
+    if (entry->thread) {
+        entry->thread->state = PROCESS_STATE_BLOCKED;
+    }
+
+    while (!__atomic_load_n(&entry->woken, __ATOMIC_ACQUIRE)) {
+        if (spins < WAIT_QUEUE_PARK_SPINS) {
+            spins++;
+            wait_queue_cpu_relax();
+            continue;
+        }
+
+        if (deadline && wait_queue_now_ns() >= deadline) {
+            wait_queue_lock(wq);
+            bool woken = __atomic_load_n(&entry->woken, __ATOMIC_ACQUIRE);
+            if (!woken) {
+                wait_queue_remove_locked(wq, entry);
+            }
+            wait_queue_unlock(wq);
+
+            if (entry->thread) {
+                entry->thread->state = PROCESS_STATE_RUNNING;
+            }
+            return woken ? 0 : WAIT_QUEUE_TIMEOUT;
+        }
+
+        sched_yield();
+    }
+
+    if (entry->thread) {
+        entry->thread->state = PROCESS_STATE_RUNNING;
+    }
+    return 0;
+}
+
+int wait_queue_wait(wait_queue_t *wq, thread_t *thread, wait_queue_cond_t cond,
+                    void *arg, u64 timeout_ns)
+{
+    if (!wq || !cond) return -1;
+
+    u64 deadline = timeout_ns ? wait_queue_now_ns() + timeout_ns : 0;
+
+    for (;;) {
+        wait_queue_entry_t entry = { .thread = thread, .key = 0 };
+
+        wait_queue_lock(wq);
+        wait_queue_add_locked(wq, &entry);
+        if (cond(arg)) {
+            wait_queue_remove_locked(wq, &entry);
+            wait_queue_unlock(wq);
+            return 0;
+        }
+        wait_queue_unlock(wq);
+
+        u64 remaining = 0;
+        if (deadline) {
+            u64 now = wait_queue_now_ns();
+            remaining = (now < deadline) ? deadline - now : 1;
+        }
+
+        if (wait_queue_sleep(wq, &entry, remaining) == WAIT_QUEUE_TIMEOUT) {
+            return cond(arg) ? 0 : WAIT_QUEUE_TIMEOUT;
+        }
+    }
+}
+
+u32 wait_queue_wake_key(wait_queue_t *wq, uintptr_t key, u32 count)
+{
+    if (!wq) return 0;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&wq->waiters, __ATOMIC_RELAXED)) return 0;
+
+    u32 woken = 0;
+
+    wait_queue_lock(wq);
+    wait_queue_entry_t *entry = wq->head;
+    while (entry && woken < count) {
+        wait_queue_entry_t *next = entry->next;
+
+        if (key == 0 || entry->key == key) {
+            wait_queue_remove_locked(wq, entry);
+            if (entry->thread) {
+                entry->thread->state = PROCESS_STATE_READY;
+            }
+            __atomic_store_n(&entry->woken, 1, __ATOMIC_RELEASE);
+            woken++;
+        }
+
+        entry = next;
+    }
+    wait_queue_unlock(wq);
+
+    return woken;
+}
+
+u32 wait_queue_wake(wait_queue_t *wq, u32 count)
+{
+    return wait_queue_wake_key(wq, 0, count);
+}
+
+u32 wait_queue_wake_all(wait_queue_t *wq)
+{
+    return wait_queue_wake_key(wq, 0, (u32)-1);
+}
@@ -0,0 +1,503 @@
+#include <kernel/workqueue.h>
+#include <kernel/wait_queue.h>
+#include <kernel/kthread.h>
+#include <kernel/interrupt.h>
+#include <kernel/percpu.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Work items are queued on worker pools. A bound workqueue has one pool
+ * per CPU, an unbound workqueue a single shared pool; each pool runs
+ * 'max_active' kworker threads, which is also its concurrency limit.
+ * A work item is queued at most once at a time (WORK_PENDING), but once
+ * it starts running it may be queued again and, on a pool with several
+ * workers, run concurrently with itself. Running instances are tracked in
+ * the pool's 'current' slots, never in the item, so a work function may
+ * free its own item.
+ */
+typedef struct worker_pool {
+    struct workqueue *wq;
+    u32 cpu;
+    spinlock_t lock;
+    work_t *head;
+    work_t **tail;
+    u32 depth;
+    u32 active;
+    u32 stopping;
+    u32 worker_count;
+    kthread_t *workers[WQ_MAX_ACTIVE];
+    work_t *current[WQ_MAX_ACTIVE];
+    wait_queue_t more_work;
+} worker_pool_t;
+
+struct workqueue {
+    char name[WQ_NAME_LEN];
+    u32 flags;
+    u32 max_active;
+    u32 pool_count;
+    worker_pool_t *pools;
+    workqueue_stats_t stats;
+};
+
+workqueue_t *system_wq = NULL;
+workqueue_t *system_unbound_wq = NULL;
+
+static u32 wq_nr_cpus = 1;
+static wait_queue_t wq_work_done;
+
+static void wq_stat_max(u64 *max, u64 value)
+{
+    u64 old = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > old &&
+           !__atomic_compare_exchange_n(max, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void wq_stat_max32(u32 *max, u32 value)
+{
+    u32 old = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > old &&
+           !__atomic_compare_exchange_n(max, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void work_init(work_t *work, work_func_t func, void *data)
+{
+    if (!work) return;
+
+    memset(work, 0, sizeof(work_t));
+    work->func = func;
+    work->data = data;
+}
+
+static void delayed_work_timer_fn(ktimer_t *timer);
+
+void delayed_work_init(delayed_work_t *dwork, work_func_t func, void *data)
+{
+    if (!dwork) return;
+
+    work_init(&dwork->work, func, data);
+    timer_setup(&dwork->timer, delayed_work_timer_fn, dwork);
+    dwork->work.timer = &dwork->timer;
+}
+
+static bool wq_pool_has_work(void *arg)
+{
+    worker_pool_t *pool = (worker_pool_t *)arg;
+
+    return __atomic_load_n(&pool->depth, __ATOMIC_ACQUIRE) > 0 ||
+           __atomic_load_n(&pool->stopping, __ATOMIC_ACQUIRE);
+}
+
+/* Takes the next item and records it in a free 'current' slot, returned in 'slot'. */
+static work_t *wq_pool_pop(worker_pool_t *pool, u32 *slot)
+{
+    spin_lock(&pool->lock);
+    work_t *work = pool->head;
+    if (work) {
+        pool->head = work->next;
+        if (!pool->head) {
+            pool->tail = &pool->head;
+        }
+        work->next = NULL;
+        __atomic_store_n(&work->pool, NULL, __ATOMIC_RELEASE);
+        __atomic_store_n(&pool->depth, pool->depth - 1, __ATOMIC_RELEASE);
+        __atomic_sub_fetch(&pool->wq->stats.depth, 1, __ATOMIC_RELAXED);
+
+        /* Claim the slot before dropping PENDING so flush_work() never sees a gap. */
+        u32 i = 0;
+        while (pool->current[i]) {
+            i++;
+        }
+        pool->current[i] = work;
+        *slot = i;
+        __atomic_and_fetch(&work->state, ~WORK_PENDING, __ATOMIC_RELEASE);
+        pool->active++;
+    }
+    spin_unlock(&pool->lock);
+
+    return work;
+}
+
+static int wq_worker_main(void *arg)
+{
+    worker_pool_t *pool = (worker_pool_t *)arg;
+    workqueue_stats_t *stats = &pool->wq->stats;
+
+    if (!(pool->wq->flags & WQ_UNBOUND)) {
+        percpu_set_current_cpu(pool->cpu);
+    }
+
+    while (!__atomic_load_n(&pool->stopping, __ATOMIC_ACQUIRE)) {
+        u32 slot;
+        work_t *work = wq_pool_pop(pool, &slot);
+        if (!work) {
+            wait_queue_wait(&pool->more_work, NULL, wq_pool_has_work, pool, 0);
+            continue;
+        }
+
+        u64 start = wait_queue_now_ns();
+        u64 latency = start > work->queued_ns ? start - work->queued_ns : 0;
+        u32 active = __atomic_add_fetch(&stats->active, 1, __ATOMIC_RELAXED);
+        wq_stat_max32(&stats->max_active_seen, active);
+        __atomic_add_fetch(&stats->total_latency_ns, latency, __ATOMIC_RELAXED);
+        wq_stat_max(&stats->max_latency_ns, latency);
+
+        work->func(work);
+
+        u64 elapsed = wait_queue_now_ns() - start;
+        __atomic_sub_fetch(&stats->active, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->executed, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->total_exec_ns, elapsed, __ATOMIC_RELAXED);
+        wq_stat_max(&stats->max_exec_ns, elapsed);
+
+        /* The function may have freed the item; only the slot is touched now. */
+        spin_lock(&pool->lock);
+        pool->current[slot] = NULL;
+        pool->active--;
+        spin_unlock(&pool->lock);
+
+        wait_queue_wake_all(&wq_work_done);
+    }
+
+    return 0;
+}
+
+static void wq_pool_insert(worker_pool_t *pool, work_t *work)
+{
+    spin_lock(&pool->lock);
+    work->next = NULL;
+    work->queued_ns = wait_queue_now_ns();
+    *pool->tail = work;
+    pool->tail = &work->next;
+    __atomic_store_n(&work->pool, pool, __ATOMIC_RELEASE);
+    __atomic_store_n(&pool->depth, pool->depth + 1, __ATOMIC_RELEASE);
+    spin_unlock(&pool->lock);
+
+    workqueue_stats_t *stats = &pool->wq->stats;
+    __atomic_add_fetch(&stats->queued, 1, __ATOMIC_RELAXED);
+    wq_stat_max32(&stats->max_depth, __atomic_add_fetch(&stats->depth, 1, __ATOMIC_RELAXED));
+
+    wait_queue_wake(&pool->more_work, 1);
+}
+
+static worker_pool_t *wq_select_pool(workqueue_t *wq, u32 cpu)
+{
+    if (wq->flags & WQ_UNBOUND) {
+        return &wq->pools[0];
+    }
+
+    return &wq->pools[cpu % wq->pool_count];
+}
+
+static void wq_pool_stop(worker_pool_t *pool)
+{
+    __atomic_store_n(&pool->stopping, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&pool->more_work);
+
+    for (u32 i = 0; i < pool->worker_count; i++) {
+        kthread_stop(pool->workers[i]);
+        pool->workers[i] = NULL;
+    }
+    pool->worker_count = 0;
+}
+
+workqueue_t *workqueue_create(const char *name, u32 flags, u32 max_active)
+{
+    workqueue_t *wq = (workqueue_t *)calloc(1, sizeof(workqueue_t));
+    if (!wq) return NULL;
+
+    if (name) {
+        strncpy(wq->name, name, WQ_NAME_LEN - 1);
+    }
+
+    if (max_active == 0) {
+        max_active = (flags & WQ_UNBOUND) ? WQ_DEFAULT_UNBOUND_ACTIVE : 1;
+    }
+    if (max_active > WQ_MAX_ACTIVE) {
+        max_active = WQ_MAX_ACTIVE;
+    }
+
+    wq->flags = flags;
+    wq->max_active = max_active;
+    wq->pool_count = (flags & WQ_UNBOUND) ? 1 : wq_nr_cpus;
+    wq->pools = (worker_pool_t *)calloc(wq->pool_count, sizeof(worker_pool_t));
+    if (!wq->pools) {
+        free(wq);
+        return NULL;
+    }
+
+    for (u32 p = 0; p < wq->pool_count; p++) {
+        worker_pool_t *pool = &wq->pools[p];
+        pool->wq = wq;
+        pool->cpu = p;
+        pool->tail = &pool->head;
+        wait_queue_init(&pool->more_work);
+
+        for (u32 i = 0; i < max_active; i++) {
+            char thread_name[KTHREAD_NAME_LEN];
+            if (flags & WQ_UNBOUND) {
+                snprintf(thread_name, sizeof(thread_name), "kworker/u:%u", i);
+            } else {
+                snprintf(thread_name, sizeof(thread_name), "kworker/%u:%u", p, i);
+            }
+
+            pool->workers[i] = kthread_run(thread_name, wq_worker_main, pool);
+            if (!pool->workers[i]) {
+                workqueue_destroy(wq);
+                return NULL;
+            }
+            pool->worker_count++;
+        }
+    }
+
+    return wq;
+}
+
+void workqueue_destroy(workqueue_t *wq)
+{
+    if (!wq) return;
+
+    flush_workqueue(wq);
+
+    for (u32 p = 0; p < wq->pool_count; p++) {
+        wq_pool_stop(&wq->pools[p]);
+    }
+
+    free(wq->pools);
+    free(wq);
+}
+
+int workqueue_init(u32 nr_cpus)
+{
+    if (system_wq) return 0;
+
+    if (nr_cpus == 0) nr_cpus = 1;
+    if (nr_cpus > WQ_MAX_CPUS) nr_cpus = WQ_MAX_CPUS;
+    wq_nr_cpus = nr_cpus;
+    wait_queue_init(&wq_work_done);
+
+    if (timer_init() != 0) {
+        return -1;
+    }
+
+    system_wq = workqueue_create("events", 0, 1);
+    system_unbound_wq = workqueue_create("events_unbound", WQ_UNBOUND, WQ_DEFAULT_UNBOUND_ACTIVE);
+
+    return (system_wq && system_unbound_wq) ? 0 : -1;
+}
+
+void workqueue_shutdown(void)
+{
+    workqueue_destroy(system_wq);
+    workqueue_destroy(system_unbound_wq);
+    system_wq = NULL;
+    system_unbound_wq = NULL;
+}
+
+/* Returns 1 if queued, 0 if the item was already pending. */
+int queue_work_on(u32 cpu, workqueue_t *wq, work_t *work)
+{
+    if (!wq || !work || !work->func) return -1;
+
+    if (__atomic_fetch_or(&work->state, WORK_PENDING, __ATOMIC_ACQ_REL) & WORK_PENDING) {
+        return 0;
+    }
+
+    work->wq = wq;
+    work->cpu = cpu;
+    wq_pool_insert(wq_select_pool(wq, cpu), work);
+    return 1;
+}
+
+int queue_work(workqueue_t *wq, work_t *work)
+{
+    return queue_work_on(ied_current_cpu(), wq, work);
+}
+
+static void delayed_work_timer_fn(ktimer_t *timer)
+{
+    delayed_work_t *dwork = (delayed_work_t *)timer->data;
+    work_t *work = &dwork->work;
+
+    wq_pool_insert(wq_select_pool(work->wq, work->cpu), work);
+}
+
+int queue_delayed_work_on(u32 cpu, workqueue_t *wq, delayed_work_t *dwork, u64 delay_ns)
+{
+    if (!wq || !dwork || !dwork->work.func) return -1;
+
+    if (delay_ns == 0) {
+        return queue_work_on(cpu, wq, &dwork->work);
+    }
+
+    if (__atomic_fetch_or(&dwork->work.state, WORK_PENDING, __ATOMIC_ACQ_REL) & WORK_PENDING) {
+        return 0;
+    }
+
+    dwork->work.wq = wq;
+    dwork->work.cpu = cpu;
+    __atomic_add_fetch(&wq->stats.delayed, 1, __ATOMIC_RELAXED);
+    timer_mod(&dwork->timer, timer_now_ns() + delay_ns);
+    return 1;
+}
+
+int queue_delayed_work(workqueue_t *wq, delayed_work_t *dwork, u64 delay_ns)
+{
+    return queue_delayed_work_on(ied_current_cpu(), wq, dwork, delay_ns);
+}
+
+static bool wq_work_idle(void *arg)
+{
+    work_t *work = (work_t *)arg;
+
+    if (__atomic_load_n(&work->state, __ATOMIC_ACQUIRE) & WORK_PENDING) return false;
+
+    workqueue_t *wq = work->wq;
+    if (!wq) return true;
+
+    for (u32 p = 0; p < wq->pool_count; p++) {
+        worker_pool_t *pool = &wq->pools[p];
+        bool running = false;
+
+        spin_lock(&pool->lock);
+        for (u32 i = 0; i < WQ_MAX_ACTIVE; i++) {
+            if (pool->current[i] == work) {
+                running = true;
+                break;
+            }
+        }
+        spin_unlock(&pool->lock);
+
+        if (running) return false;
+    }
+
+    return true;
+}
+
+/* Wait for the item's pending and running instances to finish. Returns 1 if it had to wait. */
+int flush_work(work_t *work)
+{
+    if (!work) return -1;
+    if (wq_work_idle(work)) return 0;
+
+    wait_queue_wait(&wq_work_done, NULL, wq_work_idle, work, 0);
+    return 1;
+}
+
+/*
+ * Take a pending item off its queue or timer, then wait for a running
+ * instance to finish. Must not be called from the item itself. Returns 1
+ * if a pending instance was cancelled.
+ */
+int cancel_work_sync(work_t *work)
+{
+    if (!work) return -1;
+
+    int cancelled = 0;
+
+    for (;;) {
+        worker_pool_t *pool = __atomic_load_n(&work->pool, __ATOMIC_ACQUIRE);
+
+        if (pool) {
+            spin_lock(&pool->lock);
+            if (work->pool == pool) {
+                work_t **link = &pool->head;
+                while (*link != work) {
+                    link = &(*link)->next;
+                }
+                *link = work->next;
+                if (pool->tail == &work->next) {
+                    pool->tail = link;
+                }
+                work->next = NULL;
+                __atomic_store_n(&work->pool, NULL, __ATOMIC_RELEASE);
+                __atomic_store_n(&pool->depth, pool->depth - 1, __ATOMIC_RELEASE);
+                __atomic_sub_fetch(&pool->wq->stats.depth, 1, __ATOMIC_RELAXED);
+                __atomic_and_fetch(&work->state, ~WORK_PENDING, __ATOMIC_RELEASE);
+                cancelled = 1;
+            }
+            spin_unlock(&pool->lock);
+            if (cancelled) break;
+            continue;
+        }
+
+        if (work->timer && timer_del(work->timer) == 1) {
+            __atomic_and_fetch(&work->state, ~WORK_PENDING, __ATOMIC_RELEASE);
+            cancelled = 1;
+            break;
+        }
+
+        /* Pending but on neither a queue nor a timer: a timer callback is moving it. */
+        if (!(__atomic_load_n(&work->state, __ATOMIC_ACQUIRE) & WORK_PENDING)) break;
+        wait_queue_cpu_relax();
+    }
+
+    if (cancelled) {
+        __atomic_add_fetch(&work->wq->stats.cancelled, 1, __ATOMIC_RELAXED);
+        wait_queue_wake_all(&wq_work_done);
+    }
+
+    flush_work(work);
+    return cancelled;
+}
+
+int cancel_delayed_work_sync(delayed_work_t *dwork)
+{
+    if (!dwork) return -1;
+    return cancel_work_sync(&dwork->work);
+}
+
+static bool wq_idle(void *arg)
+{
+    workqueue_t *wq = (workqueue_t *)arg;
+
+    for (u32 p = 0; p < wq->pool_count; p++) {
+        worker_pool_t *pool = &wq->pools[p];
+
+        spin_lock(&pool->lock);
+        bool busy = pool->depth > 0 || pool->active > 0;
+        spin_unlock(&pool->lock);
+
+        if (busy) return false;
+    }
+
+    return true;
+}
+
+/* Wait until every item queued on 'wq' has run. Delayed items still on their timer are not waited for. */
+int flush_workqueue(workqueue_t *wq)
+{
+    if (!wq) return -1;
+
+    return wait_queue_wait(&wq_work_done, NULL, wq_idle, wq, 0);
+}
+
+int workqueue_get_stats(workqueue_t *wq, workqueue_stats_t *stats)
+{
+    if (!wq || !stats) return -1;
+
+    memcpy(stats, &wq->stats, sizeof(workqueue_stats_t));
+    return 0;
+}
+
+void workqueue_print_stats(workqueue_t *wq)
+{
+    if (!wq) return;
+
+    workqueue_stats_t *s = &wq->stats;
+    u64 executed = s->executed ? s->executed : 1;
+
+    printf("\n=== Workqueue %s (%s, max_active %u) ===\n", wq->name,
+           (wq->flags & WQ_UNBOUND) ? "unbound" : "per-cpu", wq->max_active);
+    printf("Queued: %llu  Executed: %llu  Cancelled: %llu  Delayed: %llu\n",
+           (unsigned long long)s->queued, (unsigned long long)s->executed,
+           (unsigned long long)s->cancelled, (unsigned long long)s->delayed);
+    printf("Depth: %u (max %u)  Active: %u (max %u)\n",
+           s->depth, s->max_depth, s->active, s->max_active_seen);
+    printf("Latency: avg %llu ns, max %llu ns  Exec: avg %llu ns, max %llu ns\n",
+           (unsigned long long)(s->total_latency_ns / executed), (unsigned long long)s->max_latency_ns,
+           (unsigned long long)(s->total_exec_ns / executed), (unsigned long long)s->max_exec_ns);
+}
@@ -13,12 +13,50 @@ typedef struct {
     char* current_test;
 } test_context_t;
 
-static test_context_t test_ctx = {0, 0, 0, NULL};
+/* One context for the whole test binary, so test_main sees every file's results. */
+__attribute__((weak)) test_context_t test_ctx = {0, 0, 0, NULL};
 
-#define TEST_SUITE(name) \
+typedef struct {
+    const char *name;
+    int (*run)(void);
+} test_case_t;
+
+/*
+ * Two forms:
+ *   TEST_SUITE(name) { TEST_CASE(...) { ... } TEST_END(); }
+ *     defines run_<name>_tests();
+ *   TEST_SUITE("Name", setup, teardown, TEST(fn), ...);
+ *     runs each fn between setup and teardown (either may be NULL). A
+ *     case that returns non-zero counts as a failure.
+ */
+#define TEST_SUITE_PICK(a, b, ...) b
+#define TEST_SUITE(name, ...) \
+    TEST_SUITE_PICK(__VA_OPT__(,) TEST_SUITE_RUN, TEST_SUITE_DEFINE, ~)(name __VA_OPT__(,) __VA_ARGS__)
+
+#define TEST_SUITE_DEFINE(name) \
     void run_##name##_tests(void); \
     void run_##name##_tests(void)
 
+#define TEST(fn) ((test_case_t){ #fn, fn })
+
+#define TEST_SUITE_RUN(suite, setup, teardown, ...) \
+    do { \
+        test_case_t __cases[] = { __VA_ARGS__ }; \
+        int (*__setup)(void) = (setup); \
+        int (*__teardown)(void) = (teardown); \
+        for (size_t __i = 0; __i < sizeof(__cases) / sizeof(__cases[0]); __i++) { \
+            test_ctx.current_test = (char *)__cases[__i].name; \
+            printf("  [*] Running: %s / %s\n", (suite), test_ctx.current_test); \
+            if (__setup) __setup(); \
+            if (__cases[__i].run() != 0) { \
+                printf("    [FAIL] %s returned an error\n", test_ctx.current_test); \
+                test_ctx.failed++; \
+                test_ctx.total++; \
+            } \
+            if (__teardown) __teardown(); \
+        } \
+    } while(0)
+
 #define TEST_CASE(name) \
     do { \
         test_ctx.current_test = #name; \
@@ -93,6 +131,44 @@ static test_context_t test_ctx = {0, 0, 0, NULL};
         test_ctx.total++; \
     } while(0)
 
+/* Each operand is evaluated once; both are compared as long long. */
+#define ASSERT_CMP(a, op, b) \
+    do { \
+        long long __a = (long long)(a); \
+        long long __b = (long long)(b); \
+        if (!(__a op __b)) { \
+            printf("    [FAIL] %s:%d: %s %s %s (%lld vs %lld)\n", \
+                   __FILE__, __LINE__, #a, #op, #b, __a, __b); \
+            test_ctx.failed++; \
+        } else { \
+            test_ctx.passed++; \
+        } \
+        test_ctx.total++; \
+    } while(0)
+
+#define ASSERT_EQ(a, b)             ASSERT_CMP(a, ==, b)
+#define ASSERT_NE(a, b)             ASSERT_CMP(a, !=, b)
+#define ASSERT_GT(a, b)             ASSERT_CMP(a, >, b)
+#define ASSERT_GTE(a, b)            ASSERT_CMP(a, >=, b)
+#define ASSERT_LT(a, b)             ASSERT_CMP(a, <, b)
+#define ASSERT_LTE(a, b)            ASSERT_CMP(a, <=, b)
+#define ASSERT_GREATER(a, b)        ASSERT_CMP(a, >, b)
+#define ASSERT_GREATER_EQUAL(a, b)  ASSERT_CMP(a, >=, b)
+
+#define ASSERT_STREQ(a, b) \
+    do { \
+        const char *__a = (a); \
+        const char *__b = (b); \
+        if (!__a || !__b || strcmp(__a, __b) != 0) { \
+            printf("    [FAIL] %s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, \
+                   __a ? __a : "(null)", __b ? __b : "(null)"); \
+            test_ctx.failed++; \
+        } else { \
+            test_ctx.passed++; \
+        } \
+        test_ctx.total++; \
+    } while(0)
+
 #define PRINT_TEST_RESULTS() \
     do { \
         printf("\n========================================\n"); \
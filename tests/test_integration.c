@@ -1,9 +1,22 @@
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <kernel/syscalls.h>
+#include <kernel/syscall_ring.h>
+#include <kernel/filesystem.h>
 #include <kernel/ipc_bus.h>
 #include <kernel/event_system.h>
 #include <kernel/boot_params.h>
+#include <kernel/rcu.h>
+#include <kernel/wait_queue.h>
+#include <kernel/interrupt.h>
+#include <kernel/irq_balance.h>
+#include <kernel/workqueue.h>
+#include <kernel/spinlock.h>
+#include <kernel/perf_optimize.h>
+#include <kernel/percpu.h>
+#include <kernel/process.h>
+#include "../kernel/sysfs.h"
 #include "test_framework.h"
 
 static int setup_syscall_test(void)
@@ -52,6 +65,36 @@ static int test_syscall_validate_privilege(void)
     return 0;
 }
 
+static int syscall_seven(void)
+{
+    return 7;
+}
+
+static int test_syscall_dispatch_after_unregister(void)
+{
+    syscall_register(12, syscall_seven, "seven", 0, 0);
+    ASSERT_EQ(syscall_dispatch(12, NULL), 7);
+    
+    syscall_unregister(12);
+    ASSERT_EQ(syscall_dispatch(12, NULL), -ENOSYS);
+    ASSERT_EQ(syscall_register(12, syscall_seven, "seven", 0, 0), 0);
+    return 0;
+}
+
+/* Stands in for a blocking handler: fails if dispatch still holds a read section. */
+static int syscall_waits_for_readers(void)
+{
+    return synchronize_rcu();
+}
+
+static int test_syscall_handler_outside_rcu(void)
+{
+    ASSERT_EQ(syscall_register(13, syscall_waits_for_readers, "sync", 0, 0), 0);
+    ASSERT_EQ(syscall_dispatch(13, NULL), 0);
+    ASSERT_EQ(syscall_unregister(13), 0);
+    return 0;
+}
+
 static int test_syscall_get_count(void)
 {
     int dummy_handler = 42;
@@ -63,6 +106,229 @@ static int test_syscall_get_count(void)
     return 0;
 }
 
+static int syscall_fails(void)
+{
+    return -1;
+}
+
+static int test_syscall_stats_histogram(void)
+{
+    ASSERT_EQ(syscall_register(20, syscall_seven, "stat_ok", 0, 0), 0);
+    ASSERT_EQ(syscall_register(21, syscall_fails, "stat_fail", 0, 0), 0);
+    
+    syscall_dispatch(20, NULL);
+    syscall_stats_t stats;
+    ASSERT_EQ(syscall_gate_get_stats(20, &stats), 0);
+    ASSERT_EQ(stats.calls, 0);
+    
+    ASSERT_EQ(syscall_gate_stats_enable(true), 0);
+    syscall_gate_stats_reset();
+    for (int i = 0; i < 100; i++) {
+        syscall_dispatch(20, NULL);
+    }
+    for (int i = 0; i < 10; i++) {
+        syscall_dispatch(21, NULL);
+    }
+    
+    ASSERT_EQ(syscall_gate_get_stats(20, &stats), 0);
+    ASSERT_EQ(stats.calls, 100);
+    ASSERT_EQ(stats.errors, 0);
+    u64 bucketed = 0;
+    for (int b = 0; b < SYSCALL_HIST_BUCKETS; b++) {
+        bucketed += stats.hist[b];
+    }
+    ASSERT_EQ(bucketed, 100);
+    ASSERT_GTE(syscall_stats_percentile_ns(&stats, 99), syscall_stats_percentile_ns(&stats, 50));
+    
+    ASSERT_EQ(syscall_gate_get_stats(21, &stats), 0);
+    ASSERT_EQ(stats.errors, 10);
+    
+    sysfs_t *sysfs = sysfs_init();
+    ASSERT_NOT_NULL(sysfs);
+    ASSERT_EQ(syscall_gate_sysfs_register(sysfs, NULL), 0);
+    sysfs_entry_t *dir = sysfs_find_by_name(sysfs->root, "syscalls");
+    char buf[1024];
+    ASSERT_GT(sysfs_read_attr(sysfs_find_by_name(dir, "stats"), buf, sizeof(buf)), 0);
+    ASSERT_NOT_NULL(strstr(buf, "stat_fail"));
+    ASSERT_EQ(sysfs_write_attr(sysfs_find_by_name(dir, "enable"), "1", 0), -1);
+    ASSERT_EQ(sysfs_write_attr(sysfs_find_by_name(dir, "enable"), "0", 1), 1);
+    ASSERT_EQ(syscall_gate_stats_enabled(), false);
+    
+    syscall_dispatch(20, NULL);
+    ASSERT_EQ(syscall_gate_get_stats(20, &stats), 0);
+    ASSERT_EQ(stats.calls, 100);
+    sysfs_free(sysfs);
+    return 0;
+}
+
+static syscall_cqe_t ring_reap(syscall_ring_t *ring)
+{
+    syscall_cqe_t *cqe = NULL;
+    syscall_ring_wait_cqe(ring, &cqe);
+    syscall_cqe_t copy = *cqe;
+    syscall_ring_cqe_seen(ring);
+    return copy;
+}
+
+static int test_syscall_ring_ops_and_links(void)
+{
+    aegisfs_init();
+    inode_t *file = aegisfs_create_file("/ring_test", 0644);
+    ASSERT_NOT_NULL(file);
+    
+    pmgr_init();
+    process_t *proc = pmgr_create_process("ring_user", NULL, 1);
+    ASSERT_EQ(syscall_ring_create(proc->pid + 1, 8, 0), NULL);
+    syscall_ring_t *ring = syscall_ring_create(proc->pid, 8, 0);
+    ASSERT_NOT_NULL(ring);
+    void *files[] = { file };
+    ASSERT_EQ(syscall_ring_register_files(ring, files, 1), 0);
+    
+    /* Buffers are addresses in the process; the kernel sees them through 'buf'. */
+    ipc_object_t *shm = ipc_create_shared_memory(proc->pid, PAGE_SIZE);
+    char *user = (char *)ipc_attach_shared_memory(shm, proc->pid);
+    ASSERT_NOT_NULL(user);
+    char *buf = (char *)shm->data.shm.memory;
+    char *out = user;
+    char *in = user + 16;
+    ipc_message_t *msg = (ipc_message_t *)(user + 64);
+    
+    strcpy(buf, "ring submission");
+    memset(buf + 16, 0, 16);
+    syscall_sqe_t *sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_WRITE, 0, out, 16, 0, 1);
+    sqe->flags = SQE_F_LINK;
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_READ, 0, in, 16, 0, 2);
+    ASSERT_EQ(syscall_ring_submit(ring), 2);
+    ASSERT_EQ(ring_reap(ring).res, 16);
+    syscall_cqe_t cqe = ring_reap(ring);
+    ASSERT_EQ(cqe.user_data, 2);
+    ASSERT_EQ(cqe.res, 16);
+    ASSERT_STREQ(buf + 16, "ring submission");
+    
+    /* Kernel pointers and ranges running off the mapping are refused. */
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_READ, 0, buf, 16, 0, 8);
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_WRITE, 0, user + PAGE_SIZE - 8, 16, 0, 9);
+    ASSERT_EQ(syscall_ring_submit(ring), 2);
+    ASSERT_EQ(ring_reap(ring).res, -EFAULT);
+    ASSERT_EQ(ring_reap(ring).res, -EFAULT);
+    
+    /* A failed link cancels the rest of its chain. */
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_READ, 5, in, sizeof(in), 0, 3);
+    sqe->flags = SQE_F_LINK;
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_NOP, 0, NULL, 0, 0, 4);
+    ASSERT_EQ(syscall_ring_submit(ring), 2);
+    ASSERT_EQ(ring_reap(ring).res, -EBADF);
+    ASSERT_EQ(ring_reap(ring).res, -ECANCELED);
+    
+    /* Whatever is linked behind a timeout runs once it expires. */
+    ipc_bus_init();
+    ASSERT_EQ(ipc_bus_register_route(1, 900, 0), 0);
+    ipc_message_t bus_msg = { .source_id = 1, .dest_id = 900, .payload_size = 0 };
+    memcpy(buf + 64, &bus_msg, sizeof(bus_msg));
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_TIMEOUT, 0, NULL, 0, 20000000, 5);
+    sqe->flags = SQE_F_LINK;
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_BUS_SEND, 0, msg, 1, 0, 6);
+    ASSERT_EQ(syscall_ring_submit(ring), 2);
+    ASSERT_EQ(ipc_bus_get_queue_size(900), 0);
+    ASSERT_EQ(ring_reap(ring).res, -ETIME);
+    cqe = ring_reap(ring);
+    ASSERT_EQ(cqe.user_data, 6);
+    ASSERT_EQ(cqe.res, 0);
+    ASSERT_EQ(ipc_bus_get_queue_size(900), 1);
+    ipc_bus_clear_queue(900);
+    syscall_ring_destroy(ring);
+    
+    /* A sleeping poller is woken by submit; a busy one needs no entry at all. */
+    ring = syscall_ring_create(proc->pid, 8, SYSCALL_RING_SQPOLL);
+    ASSERT_NOT_NULL(ring);
+    ASSERT_EQ(syscall_ring_register_files(ring, files, 1), 0);
+    while (!(__atomic_load_n(&ring->header->sq.flags, __ATOMIC_ACQUIRE) & SYSCALL_RING_SQ_NEED_WAKEUP)) {
+        wait_queue_cpu_relax();
+    }
+    sqe = syscall_ring_get_sqe(ring);
+    syscall_ring_prep(sqe, SQE_OP_READ, 0, in, 4, 5, 7);
+    syscall_ring_submit(ring);
+    ASSERT_EQ(ring_reap(ring).res, 4);
+    
+    syscall_ring_stats_t stats;
+    ASSERT_EQ(syscall_ring_get_stats(ring, &stats), 0);
+    ASSERT_GTE(stats.poller_wakeups, 1);
+    ASSERT_EQ(stats.submitted, 1);
+    syscall_ring_destroy(ring);
+    ipc_destroy_shared_memory(shm);
+    aegisfs_delete_file("/ring_test");
+    return 0;
+}
+
+static int test_syscall_ring_cq_pressure(void)
+{
+    pmgr_init();
+    process_t *proc = pmgr_create_process("ring_cq", NULL, 1);
+    syscall_ring_t *ring = syscall_ring_create(proc->pid, 64, 0);
+    ASSERT_NOT_NULL(ring);
+    syscall_ring_queue_t *cq = &ring->header->cq;
+    
+    /* A chain too long to run is completed whole with -EINVAL, tail included. */
+    for (u32 i = 0; i < 40; i++) {
+        syscall_sqe_t *sqe = syscall_ring_get_sqe(ring);
+        syscall_ring_prep(sqe, SQE_OP_NOP, 0, NULL, 0, 0, i);
+        sqe->flags = i < 39 ? SQE_F_LINK : 0;
+    }
+    ASSERT_EQ(syscall_ring_submit(ring), 40);
+    for (u32 i = 0; i < 40; i++) {
+        syscall_cqe_t cqe = ring_reap(ring);
+        ASSERT_EQ(cqe.user_data, i);
+        ASSERT_EQ(cqe.res, -EINVAL);
+    }
+    
+    /* Timeouts complete from the timer while the submitter keeps the CQ full. */
+    u32 queued = 0;
+    u32 reaped = 0;
+    u32 max_used = 0;
+    u32 bad = 0;
+    for (u32 round = 0; round < 20000; round++) {
+        syscall_sqe_t *sqe;
+        while ((sqe = syscall_ring_get_sqe(ring)) != NULL) {
+            syscall_ring_prep(sqe, SQE_OP_TIMEOUT, 0, NULL, 0, 1000, round);
+            queued++;
+        }
+        syscall_ring_submit(ring);
+        syscall_ring_enter(ring, cq->entries, 0, 0);
+        
+        u32 used = __atomic_load_n(&cq->tail, __ATOMIC_ACQUIRE) - cq->head;
+        if (used > max_used) max_used = used;
+        
+        /* Free one slot a round so every submit runs against a full CQ. */
+        syscall_cqe_t *cqe = syscall_ring_peek_cqe(ring);
+        if (cqe) {
+            bad += cqe->res != -ETIME;
+            syscall_ring_cqe_seen(ring);
+            reaped++;
+        }
+    }
+    ASSERT_LTE(max_used, cq->entries);
+    ASSERT_EQ(bad, 0);
+    
+    while (reaped < queued) {
+        syscall_ring_enter(ring, cq->entries, 0, 0);
+        ASSERT_EQ(ring_reap(ring).res, -ETIME);
+        reaped++;
+    }
+    ASSERT_EQ(__atomic_load_n(&ring->inflight, __ATOMIC_ACQUIRE), 0);
+    
+    syscall_ring_destroy(ring);
+    pmgr_destroy_process(proc->pid);
+    return 0;
+}
+
 static int setup_ipc_test(void)
 {
     ipc_bus_init();
@@ -148,6 +414,85 @@ static int test_ipc_clear_queue(void)
     return 0;
 }
 
+static int ipc_notify_calls = 0;
+
+static void test_ipc_notify(int dest_id, int queued, void *context)
+{
+    ipc_notify_calls++;
+}
+
+static int test_ipc_send_receive_batch(void)
+{
+    ipc_bus_register_route(6, 7, 5);
+    ipc_bus_set_notify(7, test_ipc_notify, NULL);
+    ipc_notify_calls = 0;
+    
+    ipc_message_t batch[16];
+    memset(batch, 0, sizeof(batch));
+    for (int i = 0; i < 16; i++) {
+        batch[i].source_id = 6;
+        batch[i].dest_id = 7;
+        batch[i].msg_id = 200 + i;
+    }
+    
+    int sent = ipc_bus_send_batch(batch, 16);
+    ASSERT_EQ(sent, 16);
+    ASSERT_EQ(ipc_notify_calls, 1);
+    ASSERT_EQ(ipc_bus_get_queue_size(7), 16);
+    
+    ipc_message_t recv_batch[16];
+    int received = ipc_bus_receive_batch(7, recv_batch, 10);
+    ASSERT_EQ(received, 10);
+    ASSERT_EQ(recv_batch[0].msg_id, 200);
+    ASSERT_EQ(recv_batch[9].msg_id, 209);
+    
+    received = ipc_bus_receive_batch(7, recv_batch, 16);
+    ASSERT_EQ(received, 6);
+    ASSERT_EQ(recv_batch[5].msg_id, 215);
+    ASSERT_EQ(ipc_bus_get_queue_size(7), 0);
+    
+    ipc_bus_set_notify(7, NULL, NULL);
+    return 0;
+}
+
+static int test_ipc_batch_requires_route(void)
+{
+    ipc_message_t batch[2];
+    memset(batch, 0, sizeof(batch));
+    batch[0].source_id = 40;
+    batch[0].dest_id = 41;
+    batch[1].source_id = 40;
+    batch[1].dest_id = 41;
+    
+    ASSERT_EQ(ipc_bus_send_batch(batch, 2), -1);
+    
+    ipc_bus_register_route(40, 41, 5);
+    batch[1].dest_id = 42;
+    ASSERT_EQ(ipc_bus_send_batch(batch, 2), -1);
+    ASSERT_EQ(ipc_bus_get_queue_size(41), 0);
+    return 0;
+}
+
+static int test_ipc_batch_partial_overflow(void)
+{
+    ipc_bus_register_route(8, 9, 5);
+    
+    static ipc_message_t batch[IPC_MAX_QUEUE_SIZE + 8];
+    for (int i = 0; i < IPC_MAX_QUEUE_SIZE + 8; i++) {
+        batch[i].source_id = 8;
+        batch[i].dest_id = 9;
+        batch[i].msg_id = i;
+    }
+    
+    int sent = ipc_bus_send_batch(batch, IPC_MAX_QUEUE_SIZE + 8);
+    ASSERT_EQ(sent, IPC_MAX_QUEUE_SIZE);
+    ASSERT_EQ(ipc_bus_get_dropped_messages(9), 8);
+    
+    ipc_bus_clear_queue(9);
+    ASSERT_EQ(ipc_bus_get_queue_size(9), 0);
+    return 0;
+}
+
 static int event_callback_called = 0;
 
 static int test_event_callback(const kernel_event_t *event, void *context)
@@ -217,6 +562,899 @@ static int test_event_get_count(void)
     return 0;
 }
 
+static int async_seen = 0;
+static uint32_t async_last_id = 0;
+
+static int test_event_async_callback(const kernel_event_t *event, void *context)
+{
+    __atomic_add_fetch(&async_seen, 1, __ATOMIC_RELAXED);
+    async_last_id = event->event_id;
+    return 0;
+}
+
+static void publish_events(uint32_t type, int count)
+{
+    kernel_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.event_type = type;
+    event.source_id = 7;
+    
+    for (int i = 0; i < count; i++) {
+        event.event_id = (uint32_t)i;
+        event_publish(&event);
+    }
+}
+
+static int test_event_async_drop_oldest(void)
+{
+    event_subscription_opts_t opts = {
+        .delivery = EVENT_DELIVERY_ASYNC,
+        .backpressure = EVENT_BACKPRESSURE_DROP_OLDEST,
+        .queue_depth = 4,
+    };
+    async_seen = 0;
+    ASSERT_EQ(event_subscribe_ex(20, EVENT_DEVICE_ATTACHED, test_event_async_callback, NULL, &opts), 0);
+    
+    publish_events(EVENT_DEVICE_ATTACHED, 6);
+    ASSERT_EQ(async_seen, 0);
+    
+    event_subscriber_stats_t stats;
+    ASSERT_EQ(event_get_subscriber_stats(20, EVENT_DEVICE_ATTACHED, &stats), 0);
+    ASSERT_EQ(stats.queued, 4);
+    ASSERT_EQ(stats.dropped, 2);
+    
+    event_dispatch_flush();
+    ASSERT_EQ(async_seen, 4);
+    ASSERT_EQ(async_last_id, 5);
+    
+    event_get_subscriber_stats(20, EVENT_DEVICE_ATTACHED, &stats);
+    ASSERT_EQ(stats.delivered, 4);
+    ASSERT_EQ(stats.queued, 0);
+    ASSERT_EQ(stats.max_queued, 4);
+    
+    event_unsubscribe(20, EVENT_DEVICE_ATTACHED);
+    return 0;
+}
+
+static int test_event_async_coalesce(void)
+{
+    event_subscription_opts_t opts = {
+        .delivery = EVENT_DELIVERY_ASYNC,
+        .backpressure = EVENT_BACKPRESSURE_COALESCE,
+        .queue_depth = 2,
+    };
+    async_seen = 0;
+    event_subscribe_ex(21, EVENT_DEVICE_DETACHED, test_event_async_callback, NULL, &opts);
+    
+    publish_events(EVENT_DEVICE_DETACHED, 5);
+    
+    event_subscriber_stats_t stats;
+    event_get_subscriber_stats(21, EVENT_DEVICE_DETACHED, &stats);
+    ASSERT_EQ(stats.coalesced, 3);
+    
+    event_dispatch_flush();
+    ASSERT_EQ(async_seen, 2);
+    ASSERT_EQ(async_last_id, 4);
+    
+    event_unsubscribe(21, EVENT_DEVICE_DETACHED);
+    return 0;
+}
+
+static int test_event_async_worker_pool(void)
+{
+    event_subscription_opts_t opts = {
+        .delivery = EVENT_DELIVERY_ASYNC,
+        .backpressure = EVENT_BACKPRESSURE_BLOCK,
+        .queue_depth = 4,
+    };
+    async_seen = 0;
+    event_subscribe_ex(22, EVENT_SECURITY_ALERT, test_event_async_callback, NULL, &opts);
+    event_subscribe_ex(23, EVENT_SECURITY_ALERT, test_event_async_callback, NULL, &opts);
+    
+    ASSERT_EQ(event_dispatch_start(2), 2);
+    publish_events(EVENT_SECURITY_ALERT, 100);
+    event_dispatch_flush();
+    event_dispatch_stop();
+    
+    ASSERT_EQ(async_seen, 200);
+    
+    event_subscriber_stats_t stats;
+    event_get_subscriber_stats(22, EVENT_SECURITY_ALERT, &stats);
+    ASSERT_EQ(stats.delivered, 100);
+    ASSERT_EQ(stats.dropped, 0);
+    
+    event_unsubscribe_all(22);
+    event_unsubscribe_all(23);
+    return 0;
+}
+
+static int rcu_sync_failures = 0;
+
+static int test_event_sync_rcu_callback(const kernel_event_t *event, void *context)
+{
+    if (synchronize_rcu() != 0) {
+        rcu_sync_failures++;
+    }
+    return test_event_async_callback(event, context);
+}
+
+static int test_event_block_outside_rcu(void)
+{
+    event_subscription_opts_t opts = {
+        .delivery = EVENT_DELIVERY_ASYNC,
+        .backpressure = EVENT_BACKPRESSURE_BLOCK,
+        .queue_depth = 4,
+    };
+    async_seen = 0;
+    rcu_sync_failures = 0;
+    event_subscribe_ex(24, EVENT_SECURITY_ALERT, test_event_sync_rcu_callback, NULL, &opts);
+    
+    publish_events(EVENT_SECURITY_ALERT, 10);
+    event_dispatch_flush();
+    ASSERT_EQ(async_seen, 10);
+    ASSERT_EQ(rcu_sync_failures, 0);
+    
+    event_subscriber_stats_t stats;
+    event_get_subscriber_stats(24, EVENT_SECURITY_ALERT, &stats);
+    ASSERT_EQ(stats.dropped, 0);
+    ASSERT_GT(stats.blocked, 0);
+    
+    event_unsubscribe_all(24);
+    return 0;
+}
+
+static int self_unsubscribe_calls = 0;
+static int bystander_calls = 0;
+
+static int test_event_self_unsubscribe(const kernel_event_t *event, void *context)
+{
+    self_unsubscribe_calls++;
+    return event_unsubscribe(30, event->event_type);
+}
+
+static int test_event_bystander(const kernel_event_t *event, void *context)
+{
+    bystander_calls++;
+    return 0;
+}
+
+static int test_event_unsubscribe_during_publish(void)
+{
+    event_subscribe(30, EVENT_SYSCALL_ENTER, test_event_self_unsubscribe, NULL);
+    event_subscribe(31, EVENT_SYSCALL_ENTER, test_event_bystander, NULL);
+    
+    publish_events(EVENT_SYSCALL_ENTER, 2);
+    
+    ASSERT_EQ(self_unsubscribe_calls, 1);
+    ASSERT_EQ(bystander_calls, 2);
+    ASSERT_EQ(event_get_subscriber_count(EVENT_SYSCALL_ENTER), 1);
+    
+    ASSERT_GTE(rcu_barrier(), 1);
+    event_unsubscribe(31, EVENT_SYSCALL_ENTER);
+    return 0;
+}
+
+static int filtered_calls = 0;
+static uint32_t filtered_last_id = 0;
+static uint32_t filtered_last_count = 0;
+
+static int test_event_filtered_callback(const kernel_event_t *event, void *context)
+{
+    __atomic_add_fetch(&filtered_calls, 1, __ATOMIC_RELAXED);
+    filtered_last_id = event->event_id;
+    filtered_last_count = event->coalesced_count;
+    return 0;
+}
+
+static int test_event_mask_and_filter(void)
+{
+    event_filter_t filter;
+    ASSERT_EQ(event_filter_compile("type ==", &filter), -1);
+    ASSERT_EQ(event_filter_compile("data8[300] == 1", &filter), -1);
+    ASSERT_EQ(event_filter_compile("source == 7 && (id >= 2 || data8[0] & 0x80)", &filter), 0);
+    
+    event_mask_t mask;
+    memset(&mask, 0, sizeof(mask));
+    event_mask_set(&mask, EVENT_PAGE_FAULT);
+    event_mask_set(&mask, EVENT_IPC_MESSAGE_RECV);
+    
+    event_subscription_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.filter = &filter;
+    
+    filtered_calls = 0;
+    ASSERT_EQ(event_subscribe_mask(40, &mask, test_event_filtered_callback, NULL, &opts), 0);
+    ASSERT_EQ(event_get_subscriber_count(EVENT_PAGE_FAULT), 1);
+    ASSERT_EQ(event_get_subscriber_count(EVENT_IPC_MESSAGE_SENT), 0);
+    
+    publish_events(EVENT_PAGE_FAULT, 4);
+    publish_events(EVENT_IPC_MESSAGE_SENT, 4);
+    ASSERT_EQ(filtered_calls, 2);
+    ASSERT_EQ(filtered_last_id, 3);
+    
+    event_subscriber_stats_t stats;
+    ASSERT_EQ(event_get_subscriber_stats(40, EVENT_PAGE_FAULT, &stats), 0);
+    ASSERT_EQ(stats.filtered, 2);
+    
+    ASSERT_EQ(event_unsubscribe(40, EVENT_PAGE_FAULT), 0);
+    ASSERT_EQ(event_get_subscriber_count(EVENT_PAGE_FAULT), 0);
+    ASSERT_EQ(event_get_subscriber_count(EVENT_IPC_MESSAGE_RECV), 1);
+    ASSERT_EQ(event_unsubscribe_all(40), 1);
+    
+    ASSERT_EQ(event_subscribe_all(41, test_event_filtered_callback, NULL), MAX_EVENT_TYPES);
+    ASSERT_EQ(event_get_subscriber_count(EVENT_SECURITY_ALERT), 1);
+    ASSERT_EQ(event_unsubscribe_all(41), MAX_EVENT_TYPES);
+    return 0;
+}
+
+static int test_event_coalesce_window(void)
+{
+    event_mask_t mask;
+    memset(&mask, 0, sizeof(mask));
+    event_mask_set(&mask, EVENT_PROCESS_SCHEDULED);
+    event_mask_set(&mask, EVENT_MEMORY_FREED);
+    
+    event_subscription_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.coalesce_window_ns = 1000000000ULL;
+    
+    filtered_calls = 0;
+    ASSERT_EQ(event_subscribe_mask(42, &mask, test_event_filtered_callback, NULL, &opts), 0);
+    
+    publish_events(EVENT_PROCESS_SCHEDULED, 5);
+    ASSERT_EQ(filtered_calls, 0);
+    
+    /* A different type closes the open burst early. */
+    publish_events(EVENT_MEMORY_FREED, 1);
+    ASSERT_EQ(filtered_calls, 1);
+    ASSERT_EQ(filtered_last_id, 4);
+    ASSERT_EQ(filtered_last_count, 5);
+    
+    event_dispatch_flush();
+    ASSERT_EQ(filtered_calls, 2);
+    ASSERT_EQ(filtered_last_count, 1);
+    
+    event_subscriber_stats_t stats;
+    event_get_subscriber_stats(42, EVENT_PROCESS_SCHEDULED, &stats);
+    ASSERT_EQ(stats.bursts, 2);
+    ASSERT_EQ(stats.coalesced, 4);
+    event_unsubscribe_all(42);
+    
+    /* With workers running, the window closes on its own. */
+    opts.coalesce_window_ns = 1000000ULL;
+    filtered_calls = 0;
+    event_subscribe_ex(43, EVENT_PROCESS_SCHEDULED, test_event_filtered_callback, NULL, &opts);
+    ASSERT_EQ(event_dispatch_start(1), 1);
+    
+    publish_events(EVENT_PROCESS_SCHEDULED, 3);
+    uint64_t deadline = wait_queue_now_ns() + 1000000000ULL;
+    while (__atomic_load_n(&filtered_calls, __ATOMIC_ACQUIRE) == 0 && wait_queue_now_ns() < deadline) {
+        wait_queue_cpu_relax();
+    }
+    event_dispatch_stop();
+    
+    ASSERT_EQ(filtered_calls, 1);
+    ASSERT_EQ(filtered_last_count, 3);
+    event_unsubscribe(43, EVENT_PROCESS_SCHEDULED);
+    return 0;
+}
+
+static int rcu_callback_runs = 0;
+
+static void test_rcu_callback(rcu_head_t *head)
+{
+    rcu_callback_runs++;
+}
+
+static int test_rcu_deferred_callback(void)
+{
+    rcu_head_t head;
+    rcu_barrier();
+    rcu_callback_runs = 0;
+    u64 grace_periods = rcu_get_grace_periods();
+    
+    rcu_read_lock();
+    call_rcu(&head, test_rcu_callback);
+    ASSERT_EQ(rcu_barrier(), -1);
+    ASSERT_EQ(synchronize_rcu(), -1);
+    rcu_read_unlock();
+    
+    ASSERT_EQ(rcu_callback_runs, 0);
+    ASSERT_EQ(rcu_barrier(), 1);
+    ASSERT_EQ(rcu_callback_runs, 1);
+    ASSERT_GT(rcu_get_grace_periods(), grace_periods);
+    return 0;
+}
+
+static int irq_primary_calls = 0;
+static int irq_thread_calls = 0;
+
+static int setup_irq_test(void)
+{
+    ied_init();
+    irq_primary_calls = 0;
+    irq_thread_calls = 0;
+    return 0;
+}
+
+static irq_return_t test_irq_primary(u32 irq, void *dev_id)
+{
+    irq_primary_calls++;
+    return IRQ_WAKE_THREAD;
+}
+
+static void test_irq_thread(u32 irq, void *dev_id)
+{
+    __atomic_add_fetch(&irq_thread_calls, 1, __ATOMIC_RELAXED);
+}
+
+static int test_irq_threaded_handler(void)
+{
+    ASSERT_EQ(ied_request_threaded_irq(40, test_irq_primary, test_irq_thread, NULL, IRQ_TYPE_EDGE), 0);
+    ASSERT_EQ(ied_request_threaded_irq(40, test_irq_primary, test_irq_thread, NULL, IRQ_TYPE_EDGE), -1);
+    ASSERT_EQ(ied_register_irq(40, NULL, (void *)1, IRQ_TYPE_LEVEL), -1);
+    
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(ied_dispatch_irq_on(1, 40), 0);
+        ASSERT_EQ(ied_synchronize_irq(40), 0);
+    }
+    
+    ASSERT_EQ(irq_primary_calls, 3);
+    ASSERT_EQ(irq_thread_calls, 3);
+    
+    irq_stat_t stats;
+    ASSERT_EQ(ied_get_irq_stats(40, &stats), 0);
+    ASSERT_EQ(stats.count, 3);
+    ASSERT_EQ(stats.thread_count, 3);
+    ASSERT_GTE(stats.hardirq_ns, stats.max_hardirq_ns);
+    
+    ASSERT_EQ(ied_unregister_irq(40), 0);
+    ASSERT_EQ(ied_dispatch_irq(40), -1);
+    return 0;
+}
+
+static int softirq_runs = 0;
+static int tasklet_runs = 0;
+static int irq_event_runs = 0;
+static tasklet_t test_tasklet;
+
+static void test_softirq_storm(u32 cpu)
+{
+    softirq_runs++;
+    ied_raise_softirq(cpu, SOFTIRQ_TIMER);
+}
+
+static void test_tasklet_fn(void *data)
+{
+    tasklet_runs++;
+}
+
+static void test_irq_event_handler(void *data)
+{
+    irq_event_runs++;
+}
+
+static event_t test_irq_event = { EVENT_TYPE_IO, 1, NULL, test_irq_event_handler };
+
+static void test_irq_legacy_handler(u32 irq)
+{
+    ied_tasklet_schedule(&test_tasklet);
+    ied_tasklet_schedule(&test_tasklet);
+    ied_post_event(&test_irq_event);
+    ied_raise_softirq(ied_current_cpu(), SOFTIRQ_TIMER);
+}
+
+static int test_softirq_on_irq_exit(void)
+{
+    softirq_runs = 0;
+    tasklet_runs = 0;
+    irq_event_runs = 0;
+    ied_tasklet_init(&test_tasklet, test_tasklet_fn, NULL);
+    ASSERT_EQ(ied_open_softirq(SOFTIRQ_TIMER, test_softirq_storm), 0);
+    ASSERT_EQ(ied_register_irq(41, test_irq_legacy_handler, NULL, IRQ_TYPE_EDGE), 0);
+    
+    ASSERT_EQ(ied_dispatch_irq_on(2, 41), 0);
+    ASSERT_EQ(tasklet_runs, 1);
+    ASSERT_EQ(irq_event_runs, 1);
+    ASSERT_EQ(softirq_runs, IED_SOFTIRQ_MAX_RESTART);
+    
+    ied_cpu_stats_t stats;
+    ASSERT_EQ(ied_get_cpu_stats(2, &stats), 0);
+    ASSERT_EQ(stats.irqs, 1);
+    ASSERT_EQ(stats.tasklets, 1);
+    ASSERT_EQ(stats.softirq_deferred, 1);
+    ASSERT_EQ(ied_get_cpu_stats(0, &stats), 0);
+    ASSERT_EQ(stats.irqs, 0);
+    
+    ied_unregister_irq(41);
+    return 0;
+}
+
+static u32 routed_irq = 0;
+static u32 routed_mask = 0;
+
+static int test_route_hook(u32 irq, u32 cpu_mask)
+{
+    routed_irq = irq;
+    routed_mask = cpu_mask;
+    return 0;
+}
+
+static void test_irq_noop(u32 irq)
+{
+}
+
+static int test_irq_affinity_respects_isolation(void)
+{
+    u32 isolated = 0;
+    ASSERT_EQ(ied_parse_cpulist("2-3", &isolated), 0);
+    ASSERT_EQ(isolated, 0xC);
+    ASSERT_EQ(ied_parse_cpulist("1,x", &isolated), -1);
+    
+    ied_set_isolated_cpus(0xC);
+    ied_set_affinity_hook(test_route_hook);
+    ied_register_irq(45, test_irq_noop, NULL, IRQ_TYPE_EDGE);
+    
+    u32 mask = 0, cpu = 0;
+    ASSERT_EQ(ied_set_irq_affinity(45, 0xE), 0);
+    ied_get_irq_affinity(45, &mask, &cpu);
+    ASSERT_EQ(mask, 0xE);
+    ASSERT_EQ(cpu, 1);
+    ASSERT_EQ(routed_irq, 45);
+    ASSERT_EQ(routed_mask, 0x2);
+    
+    /* Explicitly pinning to isolated CPUs is honoured. */
+    ASSERT_EQ(ied_set_irq_affinity(45, 0x8), 0);
+    ied_get_irq_affinity(45, NULL, &cpu);
+    ASSERT_EQ(cpu, 3);
+    ASSERT_EQ(ied_set_irq_cpu(45, 1), -1);
+    ASSERT_EQ(ied_set_irq_affinity(45, 0), -1);
+    
+    ied_set_affinity_hook(NULL);
+    ied_set_isolated_cpus(0);
+    ied_unregister_irq(45);
+    return 0;
+}
+
+static int test_irq_balance_spreads_hot_irqs(void)
+{
+    irq_balance_config_t config = { 4, 2, 1, 0 };
+    ASSERT_EQ(irq_balance_init(&config), 0);
+    ied_set_isolated_cpus(0x8);
+    
+    for (u32 irq = 50; irq < 54; irq++) {
+        ied_register_irq(irq, test_irq_noop, NULL, IRQ_TYPE_EDGE);
+        for (u32 i = 0; i < (54 - irq) * 100; i++) {
+            ied_dispatch_irq(irq);
+        }
+    }
+    ASSERT_EQ(irq_balance_set_consumer(52, 2), 0);
+    ASSERT_EQ(irq_balance_set_consumer(53, 3), 0);
+    
+    irq_balance_report_t report;
+    ASSERT_EQ(irq_balance_run(&report), 3);
+    ASSERT_EQ(report.hot_irqs, 4);
+    ASSERT_GT(report.load_before[0], 0);
+    ASSERT_EQ(report.load_before[1], 0);
+    ASSERT_EQ(report.load_after[3], 0);
+    ASSERT_GT(report.load_after[0], report.load_after[1]);
+    
+    u32 cpu = 0;
+    ied_get_irq_affinity(50, NULL, &cpu);
+    ASSERT_EQ(cpu, 0);
+    ied_get_irq_affinity(51, NULL, &cpu);
+    ASSERT_EQ(cpu, 1);
+    ied_get_irq_affinity(52, NULL, &cpu);
+    ASSERT_EQ(cpu, 2);
+    ied_get_irq_affinity(53, NULL, &cpu);
+    ASSERT_EQ(cpu, 2);
+    
+    ied_dispatch_irq(51);
+    ied_cpu_stats_t stats;
+    ied_get_cpu_stats(1, &stats);
+    ASSERT_EQ(stats.irqs, 1);
+    
+    ied_set_isolated_cpus(0);
+    for (u32 irq = 50; irq < 54; irq++) {
+        ied_unregister_irq(irq);
+    }
+    return 0;
+}
+
+static u32 wq_gate = 0;
+static u32 wq_gate_entered = 0;
+static u32 wq_runs = 0;
+static u32 wq_running = 0;
+static u32 wq_max_running = 0;
+static char wq_thread_name[KTHREAD_NAME_LEN];
+static u32 wq_thread_cpu = 0;
+
+static int setup_workqueue_test(void)
+{
+    workqueue_init(4);
+    __atomic_store_n(&wq_gate, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&wq_gate_entered, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&wq_runs, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&wq_running, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&wq_max_running, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static void test_wq_count(work_t *work)
+{
+    kthread_t *self = kthread_current();
+    if (self) {
+        strncpy(wq_thread_name, self->name, KTHREAD_NAME_LEN - 1);
+    }
+    wq_thread_cpu = percpu_current_cpu();
+    __atomic_add_fetch(&wq_runs, 1, __ATOMIC_RELAXED);
+}
+
+static void test_wq_free_self(work_t *work)
+{
+    free(work);
+    __atomic_add_fetch(&wq_runs, 1, __ATOMIC_RELEASE);
+}
+
+static void test_wq_gated(work_t *work)
+{
+    __atomic_store_n(&wq_gate_entered, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&wq_gate, __ATOMIC_ACQUIRE)) {
+        wait_queue_cpu_relax();
+    }
+    __atomic_add_fetch(&wq_runs, 1, __ATOMIC_RELAXED);
+}
+
+static void test_wq_busy(work_t *work)
+{
+    u32 running = __atomic_add_fetch(&wq_running, 1, __ATOMIC_RELAXED);
+    u32 max = __atomic_load_n(&wq_max_running, __ATOMIC_RELAXED);
+    while (running > max &&
+           !__atomic_compare_exchange_n(&wq_max_running, &max, running, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    
+    u64 until = wait_queue_now_ns() + 2000000ULL;
+    while (wait_queue_now_ns() < until) {
+        wait_queue_cpu_relax();
+    }
+    
+    __atomic_sub_fetch(&wq_running, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&wq_runs, 1, __ATOMIC_RELAXED);
+}
+
+static void test_wq_gate_first(work_t *work)
+{
+    if (__atomic_fetch_add(&wq_gate_entered, 1, __ATOMIC_ACQ_REL) == 0) {
+        while (!__atomic_load_n(&wq_gate, __ATOMIC_ACQUIRE)) {
+            wait_queue_cpu_relax();
+        }
+    }
+    __atomic_add_fetch(&wq_runs, 1, __ATOMIC_RELEASE);
+}
+
+static int test_workqueue_bound_pending(void)
+{
+    workqueue_t *wq = workqueue_create("test_bound", 0, 1);
+    ASSERT_NOT_NULL(wq);
+    
+    work_t gate, work;
+    work_init(&gate, test_wq_gated, NULL);
+    work_init(&work, test_wq_count, NULL);
+    
+    ASSERT_EQ(queue_work_on(3, wq, &gate), 1);
+    ASSERT_EQ(queue_work_on(3, wq, &work), 1);
+    ASSERT_EQ(queue_work_on(3, wq, &work), 0);
+    
+    __atomic_store_n(&wq_gate, 1, __ATOMIC_RELEASE);
+    ASSERT_EQ(flush_work(&work), 1);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 2);
+    ASSERT_STREQ(wq_thread_name, "kworker/3:0");
+    ASSERT_EQ(wq_thread_cpu, 3);
+    ASSERT_EQ(flush_work(&work), 0);
+    
+    workqueue_stats_t stats;
+    ASSERT_EQ(workqueue_get_stats(wq, &stats), 0);
+    ASSERT_EQ(stats.queued, 2);
+    ASSERT_EQ(stats.executed, 2);
+    ASSERT_EQ(stats.depth, 0);
+    ASSERT_EQ(stats.max_depth, 2);
+    ASSERT_EQ(stats.max_active_seen, 1);
+    ASSERT_GT(stats.max_latency_ns, 0);
+    
+    workqueue_destroy(wq);
+    return 0;
+}
+
+static int test_workqueue_unbound_max_active(void)
+{
+    workqueue_t *wq = workqueue_create("test_unbound", WQ_UNBOUND, 2);
+    ASSERT_NOT_NULL(wq);
+    
+    work_t works[6];
+    for (int i = 0; i < 6; i++) {
+        work_init(&works[i], test_wq_busy, NULL);
+        ASSERT_EQ(queue_work(wq, &works[i]), 1);
+    }
+    
+    ASSERT_EQ(flush_workqueue(wq), 0);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 6);
+    ASSERT_EQ(__atomic_load_n(&wq_max_running, __ATOMIC_ACQUIRE), 2);
+    
+    workqueue_stats_t stats;
+    workqueue_get_stats(wq, &stats);
+    ASSERT_EQ(stats.executed, 6);
+    ASSERT_EQ(stats.max_active_seen, 2);
+    ASSERT_GTE(stats.total_exec_ns, 6 * 2000000ULL);
+    
+    /* A requeued item finishing on the other worker must not hide the first run. */
+    work_t work;
+    work_init(&work, test_wq_gate_first, NULL);
+    __atomic_store_n(&wq_runs, 0, __ATOMIC_RELEASE);
+    ASSERT_EQ(queue_work(wq, &work), 1);
+    while (!__atomic_load_n(&wq_gate_entered, __ATOMIC_ACQUIRE)) {
+        wait_queue_cpu_relax();
+    }
+    ASSERT_EQ(queue_work(wq, &work), 1);
+    while (__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE) < 1) {
+        wait_queue_cpu_relax();
+    }
+    __atomic_store_n(&wq_gate, 1, __ATOMIC_RELEASE);
+    flush_work(&work);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 2);
+    ASSERT_EQ(flush_work(&work), 0);
+    
+    /* An item may free itself; the worker must not touch it afterwards. */
+    __atomic_store_n(&wq_runs, 0, __ATOMIC_RELEASE);
+    for (int i = 0; i < 8; i++) {
+        work_t *owned = (work_t *)malloc(sizeof(work_t));
+        ASSERT_NOT_NULL(owned);
+        work_init(owned, test_wq_free_self, NULL);
+        ASSERT_EQ(queue_work(wq, owned), 1);
+    }
+    ASSERT_EQ(flush_workqueue(wq), 0);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 8);
+    
+    workqueue_destroy(wq);
+    return 0;
+}
+
+static int test_workqueue_delayed_and_cancel(void)
+{
+    delayed_work_t dwork;
+    delayed_work_init(&dwork, test_wq_count, NULL);
+    
+    ASSERT_EQ(queue_delayed_work(system_wq, &dwork, 50000000ULL), 1);
+    ASSERT_EQ(queue_delayed_work(system_wq, &dwork, 1000000ULL), 0);
+    ASSERT_EQ(cancel_delayed_work_sync(&dwork), 1);
+    ASSERT_EQ(cancel_delayed_work_sync(&dwork), 0);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 0);
+    
+    u64 start = timer_now_ns();
+    ASSERT_EQ(queue_delayed_work(system_unbound_wq, &dwork, 2000000ULL), 1);
+    ASSERT_EQ(flush_work(&dwork.work), 1);
+    ASSERT_GTE(timer_now_ns() - start, 2000000ULL);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 1);
+    
+    /* A queued item stuck behind a busy worker is taken off the queue. */
+    work_t gate, work;
+    work_init(&gate, test_wq_gated, NULL);
+    work_init(&work, test_wq_count, NULL);
+    ASSERT_EQ(queue_work_on(0, system_wq, &gate), 1);
+    ASSERT_EQ(queue_work_on(0, system_wq, &work), 1);
+    while (!__atomic_load_n(&wq_gate_entered, __ATOMIC_ACQUIRE)) {
+        wait_queue_cpu_relax();
+    }
+    ASSERT_EQ(cancel_work_sync(&work), 1);
+    __atomic_store_n(&wq_gate, 1, __ATOMIC_RELEASE);
+    ASSERT_EQ(cancel_work_sync(&gate), 0);
+    ASSERT_EQ(__atomic_load_n(&wq_runs, __ATOMIC_ACQUIRE), 2);
+    
+    workqueue_stats_t stats;
+    workqueue_get_stats(system_wq, &stats);
+    ASSERT_GTE(stats.cancelled, 2);
+    ASSERT_GTE(stats.delayed, 1);
+    return 0;
+}
+
+static spinlock_t test_spin = SPINLOCK_INIT;
+static mcs_lock_t test_mcs = MCS_LOCK_INIT;
+static lock_stats_t test_spin_stats;
+static lock_stats_t test_mcs_stats;
+static u64 test_lock_counter = 0;
+static u64 test_mcs_counter = 0;
+
+static int test_lock_worker(void *arg)
+{
+    for (int i = 0; i < 10000; i++) {
+        mcs_node_t node;
+        
+        spin_lock(&test_spin);
+        test_lock_counter++;
+        spin_unlock(&test_spin);
+        
+        mcs_lock(&test_mcs, &node);
+        test_mcs_counter++;
+        mcs_unlock(&test_mcs, &node);
+    }
+    return 0;
+}
+
+static int test_lock_blocked(void *arg)
+{
+    spin_lock(&test_spin);
+    test_lock_counter++;
+    spin_unlock(&test_spin);
+    return 0;
+}
+
+static int test_spinlock_mcs_contention_stats(void)
+{
+    perf_buffer_t *buffer = perf_create_buffer();
+    ASSERT_NOT_NULL(buffer);
+    perf_start_collection(buffer);
+    
+    lock_stats_init(&test_spin_stats, "test_spin");
+    lock_stats_init(&test_mcs_stats, "test_mcs");
+    test_spin.stats = &test_spin_stats;
+    test_mcs.stats = &test_mcs_stats;
+    lock_stats_set_perf_buffer(buffer);
+    lock_stats_enable(true);
+    test_lock_counter = 0;
+    test_mcs_counter = 0;
+    
+    /* A waiter that finds the lock held is always counted as contended. */
+    spin_lock(&test_spin);
+    kthread_t *blocked = kthread_run("lock_blocked", test_lock_blocked, NULL);
+    ASSERT_NOT_NULL(blocked);
+    u32 spins = 0;
+    while (__atomic_load_n(&test_spin.next, __ATOMIC_ACQUIRE) != 2) {
+        lock_spin_wait(&spins);
+    }
+    u64 until = wait_queue_now_ns() + 2000000ULL;
+    while (wait_queue_now_ns() < until) {
+        lock_spin_wait(&spins);
+    }
+    ASSERT_EQ(spin_trylock(&test_spin), false);
+    spin_unlock(&test_spin);
+    kthread_stop(blocked);
+    
+    ASSERT_EQ(test_spin_stats.acquisitions, 2);
+    ASSERT_EQ(test_spin_stats.contended, 1);
+    ASSERT_GTE(test_spin_stats.max_wait_ns, 1000000ULL);
+    
+    kthread_t *workers[4];
+    for (int i = 0; i < 4; i++) {
+        workers[i] = kthread_run("lock_worker", test_lock_worker, NULL);
+    }
+    for (int i = 0; i < 4; i++) {
+        kthread_stop(workers[i]);
+    }
+    lock_stats_enable(false);
+    lock_stats_set_perf_buffer(NULL);
+    
+    ASSERT_EQ(test_lock_counter, 40001);
+    ASSERT_EQ(test_mcs_counter, 40000);
+    ASSERT_EQ(test_spin_stats.acquisitions, 40002);
+    ASSERT_EQ(test_mcs_stats.acquisitions, 40000);
+    ASSERT_EQ(spin_is_locked(&test_spin), false);
+    ASSERT_EQ(lock_stats_find("test_mcs") == &test_mcs_stats, 1);
+    
+    u64 contended = test_spin_stats.contended + test_mcs_stats.contended;
+    ASSERT_EQ(buffer->sample_count, contended < PERF_MAX_SAMPLES ? contended : PERF_MAX_SAMPLES);
+    ASSERT_EQ(buffer->samples[0].event_type, PERF_EVENT_LOCK_CONTENTION);
+    
+    test_spin.stats = NULL;
+    test_mcs.stats = NULL;
+    perf_free_buffer(buffer);
+    return 0;
+}
+
+static rwlock_t test_rw = RWLOCK_INIT;
+static seqlock_t test_seq = SEQLOCK_INIT;
+static u64 test_seq_a = 0;
+static u64 test_seq_b = 0;
+static u32 test_seq_stop = 0;
+
+static int test_rw_writer(void *arg)
+{
+    write_lock(&test_rw);
+    write_unlock(&test_rw);
+    return 0;
+}
+
+static int test_seq_writer(void *arg)
+{
+    while (!__atomic_load_n(&test_seq_stop, __ATOMIC_ACQUIRE)) {
+        write_seqlock(&test_seq);
+        __atomic_store_n(&test_seq_a, test_seq_a + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&test_seq_b, test_seq_b + 2, __ATOMIC_RELAXED);
+        write_sequnlock(&test_seq);
+    }
+    return 0;
+}
+
+static int test_rwlock_and_seqlock(void)
+{
+    read_lock(&test_rw);
+    ASSERT_EQ(read_trylock(&test_rw), true);
+    ASSERT_EQ(write_trylock(&test_rw), false);
+    
+    /* A waiting writer holds off new readers. */
+    kthread_t *writer = kthread_run("rw_writer", test_rw_writer, NULL);
+    while (!(__atomic_load_n(&test_rw.cnt, __ATOMIC_ACQUIRE) & RWLOCK_WAITING)) {
+        wait_queue_cpu_relax();
+    }
+    ASSERT_EQ(read_trylock(&test_rw), false);
+    read_unlock(&test_rw);
+    read_unlock(&test_rw);
+    kthread_stop(writer);
+    
+    ASSERT_EQ(write_trylock(&test_rw), true);
+    ASSERT_EQ(read_trylock(&test_rw), false);
+    write_unlock(&test_rw);
+    ASSERT_EQ(test_rw.cnt, 0);
+    
+    __atomic_store_n(&test_seq_stop, 0, __ATOMIC_RELEASE);
+    writer = kthread_run("seq_writer", test_seq_writer, NULL);
+    
+    int torn = 0;
+    for (int i = 0; i < 20000 || __atomic_load_n(&test_seq_a, __ATOMIC_RELAXED) < 1000; i++) {
+        u64 a, b;
+        u32 seq;
+        do {
+            seq = read_seqbegin(&test_seq);
+            a = __atomic_load_n(&test_seq_a, __ATOMIC_RELAXED);
+            b = __atomic_load_n(&test_seq_b, __ATOMIC_RELAXED);
+        } while (read_seqretry(&test_seq, seq));
+        if (b != a * 2) torn++;
+    }
+    
+    __atomic_store_n(&test_seq_stop, 1, __ATOMIC_RELEASE);
+    kthread_stop(writer);
+    ASSERT_EQ(torn, 0);
+    ASSERT_GT(test_seq_a, 0);
+    return 0;
+}
+
+static DEFINE_PER_CPU(u64, test_pcpu_hits);
+
+static void test_irq_count_only(u32 irq)
+{
+    (void)irq;
+}
+
+static int test_percpu_counters(void)
+{
+    this_cpu_add(test_pcpu_hits, 5);
+    ASSERT_EQ(percpu_init(4), 0);
+    ASSERT_EQ(percpu_nr_cpus(), 4);
+    
+    /* The boot copy carries over to CPU 0 only. */
+    ASSERT_EQ(per_cpu(test_pcpu_hits, 0), 5);
+    ASSERT_EQ(per_cpu(test_pcpu_hits, 1), 0);
+    per_cpu_add(test_pcpu_hits, 1, 2);
+    per_cpu_add(test_pcpu_hits, 3, 3);
+    ASSERT_EQ(per_cpu_sum(test_pcpu_hits), 10);
+    
+    uintptr_t cpu0 = (uintptr_t)per_cpu_ptr(test_pcpu_hits, 0);
+    uintptr_t cpu1 = (uintptr_t)per_cpu_ptr(test_pcpu_hits, 1);
+    ASSERT_GTE(cpu1 - cpu0, 64);
+    ASSERT_EQ((cpu1 - cpu0) % 64, 0);
+    
+    ASSERT_EQ(ied_register_irq(41, test_irq_count_only, NULL, IRQ_TYPE_EDGE), 0);
+    u64 before = ied_get_irq_stat(41);
+    for (u32 cpu = 0; cpu < 4; cpu++) {
+        ASSERT_EQ(ied_dispatch_irq_on(cpu, 41), 0);
+        ASSERT_EQ(ied_dispatch_irq_on(cpu, 41), 0);
+    }
+    ASSERT_EQ(ied_get_irq_stat(41) - before, 8);
+    ASSERT_EQ(ied_unregister_irq(41), 0);
+    
+    per_cpu_reset(test_pcpu_hits);
+    ASSERT_EQ(per_cpu_sum(test_pcpu_hits), 0);
+    return 0;
+}
+
 static int test_boot_params_memory(void)
 {
     multiboot_info_t info;
@@ -274,21 +1512,59 @@ void test_integration_main(void)
         TEST(test_syscall_register),
         TEST(test_syscall_unregister),
         TEST(test_syscall_validate_privilege),
-        TEST(test_syscall_get_count)
+        TEST(test_syscall_get_count),
+        TEST(test_syscall_dispatch_after_unregister),
+        TEST(test_syscall_handler_outside_rcu),
+        TEST(test_syscall_stats_histogram),
+        TEST(test_syscall_ring_ops_and_links),
+        TEST(test_syscall_ring_cq_pressure)
     );
     
     TEST_SUITE("IPC Bus", setup_ipc_test, teardown_ipc_test,
         TEST(test_ipc_register_route),
         TEST(test_ipc_send_receive_message),
         TEST(test_ipc_queue_overflow),
-        TEST(test_ipc_clear_queue)
+        TEST(test_ipc_clear_queue),
+        TEST(test_ipc_send_receive_batch),
+        TEST(test_ipc_batch_requires_route),
+        TEST(test_ipc_batch_partial_overflow)
     );
     
     TEST_SUITE("Event System", setup_event_test, NULL,
         TEST(test_event_subscribe_publish),
         TEST(test_event_unsubscribe),
         TEST(test_event_multiple_subscribers),
-        TEST(test_event_get_count)
+        TEST(test_event_get_count),
+        TEST(test_event_async_drop_oldest),
+        TEST(test_event_async_coalesce),
+        TEST(test_event_async_worker_pool),
+        TEST(test_event_block_outside_rcu),
+        TEST(test_event_unsubscribe_during_publish),
+        TEST(test_event_mask_and_filter),
+        TEST(test_event_coalesce_window),
+        TEST(test_rcu_deferred_callback)
+    );
+    
+    TEST_SUITE("Interrupts", setup_irq_test, NULL,
+        TEST(test_irq_threaded_handler),
+        TEST(test_softirq_on_irq_exit),
+        TEST(test_irq_affinity_respects_isolation),
+        TEST(test_irq_balance_spreads_hot_irqs)
+    );
+    
+    TEST_SUITE("Workqueues", setup_workqueue_test, NULL,
+        TEST(test_workqueue_bound_pending),
+        TEST(test_workqueue_unbound_max_active),
+        TEST(test_workqueue_delayed_and_cancel)
+    );
+    
+    TEST_SUITE("Locking", NULL, NULL,
+        TEST(test_spinlock_mcs_contention_stats),
+        TEST(test_rwlock_and_seqlock)
+    );
+    
+    TEST_SUITE("Per-CPU", NULL, NULL,
+        TEST(test_percpu_counters)
     );
     
     TEST_SUITE("Boot Parameters", NULL, NULL,
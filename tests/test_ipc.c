@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <string.h>
+#include <kernel/ipc.h>
+#include <kernel/ipc_ring.h>
+#include <kernel/memory.h>
+#include <kernel/process.h>
+#include <kernel/filesystem.h>
+#include <kernel/futex.h>
+#include <devapi/core_api.h>
+#include "test_framework.h"
+
+static int setup_ipc_core_test(void)
+{
+    mmgr_init();
+    pmgr_init();
+    ipc_init();
+    return 0;
+}
+
+static int test_ipc_grant_shared_mapping(void)
+{
+    address_space_t *src = mmgr_create_address_space();
+    address_space_t *dst = mmgr_create_address_space();
+    u64 phys = (u64)mmgr_alloc_pages(4);
+    
+    mmgr_map_pages(src, 0x400000, phys, 4, PROT_READ | PROT_WRITE);
+    
+    u64 dst_virt = 0;
+    int result = ipc_grant_pages(src, 0x400000, dst, &dst_virt, 4, IPC_GRANT_READ);
+    ASSERT_EQ(result, 0);
+    ASSERT_EQ(dst_virt, IPC_GRANT_WINDOW_BASE);
+    ASSERT_EQ(mmgr_get_phys_addr(dst, dst_virt + PAGE_SIZE), phys + PAGE_SIZE);
+    ASSERT_EQ(mmgr_find_vma(dst, dst_virt)->prot, PROT_READ);
+    ASSERT_EQ(mmgr_get_phys_addr(src, 0x400000), phys);
+    
+    ASSERT_EQ(ipc_revoke_grant(dst, dst_virt, 4), 0);
+    ASSERT_EQ(dst->vma_count, 0);
+    
+    mmgr_destroy_address_space(src);
+    mmgr_destroy_address_space(dst);
+    return 0;
+}
+
+static int test_ipc_grant_move_and_rights(void)
+{
+    address_space_t *src = mmgr_create_address_space();
+    address_space_t *dst = mmgr_create_address_space();
+    u64 phys = (u64)mmgr_alloc_pages(2);
+    
+    mmgr_map_pages(src, 0x800000, phys, 2, PROT_READ);
+    
+    u64 dst_virt = 0;
+    ASSERT_EQ(ipc_grant_pages(src, 0x800000, dst, &dst_virt, 2, IPC_GRANT_WRITE), -1);
+    
+    ASSERT_EQ(ipc_grant_pages(src, 0x800000, dst, &dst_virt, 2, IPC_GRANT_READ | IPC_GRANT_MOVE), 0);
+    ASSERT_EQ(src->vma_count, 0);
+    ASSERT_EQ(mmgr_get_phys_addr(dst, dst_virt), phys);
+    
+    mmgr_destroy_address_space(src);
+    mmgr_destroy_address_space(dst);
+    return 0;
+}
+
+static int test_ipc_shared_memory_attach_maps(void)
+{
+    process_t *proc = pmgr_create_process("shm_client", NULL, 1);
+    ipc_object_t *shm = ipc_create_shared_memory(1, 3 * PAGE_SIZE);
+    
+    void *mem = ipc_attach_shared_memory(shm, proc->pid);
+    ASSERT_NOT_NULL(mem);
+    
+    address_space_t *as = (address_space_t *)proc->page_table;
+    ASSERT_EQ(as->vma_count, 3);
+    ASSERT_EQ((u64)mem, IPC_GRANT_WINDOW_BASE);
+    ASSERT_EQ(mmgr_get_phys_addr(as, (u64)mem), (u64)shm->data.shm.memory);
+    ASSERT_NULL(ipc_attach_shared_memory(shm, 0xdead));
+    
+    ipc_detach_shared_memory(shm);
+    ASSERT_EQ(as->vma_count, 0);
+    ASSERT_EQ(ipc_destroy_shared_memory(shm), 0);
+    return 0;
+}
+
+static int test_ipc_shm_ring_stream(void)
+{
+    process_t *producer = pmgr_create_process("ring_producer", NULL, 1);
+    process_t *consumer = pmgr_create_process("ring_consumer", NULL, 1);
+    
+    ipc_ring_t *tx = ipc_ring_create(producer->pid, PAGE_SIZE);
+    ASSERT_NOT_NULL(tx);
+    
+    ipc_ring_t *rx = ipc_ring_attach(tx->shm, consumer->pid);
+    ASSERT_NOT_NULL(rx);
+    ASSERT_NE((u64)&tx->header->head / 64, (u64)&tx->header->tail / 64);
+    
+    char out[PAGE_SIZE];
+    char in[PAGE_SIZE];
+    memset(out, 'a', sizeof(out));
+    
+    ASSERT_EQ(ipc_ring_write(tx, out, 3000), 3000);
+    ASSERT_EQ(ipc_ring_read(rx, in, 2000), 2000);
+    ASSERT_EQ(ipc_ring_write(tx, out, 3000), 3000);
+    ASSERT_EQ(ipc_ring_used(rx), 4000);
+    ASSERT_EQ(ipc_ring_write(tx, out, 1000), PAGE_SIZE - 4000);
+    ASSERT_EQ(ipc_ring_read(rx, in, sizeof(in)), PAGE_SIZE);
+    ASSERT_EQ(memcmp(in, out, PAGE_SIZE), 0);
+    
+    ipc_ring_destroy(rx);
+    ASSERT_EQ(((address_space_t *)consumer->page_table)->vma_count, 0);
+    ipc_ring_destroy(tx);
+    ASSERT_EQ(((address_space_t *)producer->page_table)->vma_count, 0);
+    return 0;
+}
+
+static u32 fastpath_seen_priority = 0;
+static process_state_t fastpath_seen_caller_state = PROCESS_STATE_NEW;
+static thread_t *fastpath_caller = NULL;
+
+static int fastpath_add_handler(thread_t *server, ipc_fastpath_msg_t *msg, void *context)
+{
+    fastpath_seen_priority = server->priority;
+    fastpath_seen_caller_state = fastpath_caller->state;
+    
+    msg->mr[0] = msg->mr[0] + msg->mr[1];
+    msg->label = 0x55;
+    msg->length = 1;
+    return 0;
+}
+
+static int test_ipc_call_fastpath(void)
+{
+    process_t *proc = pmgr_create_process("fastpath", NULL, 1);
+    thread_t *server = pmgr_create_thread(proc->pid, NULL, NULL);
+    thread_t *caller = pmgr_create_thread(proc->pid, NULL, NULL);
+    server->priority = 1;
+    caller->priority = 7;
+    caller->state = PROCESS_STATE_RUNNING;
+    caller->time_slice_remaining = 8;
+    server->time_slice_remaining = 3;
+    fastpath_caller = caller;
+    
+    ipc_endpoint_t *ep = ipc_endpoint_create(fastpath_add_handler, NULL);
+    ASSERT_NOT_NULL(ep);
+    
+    ipc_fastpath_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.mr[0] = 40;
+    msg.mr[1] = 2;
+    msg.length = 2;
+    
+    ASSERT_EQ(ipc_call(ep, caller, &msg), -1);
+    
+    ASSERT_EQ(ipc_reply_wait(ep, server), 0);
+    ASSERT_EQ(ipc_call(ep, caller, &msg), 0);
+    ASSERT_EQ(msg.mr[0], 42);
+    ASSERT_EQ(msg.label, 0x55);
+    ASSERT_EQ(fastpath_seen_priority, 7);
+    ASSERT_EQ(fastpath_seen_caller_state, PROCESS_STATE_BLOCKED);
+    
+    ASSERT_EQ(server->state, PROCESS_STATE_BLOCKED);
+    ASSERT_EQ(server->priority, 1);
+    ASSERT_EQ(server->time_slice_remaining, 3);
+    ASSERT_EQ(caller->state, PROCESS_STATE_RUNNING);
+    ASSERT_EQ(caller->time_slice_remaining, 8);
+    ASSERT_EQ(ep->fastpath_calls, 1);
+    
+    ipc_endpoint_destroy(ep);
+    return 0;
+}
+
+static int test_ipc_pipe_stream_and_wrap(void)
+{
+    ipc_object_t *pipe = ipc_create_pipe_ex(1, 2, 2 * PAGE_SIZE, IPC_PIPE_NONBLOCK);
+    ASSERT_NOT_NULL(pipe);
+    ASSERT_EQ(pipe->data.pipe.slot_count, 2);
+    
+    char out[3 * PAGE_SIZE];
+    char in[3 * PAGE_SIZE];
+    for (u32 i = 0; i < sizeof(out); i++) out[i] = (char)i;
+    
+    ASSERT_EQ(ipc_write_pipe(pipe, out, 100), 100);
+    ASSERT_EQ(ipc_write_pipe(pipe, out + 100, 3 * PAGE_SIZE), 2 * PAGE_SIZE - 100);
+    ASSERT_EQ(ipc_write_pipe(pipe, out, 1), IPC_EAGAIN);
+    
+    ASSERT_EQ(ipc_read_pipe(pipe, in, PAGE_SIZE), PAGE_SIZE);
+    ASSERT_EQ(ipc_write_pipe(pipe, out + 2 * PAGE_SIZE, PAGE_SIZE), PAGE_SIZE);
+    ASSERT_EQ(ipc_read_pipe(pipe, in + PAGE_SIZE, 2 * PAGE_SIZE), 2 * PAGE_SIZE);
+    ASSERT_EQ(memcmp(in, out, sizeof(in)), 0);
+    ASSERT_EQ(ipc_read_pipe(pipe, in, 1), IPC_EAGAIN);
+    
+    ipc_destroy_pipe(pipe);
+    return 0;
+}
+
+static u32 pipe_notify_events = 0;
+
+static void pipe_notify(u64 pipe_id, u32 events, void *context)
+{
+    pipe_notify_events |= events;
+}
+
+static int test_ipc_pipe_poll_and_hangup(void)
+{
+    ipc_object_t *pipe = ipc_create_pipe(1, 2);
+    ASSERT_NOT_NULL(pipe);
+    ipc_pipe_set_notify(pipe, pipe_notify, NULL);
+    
+    ASSERT_EQ(ipc_pipe_poll(pipe), IPC_POLL_OUT);
+    ASSERT_EQ(ipc_write_pipe(pipe, "log", 3), 3);
+    ASSERT_EQ(pipe_notify_events, IPC_POLL_IN);
+    ASSERT_EQ(ipc_pipe_poll(pipe), IPC_POLL_IN | IPC_POLL_OUT);
+    
+    ipc_pipe_close_writer(pipe);
+    ASSERT_EQ(pipe_notify_events & IPC_POLL_HUP, IPC_POLL_HUP);
+    
+    char buf[8];
+    ASSERT_EQ(ipc_read_pipe(pipe, buf, sizeof(buf)), 3);
+    ASSERT_EQ(ipc_read_pipe(pipe, buf, sizeof(buf)), 0);
+    
+    ipc_pipe_close_reader(pipe);
+    ASSERT_EQ(ipc_write_pipe(pipe, "x", 1), IPC_EPIPE);
+    
+    ipc_destroy_pipe(pipe);
+    return 0;
+}
+
+static int test_ipc_pipe_splice_file(void)
+{
+    aegisfs_init();
+    inode_t *src = aegisfs_create_file("/splice_src", 0644);
+    inode_t *dst = aegisfs_create_file("/splice_dst", 0644);
+    
+    char data[PAGE_SIZE + 512];
+    memset(data, 'p', sizeof(data));
+    ASSERT_EQ(aegisfs_write(src, 0, data, sizeof(data)), sizeof(data));
+    
+    ipc_object_t *pipe = ipc_create_pipe(1, 2);
+    ASSERT_EQ(ipc_splice_from_file(pipe, src, 0, sizeof(data)), sizeof(data));
+    ASSERT_EQ(pipe->data.pipe.tail - pipe->data.pipe.head, 2);
+    
+    ASSERT_EQ(ipc_splice_to_file(pipe, dst, 0, sizeof(data)), sizeof(data));
+    ASSERT_EQ(dst->size, sizeof(data));
+    ASSERT_EQ(dst->block_ptrs[0], src->block_ptrs[0]);
+    ASSERT_EQ(dst->block_ptrs[1], src->block_ptrs[1]);
+    
+    char check[sizeof(data)];
+    ASSERT_EQ(aegisfs_read(dst, 0, check, sizeof(check)), sizeof(check));
+    ASSERT_EQ(memcmp(check, data, sizeof(data)), 0);
+    
+    ASSERT_EQ(aegisfs_write(dst, PAGE_SIZE + 100, "xy", 2), 2);
+    ASSERT_NE(dst->block_ptrs[1], src->block_ptrs[1]);
+    ASSERT_EQ(dst->block_ptrs[0], src->block_ptrs[0]);
+    ASSERT_EQ(aegisfs_read(src, 0, check, sizeof(check)), sizeof(check));
+    ASSERT_EQ(memcmp(check, data, sizeof(data)), 0);
+    ASSERT_EQ(aegisfs_read(dst, PAGE_SIZE + 99, check, 4), 4);
+    ASSERT_EQ(memcmp(check, "pxyp", 4), 0);
+    
+    ipc_destroy_pipe(pipe);
+    return 0;
+}
+
+static int test_futex_wait_checks_value(void)
+{
+    u32 word = 1;
+    
+    ASSERT_EQ(futex_wait(&word, 0, NULL, 0), FUTEX_EAGAIN);
+    ASSERT_EQ(futex_wait(&word, 1, NULL, 1000000), FUTEX_ETIMEDOUT);
+    ASSERT_EQ(futex_wake(&word, 1), 0);
+    return 0;
+}
+
+static int test_ipc_semaphore_spin_then_sleep(void)
+{
+    ipc_object_t *sem = ipc_create_semaphore(2);
+    ASSERT_NOT_NULL(sem);
+    
+    ASSERT_EQ(ipc_semaphore_wait(sem), 0);
+    ASSERT_EQ(ipc_semaphore_try_wait(sem), 0);
+    ASSERT_EQ(ipc_semaphore_try_wait(sem), -1);
+    ASSERT_EQ(ipc_semaphore_timed_wait(sem, 1000000), IPC_ETIMEDOUT);
+    ASSERT_EQ(sem->data.sem.waiters, 0);
+    
+    ipc_semaphore_signal(sem);
+    ASSERT_EQ(ipc_semaphore_timed_wait(sem, 1000000), 0);
+    ASSERT_EQ(sem->data.sem.value, 0);
+    return 0;
+}
+
+static int test_devapi_event_wait(void)
+{
+    ASSERT_EQ(aegis_event_create("wq_auto", 0, 0), AEGIS_ERROR_OK);
+    ASSERT_EQ(aegis_event_create("wq_auto", 0, 0), AEGIS_ERROR_ALREADY_EXISTS);
+    ASSERT_EQ(aegis_event_wait("wq_auto", 1), AEGIS_ERROR_TIMEOUT);
+    
+    aegis_event_set("wq_auto");
+    ASSERT_EQ(aegis_event_wait("wq_auto", 1), AEGIS_ERROR_OK);
+    ASSERT_EQ(aegis_event_wait("wq_auto", 0), AEGIS_ERROR_TIMEOUT);
+    
+    ASSERT_EQ(aegis_event_create("wq_manual", 1, 1), AEGIS_ERROR_OK);
+    ASSERT_EQ(aegis_event_wait("wq_manual", 0), AEGIS_ERROR_OK);
+    ASSERT_EQ(aegis_event_wait("wq_manual", 0), AEGIS_ERROR_OK);
+    aegis_event_clear("wq_manual");
+    ASSERT_EQ(aegis_event_wait("wq_manual", 0), AEGIS_ERROR_TIMEOUT);
+    return 0;
+}
+
+void run_ipc_tests(void)
+{
+    printf("\n=== Kernel IPC Tests ===\n");
+    
+    TEST_SUITE("IPC Grants", setup_ipc_core_test, NULL,
+        TEST(test_ipc_grant_shared_mapping),
+        TEST(test_ipc_grant_move_and_rights),
+        TEST(test_ipc_shared_memory_attach_maps),
+        TEST(test_ipc_shm_ring_stream)
+    );
+    
+    TEST_SUITE("IPC Call/Reply", setup_ipc_core_test, NULL,
+        TEST(test_ipc_call_fastpath)
+    );
+    
+    TEST_SUITE("IPC Pipes", setup_ipc_core_test, NULL,
+        TEST(test_ipc_pipe_stream_and_wrap),
+        TEST(test_ipc_pipe_poll_and_hangup),
+        TEST(test_ipc_pipe_splice_file)
+    );
+    
+    TEST_SUITE("IPC Wait Queues", setup_ipc_core_test, NULL,
+        TEST(test_futex_wait_checks_value),
+        TEST(test_ipc_semaphore_spin_then_sleep),
+        TEST(test_devapi_event_wait)
+    );
+}
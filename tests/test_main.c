@@ -8,6 +8,7 @@ void run_filesystem_tests(void);
 void run_devapi_tests(void);
 void test_integration_main(void);
 void run_profiler_tests(void);
+void run_ipc_tests(void);
 
 int main(void) {
     printf("\n");
@@ -36,6 +37,9 @@ int main(void) {
     printf("\n[Phase 7] Running Profiler Tests...\n");
     run_profiler_tests();
 
+    printf("\n[Phase 8] Running IPC Tests...\n");
+    run_ipc_tests();
+
     printf("\n");
     printf("╔════════════════════════════════════════╗\n");
     printf("║          Test Suite Complete            ║\n");
@@ -1,5 +1,22 @@
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <link.h>
 #include <kernel/profiler.h>
+#include <kernel/sampler.h>
+#include <kernel/debugger.h>
+#include <kernel/ksym.h>
+#include <kernel/wait_queue.h>
+#include <kernel/scheduler.h>
+#include <kernel/pmu.h>
+#include <kernel/hdr_histogram.h>
+#include <kernel/tracepoint.h>
+#include <kernel/percpu.h>
+#include "../kernel/perf_optimize.h"
+#include "../kernel/perf_trace.h"
+#include "../kernel/perf_chrome.h"
 #include "test_framework.h"
 
 static int setup_profiler_test(void)
@@ -59,6 +76,515 @@ static int test_profiler_start_end(void)
     return 0;
 }
 
+static int test_profiler_interned_probes(void)
+{
+    profiler_probe_t probe = profiler_probe("interned_op");
+    ASSERT_GT(probe, 0);
+    ASSERT_EQ(profiler_probe("interned_op"), probe);
+    ASSERT_EQ(profiler_probe_find("never_recorded"), 0);
+    ASSERT_STREQ(profiler_probe_name(probe), "interned_op");
+    
+    for (uint32_t i = 1; i <= PROFILER_RING_SIZE + 10; i++) {
+        profiler_record_id(probe, i);
+    }
+    
+    ASSERT_EQ(profiler_get_count("interned_op"), PROFILER_RING_SIZE + 10);
+    ASSERT_EQ(profiler_get_min_duration("interned_op"), 1);
+    ASSERT_EQ(profiler_get_max_duration("interned_op"), PROFILER_RING_SIZE + 10);
+    
+    /* The ring keeps only the newest samples. */
+    profiler_sample_t samples[PROFILER_RING_SIZE];
+    uint32_t n = profiler_read_samples(0, samples, PROFILER_RING_SIZE);
+    ASSERT_EQ(n, PROFILER_RING_SIZE);
+    ASSERT_EQ(samples[0].duration, 11);
+    ASSERT_EQ(samples[n - 1].duration, PROFILER_RING_SIZE + 10);
+    ASSERT_EQ(samples[n - 1].probe, probe);
+    
+    profiler_clear();
+    ASSERT_EQ(profiler_get_count("interned_op"), 0);
+    ASSERT_EQ(profiler_probe_find("interned_op"), probe);
+    return 0;
+}
+
+static int test_profiler_nested_sections(void)
+{
+    profiler_start("outer");
+    profiler_start("inner");
+    profiler_end("inner");
+    profiler_end("outer");
+    
+    ASSERT_EQ(profiler_get_count("inner"), 1);
+    ASSERT_EQ(profiler_get_count("outer"), 1);
+    ASSERT_GTE(profiler_get_max_duration("outer"), profiler_get_max_duration("inner"));
+    return 0;
+}
+
+static __attribute__((noinline)) void profiler_test_spin(void)
+{
+    sampler_stats_t stats;
+    uint64_t deadline = wait_queue_now_ns() + 5000000000ULL;
+    
+    do {
+        for (volatile int i = 0; i < 100000; i++) {
+        }
+        sampler_get_stats(&stats);
+    } while (stats.samples < 200 && wait_queue_now_ns() < deadline);
+}
+
+static int test_profiler_stack_sampling(void)
+{
+    perf_buffer_t *buffer = perf_create_buffer();
+    ASSERT_NOT_NULL(buffer);
+    perf_start_collection(buffer);
+    
+    debugger_add_symbol((u64)(uintptr_t)test_profiler_stack_sampling, 0, "test_profiler_stack_sampling");
+    debugger_add_symbol((u64)(uintptr_t)profiler_test_spin, 0, "profiler_test_spin");
+    
+    ASSERT_EQ(sampler_start(buffer, 0), 0);
+    ASSERT_EQ(sampler_start(buffer, 0), -1);
+    profiler_test_spin();
+    ASSERT_EQ(sampler_stop(), 0);
+    ASSERT_EQ(sampler_running(), false);
+    
+    sampler_stats_t stats;
+    sampler_get_stats(&stats);
+    ASSERT_EQ(stats.hz, SAMPLER_DEFAULT_HZ);
+    ASSERT_GTE(stats.samples, 200);
+    ASSERT_EQ(buffer->sample_count, stats.samples);
+    /* The default rate must cost under 1% of the sampled CPU time. */
+    ASSERT_GT(10000, stats.overhead_ppm);
+    
+    u32 deepest = 0;
+    for (size_t i = 0; i < buffer->sample_count; i++) {
+        ASSERT_EQ(buffer->samples[i].event_type, PERF_EVENT_CPU_SAMPLE);
+        if (buffer->samples[i].call_depth > deepest) deepest = buffer->samples[i].call_depth;
+    }
+    ASSERT_GT(deepest, 2);
+    
+    size_t len = sampler_export_folded(buffer, NULL, 0);
+    ASSERT_GT(len, 0);
+    char *folded = malloc(len + 1);
+    ASSERT_NOT_NULL(folded);
+    ASSERT_EQ(sampler_export_folded(buffer, folded, len + 1), len);
+    ASSERT_NOT_NULL(strstr(folded, "test_profiler_stack_sampling;profiler_test_spin"));
+    
+    free(folded);
+    debugger_clear_symbols();
+    perf_free_buffer(buffer);
+    return 0;
+}
+
+static int profiler_test_main_bias(struct dl_phdr_info *info, size_t size, void *data)
+{
+    *(u64 *)data = (u64)info->dlpi_addr;
+    return 1;
+}
+
+static int test_profiler_symbol_table(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/aegis_ksym_%d.ksym", (int)getpid());
+
+    ksym_symbol_t symbols[] = {
+        { 0x2000, 0,     0, "sizeless_fn" },
+        { 0x1048, 0x8,   2, "leaf" },
+        { 0x1000, 0x100, 0, "outer_fn" },
+        { 0x1040, 0x20,  1, "helper" },
+        { 0x2100, 0x10,  0, "next_fn" },
+    };
+    ASSERT_EQ(ksym_write(path, symbols, 5), 0);
+    ASSERT_EQ(debugger_set_symbol_table(path), 3);
+
+    /* Table addresses are link-time; lookups take run-time addresses. */
+    u64 bias = 0;
+    dl_iterate_phdr(profiler_test_main_bias, &bias);
+
+    u64 offset = 0;
+    ASSERT_NULL(ksym_lookup(bias + 0xfff, &offset));
+    ASSERT_NOT_NULL(ksym_lookup(bias + 0x1010, &offset));
+    ASSERT_EQ(strcmp(ksym_lookup(bias + 0x1010, &offset), "outer_fn"), 0);
+    ASSERT_EQ(offset, 0x10);
+    /* A function without a size runs up to the next one. */
+    ASSERT_EQ(strcmp(debugger_lookup_symbol(bias + 0x20ff, &offset), "sizeless_fn"), 0);
+    ASSERT_EQ(offset, 0xff);
+    ASSERT_EQ(strcmp(ksym_lookup(bias + 0x2100, NULL), "next_fn"), 0);
+    ASSERT_NULL(ksym_lookup(bias + 0x2110, NULL));
+
+    const char *names[KSYM_MAX_INLINE + 1];
+    ASSERT_EQ(ksym_lookup_inline(bias + 0x104a, names, KSYM_MAX_INLINE + 1), 3);
+    ASSERT_EQ(strcmp(names[0], "leaf"), 0);
+    ASSERT_EQ(strcmp(names[1], "helper"), 0);
+    ASSERT_EQ(strcmp(names[2], "outer_fn"), 0);
+    ASSERT_EQ(ksym_lookup_inline(bias + 0x1058, names, KSYM_MAX_INLINE + 1), 2);
+    ASSERT_EQ(ksym_lookup_inline(bias + 0x1080, names, KSYM_MAX_INLINE + 1), 1);
+
+    /* Run-time symbols sit next to the mapped table. */
+    ASSERT_EQ(ksym_add(bias + 0x3000, 0x40, "runtime_fn"), 0);
+    ASSERT_EQ(strcmp(ksym_lookup(bias + 0x3004, NULL), "runtime_fn"), 0);
+    ASSERT_EQ(strcmp(ksym_lookup(bias + 0x1010, NULL), "outer_fn"), 0);
+
+    ksym_stats_t before, after;
+    ksym_get_stats(&before);
+    ASSERT_EQ(before.symbols, 4);
+    ASSERT_EQ(before.inlines, 2);
+    for (int i = 0; i < 100000; i++) {
+        ksym_lookup(bias + 0x1000 + (u64)(i & 0xff), NULL);
+    }
+    ksym_get_stats(&after);
+    ASSERT_EQ(after.lookups - before.lookups, 100000);
+    ASSERT_GT(after.cache_hits - before.cache_hits, 99000);
+
+    debugger_clear_symbols();
+    ASSERT_NULL(ksym_lookup(bias + 0x1010, NULL));
+    unlink(path);
+    return 0;
+}
+
+static int test_profiler_perf_stat(void)
+{
+    pmu_init();
+    
+    perf_stat_t stat;
+    ASSERT_EQ(perf_stat_begin(&stat), 0);
+    for (volatile int i = 0; i < 100000; i++) {
+    }
+    ASSERT_EQ(perf_stat_end(&stat), 0);
+    
+    ASSERT_TRUE(stat.counts.valid & PMU_EVENT_BIT(PMU_EVENT_CYCLES));
+    ASSERT_GT(stat.counts.count[PMU_EVENT_CYCLES], 0);
+    ASSERT_GT(stat.elapsed_ns, 0);
+    if (stat.counts.valid & PMU_EVENT_BIT(PMU_EVENT_INSTRUCTIONS)) {
+        ASSERT_GT(stat.counts.count[PMU_EVENT_INSTRUCTIONS], 0);
+        ASSERT_TRUE(stat.ipc > 0.0);
+    }
+    
+    /* Per-thread counts follow the thread across context switches. */
+    pmu_context_t ctx_a, ctx_b;
+    pmu_context_init(&ctx_a);
+    pmu_context_init(&ctx_b);
+    thread_t a = { .tid = 1, .pmu = &ctx_a };
+    thread_t b = { .tid = 2, .pmu = &ctx_b };
+    
+    pmu_switch(NULL, a.pmu);
+    scheduler_switch_context(&a, &b);
+    ASSERT_FALSE(ctx_a.running);
+    ASSERT_EQ(ctx_b.running, pmu_available());
+    scheduler_switch_context(&b, &a);
+    pmu_switch(a.pmu, NULL);
+    
+    pmu_counts_t counts;
+    ASSERT_EQ(pmu_context_read(&ctx_a, &counts), 0);
+    ASSERT_EQ(counts.valid, pmu_supported_events());
+    return 0;
+}
+
+static int test_profiler_percentiles(void)
+{
+    profiler_probe_t probe = profiler_probe("percentile_op");
+    for (uint32_t i = 1; i <= 1000; i++) {
+        profiler_record_id(probe, i);
+    }
+    
+    /* Buckets are at most 1/32 of their value wide. */
+    ASSERT_GTE(profiler_get_percentile("percentile_op", 500), 500);
+    ASSERT_GTE(500 + 500 / 32, profiler_get_percentile("percentile_op", 500));
+    ASSERT_GTE(profiler_get_percentile("percentile_op", 990), 990);
+    ASSERT_GTE(990 + 990 / 32, profiler_get_percentile("percentile_op", 990));
+    ASSERT_EQ(profiler_get_percentile("percentile_op", 1000), 1000);
+    
+    hdr_hist_t small;
+    hdr_hist_reset(&small);
+    for (u64 v = 0; v < 2 * HDR_SUB_COUNT; v++) {
+        hdr_hist_record(&small, v);
+    }
+    ASSERT_EQ(hdr_hist_quantile(&small, 500), HDR_SUB_COUNT - 1);
+    
+    perf_buffer_t *buffer = perf_create_buffer();
+    ASSERT_NOT_NULL(buffer);
+    perf_start_collection(buffer);
+    
+    perf_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.event_type = PERF_EVENT_SYSCALL;
+    for (uint32_t i = 0; i < PERF_MAX_SAMPLES + 1000; i++) {
+        sample.duration_ns = i % 100 == 99 ? 50000 : 1000;
+        perf_record_sample(buffer, &sample);
+    }
+    
+    perf_statistics_t *stats = perf_analyze_buffer(buffer);
+    ASSERT_NOT_NULL(stats);
+    perf_event_stats_t *syscalls = &stats->event_stats[PERF_EVENT_SYSCALL];
+    ASSERT_EQ(syscalls->count, PERF_MAX_SAMPLES);
+    ASSERT_GTE(syscalls->p50_duration_ns, 1000);
+    ASSERT_GT(2000, syscalls->p90_duration_ns);
+    ASSERT_GT(2000, syscalls->p99_duration_ns);
+    ASSERT_EQ(syscalls->p999_duration_ns, 50000);
+    
+    /* The histogram keeps counting past the end of the sample array. */
+    hdr_hist_t merged;
+    ASSERT_EQ(perf_event_histogram(buffer, PERF_EVENT_SYSCALL, &merged), 0);
+    ASSERT_EQ(merged.count, PERF_MAX_SAMPLES + 1000);
+    
+    perf_free_statistics(stats);
+    perf_free_buffer(buffer);
+    return 0;
+}
+
+static int test_profiler_trace_streaming(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/aegis_trace_%d.bin", (int)getpid());
+    
+    perf_buffer_t *stream = perf_create_stream_buffer(path);
+    ASSERT_NOT_NULL(stream);
+    perf_start_collection(stream);
+    
+    const uint32_t total = PERF_MAX_SAMPLES * 5;
+    perf_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    uint32_t written = 0;
+    for (uint32_t i = 0; i < total; i++) {
+        sample.timestamp = 1000000 + (uint64_t)i * 250;
+        sample.cpu_id = i % 4;
+        sample.tid = 100 + i % 4;
+        sample.event_type = i % 2 ? PERF_EVENT_SYSCALL : PERF_EVENT_CPU_SAMPLE;
+        sample.duration_ns = i % 100 == 99 ? 50000 : 1000;
+        sample.call_depth = 3;
+        sample.call_stack[0] = 0x401000 + (i % 8) * 0x40;
+        sample.call_stack[1] = 0x402000;
+        sample.call_stack[2] = 0x400800;
+        written += perf_record_sample(stream, &sample);
+    }
+    ASSERT_EQ(written, total);
+    
+    perf_trace_stats_t tstats;
+    perf_trace_get_stats(stream->stream, &tstats);
+    ASSERT_EQ(tstats.records, total);
+    ASSERT_EQ(tstats.lost, 0);
+    ASSERT_EQ(stream->sample_count, 0);
+    perf_stop_collection(stream);
+    perf_free_buffer(stream);
+    
+    perf_buffer_t *loaded = perf_trace_load(path);
+    ASSERT_NOT_NULL(loaded);
+    ASSERT_EQ(loaded->sample_count, total);
+    ASSERT_EQ(loaded->collection_start, 1000000);
+    
+    uint32_t in_order = 1;
+    for (size_t i = 1; i < loaded->sample_count; i++) {
+        perf_sample_t *prev = &loaded->samples[i - 1];
+        perf_sample_t *cur = &loaded->samples[i];
+        if (cur->cpu_id == prev->cpu_id && cur->timestamp < prev->timestamp) in_order = 0;
+    }
+    ASSERT_TRUE(in_order);
+    ASSERT_EQ(loaded->samples[0].call_stack[1], 0x402000);
+    ASSERT_EQ(loaded->samples[0].call_stack[2], 0x400800);
+    
+    perf_statistics_t *stats = perf_analyze_buffer(loaded);
+    ASSERT_NOT_NULL(stats);
+    ASSERT_EQ(stats->event_stats[PERF_EVENT_SYSCALL].count, total / 2);
+    ASSERT_EQ(stats->event_stats[PERF_EVENT_SYSCALL].p999_duration_ns, 50000);
+    perf_free_statistics(stats);
+    
+    perf_hotspot_analysis_t *hotspots = perf_find_hotspots(loaded);
+    ASSERT_NOT_NULL(hotspots);
+    ASSERT_EQ(hotspots->hotspot_count, 8);
+    ASSERT_EQ(hotspots->hotspots[0].call_count, total / 8);
+    perf_free_hotspot_analysis(hotspots);
+    perf_free_buffer(loaded);
+    
+    /* A damaged chunk header costs that chunk only. */
+    FILE *file = fopen(path, "r+b");
+    ASSERT_NOT_NULL(file);
+    fseek(file, sizeof(perf_trace_file_hdr_t), SEEK_SET);
+    fputc(0, file);
+    fclose(file);
+    
+    perf_trace_reader_t *reader = perf_trace_open(path);
+    ASSERT_NOT_NULL(reader);
+    uint32_t recovered = 0;
+    while (perf_trace_next(reader, &sample) > 0) {
+        recovered++;
+    }
+    ASSERT_GT(recovered, 0);
+    ASSERT_GT(total, recovered);
+    ASSERT_GT(perf_trace_skipped_bytes(reader), 0);
+    perf_trace_reader_close(reader);
+    
+    unlink(path);
+    return 0;
+}
+
+static char *profiler_test_slurp(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    char *text = malloc((size_t)size + 1);
+    if (text) {
+        text[fread(text, 1, (size_t)size, file)] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+static void profiler_test_timeline(perf_buffer_t *buffer)
+{
+    perf_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    
+    sample.event_type = PERF_EVENT_CONTEXT_SWITCH;
+    sample.cpu_id = 0;
+    sample.tid = 10;
+    sample.event_value = 11;
+    sample.timestamp = 1000;
+    perf_record_sample(buffer, &sample);
+    
+    sample.event_type = PERF_EVENT_IPC_MESSAGE;
+    sample.tid = 11;
+    sample.event_value = 42;
+    sample.timestamp = 2000;
+    sample.duration_ns = 300;
+    perf_record_sample(buffer, &sample);
+    
+    sample.cpu_id = 1;
+    sample.tid = 20;
+    sample.event_value = 42 | PERF_IPC_RECV;
+    sample.timestamp = 2500;
+    perf_record_sample(buffer, &sample);
+    
+    sample.event_type = PERF_EVENT_CONTEXT_SWITCH;
+    sample.cpu_id = 0;
+    sample.tid = 11;
+    sample.event_value = 10;
+    sample.timestamp = 5000;
+    sample.duration_ns = 0;
+    perf_record_sample(buffer, &sample);
+}
+
+static int test_profiler_chrome_export(void)
+{
+    char json_path[64], trace_path[64];
+    snprintf(json_path, sizeof(json_path), "/tmp/aegis_chrome_%d.json", (int)getpid());
+    snprintf(trace_path, sizeof(trace_path), "/tmp/aegis_chrome_%d.bin", (int)getpid());
+    
+    perf_buffer_t *buffer = perf_create_buffer();
+    ASSERT_NOT_NULL(buffer);
+    perf_start_collection(buffer);
+    profiler_test_timeline(buffer);
+    
+    profiler_start("chrome_region");
+    profiler_end("chrome_region");
+    
+    perf_chrome_t *chrome = perf_chrome_open(json_path);
+    ASSERT_NOT_NULL(chrome);
+    int events = perf_chrome_add_buffer(chrome, buffer);
+    /* 2 switch markers, 1 running slice, 2 IPC slices, 2 flow ends. */
+    ASSERT_EQ(events, 7);
+    ASSERT_GT(perf_chrome_add_profiler(chrome), 0);
+    ASSERT_EQ(perf_chrome_close(chrome), 0);
+    perf_free_buffer(buffer);
+    
+    char *json = profiler_test_slurp(json_path);
+    ASSERT_NOT_NULL(json);
+    ASSERT_TRUE(strncmp(json, "{\"displayTimeUnit\"", 18) == 0);
+    ASSERT_NOT_NULL(strstr(json, "\"name\":\"tid 11\",\"cat\":\"sched\",\"ph\":\"X\",\"ts\":1.000,\"pid\":1,\"tid\":1,\"dur\":4.000"));
+    ASSERT_NOT_NULL(strstr(json, "\"ph\":\"s\",\"ts\":2.000,\"pid\":1,\"tid\":3,\"id\":42}"));
+    ASSERT_NOT_NULL(strstr(json, "\"ph\":\"f\",\"ts\":2.500,\"pid\":2,\"tid\":3,\"id\":42,\"bp\":\"e\"}"));
+    ASSERT_NOT_NULL(strstr(json, "\"name\":\"chrome_region\",\"cat\":\"profiler\""));
+    ASSERT_NOT_NULL(strstr(json, "\"args\":{\"name\":\"CPU 1\"}"));
+    ASSERT_NOT_NULL(strstr(json, "\n]}\n"));
+    free(json);
+    
+    /* The on-disk trace exports the same timeline. */
+    perf_buffer_t *stream = perf_create_stream_buffer(trace_path);
+    ASSERT_NOT_NULL(stream);
+    perf_start_collection(stream);
+    profiler_test_timeline(stream);
+    perf_stop_collection(stream);
+    perf_free_buffer(stream);
+    
+    chrome = perf_chrome_open(json_path);
+    ASSERT_NOT_NULL(chrome);
+    ASSERT_EQ(perf_chrome_add_trace(chrome, trace_path), 7);
+    ASSERT_EQ(perf_chrome_close(chrome), 0);
+    
+    unlink(trace_path);
+    unlink(json_path);
+    return 0;
+}
+
+static int profiler_test_traced(int value)
+{
+    AEGIS_TRACE(profiler_test, hit, value, value * 2);
+    return value;
+}
+
+static int test_profiler_tracepoints(void)
+{
+    char json_path[64];
+    snprintf(json_path, sizeof(json_path), "/tmp/aegis_tp_%d.json", (int)getpid());
+    
+    trace_disable_all();
+    trace_clear();
+    
+    tracepoint_t *hit = trace_find("profiler_test", "hit");
+    ASSERT_NOT_NULL(hit);
+    ASSERT_STREQ(hit->args, "value, value * 2");
+    ASSERT_NOT_NULL(trace_find("sched", "switch"));
+    ASSERT_GT(trace_list(NULL, 0), 1);
+    
+    /* Disabled sites record nothing. */
+    profiler_test_traced(1);
+    trace_record_t records[8];
+    ASSERT_EQ(trace_read(percpu_current_cpu(), records, 8), 0);
+    ASSERT_EQ(hit->hits, 0);
+    
+    ASSERT_EQ(trace_enable("profiler_test", "*"), 1);
+    ASSERT_GTE(trace_enable("sched", "switch"), 1);
+    profiler_test_traced(21);
+    
+    thread_t prev, next;
+    memset(&prev, 0, sizeof(prev));
+    memset(&next, 0, sizeof(next));
+    prev.tid = 5;
+    next.tid = 6;
+    scheduler_switch_context(&prev, &next);
+    
+    ASSERT_EQ(trace_read(percpu_current_cpu(), records, 8), 2);
+    ASSERT_EQ(records[0].tp, hit);
+    ASSERT_EQ(records[0].nargs, 2);
+    ASSERT_EQ(records[0].args[0], 21);
+    ASSERT_EQ(records[0].args[1], 42);
+    ASSERT_STREQ(records[1].tp->subsys, "sched");
+    ASSERT_EQ(records[1].args[0], 5);
+    ASSERT_EQ(records[1].args[1], 6);
+    ASSERT_GTE(records[1].timestamp, records[0].timestamp);
+    
+    perf_chrome_t *chrome = perf_chrome_open(json_path);
+    ASSERT_NOT_NULL(chrome);
+    ASSERT_EQ(perf_chrome_add_tracepoints(chrome), 2);
+    ASSERT_EQ(perf_chrome_close(chrome), 0);
+    
+    char *json = profiler_test_slurp(json_path);
+    ASSERT_NOT_NULL(json);
+    ASSERT_NOT_NULL(strstr(json, "\"name\":\"profiler_test:hit\""));
+    ASSERT_NOT_NULL(strstr(json, "\"value\":21,\"value * 2\":42}"));
+    ASSERT_NOT_NULL(strstr(json, "\"prev->tid\":5,\"next->tid\":6,"));
+    free(json);
+    unlink(json_path);
+    
+    trace_disable_all();
+    profiler_test_traced(3);
+    ASSERT_EQ(hit->hits, 1);
+    trace_clear();
+    return 0;
+}
+
 void run_profiler_tests(void)
 {
     printf("\n=== Profiler Tests ===\n");
@@ -67,6 +593,15 @@ void run_profiler_tests(void)
         TEST(test_profiler_record_event),
         TEST(test_profiler_get_average),
         TEST(test_profiler_get_max_min),
-        TEST(test_profiler_start_end)
+        TEST(test_profiler_start_end),
+        TEST(test_profiler_interned_probes),
+        TEST(test_profiler_nested_sections),
+        TEST(test_profiler_stack_sampling),
+        TEST(test_profiler_symbol_table),
+        TEST(test_profiler_perf_stat),
+        TEST(test_profiler_percentiles),
+        TEST(test_profiler_trace_streaming),
+        TEST(test_profiler_chrome_export),
+        TEST(test_profiler_tracepoints)
     );
 }